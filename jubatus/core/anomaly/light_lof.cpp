@@ -227,8 +227,8 @@ void light_lof::unlearn(const std::string& key) {
 float light_lof::collect_lrds(
     const common::sfv_t& query,
     std::vector<float>& neighbor_lrds) const {
-  std::vector<std::pair<std::string, float> > neighbors;
-  nearest_neighbor_engine_->neighbor_row(
+  std::vector<std::pair<uint64_t, float> > neighbors;
+  nearest_neighbor_engine_->neighbor_row_index(
       query, neighbors, config_.nearest_neighbor_num);
 
   return collect_lrds_from_neighbors(neighbors, neighbor_lrds);
@@ -237,13 +237,15 @@ float light_lof::collect_lrds(
 float light_lof::collect_lrds(
     const std::string& id,
     std::vector<float>& neighbor_lrds) const {
-  std::vector<std::pair<std::string, float> > neighbors;
-  nearest_neighbor_engine_->neighbor_row(
+  std::vector<std::pair<uint64_t, float> > neighbors;
+  nearest_neighbor_engine_->neighbor_row_index(
       id, neighbors, config_.nearest_neighbor_num + 1);
 
   // neighbors may contain given id. We ignore it.
-  for (size_t i = 0; i < neighbors.size(); ++i) {
-    if (neighbors[i].first == id) {
+  const std::pair<bool, uint64_t> self =
+      nearest_neighbor_engine_->get_const_table()->exact_match(id);
+  for (size_t i = 0; self.first && i < neighbors.size(); ++i) {
+    if (neighbors[i].first == self.second) {
       std::swap(neighbors[i], neighbors.back());
       neighbors.pop_back();
       break;
@@ -257,7 +259,7 @@ float light_lof::collect_lrds(
 }
 
 float light_lof::collect_lrds_from_neighbors(
-    const std::vector<std::pair<std::string, float> >& neighbors,
+    const std::vector<std::pair<uint64_t, float> >& neighbors,
     std::vector<float>& neighbor_lrds) const {
   neighbor_lrds.resize(neighbors.size());
   if (neighbors.empty()) {
@@ -265,9 +267,12 @@ float light_lof::collect_lrds_from_neighbors(
   }
 
   // Collect parameters of given neighbors.
+  shared_ptr<const column_table> nn_table =
+      nearest_neighbor_engine_->get_const_table();
   std::vector<parameter> parameters(neighbors.size());
   for (size_t i = 0; i < neighbors.size(); ++i) {
-    parameters[i] = get_row_parameter(neighbors[i].first);
+    parameters[i] =
+        get_row_parameter(nn_table->get_key_ref(neighbors[i].first));
     neighbor_lrds[i] = parameters[i].lrd;
   }
 
@@ -291,12 +296,14 @@ float light_lof::collect_lrds_from_neighbors(
 void light_lof::collect_neighbors(
     const std::string& query,
     unordered_set<std::string>& neighbors) const {
-  std::vector<std::pair<std::string, float> > nn_result;
-  nearest_neighbor_engine_->neighbor_row(
+  std::vector<std::pair<uint64_t, float> > nn_result;
+  nearest_neighbor_engine_->neighbor_row_index(
       query, nn_result, config_.reverse_nearest_neighbor_num);
 
+  shared_ptr<const column_table> nn_table =
+      nearest_neighbor_engine_->get_const_table();
   for (size_t i = 0; i < nn_result.size(); ++i) {
-    neighbors.insert(nn_result[i].first);
+    neighbors.insert(nn_table->get_key_ref(nn_result[i].first));
   }
 }
 
@@ -320,19 +327,22 @@ void light_lof::update_entries(const unordered_set<std::string>& neighbors) {
       nested_neighbors;
 
   // Gather k-nearest neighbors of each member of neighbors and update their
-  // k-dists.
-  std::vector<std::pair<std::string, float> > nn_result;
+  // k-dists.  Rows of the nearest neighbor table are mapped to rows of the
+  // score table through their keys, as the two tables are not aligned.
+  shared_ptr<const column_table> nn_table =
+      nearest_neighbor_engine_->get_const_table();
+  std::vector<std::pair<uint64_t, float> > nn_result;
   for (std::vector<uint64_t>::const_iterator it = ids.begin();
        it != ids.end(); ++it) {
-    nearest_neighbor_engine_->neighbor_row(
-        table->get_key(*it), nn_result, config_.nearest_neighbor_num);
+    nearest_neighbor_engine_->neighbor_row_index(
+        table->get_key_ref(*it), nn_result, config_.nearest_neighbor_num);
     std::vector<std::pair<uint64_t, float> >& nn_indexes =
         nested_neighbors[*it];
 
     nn_indexes.reserve(nn_result.size());
     for (size_t i = 0; i < nn_result.size(); ++i) {
       const std::pair<bool, uint64_t> hit =
-          table->exact_match(nn_result[i].first);
+          table->exact_match(nn_table->get_key_ref(nn_result[i].first));
       if (hit.first) {
         nn_indexes.push_back(std::make_pair(hit.second, nn_result[i].second));
       }
@@ -105,8 +105,10 @@ class light_lof : public anomaly_base {
   float collect_lrds(
       const std::string& query,
       std::vector<float>& neighbor_lrds) const;
+  // neighbors are pairs of a row index of the nearest neighbor table and
+  // the distance.
   float collect_lrds_from_neighbors(
-      const std::vector<std::pair<std::string, float> >& neighbors,
+      const std::vector<std::pair<uint64_t, float> >& neighbors,
       std::vector<float>& neighbor_lrd) const;
 
   void collect_neighbors(
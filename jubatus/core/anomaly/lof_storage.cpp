@@ -118,6 +118,7 @@ void lof_storage::remove_row(const string& row) {
 void lof_storage::clear() {
   lof_table_t().swap(lof_table_);
   lof_table_t().swap(lof_table_diff_);
+  mixing_table_.reset();
   nn_engine_->clear();
 }
 
@@ -148,8 +149,14 @@ string lof_storage::name() const {
   return "lof_storage";
 }
 
-float lof_storage::get_kdist(const string& row) const {
+const lof_entry& lof_storage::get_entry(const string& row) const {
   lof_table_t::const_iterator it = lof_table_diff_.find(row);
+  if (it == lof_table_diff_.end() && mixing_table_) {
+    it = mixing_table_->find(row);
+    if (it == mixing_table_->end()) {
+      it = lof_table_diff_.end();
+    }
+  }
   if (it == lof_table_diff_.end()) {
     it = lof_table_.find(row);
     if (it == lof_table_.end()) {
@@ -162,28 +169,21 @@ float lof_storage::get_kdist(const string& row) const {
       common::exception::runtime_error("specified row is recently removed")
       << common::exception::error_message("row id: " + row));
   }
-  return it->second.kdist;
+  return it->second;
+}
+
+float lof_storage::get_kdist(const string& row) const {
+  return get_entry(row).kdist;
 }
 
 float lof_storage::get_lrd(const string& row) const {
-  lof_table_t::const_iterator it = lof_table_diff_.find(row);
-  if (it == lof_table_diff_.end()) {
-    it = lof_table_.find(row);
-    if (it == lof_table_.end()) {
-      throw JUBATUS_EXCEPTION(
-        common::exception::runtime_error("specified row does not exist")
-        << common::exception::error_message("row id: " + row));
-    }
-  } else if (is_removed(it->second)) {
-    throw JUBATUS_EXCEPTION(
-      common::exception::runtime_error("specified row is recently removed")
-      << common::exception::error_message("row id: " + row));
-  }
-  return it->second.lrd;
+  return get_entry(row).lrd;
 }
 
 bool lof_storage::has_row(const string& row) const {
-  return lof_table_diff_.count(row) > 0 || lof_table_.count(row) > 0;
+  return lof_table_diff_.count(row) > 0 ||
+      (mixing_table_ && mixing_table_->count(row) > 0) ||
+      lof_table_.count(row) > 0;
 }
 
 void lof_storage::update_all() {
@@ -206,7 +206,15 @@ void lof_storage::set_nn_engine(
 }
 
 void lof_storage::get_diff(lof_table_t& diff) const {
-  diff = lof_table_diff_;
+  if (!mixing_table_) {
+    diff = lof_table_diff_;
+    return;
+  }
+  diff = *mixing_table_;
+  for (lof_table_t::const_iterator it = lof_table_diff_.begin();
+       it != lof_table_diff_.end(); ++it) {
+    diff[it->first] = it->second;
+  }
 }
 
 bool lof_storage::put_diff(const lof_table_t& mixed_diff) {
@@ -218,10 +226,37 @@ bool lof_storage::put_diff(const lof_table_t& mixed_diff) {
       lof_table_[it->first] = it->second;
     }
   }
-  lof_table_diff_.clear();
+  if (mixing_table_) {
+    // updates after freeze_diff() are left for the next MIX
+    mixing_table_.reset();
+  } else {
+    lof_table_diff_.clear();
+  }
   return true;
 }
 
+shared_ptr<const lof_table_t> lof_storage::freeze_diff() {
+  shared_ptr<lof_table_t> frozen(new lof_table_t);
+  if (mixing_table_) {
+    // previous MIX did not finish; mix both of them
+    get_diff(*frozen);
+    lof_table_diff_.clear();
+  } else {
+    frozen->swap(lof_table_diff_);
+  }
+  mixing_table_ = frozen;
+  return mixing_table_;
+}
+
+void lof_storage::abort_diff() {
+  if (!mixing_table_) {
+    return;
+  }
+  // newer updates take precedence
+  lof_table_diff_.insert(mixing_table_->begin(), mixing_table_->end());
+  mixing_table_.reset();
+}
+
 void lof_storage::mix(const lof_table_t& lhs, lof_table_t& rhs) const {
   for (lof_table_t::const_iterator it = lhs.begin(); it != lhs.end(); ++it) {
     if (is_removed(it->second)) {
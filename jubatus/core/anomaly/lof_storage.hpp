@@ -116,6 +116,11 @@ class lof_storage {
   bool put_diff(const lof_table_t& mixed_diff);
   void mix(const lof_table_t& lhs, lof_table_t& rhs) const;
 
+  // moves the current diff aside so that it can be packed without the model
+  // lock; it stays visible to readers until put_diff() or abort_diff()
+  jubatus::util::lang::shared_ptr<const lof_table_t> freeze_diff();
+  void abort_diff();
+
   storage::version get_version() const {
     return storage::version();
   }
@@ -127,12 +132,33 @@ class lof_storage {
     o.convert(this);
   }
 
-  MSGPACK_DEFINE(lof_table_, lof_table_diff_, neighbor_num_, reverse_nn_num_);
+  template <class Packer>
+  void msgpack_pack(Packer& pk) const {
+    if (!mixing_table_) {
+      msgpack::type::make_define(
+          lof_table_, lof_table_diff_, neighbor_num_, reverse_nn_num_)
+          .msgpack_pack(pk);
+    } else {
+      lof_table_t diff;
+      get_diff(diff);
+      msgpack::type::make_define(
+          lof_table_, diff, neighbor_num_, reverse_nn_num_).msgpack_pack(pk);
+    }
+  }
+
+  void msgpack_unpack(msgpack::object o) {
+    msgpack::type::make_define(
+        lof_table_, lof_table_diff_, neighbor_num_, reverse_nn_num_)
+        .msgpack_unpack(o);
+    mixing_table_.reset();
+  }
 
  private:
   static void mark_removed(lof_entry& entry);
   static bool is_removed(const lof_entry& entry);
 
+  const lof_entry& get_entry(const std::string& row) const;
+
   float collect_lrds_from_neighbors(
       const std::vector<std::pair<std::string, float> >& neighbors,
       jubatus::util::data::unordered_map<std::string, float>&
@@ -156,6 +182,8 @@ class lof_storage {
 
   lof_table_t lof_table_;  // table for storing k-dist and lrd values
   lof_table_t lof_table_diff_;
+  // diff being MIXed; entries here are not yet in lof_table_
+  jubatus::util::lang::shared_ptr<const lof_table_t> mixing_table_;
 
   uint32_t neighbor_num_;  // k of k-nn
   uint32_t reverse_nn_num_;  // ck of ck-nn as an approx. of k-reverse-nn
@@ -164,7 +192,7 @@ class lof_storage {
     nn_engine_;
 };
 
-typedef framework::linear_mixable_helper<lof_storage, lof_table_t>
+typedef framework::double_buffered_mixable_helper<lof_storage, lof_table_t>
     mixable_lof_storage;
 
 }  // namespace anomaly
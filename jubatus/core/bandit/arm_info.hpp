@@ -33,6 +33,13 @@ struct arm_info {
   MSGPACK_DEFINE(trial_count, weight);
 };
 
+inline double expectation_of(const arm_info& a) {
+  if (a.trial_count == 0) {
+    return 0;
+  }
+  return a.weight / a.trial_count;
+}
+
 typedef jubatus::util::data::unordered_map<std::string, arm_info> arm_info_map;
 
 }  // namespace bandit
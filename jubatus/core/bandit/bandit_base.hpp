@@ -18,6 +18,7 @@
 #define JUBATUS_CORE_BANDIT_BANDIT_BASE_HPP_
 
 #include <string>
+#include <vector>
 
 #include "arm_info.hpp"
 #include "../framework/packer.hpp"
@@ -39,6 +40,17 @@ class bandit_base {
 
   virtual std::string select_arm(const std::string& player_id) = 0;
 
+  // selects an arm for each of player_ids
+  virtual std::vector<std::string> select_arms(
+      const std::vector<std::string>& player_ids) {
+    std::vector<std::string> result;
+    result.reserve(player_ids.size());
+    for (size_t i = 0; i < player_ids.size(); ++i) {
+      result.push_back(select_arm(player_ids[i]));
+    }
+    return result;
+  }
+
   virtual bool register_reward(const std::string& player_id,
                                const std::string& arm_id,
                                double reward) = 0;
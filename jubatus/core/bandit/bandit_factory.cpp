@@ -16,8 +16,11 @@
 
 #include "bandit_factory.hpp"
 
+#include <limits>
 #include <string>
 
+#include "jubatus/util/data/optional.h"
+
 #include "epsilon_greedy.hpp"
 #include "ucb1.hpp"
 #include "ts.hpp"
@@ -43,22 +46,37 @@ struct epsilon_greedy_config {
 
 struct softmax_config {
   double tau;
+  jubatus::util::data::optional<int64_t> seed;
 
   template<class Ar>
   void serialize(Ar& ar) {
-    ar & JUBA_MEMBER(tau);
+    ar & JUBA_MEMBER(tau) & JUBA_MEMBER(seed);
   }
 };
 
 struct exp3_config {
   double gamma;
+  jubatus::util::data::optional<int64_t> seed;
 
   template<class Ar>
   void serialize(Ar& ar) {
-    ar & JUBA_MEMBER(gamma);
+    ar & JUBA_MEMBER(gamma) & JUBA_MEMBER(seed);
   }
 };
 
+namespace {
+
+uint32_t check_seed(int64_t seed) {
+  if (seed < 0 || std::numeric_limits<uint32_t>::max() < seed) {
+    throw JUBATUS_EXCEPTION(
+        common::config_exception() << common::exception::error_message(
+            "bandit seed must be within unsigned 32 bit integer"));
+  }
+  return static_cast<uint32_t>(seed);
+}
+
+}  // namespace
+
 shared_ptr<bandit_base> bandit_factory::create(
     const std::string& name,
     const common::jsonconfig::config& param) {
@@ -82,6 +100,10 @@ shared_ptr<bandit_base> bandit_factory::create(
               "parameter block is not specified in config"));
     }
     softmax_config conf = config_cast_check<softmax_config>(param);
+    if (conf.seed) {
+      return shared_ptr<bandit_base>(
+          new softmax(conf.tau, check_seed(*conf.seed)));
+    }
     return shared_ptr<bandit_base>(new softmax(conf.tau));
   } else if (name == "exp3") {
     if (param.type() == json::json::Null) {
@@ -90,6 +112,10 @@ shared_ptr<bandit_base> bandit_factory::create(
               "parameter block is not specified in config"));
     }
     exp3_config conf = config_cast_check<exp3_config>(param);
+    if (conf.seed) {
+      return shared_ptr<bandit_base>(
+          new exp3(conf.gamma, check_seed(*conf.seed)));
+    }
     return shared_ptr<bandit_base>(new exp3(conf.gamma));
   } else {
     throw JUBATUS_EXCEPTION(
@@ -65,6 +65,19 @@ TEST(bandit_factory, exp3) {
   EXPECT_EQ("exp3", p->name());
 }
 
+TEST(bandit_factory, seed) {
+  json::json js(new json::json_object);
+  js["tau"] = json::to_json(0.5);
+  js["seed"] = json::to_json(42);
+  shared_ptr<bandit_base> p = bandit_factory::create(
+      "softmax", common::jsonconfig::config(js));
+  EXPECT_EQ("softmax", p->name());
+
+  js["seed"] = json::to_json(-1);
+  EXPECT_THROW(bandit_factory::create(
+      "softmax", common::jsonconfig::config(js)), common::config_exception);
+}
+
 }  // namespace bandit
 }  // namespace core
 }  // namespace jubatus
@@ -44,10 +44,13 @@ std::string epsilon_greedy::select_arm(const std::string& player_id) {
     return arms[rand_.next_int(arms.size())];
   } else {
     // exploitation
+    std::vector<arm_info> infos;
+    s_.get_arm_infos(player_id, infos);
+
     std::string result = arms[0];
-    double exp_max = s_.get_expectation(player_id, arms[0]);
+    double exp_max = expectation_of(infos[0]);
     for (size_t i = 1; i < arms.size(); ++i) {
-      double exp = s_.get_expectation(player_id, arms[i]);
+      double exp = expectation_of(infos[i]);
       if (exp > exp_max) {
         result = arms[i];
         exp_max = exp;
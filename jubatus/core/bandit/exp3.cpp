@@ -19,7 +19,6 @@
 #include <string>
 #include <vector>
 #include "../common/exception.hpp"
-#include "select_by_weights.hpp"
 
 namespace jubatus {
 namespace core {
@@ -33,26 +32,28 @@ exp3::exp3(double gamma)
   }
 }
 
-void exp3::calc_weights_(const std::string& player_id,
-                         std::vector<double>& weights) const {
-  const std::vector<std::string>& arms = s_.get_arm_ids();
-  if (arms.empty()) {
+exp3::exp3(double gamma, uint32_t seed)
+    : gamma_(gamma), rand_(seed) {
+  if (gamma < 0 || 1 < gamma) {
     throw JUBATUS_EXCEPTION(
-        common::exception::runtime_error("arm is not registered"));
+        common::invalid_parameter("0 <= gamma <= 1"));
   }
+}
 
-  const size_t n = arms.size();
-  weights.clear();
-  weights.reserve(n);
-  double total_weight = 0;
-  for (size_t i = 0; i < n; ++i) {
-    const double weight = std::exp(s_.get_arm_info(player_id, arms[i]).weight);
-    weights.push_back(weight);
-    total_weight += weight;
+void exp3::cache_weights_(const std::string& player_id) {
+  if (sampler_.has_player(player_id)) {
+    return;
   }
-  for (size_t i = 0; i < n; ++i) {
-    weights[i] = (1.0 - gamma_) * weights[i] / total_weight + gamma_ * n;
+
+  std::vector<arm_info> infos;
+  s_.get_arm_infos(player_id, infos);
+
+  std::vector<double> weights;
+  weights.reserve(infos.size());
+  for (size_t i = 0; i < infos.size(); ++i) {
+    weights.push_back(std::exp(infos[i].weight));
   }
+  sampler_.set_weights(player_id, weights);
 }
 
 std::string exp3::select_arm(const std::string& player_id) {
@@ -62,15 +63,24 @@ std::string exp3::select_arm(const std::string& player_id) {
         common::exception::runtime_error("arm is not registered"));
   }
 
-  std::vector<double> weights;
-  calc_weights_(player_id, weights);
-  return arms[select_by_weights(weights, rand_)];
+  // Arm i is selected with a probability proportional to
+  // (1 - gamma) * w_i / sum(w) + gamma * n; draw from the uniform part or
+  // from the cached weights according to their total mass.
+  cache_weights_(player_id);
+  const size_t n = arms.size();
+  const double uniform = gamma_ * n * n;
+  if (rand_.next_double((1.0 - gamma_) + uniform) < uniform) {
+    return arms[rand_.next_int(n)];
+  }
+  return arms[sampler_.select(player_id, rand_)];
 }
 
 bool exp3::register_arm(const std::string& arm_id) {
+  sampler_.clear();
   return s_.register_arm(arm_id);
 }
 bool exp3::delete_arm(const std::string& arm_id) {
+  sampler_.clear();
   return s_.delete_arm(arm_id);
 }
 
@@ -78,14 +88,19 @@ bool exp3::register_reward(const std::string& player_id,
                            const std::string& arm_id,
                            double reward) {
   const std::vector<std::string>& arms = s_.get_arm_ids();
-  size_t i = std::find(arms.begin(), arms.end(), arm_id) - arms.begin();
+  const size_t i = s_.get_arm_index(arm_id);
   if (i >= arms.size()) {
     return false;
   }
-  std::vector<double> weights;
-  calc_weights_(player_id, weights);
-  return s_.register_reward(player_id, arm_id,
-                            reward * weights[i] * gamma_ / arms.size());
+  cache_weights_(player_id);
+  const size_t n = arms.size();
+  const double p = (1.0 - gamma_) * sampler_.get_weight(player_id, i)
+      / sampler_.get_total(player_id) + gamma_ * n;
+  const bool result =
+      s_.register_reward(player_id, arm_id, reward * p * gamma_ / n);
+  sampler_.update(player_id, i,
+                  std::exp(s_.get_arm_info(player_id, arm_id).weight));
+  return result;
 }
 
 arm_info_map exp3::get_arm_info(const std::string& arm_id) const {
@@ -93,9 +108,11 @@ arm_info_map exp3::get_arm_info(const std::string& arm_id) const {
 }
 
 bool exp3::reset(const std::string& player_id) {
+  sampler_.erase(player_id);
   return s_.reset(player_id);
 }
 void exp3::clear() {
+  sampler_.clear();
   s_.clear();
 }
 
@@ -103,6 +120,7 @@ void exp3::pack(framework::packer& pk) const {
   pk.pack(s_);
 }
 void exp3::unpack(msgpack::object o) {
+  sampler_.clear();
   o.convert(&s_);
 }
 
@@ -110,6 +128,7 @@ void exp3::get_diff(diff_t& diff) const {
   s_.get_diff(diff);
 }
 bool exp3::put_diff(const diff_t& diff) {
+  sampler_.erase_players(diff);
   return s_.put_diff(diff);
 }
 void exp3::mix(const diff_t& lhs, diff_t& rhs) const {
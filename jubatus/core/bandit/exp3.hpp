@@ -22,6 +22,7 @@
 
 #include "bandit_base.hpp"
 #include "summation_storage.hpp"
+#include "weighted_sampler.hpp"
 #include "jubatus/util/math/random.h"
 
 namespace jubatus {
@@ -31,6 +32,7 @@ namespace bandit {
 class exp3 : public bandit_base {
  public:
   explicit exp3(double gamma);
+  exp3(double gamma, uint32_t seed);
 
   std::string select_arm(const std::string& player_id);
 
@@ -61,9 +63,9 @@ class exp3 : public bandit_base {
   double gamma_;
   jubatus::util::math::random::mtrand rand_;
   summation_storage s_;
+  weighted_sampler sampler_;  // caches exp(weight) of arms
 
-  void calc_weights_(const std::string& player_id,
-                     std::vector<double>& weights) const;
+  void cache_weights_(const std::string& player_id);
 };
 
 }  // namespace bandit
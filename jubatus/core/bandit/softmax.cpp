@@ -21,7 +21,6 @@
 #include <cmath>
 #include <numeric>
 #include "../common/exception.hpp"
-#include "select_by_weights.hpp"
 
 namespace jubatus {
 namespace core {
@@ -35,6 +34,14 @@ softmax::softmax(double tau)
   }
 }
 
+softmax::softmax(double tau, uint32_t seed)
+    : tau_(tau), rand_(seed) {
+  if (tau <= 0) {
+    throw JUBATUS_EXCEPTION(
+        common::invalid_parameter("0 < tau"));
+  }
+}
+
 std::string softmax::select_arm(const std::string& player_id) {
   const std::vector<std::string>& arms = s_.get_arm_ids();
   if (arms.empty()) {
@@ -42,27 +49,43 @@ std::string softmax::select_arm(const std::string& player_id) {
         common::exception::runtime_error("arm is not registered"));
   }
 
-  std::vector<double> weights;
-  weights.reserve(arms.size());
+  if (!sampler_.has_player(player_id)) {
+    std::vector<arm_info> infos;
+    s_.get_arm_infos(player_id, infos);
 
-  for (size_t i = 0; i < arms.size(); ++i) {
-    double expectation = s_.get_expectation(player_id, arms[i]);
-    weights.push_back(std::exp(expectation / tau_));
+    std::vector<double> weights;
+    weights.reserve(arms.size());
+    for (size_t i = 0; i < arms.size(); ++i) {
+      weights.push_back(weight_of(infos[i]));
+    }
+    sampler_.set_weights(player_id, weights);
   }
-  return arms[select_by_weights(weights, rand_)];
+  return arms[sampler_.select(player_id, rand_)];
+}
+
+double softmax::weight_of(const arm_info& a) const {
+  return std::exp(expectation_of(a) / tau_);
 }
 
 bool softmax::register_arm(const std::string& arm_id) {
+  sampler_.clear();
   return s_.register_arm(arm_id);
 }
 bool softmax::delete_arm(const std::string& arm_id) {
+  sampler_.clear();
   return s_.delete_arm(arm_id);
 }
 
 bool softmax::register_reward(const std::string& player_id,
                                      const std::string& arm_id,
                                      double reward) {
-  return s_.register_reward(player_id, arm_id, reward);
+  const bool result = s_.register_reward(player_id, arm_id, reward);
+  const size_t i = s_.get_arm_index(arm_id);
+  if (i < s_.get_arm_ids().size()) {
+    sampler_.update(player_id, i,
+                    weight_of(s_.get_arm_info(player_id, arm_id)));
+  }
+  return result;
 }
 
 arm_info_map softmax::get_arm_info(const std::string& arm_id) const {
@@ -70,9 +93,11 @@ arm_info_map softmax::get_arm_info(const std::string& arm_id) const {
 }
 
 bool softmax::reset(const std::string& player_id) {
+  sampler_.erase(player_id);
   return s_.reset(player_id);
 }
 void softmax::clear() {
+  sampler_.clear();
   s_.clear();
 }
 
@@ -80,6 +105,7 @@ void softmax::pack(framework::packer& pk) const {
   pk.pack(s_);
 }
 void softmax::unpack(msgpack::object o) {
+  sampler_.clear();
   o.convert(&s_);
 }
 
@@ -87,6 +113,7 @@ void softmax::get_diff(diff_t& diff) const {
   s_.get_diff(diff);
 }
 bool softmax::put_diff(const diff_t& diff) {
+  sampler_.erase_players(diff);
   return s_.put_diff(diff);
 }
 void softmax::mix(const diff_t& lhs, diff_t& rhs) const {
@@ -21,6 +21,7 @@
 
 #include "bandit_base.hpp"
 #include "summation_storage.hpp"
+#include "weighted_sampler.hpp"
 #include "jubatus/util/math/random.h"
 
 namespace jubatus {
@@ -30,6 +31,7 @@ namespace bandit {
 class softmax : public bandit_base {
  public:
   explicit softmax(double tau);
+  softmax(double tau, uint32_t seed);
 
   std::string select_arm(const std::string& player_id);
 
@@ -57,9 +59,12 @@ class softmax : public bandit_base {
   void mix(const diff_t& lhs, diff_t& rhs) const;
 
  private:
+  double weight_of(const arm_info& a) const;
+
   double tau_;
   jubatus::util::math::random::mtrand rand_;
   summation_storage s_;
+  weighted_sampler sampler_;
 };
 
 }  // namespace bandit
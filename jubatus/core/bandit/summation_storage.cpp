@@ -17,44 +17,111 @@
 #include "summation_storage.hpp"
 
 #include <string>
+#include <utility>
 #include <vector>
 
 namespace jubatus {
 namespace core {
 namespace bandit {
 
+namespace {
+
+const size_t NOT_FOUND = static_cast<size_t>(-1);
+
+bool is_empty(const arm_info& a) {
+  return a.trial_count == 0 && a.weight == 0;
+}
+
+void add(arm_info& a0, const arm_info& a1) {
+  a0.trial_count += a1.trial_count;
+  a0.weight += a1.weight;
+}
+
+}  // namespace
+
 summation_storage::summation_storage() {
 }
 
+size_t summation_storage::get_slot(const std::string& arm_id) {
+  jubatus::util::data::unordered_map<std::string, size_t>::const_iterator
+      iter = slot_index_.find(arm_id);
+  if (iter != slot_index_.end()) {
+    return iter->second;
+  }
+  const size_t slot = slot_names_.size();
+  slot_index_.insert(std::make_pair(arm_id, slot));
+  slot_names_.push_back(arm_id);
+  return slot;
+}
+
+size_t summation_storage::find_slot(const std::string& arm_id) const {
+  jubatus::util::data::unordered_map<std::string, size_t>::const_iterator
+      iter = slot_index_.find(arm_id);
+  if (iter == slot_index_.end()) {
+    return NOT_FOUND;
+  }
+  return iter->second;
+}
+
+void summation_storage::update_slot_positions() {
+  slot_positions_.assign(slot_names_.size(), NOT_FOUND);
+  for (size_t i = 0; i < arm_slots_.size(); ++i) {
+    slot_positions_[arm_slots_[i]] = i;
+  }
+}
+
+size_t summation_storage::get_arm_index(const std::string& arm_id) const {
+  const size_t slot = find_slot(arm_id);
+  if (slot >= slot_positions_.size() || slot_positions_[slot] == NOT_FOUND) {
+    return arm_ids_.size();
+  }
+  return slot_positions_[slot];
+}
+
+const summation_storage::arm_entry* summation_storage::find_entry(
+    const std::string& player_id,
+    const std::string& arm_id) const {
+  player_table_t::const_iterator iter = players_.find(player_id);
+  if (iter == players_.end()) {
+    return NULL;
+  }
+  const size_t slot = find_slot(arm_id);
+  if (slot >= iter->second.arms.size()) {
+    return NULL;
+  }
+  return &iter->second.arms[slot];
+}
+
 bool summation_storage::register_arm(const std::string& arm_id) {
-  if (std::find(arm_ids_.begin(), arm_ids_.end(), arm_id) != arm_ids_.end()) {
+  if (get_arm_index(arm_id) < arm_ids_.size()) {
     // arm_id is already in arms_
     return false;
   }
   arm_ids_.push_back(arm_id);
+  arm_slots_.push_back(get_slot(arm_id));
+  update_slot_positions();
   return true;
 }
 
-namespace {
-void delete_arm_(summation_storage::table_t& t, const std::string& arm_id) {
-  for (summation_storage::table_t::iterator iter = t.begin();
-       iter != t.end(); ++iter) {
-    arm_info_map& as = iter->second;
-    as.erase(arm_id);
-  }
-}
-}  // namespace
-
 bool summation_storage::delete_arm(const std::string& arm_id) {
-  delete_arm_(mixed_, arm_id);
-  delete_arm_(unmixed_, arm_id);
+  const size_t slot = find_slot(arm_id);
+  if (slot != NOT_FOUND) {
+    for (player_table_t::iterator iter = players_.begin();
+         iter != players_.end(); ++iter) {
+      std::vector<arm_entry>& arms = iter->second.arms;
+      if (slot < arms.size()) {
+        arms[slot] = arm_entry();
+      }
+    }
+  }
 
-  std::vector<std::string>::iterator iter =
-      std::remove(arm_ids_.begin(), arm_ids_.end(), arm_id);
-  if (iter == arm_ids_.end()) {
+  const size_t i = get_arm_index(arm_id);
+  if (i >= arm_ids_.size()) {
     return false;
   }
-  arm_ids_.erase(iter, arm_ids_.end());
+  arm_slots_.erase(arm_slots_.begin() + i);
+  arm_ids_.erase(arm_ids_.begin() + i);
+  update_slot_positions();
   return true;
 }
 
@@ -62,74 +129,106 @@ bool summation_storage::register_reward(
     const std::string& player_id,
     const std::string& arm_id,
     double reward) {
-  arm_info_map& as = unmixed_[player_id];
-  arm_info& a = as[arm_id];
+  const size_t slot = get_slot(arm_id);
+  player_entry& p = players_[player_id];
+  if (p.arms.size() <= slot) {
+    p.arms.resize(slot_names_.size());
+  }
+  arm_info& a = p.arms[slot].unmixed;
   a.trial_count += 1;
   a.weight += reward;
-  return true;
-}
-
-namespace {
-arm_info get_arm_info_(
-    const summation_storage::table_t& t,
-    const std::string& player_id,
-    const std::string& arm_id) {
-  summation_storage::table_t::const_iterator iter = t.find(player_id);
-  if (iter == t.end()) {
-    const arm_info a0 = {0, 0.0};
-    return a0;
+  if (!p.has_unmixed) {
+    p.has_unmixed = true;
+    unmixed_players_.push_back(player_id);
   }
-  const arm_info_map& as = iter->second;
-  arm_info_map::const_iterator jter = as.find(arm_id);
-  if (jter == as.end()) {
-    const arm_info a0 = {0, 0.0};
-    return a0;
-  }
-  return jter->second;
+  return true;
 }
-}  // namespace
 
 arm_info summation_storage::get_arm_info(
     const std::string& player_id,
     const std::string& arm_id) const {
-  const arm_info a1 = get_arm_info_(mixed_, player_id, arm_id);
-  const arm_info a2 = get_arm_info_(unmixed_, player_id, arm_id);
-
-  arm_info result;
-  result.trial_count = a1.trial_count + a2.trial_count;
-  result.weight = a1.weight + a2.weight;
+  arm_info result = {0, 0.0};
+  const arm_entry* e = find_entry(player_id, arm_id);
+  if (e) {
+    add(result, e->mixed);
+    add(result, e->unmixed);
+  }
   return result;
 }
 
 double summation_storage::get_expectation(
     const std::string& player_id,
     const std::string& arm_id) const {
-  const arm_info a = get_arm_info(player_id, arm_id);
-  if (a.trial_count == 0) {
-    return 0;
-  }
-  return a.weight / a.trial_count;
+  return expectation_of(get_arm_info(player_id, arm_id));
 }
 
 arm_info_map summation_storage::get_arm_info_map(
     const std::string& player_id) const {
   arm_info_map result;
 
-  for (std::vector<std::string>::const_iterator iter = arm_ids_.begin();
-       iter != arm_ids_.end(); ++iter) {
-    result.insert(std::make_pair(*iter, get_arm_info(player_id, *iter)));
+  std::vector<arm_info> infos;
+  get_arm_infos(player_id, infos);
+  for (size_t i = 0; i < arm_ids_.size(); ++i) {
+    result.insert(std::make_pair(arm_ids_[i], infos[i]));
   }
 
   return result;
 }
 
+void summation_storage::get_arm_infos(
+    const std::string& player_id,
+    std::vector<arm_info>& infos) const {
+  const arm_info a0 = {0, 0.0};
+  infos.assign(arm_ids_.size(), a0);
+
+  player_table_t::const_iterator iter = players_.find(player_id);
+  if (iter == players_.end()) {
+    return;
+  }
+  const std::vector<arm_entry>& arms = iter->second.arms;
+  for (size_t i = 0; i < arm_slots_.size(); ++i) {
+    const size_t slot = arm_slots_[i];
+    if (slot < arms.size()) {
+      add(infos[i], arms[slot].mixed);
+      add(infos[i], arms[slot].unmixed);
+    }
+  }
+}
+
 void summation_storage::get_diff(table_t& diff) const {
-  diff = unmixed_;
+  diff.clear();
+  for (size_t i = 0; i < unmixed_players_.size(); ++i) {
+    player_table_t::const_iterator iter = players_.find(unmixed_players_[i]);
+    if (iter == players_.end() || !iter->second.has_unmixed) {
+      // reset after the update
+      continue;
+    }
+    arm_info_map& as = diff[iter->first];
+    const std::vector<arm_entry>& arms = iter->second.arms;
+    for (size_t slot = 0; slot < arms.size(); ++slot) {
+      if (!is_empty(arms[slot].unmixed)) {
+        as[slot_names_[slot]] = arms[slot].unmixed;
+      }
+    }
+  }
 }
 
 bool summation_storage::put_diff(const table_t& diff) {
-  mix(diff, mixed_);
-  unmixed_.clear();
+  const arm_info a0 = {0, 0.0};
+  for (size_t i = 0; i < unmixed_players_.size(); ++i) {
+    player_table_t::iterator iter = players_.find(unmixed_players_[i]);
+    if (iter == players_.end()) {
+      continue;
+    }
+    std::vector<arm_entry>& arms = iter->second.arms;
+    for (size_t slot = 0; slot < arms.size(); ++slot) {
+      arms[slot].unmixed = a0;
+    }
+    iter->second.has_unmixed = false;
+  }
+  unmixed_players_.clear();
+
+  add_table(diff, false);
   return true;
 }
 
@@ -140,23 +239,78 @@ void summation_storage::mix(const table_t& lhs, table_t& rhs) {
     const arm_info_map& as1 = iter->second;
     for (arm_info_map::const_iterator jter = as1.begin();
          jter != as1.end(); ++jter) {
-      arm_info& a0 = as0[jter->first];
-      const arm_info& a1 = jter->second;
-      a0.trial_count += a1.trial_count;
-      a0.weight += a1.weight;
+      add(as0[jter->first], jter->second);
     }
   }
 }
 
 bool summation_storage::reset(const std::string& player_id) {
-  bool result1 = mixed_.erase(player_id) > 0;
-  bool result2 = unmixed_.erase(player_id) > 0;
-  return result1 || result2;
+  return players_.erase(player_id) > 0;
 }
 
 void summation_storage::clear() {
-  mixed_.clear();
-  unmixed_.clear();
+  players_.clear();
+  unmixed_players_.clear();
+}
+
+void summation_storage::msgpack_unpack(msgpack::object o) {
+  std::vector<std::string> arm_ids;
+  table_t mixed, unmixed;
+  msgpack::type::make_define(arm_ids, mixed, unmixed).msgpack_unpack(o);
+
+  arm_ids_.clear();
+  arm_slots_.clear();
+  slot_positions_.clear();
+  slot_index_.clear();
+  slot_names_.clear();
+  clear();
+  for (size_t i = 0; i < arm_ids.size(); ++i) {
+    register_arm(arm_ids[i]);
+  }
+  add_table(mixed, false);
+  add_table(unmixed, true);
+}
+
+void summation_storage::to_table(bool unmixed, table_t& table) const {
+  table.clear();
+  for (player_table_t::const_iterator iter = players_.begin();
+       iter != players_.end(); ++iter) {
+    if (unmixed && !iter->second.has_unmixed) {
+      continue;
+    }
+    const std::vector<arm_entry>& arms = iter->second.arms;
+    arm_info_map* as = NULL;
+    for (size_t slot = 0; slot < arms.size(); ++slot) {
+      const arm_info& a = unmixed ? arms[slot].unmixed : arms[slot].mixed;
+      if (is_empty(a)) {
+        continue;
+      }
+      if (!as) {
+        as = &table[iter->first];
+      }
+      (*as)[slot_names_[slot]] = a;
+    }
+  }
+}
+
+void summation_storage::add_table(const table_t& table, bool unmixed) {
+  for (table_t::const_iterator iter = table.begin();
+       iter != table.end(); ++iter) {
+    player_entry& p = players_[iter->first];
+    const arm_info_map& as = iter->second;
+    for (arm_info_map::const_iterator jter = as.begin();
+         jter != as.end(); ++jter) {
+      const size_t slot = get_slot(jter->first);
+      if (p.arms.size() <= slot) {
+        p.arms.resize(slot_names_.size());
+      }
+      add(unmixed ? p.arms[slot].unmixed : p.arms[slot].mixed, jter->second);
+    }
+    if (unmixed && !p.has_unmixed) {
+      p.has_unmixed = true;
+      unmixed_players_.push_back(iter->first);
+    }
+  }
 }
 
 }  // namespace bandit
@@ -20,12 +20,16 @@
 #include <string>
 #include <vector>
 
+#include "jubatus/util/data/unordered_map.h"
 #include "bandit_base.hpp"
 
 namespace jubatus {
 namespace core {
 namespace bandit {
 
+// Arm ids are interned to dense slots, and each player has a contiguous
+// array of statistics indexed by slot.  Mixed and unmixed values are kept
+// side by side and summed on read.
 class summation_storage {
  public:
   typedef bandit_base::diff_t table_t;
@@ -49,6 +53,14 @@ class summation_storage {
   }
   arm_info_map get_arm_info_map(const std::string& player_id) const;
 
+  // position of arm_id in get_arm_ids(), or get_arm_ids().size() if it is
+  // not registered
+  size_t get_arm_index(const std::string& arm_id) const;
+
+  // statistics of all arms in the order of get_arm_ids()
+  void get_arm_infos(const std::string& player_id,
+                     std::vector<arm_info>& infos) const;
+
   void get_diff(table_t& diff) const;
   bool put_diff(const table_t& diff);
   static void mix(const table_t& lhs, table_t& rhs);
@@ -56,11 +68,57 @@ class summation_storage {
   bool reset(const std::string& player_id);
   void clear();
 
-  MSGPACK_DEFINE(arm_ids_, mixed_, unmixed_);
+  template<class Packer>
+  void msgpack_pack(Packer& pk) const {
+    table_t mixed, unmixed;
+    to_table(false, mixed);
+    to_table(true, unmixed);
+    msgpack::type::make_define(arm_ids_, mixed, unmixed).msgpack_pack(pk);
+  }
+  void msgpack_unpack(msgpack::object o);
 
  private:
+  struct arm_entry {
+    arm_entry() {
+      mixed.trial_count = 0;
+      mixed.weight = 0;
+      unmixed.trial_count = 0;
+      unmixed.weight = 0;
+    }
+
+    arm_info mixed;
+    arm_info unmixed;
+  };
+
+  struct player_entry {
+    player_entry() : has_unmixed(false) {
+    }
+
+    std::vector<arm_entry> arms;  // indexed by slot
+    bool has_unmixed;
+  };
+
+  typedef jubatus::util::data::unordered_map<std::string, player_entry>
+      player_table_t;
+
+  size_t get_slot(const std::string& arm_id);
+  size_t find_slot(const std::string& arm_id) const;
+  void update_slot_positions();
+  const arm_entry* find_entry(const std::string& player_id,
+                              const std::string& arm_id) const;
+  void to_table(bool unmixed, table_t& table) const;
+  void add_table(const table_t& table, bool unmixed);
+
   std::vector<std::string> arm_ids_;
-  table_t mixed_, unmixed_;
+  std::vector<size_t> arm_slots_;  // slots of arm_ids_
+  std::vector<size_t> slot_positions_;  // inverse of arm_slots_
+
+  // slots are never released; statistics of a deleted arm are zeroed
+  jubatus::util::data::unordered_map<std::string, size_t> slot_index_;
+  std::vector<std::string> slot_names_;
+
+  player_table_t players_;
+  std::vector<std::string> unmixed_players_;
 };
 
 }  // namespace bandit
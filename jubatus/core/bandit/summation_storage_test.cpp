@@ -17,6 +17,7 @@
 #include "summation_storage.hpp"
 
 #include <string>
+#include <vector>
 
 #include <gtest/gtest.h>
 
@@ -149,6 +150,66 @@ TEST(storage, mix) {
   }
 }
 
+TEST(summation_storage, get_arm_infos) {
+  summation_storage s;
+  s.register_arm("hoge");
+  s.register_arm("fuga");
+  s.register_reward("player1", "fuga", 1.0);
+  s.register_reward("player1", "piyo", 1.0);
+
+  std::vector<arm_info> infos;
+  s.get_arm_infos("player1", infos);
+  ASSERT_EQ(2u, infos.size());
+  EXPECT_EQ(0, infos[0].trial_count);
+  EXPECT_EQ(1, infos[1].trial_count);
+
+  // statistics of an unregistered arm appear once it is registered
+  s.register_arm("piyo");
+  s.delete_arm("hoge");
+  s.get_arm_infos("player1", infos);
+  ASSERT_EQ(2u, infos.size());
+  EXPECT_EQ(1, infos[0].trial_count);
+  EXPECT_EQ(1.0, infos[1].weight);
+
+  // statistics of a deleted arm are cleared
+  s.register_reward("player1", "hoge", 1.0);
+  s.delete_arm("hoge");
+  s.register_arm("hoge");
+  EXPECT_EQ(0, s.get_arm_info("player1", "hoge").trial_count);
+
+  s.get_arm_infos("player2", infos);
+  ASSERT_EQ(3u, infos.size());
+  EXPECT_EQ(0, infos[0].trial_count);
+}
+
+TEST(summation_storage, pack_and_unpack) {
+  summation_storage s1;
+  s1.register_arm("hoge");
+  s1.register_reward("player1", "hoge", 1.0);
+  summation_storage::table_t diff;
+  s1.get_diff(diff);
+  s1.put_diff(diff);
+  s1.register_reward("player1", "hoge", 0.0);
+  s1.register_reward("player2", "fuga", 1.0);
+
+  msgpack::sbuffer buf;
+  msgpack::pack(buf, s1);
+  msgpack::unpacked unpacked;
+  msgpack::unpack(&unpacked, buf.data(), buf.size());
+  summation_storage s2;
+  unpacked.get().convert(&s2);
+
+  ASSERT_EQ(1u, s2.get_arm_ids().size());
+  EXPECT_EQ(2, s2.get_arm_info("player1", "hoge").trial_count);
+  EXPECT_EQ(1.0, s2.get_arm_info("player2", "fuga").weight);
+
+  // only the unmixed part is in the diff
+  s2.get_diff(diff);
+  ASSERT_EQ(2u, diff.size());
+  EXPECT_EQ(1, diff["player1"]["hoge"].trial_count);
+  EXPECT_EQ(0.0, diff["player1"]["hoge"].weight);
+}
+
 }  // namespace bandit
 }  // namespace core
 }  // namespace jubatus
@@ -38,10 +38,13 @@ std::string ts::select_arm(const std::string& player_id) {
         common::exception::runtime_error("arm is not registered"));
   }
 
+  std::vector<arm_info> infos;
+  s_.get_arm_infos(player_id, infos);
+
   double score_max = -DBL_MAX;
   std::string result;
   for (size_t i = 0; i < arms.size(); ++i) {
-    const arm_info& a = s_.get_arm_info(player_id, arms[i]);
+    const arm_info& a = infos[i];
     double alpha = a.weight + 1.0;
     double beta = a.trial_count - a.weight + 1.0;
     double score = rand_.next_beta(alpha, beta);
@@ -69,8 +72,7 @@ bool ts::register_reward(const std::string& player_id,
         common::exception::runtime_error("reward is not in {0,1}")); //Thompson sampling assumes binary rewards
   }
   const std::vector<std::string>& arms = s_.get_arm_ids();
-  size_t i = std::find(arms.begin(), arms.end(), arm_id) - arms.begin();
-  if (i >= arms.size()) {
+  if (s_.get_arm_index(arm_id) >= arms.size()) {
     return false;
   }
   return s_.register_reward(player_id, arm_id, reward);
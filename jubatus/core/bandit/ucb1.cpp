@@ -35,9 +35,12 @@ std::string ucb1::select_arm(const std::string& player_id) {
         common::exception::runtime_error("arm is not registered"));
   }
 
+  std::vector<arm_info> infos;
+  s_.get_arm_infos(player_id, infos);
+
   int total_trial = 0;
   for (size_t i = 0; i < arms.size(); ++i) {
-    const arm_info& a = s_.get_arm_info(player_id, arms[i]);
+    const arm_info& a = infos[i];
     if (a.trial_count == 0) {
       return arms[i];
     }
@@ -48,7 +51,7 @@ std::string ucb1::select_arm(const std::string& player_id) {
   double score_max = -DBL_MAX;
   std::string result;
   for (size_t i = 0; i < arms.size(); ++i) {
-    const arm_info& a = s_.get_arm_info(player_id, arms[i]);
+    const arm_info& a = infos[i];
     double exp = a.weight / a.trial_count;
     double score = exp + std::sqrt(2 * log_total_trial / a.trial_count);
     if (score > score_max) {
@@ -0,0 +1,146 @@
+// Jubatus: Online machine learning framework for distributed environment
+// Copyright (C) 2015 Preferred Networks and Nippon Telegraph and Telephone Corporation.
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License version 2.1 as published by the Free Software Foundation.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+
+#include "weighted_sampler.hpp"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "../common/exception.hpp"
+
+using jubatus::util::math::random::mtrand;
+
+namespace jubatus {
+namespace core {
+namespace bandit {
+
+const size_t weighted_sampler::DEFAULT_MAX_WEIGHTS = 1 << 22;
+
+weighted_sampler::entry::entry(const std::vector<double>& w)
+    : weights(w),
+      tree(w.size()),
+      update_count(0) {
+  for (size_t i = 0; i < weights.size(); ++i) {
+    tree.increase(i, weights[i]);
+  }
+}
+
+void weighted_sampler::entry::rebuild() {
+  jubatus::util::data::fenwick_tree<double> t(weights.size());
+  for (size_t i = 0; i < weights.size(); ++i) {
+    t.increase(i, weights[i]);
+  }
+  tree = t;
+  update_count = 0;
+}
+
+weighted_sampler::weighted_sampler(size_t max_weights)
+    : max_weights_(max_weights),
+      weight_count_(0) {
+}
+
+bool weighted_sampler::has_player(const std::string& player_id) const {
+  return players_.count(player_id) > 0;
+}
+
+void weighted_sampler::set_weights(
+    const std::string& player_id,
+    const std::vector<double>& weights) {
+  erase(player_id);
+  while (!players_.empty() &&
+         weight_count_ + weights.size() > max_weights_) {
+    weight_count_ -= players_.begin()->second.weights.size();
+    players_.erase(players_.begin());
+  }
+  players_.insert(std::make_pair(player_id, entry(weights)));
+  weight_count_ += weights.size();
+}
+
+void weighted_sampler::update(
+    const std::string& player_id,
+    size_t arm,
+    double weight) {
+  table_t::iterator it = players_.find(player_id);
+  if (it == players_.end()) {
+    return;
+  }
+  entry& e = it->second;
+  e.tree.increase(arm, weight - e.weights[arm]);
+  e.weights[arm] = weight;
+
+  // recompute sums from scratch once in a while, as errors accumulate
+  if (++e.update_count > e.weights.size()) {
+    e.rebuild();
+  }
+}
+
+double weighted_sampler::get_weight(
+    const std::string& player_id,
+    size_t arm) const {
+  return get_entry(player_id).weights[arm];
+}
+
+double weighted_sampler::get_total(const std::string& player_id) const {
+  const entry& e = get_entry(player_id);
+  return e.tree.query(e.tree.size() - 1);
+}
+
+size_t weighted_sampler::select(
+    const std::string& player_id,
+    mtrand& rand) const {
+  const entry& e = get_entry(player_id);
+  const int n = e.tree.size();
+  const double x = rand.next_double(e.tree.query(n - 1));
+  const int i = e.tree.upper_bound(x);
+  return i < n ? i : n - 1;
+}
+
+void weighted_sampler::erase(const std::string& player_id) {
+  table_t::iterator it = players_.find(player_id);
+  if (it != players_.end()) {
+    weight_count_ -= it->second.weights.size();
+    players_.erase(it);
+  }
+}
+
+void weighted_sampler::erase_players(const bandit_base::diff_t& diff) {
+  for (bandit_base::diff_t::const_iterator it = diff.begin();
+       it != diff.end(); ++it) {
+    erase(it->first);
+  }
+}
+
+void weighted_sampler::clear() {
+  players_.clear();
+  weight_count_ = 0;
+}
+
+const weighted_sampler::entry& weighted_sampler::get_entry(
+    const std::string& player_id) const {
+  table_t::const_iterator it = players_.find(player_id);
+  if (it == players_.end()) {
+    throw JUBATUS_EXCEPTION(
+        common::exception::runtime_error("player is not cached")
+        << common::exception::error_message("player id: " + player_id));
+  }
+  return it->second;
+}
+
+}  // namespace bandit
+}  // namespace core
+}  // namespace jubatus
@@ -0,0 +1,83 @@
+// Jubatus: Online machine learning framework for distributed environment
+// Copyright (C) 2015 Preferred Networks and Nippon Telegraph and Telephone Corporation.
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License version 2.1 as published by the Free Software Foundation.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+
+#ifndef JUBATUS_CORE_BANDIT_WEIGHTED_SAMPLER_HPP_
+#define JUBATUS_CORE_BANDIT_WEIGHTED_SAMPLER_HPP_
+
+#include <string>
+#include <vector>
+
+#include "jubatus/util/data/fenwick_tree.h"
+#include "jubatus/util/data/unordered_map.h"
+#include "jubatus/util/math/random.h"
+#include "bandit_base.hpp"
+
+namespace jubatus {
+namespace core {
+namespace bandit {
+
+// Caches weights of arms per player in Fenwick trees, so that selecting an
+// arm and updating the weight of an arm take O(log n).  Players are evicted
+// when the total number of cached weights exceeds max_weights.
+class weighted_sampler {
+ public:
+  static const size_t DEFAULT_MAX_WEIGHTS;
+
+  explicit weighted_sampler(size_t max_weights = DEFAULT_MAX_WEIGHTS);
+
+  bool has_player(const std::string& player_id) const;
+  void set_weights(const std::string& player_id,
+                   const std::vector<double>& weights);
+
+  // does nothing when player_id is not cached
+  void update(const std::string& player_id, size_t arm, double weight);
+
+  // player_id must be cached for these methods
+  double get_weight(const std::string& player_id, size_t arm) const;
+  double get_total(const std::string& player_id) const;
+  size_t select(const std::string& player_id,
+                jubatus::util::math::random::mtrand& rand) const;
+
+  void erase(const std::string& player_id);
+  // erases players whose statistics are updated by the MIX
+  void erase_players(const bandit_base::diff_t& diff);
+  void clear();
+
+ private:
+  struct entry {
+    explicit entry(const std::vector<double>& w);
+    void rebuild();
+
+    std::vector<double> weights;
+    jubatus::util::data::fenwick_tree<double> tree;
+    size_t update_count;
+  };
+
+  typedef jubatus::util::data::unordered_map<std::string, entry> table_t;
+
+  const entry& get_entry(const std::string& player_id) const;
+
+  table_t players_;
+  size_t max_weights_;
+  size_t weight_count_;
+};
+
+}  // namespace bandit
+}  // namespace core
+}  // namespace jubatus
+
+#endif  // JUBATUS_CORE_BANDIT_WEIGHTED_SAMPLER_HPP_
@@ -0,0 +1,93 @@
+// Jubatus: Online machine learning framework for distributed environment
+// Copyright (C) 2015 Preferred Networks and Nippon Telegraph and Telephone Corporation.
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License version 2.1 as published by the Free Software Foundation.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+
+#include "weighted_sampler.hpp"
+
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using jubatus::util::math::random::mtrand;
+
+namespace jubatus {
+namespace core {
+namespace bandit {
+
+TEST(weighted_sampler, select) {
+  weighted_sampler s;
+  std::vector<double> w;
+  w.push_back(1.0);
+  w.push_back(0.0);
+  w.push_back(3.0);
+  s.set_weights("player1", w);
+  ASSERT_TRUE(s.has_player("player1"));
+  EXPECT_FALSE(s.has_player("player2"));
+  EXPECT_DOUBLE_EQ(4.0, s.get_total("player1"));
+
+  mtrand rand(0);
+  std::vector<int> count(3);
+  for (int i = 0; i < 4000; ++i) {
+    ++count[s.select("player1", rand)];
+  }
+  EXPECT_EQ(0, count[1]);
+  EXPECT_LT(800, count[0]);
+  EXPECT_GT(1200, count[0]);
+
+  s.update("player1", 0, 0.0);
+  s.update("player1", 1, 2.0);
+  EXPECT_DOUBLE_EQ(5.0, s.get_total("player1"));
+  EXPECT_DOUBLE_EQ(2.0, s.get_weight("player1", 1));
+  for (int i = 0; i < 100; ++i) {
+    EXPECT_NE(0u, s.select("player1", rand));
+  }
+
+  // not cached
+  s.update("player2", 0, 1.0);
+  EXPECT_FALSE(s.has_player("player2"));
+}
+
+TEST(weighted_sampler, evict) {
+  weighted_sampler s(4);
+  std::vector<double> w(3, 1.0);
+  s.set_weights("player1", w);
+  s.set_weights("player2", w);
+  EXPECT_FALSE(s.has_player("player1"));
+  EXPECT_TRUE(s.has_player("player2"));
+
+  bandit_base::diff_t diff;
+  diff["player2"];
+  s.erase_players(diff);
+  EXPECT_FALSE(s.has_player("player2"));
+}
+
+TEST(weighted_sampler, fenwick_tree_upper_bound) {
+  jubatus::util::data::fenwick_tree<double> t(5);
+  t.increase(0, 1.0);
+  t.increase(2, 2.0);
+  t.increase(4, 1.0);
+  EXPECT_EQ(0, t.upper_bound(0.0));
+  EXPECT_EQ(0, t.upper_bound(0.5));
+  EXPECT_EQ(2, t.upper_bound(1.0));
+  EXPECT_EQ(2, t.upper_bound(2.5));
+  EXPECT_EQ(4, t.upper_bound(3.0));
+  EXPECT_EQ(5, t.upper_bound(4.0));
+}
+
+}  // namespace bandit
+}  // namespace core
+}  // namespace jubatus
@@ -0,0 +1,96 @@
+// Jubatus: Online machine learning framework for distributed environment
+// Copyright (C) 2015 Preferred Networks and Nippon Telegraph and Telephone Corporation.
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License version 2.1 as published by the Free Software Foundation.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+#include <string>
+#include <vector>
+#include "jubatus/util/lang/cast.h"
+#include "jubatus/util/lang/shared_ptr.h"
+#include "../anomaly/lof.hpp"
+#include "../anomaly/lof_storage.hpp"
+#include "../recommender/euclid_lsh.hpp"
+#include "benchmark.hpp"
+
+using std::string;
+using std::vector;
+using jubatus::util::lang::lexical_cast;
+using jubatus::util::lang::shared_ptr;
+using jubatus::util::math::random::mtrand;
+using jubatus::core::anomaly::lof;
+using jubatus::core::anomaly::lof_storage;
+
+namespace jubatus {
+namespace core {
+namespace bench {
+namespace {
+
+const size_t num_rows = 1000;
+const size_t dimension = 1000;
+
+// Updates rows of, or scores queries against, a LOF model of |num_rows|
+// rows; updates go to existing rows so that the number of rows stays fixed.
+class lof_bench : public benchmark {
+ public:
+  explicit lof_bench(bool add)
+      : benchmark(add ? "anomaly/lof/add" : "anomaly/lof/score"),
+        add_(add) {
+  }
+
+  void set_up(mtrand& rand) {
+    lof_.reset(new lof(
+        lof_storage::config(),
+        shared_ptr<recommender::recommender_base>(
+            new recommender::euclid_lsh)));
+    for (size_t r = 0; r < num_rows; ++r) {
+      lof_->update_row(id(r), random_sfv(rand, 20, dimension));
+    }
+    for (size_t i = 0; i < num_rows; ++i) {
+      queries_.push_back(random_sfv(rand, 20, dimension));
+    }
+  }
+
+  void run(size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+      const common::sfv_t& query = queries_[i % queries_.size()];
+      if (add_) {
+        lof_->update_row(id(i % num_rows), query);
+      } else {
+        lof_->calc_anomaly_score(query);
+      }
+    }
+  }
+
+  void tear_down() {
+    lof_.reset();
+    queries_.clear();
+  }
+
+ private:
+  static string id(size_t r) {
+    return "r" + lexical_cast<string>(r);
+  }
+
+  const bool add_;
+  shared_ptr<lof> lof_;
+  vector<common::sfv_t> queries_;
+};
+
+lof_bench lof_add_bench(true);
+lof_bench lof_score_bench(false);
+
+}  // namespace
+}  // namespace bench
+}  // namespace core
+}  // namespace jubatus
@@ -0,0 +1,93 @@
+// Jubatus: Online machine learning framework for distributed environment
+// Copyright (C) 2015 Preferred Networks and Nippon Telegraph and Telephone Corporation.
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License version 2.1 as published by the Free Software Foundation.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+#include <stdint.h>
+
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "jubatus/util/lang/cast.h"
+#include "benchmark.hpp"
+
+using std::string;
+using std::vector;
+using jubatus::util::lang::lexical_cast;
+using jubatus::core::bench::result;
+using jubatus::core::bench::run_options;
+
+namespace {
+
+bool parse_option(const string& arg, const string& name, string& value) {
+  const string prefix = "--" + name + "=";
+  if (arg.compare(0, prefix.size(), prefix) != 0) {
+    return false;
+  }
+  value = arg.substr(prefix.size());
+  return true;
+}
+
+void usage(const char* program) {
+  std::cerr << "usage: " << program
+            << " [--filter=SUBSTR] [--seed=N] [--min_time=SEC]"
+            << " [--repetitions=N] [--output=FILE]" << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  run_options options;
+  string output;
+  for (int i = 1; i < argc; ++i) {
+    const string arg = argv[i];
+    string value;
+    if (parse_option(arg, "filter", value)) {
+      options.filter = value;
+    } else if (parse_option(arg, "seed", value)) {
+      options.seed = lexical_cast<uint32_t>(value);
+    } else if (parse_option(arg, "min_time", value)) {
+      options.min_time = lexical_cast<double>(value);
+    } else if (parse_option(arg, "repetitions", value)) {
+      options.repetitions = lexical_cast<size_t>(value);
+    } else if (parse_option(arg, "output", value)) {
+      output = value;
+    } else {
+      usage(argv[0]);
+      return 1;
+    }
+  }
+
+  vector<result> results;
+  run_benchmarks(options, results);
+  for (size_t i = 0; i < results.size(); ++i) {
+    std::fprintf(stderr, "%-48s %12.1f ns/op (%zu iterations)\n",
+                 results[i].name.c_str(), results[i].ns_per_op,
+                 results[i].iterations);
+  }
+
+  if (output.empty()) {
+    write_json(options, results, std::cout);
+  } else {
+    std::ofstream ofs(output.c_str());
+    write_json(options, results, ofs);
+    if (!ofs) {
+      std::cerr << "failed to write " << output << std::endl;
+      return 1;
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,192 @@
+// Jubatus: Online machine learning framework for distributed environment
+// Copyright (C) 2015 Preferred Networks and Nippon Telegraph and Telephone Corporation.
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License version 2.1 as published by the Free Software Foundation.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+#include "benchmark.hpp"
+
+#include <algorithm>
+#include <iomanip>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+#include "jubatus/util/lang/cast.h"
+#include "jubatus/util/system/time_util.h"
+#include "jubatus/core_config.hpp"
+
+using std::string;
+using std::vector;
+using jubatus::util::lang::lexical_cast;
+using jubatus::util::math::random::mtrand;
+using jubatus::util::system::time::clock_time;
+using jubatus::util::system::time::get_clock_time;
+
+namespace jubatus {
+namespace core {
+namespace bench {
+
+namespace {
+
+vector<benchmark*>& registry() {
+  static vector<benchmark*> benchmarks;
+  return benchmarks;
+}
+
+bool name_less(const benchmark* lhs, const benchmark* rhs) {
+  return lhs->name() < rhs->name();
+}
+
+// seconds taken by |b.run(n)|
+double measure(benchmark& b, size_t n) {
+  clock_time start = get_clock_time();
+  b.run(n);
+  clock_time end = get_clock_time();
+  return static_cast<double>(end) - static_cast<double>(start);
+}
+
+result run_one(benchmark& b, const run_options& options) {
+  mtrand rand(options.seed);
+  b.set_up(rand);
+  b.run(1);  // warm up
+
+  // grow the iteration count until one run takes |min_time|
+  size_t n = 1;
+  double elapsed = measure(b, n);
+  while (elapsed < options.min_time) {
+    size_t next = n * 10;
+    if (elapsed > 0) {
+      next = static_cast<size_t>(n * options.min_time * 1.2 / elapsed) + 1;
+      next = std::min(std::max(next, n + 1), n * 10);
+    }
+    n = next;
+    elapsed = measure(b, n);
+  }
+
+  vector<double> ns_per_op;
+  ns_per_op.push_back(elapsed * 1e9 / n);
+  while (ns_per_op.size() < std::max<size_t>(options.repetitions, 1)) {
+    ns_per_op.push_back(measure(b, n) * 1e9 / n);
+  }
+  b.tear_down();
+
+  std::sort(ns_per_op.begin(), ns_per_op.end());
+  result r;
+  r.name = b.name();
+  r.iterations = n;
+  r.ns_per_op = ns_per_op[ns_per_op.size() / 2];
+  r.min_ns_per_op = ns_per_op.front();
+  r.max_ns_per_op = ns_per_op.back();
+  return r;
+}
+
+string quote(const string& s) {
+  string ret = "\"";
+  for (size_t i = 0; i < s.size(); ++i) {
+    if (s[i] == '"' || s[i] == '\\') {
+      ret += '\\';
+    }
+    ret += s[i];
+  }
+  return ret + "\"";
+}
+
+}  // namespace
+
+benchmark::benchmark(const string& name)
+    : name_(name) {
+  registry().push_back(this);
+}
+
+benchmark::~benchmark() {
+  vector<benchmark*>& benchmarks = registry();
+  benchmarks.erase(
+      std::remove(benchmarks.begin(), benchmarks.end(), this),
+      benchmarks.end());
+}
+
+void run_benchmarks(const run_options& options, vector<result>& results) {
+  vector<benchmark*> benchmarks = registry();
+  std::sort(benchmarks.begin(), benchmarks.end(), name_less);
+  for (size_t i = 0; i < benchmarks.size(); ++i) {
+    if (benchmarks[i]->name().find(options.filter) == string::npos) {
+      continue;
+    }
+    results.push_back(run_one(*benchmarks[i], options));
+  }
+}
+
+void write_json(
+    const run_options& options,
+    const vector<result>& results,
+    std::ostream& os) {
+  os << std::fixed << std::setprecision(1);
+  os << "{\n";
+  os << "  \"version\": " << quote(JUBATUS_CORE_VERSION) << ",\n";
+#ifdef NDEBUG
+  os << "  \"debug\": false,\n";
+#else
+  os << "  \"debug\": true,\n";
+#endif
+  os << "  \"seed\": " << options.seed << ",\n";
+  os << "  \"repetitions\": " << options.repetitions << ",\n";
+  os << "  \"benchmarks\": [";
+  for (size_t i = 0; i < results.size(); ++i) {
+    const result& r = results[i];
+    os << (i == 0 ? "\n" : ",\n");
+    os << "    {\"name\": " << quote(r.name)
+       << ", \"iterations\": " << r.iterations
+       << ", \"ns_per_op\": " << r.ns_per_op
+       << ", \"min_ns_per_op\": " << r.min_ns_per_op
+       << ", \"max_ns_per_op\": " << r.max_ns_per_op << "}";
+  }
+  os << "\n  ]\n}\n";
+}
+
+string random_feature(mtrand& rand, size_t dim) {
+  return "f" + lexical_cast<string>(rand.next_int(dim));
+}
+
+common::sfv_t random_sfv(mtrand& rand, size_t num_features, size_t dim) {
+  vector<uint32_t> ids;
+  while (ids.size() < std::min(num_features, dim)) {
+    uint32_t id = rand.next_int(dim);
+    if (std::find(ids.begin(), ids.end(), id) == ids.end()) {
+      ids.push_back(id);
+    }
+  }
+  common::sfv_t sfv;
+  for (size_t i = 0; i < ids.size(); ++i) {
+    sfv.push_back(std::make_pair(
+        "f" + lexical_cast<string>(ids[i]),
+        static_cast<float>(rand.next_double())));
+  }
+  std::sort(sfv.begin(), sfv.end());
+  return sfv;
+}
+
+string random_text(mtrand& rand, size_t num_words, size_t vocabulary) {
+  string text;
+  for (size_t i = 0; i < num_words; ++i) {
+    if (i > 0) {
+      text += ' ';
+    }
+    text += "w" + lexical_cast<string>(rand.next_int(vocabulary));
+  }
+  return text;
+}
+
+}  // namespace bench
+}  // namespace core
+}  // namespace jubatus
@@ -0,0 +1,111 @@
+// Jubatus: Online machine learning framework for distributed environment
+// Copyright (C) 2015 Preferred Networks and Nippon Telegraph and Telephone Corporation.
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License version 2.1 as published by the Free Software Foundation.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+#ifndef JUBATUS_CORE_BENCH_BENCHMARK_HPP_
+#define JUBATUS_CORE_BENCH_BENCHMARK_HPP_
+
+#include <stdint.h>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "jubatus/util/math/random.h"
+#include "../common/type.hpp"
+
+namespace jubatus {
+namespace core {
+namespace bench {
+
+// A benchmark registers itself to the runner on construction; define one
+// static instance of each benchmark class.
+class benchmark {
+ public:
+  explicit benchmark(const std::string& name);
+  virtual ~benchmark();
+
+  const std::string& name() const {
+    return name_;
+  }
+
+  // Builds the input data and the model; not measured.  |rand| is seeded
+  // with the same value in every run so that results are reproducible.
+  virtual void set_up(jubatus::util::math::random::mtrand& rand) = 0;
+
+  // Runs the measured operation |n| times.
+  virtual void run(size_t n) = 0;
+
+  // Releases what set_up built.
+  virtual void tear_down() {
+  }
+
+ private:
+  std::string name_;
+};
+
+struct run_options {
+  run_options()
+      : seed(0),
+        min_time(0.5),
+        repetitions(5) {
+  }
+
+  // Only benchmarks whose name contains |filter| are run.
+  std::string filter;
+  uint32_t seed;
+  // Each repetition runs for at least |min_time| seconds.
+  double min_time;
+  size_t repetitions;
+};
+
+struct result {
+  std::string name;
+  size_t iterations;  // per repetition
+  double ns_per_op;  // median over the repetitions
+  double min_ns_per_op;
+  double max_ns_per_op;
+};
+
+void run_benchmarks(const run_options& options, std::vector<result>& results);
+void write_json(
+    const run_options& options,
+    const std::vector<result>& results,
+    std::ostream& os);
+
+// Seeded synthetic data shared by the benchmarks.
+
+// "f<N>" with N uniformly drawn from [0, dim)
+std::string random_feature(
+    jubatus::util::math::random::mtrand& rand,
+    size_t dim);
+
+// |num_features| distinct features drawn from a |dim|-dimensional space with
+// values in [0, 1), sorted by key.
+common::sfv_t random_sfv(
+    jubatus::util::math::random::mtrand& rand,
+    size_t num_features,
+    size_t dim);
+
+// |num_words| words separated by spaces, drawn from a vocabulary of
+// |vocabulary| words.
+std::string random_text(
+    jubatus::util::math::random::mtrand& rand,
+    size_t num_words,
+    size_t vocabulary);
+
+}  // namespace bench
+}  // namespace core
+}  // namespace jubatus
+
+#endif  // JUBATUS_CORE_BENCH_BENCHMARK_HPP_
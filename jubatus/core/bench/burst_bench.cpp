@@ -0,0 +1,91 @@
+// Jubatus: Online machine learning framework for distributed environment
+// Copyright (C) 2015 Preferred Networks and Nippon Telegraph and Telephone Corporation.
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License version 2.1 as published by the Free Software Foundation.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+#include <cfloat>
+#include <string>
+#include <vector>
+#include "jubatus/util/lang/cast.h"
+#include "jubatus/util/lang/shared_ptr.h"
+#include "../burst/burst.hpp"
+#include "benchmark.hpp"
+
+using std::string;
+using std::vector;
+using jubatus::util::lang::lexical_cast;
+using jubatus::util::lang::shared_ptr;
+using jubatus::util::math::random::mtrand;
+
+namespace jubatus {
+namespace core {
+namespace bench {
+namespace {
+
+const size_t vocabulary = 1000;
+
+class add_document_bench : public benchmark {
+ public:
+  add_document_bench()
+      : benchmark("burst/add_document"),
+        pos_(0) {
+  }
+
+  void set_up(mtrand& rand) {
+    burst::burst_options options = {
+      10,       // window_batch_size
+      1.0,      // batch_interval
+      10,       // result_window_rotate_size
+      5,        // max_reuse_batch_num
+      DBL_MAX   // costcut_threshold
+    };
+    burst_.reset(new burst::burst(options));
+    burst::keyword_params params = {
+      2.0,  // scaling_param
+      1.0   // gamma
+    };
+    for (size_t i = 0; i < 10; ++i) {
+      burst_->add_keyword("w" + lexical_cast<string>(i), params, true);
+    }
+    for (size_t i = 0; i < 1000; ++i) {
+      documents_.push_back(random_text(rand, 20, vocabulary));
+    }
+    pos_ = 0;
+  }
+
+  // a hundred documents per batch interval
+  void run(size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+      burst_->add_document(documents_[i % documents_.size()], pos_);
+      pos_ += 0.01;
+    }
+  }
+
+  void tear_down() {
+    burst_.reset();
+    documents_.clear();
+  }
+
+ private:
+  shared_ptr<burst::burst> burst_;
+  vector<string> documents_;
+  double pos_;
+};
+
+add_document_bench add_document_bench_instance;
+
+}  // namespace
+}  // namespace bench
+}  // namespace core
+}  // namespace jubatus
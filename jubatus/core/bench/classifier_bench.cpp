@@ -0,0 +1,124 @@
+// Jubatus: Online machine learning framework for distributed environment
+// Copyright (C) 2015 Preferred Networks and Nippon Telegraph and Telephone Corporation.
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License version 2.1 as published by the Free Software Foundation.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+#include <string>
+#include <utility>
+#include <vector>
+#include "jubatus/util/lang/cast.h"
+#include "jubatus/util/lang/shared_ptr.h"
+#include "jubatus/util/text/json.h"
+#include "../classifier/classifier_base.hpp"
+#include "../classifier/classifier_factory.hpp"
+#include "../classifier/classifier_type.hpp"
+#include "../common/jsonconfig.hpp"
+#include "../storage/local_storage_mixture.hpp"
+#include "benchmark.hpp"
+
+using std::string;
+using std::vector;
+using jubatus::util::lang::lexical_cast;
+using jubatus::util::lang::shared_ptr;
+using jubatus::util::math::random::mtrand;
+using jubatus::util::text::json::json;
+using jubatus::util::text::json::json_object;
+using jubatus::util::text::json::to_json;
+using jubatus::core::classifier::classifier_base;
+using jubatus::core::classifier::classifier_factory;
+using jubatus::core::classifier::classify_result;
+
+namespace jubatus {
+namespace core {
+namespace bench {
+namespace {
+
+const size_t num_examples = 1000;
+const size_t num_labels = 4;
+const size_t num_features = 50;
+const size_t dimension = 10000;
+
+// Trains or classifies examples drawn from a fixed synthetic dataset with a
+// learner built by classifier_factory on local_storage_mixture, which is
+// what the classifier server uses.
+class classifier_bench : public benchmark {
+ public:
+  enum operation {
+    TRAIN,
+    CLASSIFY
+  };
+
+  classifier_bench(const string& method, operation op)
+      : benchmark("classifier/" + method +
+                  (op == TRAIN ? "/train" : "/classify")),
+        method_(method),
+        op_(op) {
+  }
+
+  void set_up(mtrand& rand) {
+    json param;
+    if (method_ != "perceptron" && method_ != "PA") {
+      param = json(new json_object);
+      param["regularization_weight"] = to_json(1.0);
+    }
+    classifier_ = classifier_factory::create_classifier(
+        method_,
+        common::jsonconfig::config(param),
+        storage_ptr(new storage::local_storage_mixture));
+
+    for (size_t i = 0; i < num_examples; ++i) {
+      data_.push_back(std::make_pair(
+          "l" + lexical_cast<string>(rand.next_int(num_labels)),
+          random_sfv(rand, num_features, dimension)));
+    }
+    if (op_ == CLASSIFY) {
+      for (size_t i = 0; i < data_.size(); ++i) {
+        classifier_->train(data_[i].second, data_[i].first);
+      }
+    }
+  }
+
+  void run(size_t n) {
+    classify_result result;
+    for (size_t i = 0; i < n; ++i) {
+      const std::pair<string, common::sfv_t>& d = data_[i % data_.size()];
+      if (op_ == TRAIN) {
+        classifier_->train(d.second, d.first);
+      } else {
+        classifier_->classify_with_scores(d.second, result);
+      }
+    }
+  }
+
+  void tear_down() {
+    classifier_.reset();
+    data_.clear();
+  }
+
+ private:
+  const string method_;
+  const operation op_;
+  shared_ptr<classifier_base> classifier_;
+  vector<std::pair<string, common::sfv_t> > data_;
+};
+
+classifier_bench perceptron_train("perceptron", classifier_bench::TRAIN);
+classifier_bench pa_train("PA", classifier_bench::TRAIN);
+classifier_bench arow_train("AROW", classifier_bench::TRAIN);
+classifier_bench arow_classify("AROW", classifier_bench::CLASSIFY);
+
+}  // namespace
+}  // namespace bench
+}  // namespace core
+}  // namespace jubatus
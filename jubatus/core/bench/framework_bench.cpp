@@ -0,0 +1,146 @@
+// Jubatus: Online machine learning framework for distributed environment
+// Copyright (C) 2015 Preferred Networks and Nippon Telegraph and Telephone Corporation.
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License version 2.1 as published by the Free Software Foundation.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+#include <string>
+#include <vector>
+#include <msgpack.hpp>
+#include "jubatus/util/lang/cast.h"
+#include "jubatus/util/lang/shared_ptr.h"
+#include "../framework/mixable_versioned_table.hpp"
+#include "../framework/packer.hpp"
+#include "../framework/stream_writer.hpp"
+#include "../table/column/column_table.hpp"
+#include "benchmark.hpp"
+
+using std::string;
+using std::vector;
+using jubatus::util::lang::lexical_cast;
+using jubatus::util::lang::shared_ptr;
+using jubatus::util::math::random::mtrand;
+using jubatus::core::framework::jubatus_packer;
+using jubatus::core::framework::mixable_versioned_table;
+using jubatus::core::framework::packer;
+using jubatus::core::framework::stream_writer;
+using jubatus::core::table::bit_vector;
+using jubatus::core::table::column_table;
+using jubatus::core::table::column_type;
+using jubatus::core::table::owner;
+
+namespace jubatus {
+namespace core {
+namespace bench {
+namespace {
+
+const size_t num_rows = 10000;
+const size_t bit_num = 64;
+
+shared_ptr<mixable_versioned_table> make_table() {
+  shared_ptr<column_table> table(new column_table);
+  vector<column_type> schema;
+  schema.push_back(column_type(column_type::bit_vector_type, bit_num));
+  schema.push_back(column_type(column_type::float_type));
+  table->init(schema);
+  shared_ptr<mixable_versioned_table> mixable(new mixable_versioned_table);
+  mixable->set_model(table);
+  return mixable;
+}
+
+// Pulls every row of a |num_rows| rows table (as a MIX with a new member
+// does), or pushes all of them into an empty table.
+class versioned_table_bench : public benchmark {
+ public:
+  explicit versioned_table_bench(bool pull)
+      : benchmark(pull ? "framework/mixable_versioned_table/pull"
+                       : "framework/mixable_versioned_table/push"),
+        pull_(pull) {
+  }
+
+  void set_up(mtrand& rand) {
+    source_ = make_table();
+    for (size_t r = 0; r < num_rows; ++r) {
+      bit_vector bv(bit_num);
+      for (size_t i = 0; i < bit_num; ++i) {
+        if (rand.next_int(2)) {
+          bv.set_bit(i);
+        }
+      }
+      source_->get_model()->add(
+          "r" + lexical_cast<string>(r), owner("bench"), bv,
+          static_cast<float>(rand.next_double()));
+    }
+
+    // the argument of a member which has nothing yet
+    arg_buf_.reset(new msgpack::sbuffer);
+    pack(*arg_buf_, framework::version_clock());
+    msgpack::unpack(&arg_, arg_buf_->data(), arg_buf_->size());
+
+    pulled_buf_.reset(new msgpack::sbuffer);
+    pull(*source_, *pulled_buf_);
+    msgpack::unpack(&pulled_, pulled_buf_->data(), pulled_buf_->size());
+    destination_ = make_table();
+  }
+
+  void run(size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+      if (pull_) {
+        msgpack::sbuffer buf;
+        pull(*source_, buf);
+      } else {
+        destination_->get_model()->clear();
+        destination_->push(pulled_.get());
+      }
+    }
+  }
+
+  void tear_down() {
+    source_.reset();
+    destination_.reset();
+    arg_buf_.reset();
+    pulled_buf_.reset();
+  }
+
+ private:
+  template <class T>
+  static void pack(msgpack::sbuffer& buf, const T& v) {
+    stream_writer<msgpack::sbuffer> st(buf);
+    jubatus_packer jp(st);
+    packer pk(jp);
+    pk.pack(v);
+  }
+
+  void pull(const mixable_versioned_table& table, msgpack::sbuffer& buf) {
+    stream_writer<msgpack::sbuffer> st(buf);
+    jubatus_packer jp(st);
+    packer pk(jp);
+    table.pull(arg_.get(), pk);
+  }
+
+  const bool pull_;
+  shared_ptr<mixable_versioned_table> source_;
+  shared_ptr<mixable_versioned_table> destination_;
+  shared_ptr<msgpack::sbuffer> arg_buf_;
+  msgpack::unpacked arg_;
+  shared_ptr<msgpack::sbuffer> pulled_buf_;
+  msgpack::unpacked pulled_;
+};
+
+versioned_table_bench versioned_table_pull_bench(true);
+versioned_table_bench versioned_table_push_bench(false);
+
+}  // namespace
+}  // namespace bench
+}  // namespace core
+}  // namespace jubatus
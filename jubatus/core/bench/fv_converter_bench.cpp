@@ -0,0 +1,102 @@
+// Jubatus: Online machine learning framework for distributed environment
+// Copyright (C) 2015 Preferred Networks and Nippon Telegraph and Telephone Corporation.
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License version 2.1 as published by the Free Software Foundation.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+#include <string>
+#include <utility>
+#include <vector>
+#include "jubatus/util/lang/cast.h"
+#include "jubatus/util/lang/shared_ptr.h"
+#include "../fv_converter/converter_config.hpp"
+#include "../fv_converter/datum.hpp"
+#include "../fv_converter/datum_to_fv_converter.hpp"
+#include "benchmark.hpp"
+
+using std::string;
+using std::vector;
+using jubatus::util::lang::lexical_cast;
+using jubatus::util::lang::shared_ptr;
+using jubatus::util::math::random::mtrand;
+using jubatus::core::fv_converter::converter_config;
+using jubatus::core::fv_converter::datum;
+using jubatus::core::fv_converter::datum_to_fv_converter;
+using jubatus::core::fv_converter::num_rule;
+using jubatus::core::fv_converter::string_rule;
+
+namespace jubatus {
+namespace core {
+namespace bench {
+namespace {
+
+class convert_bench : public benchmark {
+ public:
+  convert_bench()
+      : benchmark("fv_converter/datum_to_fv_converter/convert") {
+  }
+
+  void set_up(mtrand& rand) {
+    string_rule str_rule;
+    str_rule.key = "*";
+    str_rule.type = "space";
+    str_rule.sample_weight = "tf";
+    str_rule.global_weight = "bin";
+    num_rule n_rule;
+    n_rule.key = "*";
+    n_rule.type = "num";
+
+    converter_config c;
+    c.string_rules = vector<string_rule>();
+    c.string_rules->push_back(str_rule);
+    c.num_rules = vector<num_rule>();
+    c.num_rules->push_back(n_rule);
+    converter_ = fv_converter::make_fv_converter(c);
+
+    for (size_t i = 0; i < 1000; ++i) {
+      datum d;
+      d.string_values_.push_back(
+          std::make_pair("title", random_text(rand, 10, 10000)));
+      d.string_values_.push_back(
+          std::make_pair("body", random_text(rand, 100, 10000)));
+      for (size_t j = 0; j < 10; ++j) {
+        d.num_values_.push_back(std::make_pair(
+            "n" + lexical_cast<string>(j), rand.next_double()));
+      }
+      data_.push_back(d);
+    }
+  }
+
+  void run(size_t n) {
+    common::sfv_t fv;
+    for (size_t i = 0; i < n; ++i) {
+      converter_->convert(data_[i % data_.size()], fv);
+    }
+  }
+
+  void tear_down() {
+    converter_.reset();
+    data_.clear();
+  }
+
+ private:
+  shared_ptr<datum_to_fv_converter> converter_;
+  vector<datum> data_;
+};
+
+convert_bench convert_bench_instance;
+
+}  // namespace
+}  // namespace bench
+}  // namespace core
+}  // namespace jubatus
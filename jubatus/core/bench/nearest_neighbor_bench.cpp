@@ -0,0 +1,100 @@
+// Jubatus: Online machine learning framework for distributed environment
+// Copyright (C) 2015 Preferred Networks and Nippon Telegraph and Telephone Corporation.
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License version 2.1 as published by the Free Software Foundation.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+#include <stdint.h>
+#include <string>
+#include <utility>
+#include <vector>
+#include "jubatus/util/lang/cast.h"
+#include "jubatus/util/lang/shared_ptr.h"
+#include "../nearest_neighbor/bit_vector_ranking.hpp"
+#include "../table/column/column_table.hpp"
+#include "benchmark.hpp"
+
+using std::pair;
+using std::string;
+using std::vector;
+using jubatus::util::lang::lexical_cast;
+using jubatus::util::lang::shared_ptr;
+using jubatus::util::math::random::mtrand;
+using jubatus::core::table::bit_vector;
+using jubatus::core::table::column_table;
+using jubatus::core::table::column_type;
+using jubatus::core::table::owner;
+
+namespace jubatus {
+namespace core {
+namespace bench {
+namespace {
+
+const size_t bit_num = 256;
+
+bit_vector random_bit_vector(mtrand& rand) {
+  bit_vector bv(bit_num);
+  for (size_t i = 0; i < bit_num; ++i) {
+    if (rand.next_int(2)) {
+      bv.set_bit(i);
+    }
+  }
+  return bv;
+}
+
+class ranking_hamming_bench : public benchmark {
+ public:
+  ranking_hamming_bench()
+      : benchmark("nearest_neighbor/ranking_hamming_bit_vectors") {
+  }
+
+  void set_up(mtrand& rand) {
+    table_.reset(new column_table);
+    vector<column_type> schema;
+    schema.push_back(column_type(column_type::bit_vector_type, bit_num));
+    table_->init(schema);
+    for (size_t r = 0; r < 100000; ++r) {
+      table_->add("r" + lexical_cast<string>(r), owner("bench"),
+                  random_bit_vector(rand));
+    }
+    for (size_t i = 0; i < 100; ++i) {
+      queries_.push_back(random_bit_vector(rand));
+    }
+  }
+
+  void run(size_t n) {
+    const table::const_bit_vector_column& column =
+        table_->get_bit_vector_column(0);
+    vector<pair<uint64_t, float> > ret;
+    for (size_t i = 0; i < n; ++i) {
+      nearest_neighbor::ranking_hamming_bit_vectors(
+          queries_[i % queries_.size()], column, ret, 10);
+    }
+  }
+
+  void tear_down() {
+    table_.reset();
+    queries_.clear();
+  }
+
+ private:
+  shared_ptr<column_table> table_;
+  vector<bit_vector> queries_;
+};
+
+ranking_hamming_bench ranking_hamming_bench_instance;
+
+}  // namespace
+}  // namespace bench
+}  // namespace core
+}  // namespace jubatus
@@ -0,0 +1,166 @@
+// Jubatus: Online machine learning framework for distributed environment
+// Copyright (C) 2015 Preferred Networks and Nippon Telegraph and Telephone Corporation.
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License version 2.1 as published by the Free Software Foundation.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+#include <string>
+#include <utility>
+#include <vector>
+#include "jubatus/util/lang/cast.h"
+#include "jubatus/util/lang/shared_ptr.h"
+#include "../storage/inverted_index_storage.hpp"
+#include "../storage/local_storage.hpp"
+#include "../storage/lsh_index_storage.hpp"
+#include "benchmark.hpp"
+
+using std::pair;
+using std::string;
+using std::vector;
+using jubatus::util::lang::lexical_cast;
+using jubatus::util::lang::shared_ptr;
+using jubatus::util::math::random::mtrand;
+
+namespace jubatus {
+namespace core {
+namespace bench {
+namespace {
+
+const size_t num_queries = 1000;
+
+class local_storage_inp_bench : public benchmark {
+ public:
+  local_storage_inp_bench()
+      : benchmark("storage/local_storage/inp") {
+  }
+
+  void set_up(mtrand& rand) {
+    const size_t dimension = 10000;
+    storage_.reset(new storage::local_storage);
+    for (size_t f = 0; f < dimension; ++f) {
+      const string feature = "f" + lexical_cast<string>(f);
+      for (size_t l = 0; l < 10; ++l) {
+        storage_->set(feature, "l" + lexical_cast<string>(l),
+                      rand.next_gaussian());
+      }
+    }
+    for (size_t i = 0; i < num_queries; ++i) {
+      queries_.push_back(random_sfv(rand, 100, dimension));
+    }
+  }
+
+  void run(size_t n) {
+    storage::map_feature_val1_t scores;
+    for (size_t i = 0; i < n; ++i) {
+      storage_->inp(queries_[i % queries_.size()], scores);
+    }
+  }
+
+  void tear_down() {
+    storage_.reset();
+    queries_.clear();
+  }
+
+ private:
+  shared_ptr<storage::local_storage> storage_;
+  vector<common::sfv_t> queries_;
+};
+
+class inverted_index_calc_scores_bench : public benchmark {
+ public:
+  inverted_index_calc_scores_bench()
+      : benchmark("storage/inverted_index_storage/calc_scores") {
+  }
+
+  void set_up(mtrand& rand) {
+    const size_t dimension = 10000;
+    storage_.reset(new storage::inverted_index_storage);
+    for (size_t r = 0; r < 10000; ++r) {
+      const string row = "r" + lexical_cast<string>(r);
+      common::sfv_t sfv = random_sfv(rand, 50, dimension);
+      for (size_t i = 0; i < sfv.size(); ++i) {
+        // the index is transposed: features are rows and ids are columns
+        storage_->set(sfv[i].first, row, sfv[i].second);
+      }
+    }
+    for (size_t i = 0; i < num_queries; ++i) {
+      queries_.push_back(random_sfv(rand, 50, dimension));
+    }
+  }
+
+  void run(size_t n) {
+    vector<pair<string, float> > scores;
+    for (size_t i = 0; i < n; ++i) {
+      storage_->calc_scores(queries_[i % queries_.size()], scores, 10);
+    }
+  }
+
+  void tear_down() {
+    storage_.reset();
+    queries_.clear();
+  }
+
+ private:
+  shared_ptr<storage::inverted_index_storage> storage_;
+  vector<common::sfv_t> queries_;
+};
+
+class lsh_index_similar_row_bench : public benchmark {
+ public:
+  lsh_index_similar_row_bench()
+      : benchmark("storage/lsh_index_storage/similar_row") {
+  }
+
+  void set_up(mtrand& rand) {
+    storage_.reset(new storage::lsh_index_storage(64, 4, 0));
+    for (size_t r = 0; r < 10000; ++r) {
+      storage_->set_row("r" + lexical_cast<string>(r), random_hash(rand), 1);
+    }
+    for (size_t i = 0; i < num_queries; ++i) {
+      queries_.push_back(random_hash(rand));
+    }
+  }
+
+  void run(size_t n) {
+    vector<pair<string, float> > ids;
+    for (size_t i = 0; i < n; ++i) {
+      storage_->similar_row(queries_[i % queries_.size()], 1, 64, 10, ids);
+    }
+  }
+
+  void tear_down() {
+    storage_.reset();
+    queries_.clear();
+  }
+
+ private:
+  vector<float> random_hash(mtrand& rand) const {
+    vector<float> hash(storage_->all_lsh_num());
+    for (size_t i = 0; i < hash.size(); ++i) {
+      hash[i] = rand.next_gaussian();
+    }
+    return hash;
+  }
+
+  shared_ptr<storage::lsh_index_storage> storage_;
+  vector<vector<float> > queries_;
+};
+
+local_storage_inp_bench local_storage_inp_bench_instance;
+inverted_index_calc_scores_bench inverted_index_calc_scores_bench_instance;
+lsh_index_similar_row_bench lsh_index_similar_row_bench_instance;
+
+}  // namespace
+}  // namespace bench
+}  // namespace core
+}  // namespace jubatus
@@ -20,7 +20,6 @@
 #include <cmath>
 #include <string>
 
-#include "classifier_util.hpp"
 #include "../common/exception.hpp"
 
 using std::string;
@@ -47,51 +46,51 @@ arow::arow(
 
 void arow::train(const common::sfv_t& sfv, const string& label) {
   check_touchable(label);
+  train_on_storage(this, sfv, label);
+}
 
+template <class Storage>
+void arow::train_on(
+    Storage& storage,
+    const common::sfv_t& sfv,
+    const string& label) {
   string incorrect_label;
-  float variance = 0.f;
-  float margin = -calc_margin_and_variance(sfv, label, incorrect_label,
-                                           variance);
+  float margin = -calc_margin(sfv, label, incorrect_label);
   if (margin >= 1.f) {
     storage_->register_label(label);
     return;
   }
 
+  storage::weight_accessor<Storage> weights(storage, label, incorrect_label);
+  float variance = calc_variance(weights, sfv);
   float beta = 1.f / (variance + 1.f / config_.regularization_weight);
   float alpha = (1.f - margin) * beta;  // max(0, 1 - margin) = 1 - margin
-  update(sfv, alpha, beta, label, incorrect_label);
+  update(weights, sfv, alpha, beta, label);
 }
 
+template <class Storage>
 void arow::update(
+    storage::weight_accessor<Storage>& weights,
     const common::sfv_t& sfv,
     float alpha,
     float beta,
-    const std::string& pos_label,
-    const std::string& neg_label) {
+    const std::string& pos_label) {
   for (common::sfv_t::const_iterator it = sfv.begin(); it != sfv.end(); ++it) {
     const string& feature = it->first;
     float val = it->second;
-    storage::feature_val2_t ret;
-    storage_->get2(feature, ret);
 
     storage::val2_t pos_val(0.f, 1.f);
     storage::val2_t neg_val(0.f, 1.f);
-    ClassifierUtil::get_two(ret, pos_label, neg_label, pos_val, neg_val);
+    weights.get2(feature, pos_val, neg_val);
 
-    storage_->set2(
+    weights.set2(
         feature,
-        pos_label,
         storage::val2_t(
             pos_val.v1 + alpha * pos_val.v2 * val,
-            pos_val.v2 - beta * pos_val.v2 * pos_val.v2 * val * val));
-    if (neg_label != "") {
-      storage_->set2(
-          feature,
-          neg_label,
-          storage::val2_t(
-              neg_val.v1 - alpha * neg_val.v2 * val,
-              neg_val.v2 - beta * neg_val.v2 * neg_val.v2 * val * val));
-    }
+            pos_val.v2 - beta * pos_val.v2 * pos_val.v2 * val * val),
+        storage::val2_t(
+            neg_val.v1 - alpha * neg_val.v2 * val,
+            neg_val.v2 - beta * neg_val.v2 * neg_val.v2 * val * val));
   }
   touch(pos_label);
 }
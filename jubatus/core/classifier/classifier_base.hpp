@@ -42,6 +42,16 @@ class classifier_base {
 
   virtual void train(const common::sfv_t& fv, const std::string& label) = 0;
 
+  // Trains on every example of |data|.  Implementations may split the batch
+  // among |num_threads| threads, in which case the resulting model depends on
+  // scheduling; with |num_threads| == 1 it is the same as calling |train| on
+  // each example in order.
+  virtual void batch_train(const labeled_fv_list& data, size_t num_threads) {
+    for (size_t i = 0; i < data.size(); ++i) {
+      train(data[i].second, data[i].first);
+    }
+  }
+
   virtual void classify_with_scores(
       const common::sfv_t& fv, classify_result& scores) const = 0;
 
@@ -28,6 +28,7 @@
 
 #include "classifier.hpp"
 #include "../storage/local_storage.hpp"
+#include "../storage/local_storage_mixture.hpp"
 #include "../common/exception.hpp"
 #include "../common/jsonconfig.hpp"
 #include "../unlearner/lru_unlearner.hpp"
@@ -155,6 +156,53 @@ TYPED_TEST_P(classifier_test, random3) {
   EXPECT_GT(correct, 95u);
 }
 
+TYPED_TEST_P(classifier_test, batch_train) {
+  jubatus::util::math::random::mtrand rand(0);
+  shared_ptr<TypeParam> p = make_classifier<TypeParam>();
+
+  labeled_fv_list data;
+  for (size_t i = 0; i < 1000; ++i) {
+    pair<string, vector<double> > d = gen_random_data3(rand);
+    data.push_back(make_pair(d.first, convert(d.second)));
+  }
+  p->batch_train(data, 4);
+  EXPECT_EQ(3u, p->get_labels().size());
+
+  size_t correct = 0;
+  for (size_t i = 0; i < 100; ++i) {
+    pair<string, vector<double> > d = gen_random_data3(rand);
+    if (d.first == p->classify(convert(d.second))) {
+      ++correct;
+    }
+  }
+  EXPECT_GT(correct, 95u);
+}
+
+TYPED_TEST_P(classifier_test, batch_train_single_thread) {
+  jubatus::util::math::random::mtrand rand(0);
+  shared_ptr<TypeParam> p1 = make_classifier<TypeParam>();
+  shared_ptr<TypeParam> p2 = make_classifier<TypeParam>();
+
+  labeled_fv_list data;
+  for (size_t i = 0; i < 100; ++i) {
+    pair<string, vector<double> > d = gen_random_data(rand);
+    data.push_back(make_pair(d.first, convert(d.second)));
+    p1->train(data.back().second, data.back().first);
+  }
+  p2->batch_train(data, 1);
+
+  for (size_t i = 0; i < 10; ++i) {
+    classify_result r1, r2;
+    p1->classify_with_scores(data[i].second, r1);
+    p2->classify_with_scores(data[i].second, r2);
+    ASSERT_EQ(r1.size(), r2.size());
+    for (size_t j = 0; j < r1.size(); ++j) {
+      EXPECT_EQ(r1[j].label, r2[j].label);
+      EXPECT_EQ(r1[j].score, r2[j].score);
+    }
+  }
+}
+
 TYPED_TEST_P(classifier_test, delete_label) {
   shared_ptr<TypeParam> p = make_classifier<TypeParam>();
 
@@ -237,6 +285,8 @@ REGISTER_TYPED_TEST_CASE_P(
     sfv_err,
     random,
     random3,
+    batch_train,
+    batch_train_single_thread,
     delete_label,
     unlearning);
 
@@ -247,6 +297,68 @@ typedef testing::Types<
 
 INSTANTIATE_TYPED_TEST_CASE_P(cl, classifier_test, classifier_types);
 
+// Storages whose exact type is not known to linear_classifier, so that
+// learners reach them through the virtual storage_base interface.
+class virtual_local_storage : public storage::local_storage {
+};
+class virtual_local_storage_mixture : public storage::local_storage_mixture {
+};
+
+template<typename T>
+class linear_classifier_storage_test : public testing::Test {
+};
+
+typedef testing::Types<confidence_weighted, arow, normal_herd>
+  second_order_classifier_types;
+
+TYPED_TEST_CASE(linear_classifier_storage_test, second_order_classifier_types);
+
+template<class Classifier>
+void expect_same_model(storage_ptr s1, storage_ptr s2) {
+  classifier_config c;
+  Classifier p1(c, s1);
+  Classifier p2(c, s2);
+
+  jubatus::util::math::random::mtrand rand(0);
+  vector<common::sfv_t> fvs;
+  for (size_t i = 0; i < 200; ++i) {
+    pair<string, vector<double> > d = gen_random_data3(rand);
+    fvs.push_back(convert(d.second));
+    p1.train(fvs.back(), d.first);
+    p2.train(fvs.back(), d.first);
+  }
+
+  for (size_t i = 0; i < fvs.size(); ++i) {
+    classify_result r1, r2;
+    p1.classify_with_scores(fvs[i], r1);
+    p2.classify_with_scores(fvs[i], r2);
+    ASSERT_EQ(r1.size(), r2.size());
+    for (size_t j = 0; j < r1.size(); ++j) {
+      EXPECT_EQ(r1[j].label, r2[j].label);
+      EXPECT_EQ(r1[j].score, r2[j].score);
+    }
+  }
+
+  storage::feature_val3_t w1, w2;
+  s1->get3("f0", w1);
+  s2->get3("f0", w2);
+  std::sort(w1.begin(), w1.end());
+  std::sort(w2.begin(), w2.end());
+  EXPECT_EQ(w1, w2);
+}
+
+TYPED_TEST(linear_classifier_storage_test, local_storage) {
+  expect_same_model<TypeParam>(
+      storage_ptr(new local_storage),
+      storage_ptr(new virtual_local_storage));
+}
+
+TYPED_TEST(linear_classifier_storage_test, local_storage_mixture) {
+  expect_same_model<TypeParam>(
+      storage_ptr(new storage::local_storage_mixture),
+      storage_ptr(new virtual_local_storage_mixture));
+}
+
 TEST(classifier_config_test, regularization_weight) {
   storage_ptr s(new local_storage);
   classifier_config c;
@@ -19,9 +19,11 @@
 
 #include <stdint.h>
 
+#include <utility>
 #include <vector>
 #include <string>
 
+#include "../common/type.hpp"
 #include "classifier_config.hpp"
 
 namespace jubatus {
@@ -40,6 +42,9 @@ struct classify_result_elem {
 
 typedef std::vector<classify_result_elem> classify_result;
 
+// (label, feature vector) pairs to train on
+typedef std::vector<std::pair<std::string, common::sfv_t> > labeled_fv_list;
+
 }  // namespace classifier
 }  // namespace core
 }  // namespace jubatus
@@ -20,7 +20,6 @@
 #include <cmath>
 #include <string>
 
-#include "classifier_util.hpp"
 #include "../common/exception.hpp"
 
 using std::string;
@@ -47,12 +46,19 @@ confidence_weighted::confidence_weighted(
 
 void confidence_weighted::train(const common::sfv_t& sfv, const string& label) {
   check_touchable(label);
+  train_on_storage(this, sfv, label);
+}
 
+template <class Storage>
+void confidence_weighted::train_on(
+    Storage& storage,
+    const common::sfv_t& sfv,
+    const string& label) {
   const float C = config_.regularization_weight;
   string incorrect_label;
-  float variance = 0.f;
-  float margin = -calc_margin_and_variance(sfv, label, incorrect_label,
-                                           variance);
+  float margin = -calc_margin(sfv, label, incorrect_label);
+  storage::weight_accessor<Storage> weights(storage, label, incorrect_label);
+  float variance = calc_variance(weights, sfv);
   float b = 1.f + 2 * C * margin;
   float gamma = -b + std::sqrt(b * b - 8 * C * (margin - C * variance));
 
@@ -61,40 +67,33 @@ void confidence_weighted::train(const common::sfv_t& sfv, const string& label) {
     return;
   }
   gamma /= 4 * C * variance;
-  update(sfv, gamma, label, incorrect_label);
+  update(weights, sfv, gamma, label);
 }
 
+template <class Storage>
 void confidence_weighted::update(
+    storage::weight_accessor<Storage>& weights,
     const common::sfv_t& sfv,
     float step_width,
-    const string& pos_label,
-    const string& neg_label) {
+    const string& pos_label) {
   for (common::sfv_t::const_iterator it = sfv.begin(); it != sfv.end(); ++it) {
     const string& feature = it->first;
     float val = it->second;
-    storage::feature_val2_t val2;
-    storage_->get2(feature, val2);
 
     storage::val2_t pos_val(0.f, 1.f);
     storage::val2_t neg_val(0.f, 1.f);
-    ClassifierUtil::get_two(val2, pos_label, neg_label, pos_val, neg_val);
+    weights.get2(feature, pos_val, neg_val);
 
     const float C = config_.regularization_weight;
     float covar_pos_step = 2.f * step_width * val * val * C;
     float covar_neg_step = 2.f * step_width * val * val * C;
 
-    storage_->set2(
+    weights.set2(
         feature,
-        pos_label,
         storage::val2_t(pos_val.v1 + step_width * pos_val.v2 * val,
-                        1.f / (1.f / pos_val.v2 + covar_pos_step)));
-    if (neg_label != "") {
-      storage_->set2(
-          feature,
-          neg_label,
-          storage::val2_t(neg_val.v1 - step_width * neg_val.v2 * val,
-                          1.f / (1.f / neg_val.v2 + covar_neg_step)));
-    }
+                        1.f / (1.f / pos_val.v2 + covar_pos_step)),
+        storage::val2_t(neg_val.v1 - step_width * neg_val.v2 * val,
+                        1.f / (1.f / neg_val.v2 + covar_neg_step)));
   }
   touch(pos_label);
 }
@@ -34,11 +34,18 @@ class confidence_weighted : public linear_classifier {
   void train(const common::sfv_t& fv, const std::string& label);
   std::string name() const;
  private:
+  friend class linear_classifier;
+  template <class Storage>
+  void train_on(
+      Storage& storage,
+      const common::sfv_t& fv,
+      const std::string& label);
+  template <class Storage>
   void update(
-    const common::sfv_t& fv,
-    float step_weigth,
-    const std::string& pos_label,
-    const std::string& neg_label);
+      storage::weight_accessor<Storage>& weights,
+      const common::sfv_t& fv,
+      float step_weigth,
+      const std::string& pos_label);
   classifier_config config_;
 };
 
@@ -23,23 +23,39 @@
 #include <map>
 #include <queue>
 #include <string>
+#include <typeinfo>
 #include <vector>
+#include "jubatus/util/concurrent/thread.h"
+#include "jubatus/util/data/unordered_set.h"
 #include "jubatus/util/lang/bind.h"
 
 #include "../common/exception.hpp"
+#include "../storage/weight_view.hpp"
 #include "classifier_util.hpp"
 
 using std::string;
 using std::vector;
+using jubatus::util::concurrent::thread;
+using jubatus::util::lang::shared_ptr;
 using jubatus::core::storage::map_feature_val1_t;
-using jubatus::core::storage::feature_val2_t;
 
 namespace jubatus {
 namespace core {
 namespace classifier {
 
 linear_classifier::linear_classifier(storage_ptr storage)
-  : storage_(storage), mixable_storage_(storage_) {
+  : storage_(storage), mixable_storage_(storage_),
+    local_storage_(NULL), local_storage_mixture_(NULL) {
+  // Exact type match: subclasses may override the virtual accessors.
+  if (!storage) {
+    return;
+  }
+  if (typeid(*storage) == typeid(storage::local_storage)) {
+    local_storage_ = static_cast<storage::local_storage*>(storage.get());
+  } else if (typeid(*storage) == typeid(storage::local_storage_mixture)) {
+    local_storage_mixture_ =
+        static_cast<storage::local_storage_mixture*>(storage.get());
+  }
 }
 
 linear_classifier::~linear_classifier() {
@@ -52,6 +68,21 @@ namespace {
 void delete_label_wrapper(linear_classifier* cb, const std::string& label) {
     cb->unlearn_label(label);
 }
+
+void train_shard(
+    linear_classifier* c,
+    const labeled_fv_list* data,
+    size_t begin,
+    size_t end,
+    string* error) {
+  try {
+    for (size_t i = begin; i < end; ++i) {
+      c->train((*data)[i].second, (*data)[i].first);
+    }
+  } catch (const std::exception& e) {
+    *error = e.what();
+  }
+}
 }
 
 void linear_classifier::set_label_unlearner(
@@ -64,6 +95,55 @@ void linear_classifier::set_label_unlearner(
   unlearner_ = label_unlearner;
 }
 
+void linear_classifier::batch_train(
+    const labeled_fv_list& data,
+    size_t num_threads) {
+  num_threads = std::min(num_threads, data.size());
+  if (num_threads <= 1 || unlearner_) {
+    classifier_base::batch_train(data, num_threads);
+    return;
+  }
+
+  jubatus::util::data::unordered_set<string> feature_set;
+  vector<string> labels;
+  for (size_t i = 0; i < data.size(); ++i) {
+    labels.push_back(data[i].first);
+    const common::sfv_t& fv = data[i].second;
+    for (size_t j = 0; j < fv.size(); ++j) {
+      feature_set.insert(fv[j].first);
+    }
+  }
+  vector<string> features(feature_set.begin(), feature_set.end());
+  shared_ptr<storage::weight_view> view(
+      new storage::weight_view(*storage_, features, labels));
+
+  // Algorithms access weights only through |storage_|, so let them train on
+  // the view while the threads run.
+  storage_ptr base = storage_;
+  storage_ = view;
+  vector<string> errors(num_threads);
+  vector<shared_ptr<thread> > threads;
+  for (size_t t = 0; t < num_threads; ++t) {
+    threads.push_back(shared_ptr<thread>(new thread(jubatus::util::lang::bind(
+        &train_shard, this, &data,
+        data.size() * t / num_threads,
+        data.size() * (t + 1) / num_threads,
+        &errors[t]))));
+    threads.back()->start();
+  }
+  for (size_t t = 0; t < num_threads; ++t) {
+    threads[t]->join();
+  }
+  storage_ = base;
+
+  for (size_t t = 0; t < num_threads; ++t) {
+    if (!errors[t].empty()) {
+      throw JUBATUS_EXCEPTION(common::exception::runtime_error(errors[t]));
+    }
+  }
+  view->write_back(*storage_);
+}
+
 void linear_classifier::classify_with_scores(
     const common::sfv_t& sfv,
     classify_result& scores) const {
@@ -166,33 +246,6 @@ float linear_classifier::calc_margin(
   return incorrect_score - correct_score;
 }
 
-float linear_classifier::calc_margin_and_variance(
-    const common::sfv_t& sfv,
-    const string& label,
-    string& incorrect_label,
-    float& var) const {
-  float margin = calc_margin(sfv, label, incorrect_label);
-  var = 0.f;
-
-  for (size_t i = 0; i < sfv.size(); ++i) {
-    const string& feature = sfv[i].first;
-    const float val = sfv[i].second;
-    feature_val2_t weight_covars;
-    storage_->get2(feature, weight_covars);
-    float label_covar = 1.f;
-    float incorrect_label_covar = 1.f;
-    for (size_t j = 0; j < weight_covars.size(); ++j) {
-      if (weight_covars[j].first == label) {
-        label_covar = weight_covars[j].second.v2;
-      } else if (weight_covars[j].first == incorrect_label) {
-        incorrect_label_covar = weight_covars[j].second.v2;
-      }
-    }
-    var += (label_covar + incorrect_label_covar) * val * val;
-  }
-  return margin;
-}
-
 float linear_classifier::squared_norm(const common::sfv_t& fv) {
   float ret = 0.f;
   for (size_t i = 0; i < fv.size(); ++i) {
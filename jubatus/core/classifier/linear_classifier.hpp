@@ -27,6 +27,9 @@
 #include "../common/type.hpp"
 #include "../framework/linear_function_mixer.hpp"
 #include "../storage/storage_base.hpp"
+#include "../storage/local_storage.hpp"
+#include "../storage/local_storage_mixture.hpp"
+#include "../storage/weight_accessor.hpp"
 #include "../unlearner/unlearner_base.hpp"
 #include "classifier_type.hpp"
 #include "classifier_base.hpp"
@@ -41,6 +44,12 @@ class linear_classifier : public classifier_base {
   virtual ~linear_classifier();
   virtual void train(const common::sfv_t& fv, const std::string& label) = 0;
 
+  // Shards |data| among |num_threads| threads that train on a shared
+  // storage::weight_view without locking (Hogwild!), then writes the updated
+  // weights back to the storage.  Falls back to serial training when a label
+  // unlearner is set, as unlearners are not thread-safe.
+  void batch_train(const labeled_fv_list& data, size_t num_threads);
+
   void set_label_unlearner(
       jubatus::util::lang::shared_ptr<unlearner::unlearner_base>
           label_unlearner);
@@ -82,11 +91,10 @@ class linear_classifier : public classifier_base {
       const common::sfv_t& sfv,
       const std::string& label,
       std::string& incorrect_label) const;
-  float calc_margin_and_variance(
-      const common::sfv_t& sfv,
-      const std::string& label,
-      std::string& incorrect_label,
-      float& variance) const;
+  template <class Storage>
+  static float calc_variance(
+      const storage::weight_accessor<Storage>& weights,
+      const common::sfv_t& sfv);
   std::string get_largest_incorrect_label(
       const common::sfv_t& sfv,
       const std::string& label,
@@ -96,11 +104,50 @@ class linear_classifier : public classifier_base {
   void check_touchable(const std::string& label);
   void touch(const std::string& label);
 
+  // Calls |learner->train_on(s, sfv, label)| where |s| is |*storage_| typed
+  // as its concrete class when that class has non-virtual accessors (see
+  // storage/weight_accessor.hpp), or as storage_base otherwise.  The
+  // concrete class is looked up once, when the learner is constructed.
+  template <class Learner>
+  void train_on_storage(
+      Learner* learner,
+      const common::sfv_t& sfv,
+      const std::string& label) {
+    if (local_storage_mixture_ && storage_.get() == local_storage_mixture_) {
+      learner->train_on(*local_storage_mixture_, sfv, label);
+    } else if (local_storage_ && storage_.get() == local_storage_) {
+      learner->train_on(*local_storage_, sfv, label);
+    } else {
+      learner->train_on(*storage_, sfv, label);
+    }
+  }
+
   storage_ptr storage_;
   jubatus::util::lang::shared_ptr<unlearner::unlearner_base> unlearner_;
   framework::linear_function_mixer mixable_storage_;
+
+ private:
+  storage::local_storage* local_storage_;
+  storage::local_storage_mixture* local_storage_mixture_;
 };
 
+template <class Storage>
+float linear_classifier::calc_variance(
+    const storage::weight_accessor<Storage>& weights,
+    const common::sfv_t& sfv) {
+  float var = 0.f;
+  for (size_t i = 0; i < sfv.size(); ++i) {
+    const float val = sfv[i].second;
+    storage::val2_t label_weight(0.f, 1.f);
+    storage::val2_t incorrect_label_weight(0.f, 1.f);
+    weights.get2(sfv[i].first, label_weight, incorrect_label_weight);
+    float label_covar = label_weight.v2;
+    float incorrect_label_covar = incorrect_label_weight.v2;
+    var += (label_covar + incorrect_label_covar) * val * val;
+  }
+  return var;
+}
+
 }  // namespace classifier
 }  // namespace core
 }  // namespace jubatus
@@ -117,17 +117,20 @@ std::string nearest_neighbor_classifier::classify(
 
 void nearest_neighbor_classifier::classify_with_scores(
     const common::sfv_t& fv, classify_result& scores) const {
-  std::vector<std::pair<std::string, float> > ids;
-  nearest_neighbor_engine_->neighbor_row(fv, ids, k_);
+  std::vector<std::pair<uint64_t, float> > rows;
+  nearest_neighbor_engine_->neighbor_row_index(fv, rows, k_);
+  shared_ptr<const table::column_table> table =
+      nearest_neighbor_engine_->get_const_table();
 
   std::map<std::string, float> m;
   for (unordered_set<std::string>::const_iterator iter = labels_.begin();
        iter != labels_.end(); ++iter) {
     m.insert(std::make_pair(*iter, 0));
   }
-  for (size_t i = 0; i < ids.size(); ++i) {
-    std::string label = get_label_from_id(ids[i].first);
-    m[label] += std::exp(-alpha_ * ids[i].second);
+  for (size_t i = 0; i < rows.size(); ++i) {
+    const std::string label =
+        get_label_from_id(table->get_key_ref(rows[i].first));
+    m[label] += std::exp(-alpha_ * rows[i].second);
   }
 
   scores.clear();
@@ -148,9 +151,8 @@ bool nearest_neighbor_classifier::delete_label(const std::string& label) {
 
   std::vector<std::string> ids_to_be_deleted;
   for (size_t i = 0, n = table->size(); i < n; ++i) {
-    std::string id = table->get_key(i);
-    std::string l = get_label_from_id(id);
-    if (l == label) {
+    const std::string& id = table->get_key_ref(i);
+    if (get_label_from_id(id) == label) {
       ids_to_be_deleted.push_back(id);
     }
   }
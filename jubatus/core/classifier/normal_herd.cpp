@@ -20,7 +20,6 @@
 #include <cmath>
 #include <string>
 
-#include "classifier_util.hpp"
 #include "../common/exception.hpp"
 
 using std::string;
@@ -48,60 +47,61 @@ normal_herd::normal_herd(
 
 void normal_herd::train(const common::sfv_t& sfv, const string& label) {
   check_touchable(label);
+  train_on_storage(this, sfv, label);
+}
 
+template <class Storage>
+void normal_herd::train_on(
+    Storage& storage,
+    const common::sfv_t& sfv,
+    const string& label) {
   string incorrect_label;
-  float variance = 0.f;
-  float margin = -calc_margin_and_variance(sfv, label, incorrect_label,
-                                           variance);
+  float margin = -calc_margin(sfv, label, incorrect_label);
   if (margin >= 1.f) {
     storage_->register_label(label);
     return;
   }
-  update(sfv, margin, variance, label, incorrect_label);
+
+  storage::weight_accessor<Storage> weights(storage, label, incorrect_label);
+  float variance = calc_variance(weights, sfv);
+  update(weights, sfv, margin, variance, label);
 }
 
+template <class Storage>
 void normal_herd::update(
+    storage::weight_accessor<Storage>& weights,
     const common::sfv_t& sfv,
     float margin,
     float variance,
-    const string& pos_label,
-    const string& neg_label) {
+    const string& pos_label) {
   for (common::sfv_t::const_iterator it = sfv.begin(); it != sfv.end(); ++it) {
     const string& feature = it->first;
     float val = it->second;
-    storage::feature_val2_t ret;
-    storage_->get2(feature, ret);
 
     storage::val2_t pos_val(0.f, 1.f);
     storage::val2_t neg_val(0.f, 1.f);
-    ClassifierUtil::get_two(ret, pos_label, neg_label, pos_val, neg_val);
+    weights.get2(feature, pos_val, neg_val);
 
     float val_covariance_pos = val * pos_val.v2;
     float val_covariance_neg = val * neg_val.v2;
 
     const float C = config_.regularization_weight;
-    storage_->set2(
+    weights.set2(
         feature,
-        pos_label,
         storage::val2_t(
             pos_val.v1
                 + (1.f - margin) * val_covariance_pos
                     / (variance + 1.f / C),
             1.f
                 / ((1.f / pos_val.v2) + (2 * C + C * C * variance)
+                    * val * val)),
+        storage::val2_t(
+            neg_val.v1
+                - (1.f - margin) * val_covariance_neg
+                    / (variance + 1.f / C),
+            1.f
+                / ((1.f / neg_val.v2) + (2 * C + C * C * variance)
                     * val * val)));
-    if (neg_label != "") {
-      storage_->set2(
-          feature,
-          neg_label,
-          storage::val2_t(
-              neg_val.v1
-                  - (1.f - margin) * val_covariance_neg
-                      / (variance + 1.f / C),
-              1.f
-                  / ((1.f / neg_val.v2) + (2 * C + C * C * variance)
-                      * val * val)));
-    }
   }
   touch(pos_label);
 }
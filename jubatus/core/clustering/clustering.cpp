@@ -57,6 +57,11 @@ clustering::clustering(
         "method = kmeans, compressor_method != compressive_gmm"));
   }
 
+  if (method != "kmeans" && cfg.kmeans_streaming && *cfg.kmeans_streaming) {
+    throw JUBATUS_EXCEPTION(common::invalid_parameter(
+        "kmeans_streaming is only for method = kmeans"));
+  }
+
   if (!(1 <= cfg.k)) {
     throw JUBATUS_EXCEPTION(
         common::invalid_parameter("1 <= k"));
@@ -134,6 +139,10 @@ void clustering::set_clustering_method(
 }
 
 bool clustering::push(const std::vector<weighted_point>& points) {
+  if (config_.kmeans_streaming && *config_.kmeans_streaming) {
+    // refine first; adding to the storage may trigger a full batch_update
+    update_clusters(points, false);
+  }
   jubatus::util::lang::shared_ptr<storage> sto = storage_->get_model();
   for (std::vector<weighted_point>::const_iterator it = points.begin();
        it != points.end(); ++it) {
@@ -186,6 +195,14 @@ void clustering::unpack(msgpack::object o) {
   storage_->get_model()->unpack(o);
 }
 
+void clustering::pack_method(framework::packer& pk) const {
+  clustering_method_->pack(pk);
+}
+
+void clustering::unpack_method(msgpack::object o) {
+  clustering_method_->unpack(o);
+}
+
 void clustering::clear() {
   storage_->get_model()->clear();
 }
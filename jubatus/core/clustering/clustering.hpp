@@ -72,6 +72,10 @@ class clustering {
 
   void pack(framework::packer& pk) const;
   void unpack(msgpack::object o);
+  // state of the clustering method, e.g. streaming k-means centers;
+  // unpack_method() must follow unpack()
+  void pack_method(framework::packer& pk) const;
+  void unpack_method(msgpack::object o);
   void clear();
 
   // for test only
@@ -19,6 +19,7 @@
 
 #include <string>
 #include <msgpack.hpp>
+#include "jubatus/util/data/optional.h"
 #include "jubatus/util/data/serialization.h"
 #include "jubatus/util/text/json.h"
 
@@ -49,6 +50,11 @@ struct clustering_config {
   double forgetting_factor;
   double forgetting_threshold;
 
+  // method specific; not part of the saved model
+  jubatus::util::data::optional<bool> kmeans_streaming;
+  jubatus::util::data::optional<bool> gmm_diagonal_covariance;
+  jubatus::util::data::optional<int> gmm_num_threads;
+
   MSGPACK_DEFINE(
       k,
       compressor_method,
@@ -68,7 +74,10 @@ struct clustering_config {
         & JUBA_MEMBER(bicriteria_base_size)
         & JUBA_MEMBER(compressed_bucket_size)
         & JUBA_MEMBER(forgetting_factor)
-        & JUBA_MEMBER(forgetting_threshold);
+        & JUBA_MEMBER(forgetting_threshold)
+        & JUBA_MEMBER(kmeans_streaming)
+        & JUBA_MEMBER(gmm_diagonal_covariance)
+        & JUBA_MEMBER(gmm_num_threads);
   }
 };
 
@@ -18,6 +18,8 @@
 #define JUBATUS_CORE_CLUSTERING_CLUSTERING_METHOD_HPP_
 
 #include <vector>
+#include <msgpack.hpp>
+#include "../framework/packer.hpp"
 #include "types.hpp"
 
 namespace jubatus {
@@ -29,7 +31,7 @@ class clustering_method {
   virtual ~clustering_method() {}
 
   virtual void batch_update(wplist points) = 0;
-  virtual void online_update(wplist points) = 0;
+  virtual void online_update(const wplist& points) = 0;
   virtual std::vector<common::sfv_t> get_k_center() const = 0;
   virtual common::sfv_t
       get_nearest_center(const common::sfv_t& point) const = 0;
@@ -37,6 +39,11 @@ class clustering_method {
       get_nearest_center_index(const common::sfv_t& point) const = 0;
   virtual wplist get_cluster(size_t cluster_id, const wplist& points) const = 0;
   virtual std::vector<wplist> get_clusters(const wplist& points) const = 0;
+
+  // saves what cannot be recomputed from the storage, e.g. centers refined
+  // by online_update(); unpack() runs after the storage is unpacked
+  virtual void pack(framework::packer& packer) const = 0;
+  virtual void unpack(msgpack::object o) = 0;
 };
 
 }  // namespace clustering
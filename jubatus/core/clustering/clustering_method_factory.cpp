@@ -33,12 +33,16 @@ shared_ptr<clustering_method> clustering_method_factory::create(
     const std::string& method,
     const clustering_config& config) {
   if (method == "kmeans") {
-    return shared_ptr<clustering_method>(
-        new kmeans_clustering_method(config.k));
+    return shared_ptr<clustering_method>(new kmeans_clustering_method(
+        config.k,
+        config.kmeans_streaming ? *config.kmeans_streaming : false));
 #ifdef JUBATUS_USE_EIGEN
   } else if (method == "gmm") {
-    return shared_ptr<clustering_method>(
-        new gmm_clustering_method(config.k));
+    return shared_ptr<clustering_method>(new gmm_clustering_method(
+        config.k,
+        config.gmm_diagonal_covariance ?
+            *config.gmm_diagonal_covariance : false,
+        config.gmm_num_threads ? *config.gmm_num_threads : 1));
 #endif
   }
   throw JUBATUS_EXCEPTION(core::common::unsupported_method(method));
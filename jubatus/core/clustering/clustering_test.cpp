@@ -21,6 +21,7 @@
 
 #include <gtest/gtest.h>
 
+#include "../framework/stream_writer.hpp"
 #include "clustering.hpp"
 #include "clustering_config.hpp"
 
@@ -173,6 +174,120 @@ INSTANTIATE_TEST_CASE_P(
     clustering_test,
     ::testing::ValuesIn(test_cases));
 
+namespace {
+
+weighted_point make_point(float x, float y) {
+  weighted_point p;
+  p.weight = 1;
+  p.data.push_back(std::make_pair("x", x));
+  p.data.push_back(std::make_pair("y", y));
+  return p;
+}
+
+}  // namespace
+
+TEST(clustering, kmeans_streaming) {
+  clustering_config cfg;
+  cfg.kmeans_streaming = true;
+  clustering c("name", "kmeans", cfg);
+  ASSERT_TRUE(c.get_k_center().empty());
+
+  wplist points;
+  points.push_back(make_point(1, 1));
+  points.push_back(make_point(1, 1));
+  points.push_back(make_point(-1, -1));
+  points.push_back(make_point(-1, -1));
+  c.push(points);
+  // centers are available before the bucket is full
+  ASSERT_EQ(2u, c.get_k_center().size());
+
+  common::sfv_t center = c.get_nearest_center(make_point(1, 1).data);
+  ASSERT_EQ(2u, center.size());
+  EXPECT_FLOAT_EQ(1, center[0].second);
+
+  // each push moves the center to the mean of all its members
+  points.clear();
+  points.push_back(make_point(4, 4));
+  points.push_back(make_point(4, 4));
+  c.push(points);
+  center = c.get_nearest_center(make_point(3, 3).data);
+  ASSERT_EQ(2u, center.size());
+  EXPECT_FLOAT_EQ(2.5, center[0].second);
+  EXPECT_FLOAT_EQ(2.5, center[1].second);
+
+  // a new feature widens the centers
+  points.clear();
+  points.push_back(make_point(-1, -1));
+  points.back().data.push_back(std::make_pair("z", 2.0f));
+  c.push(points);
+  center = c.get_nearest_center(make_point(-1, -1).data);
+  ASSERT_EQ(3u, center.size());
+  EXPECT_EQ("z", center[2].first);
+  EXPECT_FLOAT_EQ(2.0 / 3, center[2].second);
+}
+
+TEST(clustering, kmeans_streaming_warmup) {
+  clustering_config cfg;
+  cfg.kmeans_streaming = true;
+  clustering c("name", "kmeans", cfg);
+
+  // points pushed one by one are kept until there are k of them
+  wplist points;
+  points.push_back(make_point(1, 1));
+  c.push(points);
+  ASSERT_TRUE(c.get_k_center().empty());
+  points[0] = make_point(-1, -1);
+  c.push(points);
+  ASSERT_EQ(2u, c.get_k_center().size());
+  common::sfv_t center = c.get_nearest_center(make_point(2, 2).data);
+  ASSERT_EQ(2u, center.size());
+  EXPECT_FLOAT_EQ(1, center[0].second);
+}
+
+TEST(clustering, kmeans_streaming_pack) {
+  clustering_config cfg;
+  cfg.kmeans_streaming = true;
+  clustering c("name", "kmeans", cfg);
+  wplist points;
+  points.push_back(make_point(1, 1));
+  points.push_back(make_point(-1, -1));
+  c.push(points);
+  points.clear();
+  points.push_back(make_point(3, 3));
+  c.push(points);
+
+  msgpack::sbuffer sbuf;
+  framework::stream_writer<msgpack::sbuffer> st(sbuf);
+  framework::jubatus_packer jp(st);
+  framework::packer pk(jp);
+  pk.pack_array(2);
+  c.pack(pk);
+  c.pack_method(pk);
+
+  msgpack::unpacked msg;
+  msgpack::unpack(&msg, sbuf.data(), sbuf.size());
+  clustering loaded("name", "kmeans", cfg);
+  loaded.unpack(msg.get().via.array.ptr[0]);
+  loaded.unpack_method(msg.get().via.array.ptr[1]);
+  ASSERT_EQ(2u, loaded.get_k_center().size());
+  common::sfv_t center = loaded.get_nearest_center(make_point(2, 2).data);
+  ASSERT_EQ(2u, center.size());
+  EXPECT_FLOAT_EQ(2, center[0].second);
+
+  // the weights of the centers come back too
+  points[0] = make_point(4, 4);
+  loaded.push(points);
+  center = loaded.get_nearest_center(make_point(2, 2).data);
+  ASSERT_EQ(2u, center.size());
+  EXPECT_FLOAT_EQ(8.0 / 3, center[0].second);
+}
+
+TEST(clustering, kmeans_streaming_for_gmm) {
+  clustering_config cfg;
+  cfg.kmeans_streaming = true;
+  EXPECT_THROW(clustering("name", "gmm", cfg), common::invalid_parameter);
+}
+
 }  // namespace clustering
 }  // namespace core
 }  // namespace jubatus
@@ -28,29 +28,37 @@ namespace core {
 namespace clustering {
 
 void eigen_feature_mapper::clear() {
-  map_.clear();
-  rmap_.clear();
-  d_ = 0;
+  ids_.clear();
 }
 
 int eigen_feature_mapper::get_dimension() {
-  return d_;
+  return ids_.get_dimension();
 }
 
 eigen_svec_t eigen_feature_mapper::convert(
     const common::sfv_t& src,
     bool update_map) {
-  eigen_svec_t ret(d_);
-  for (common::sfv_t::const_iterator it = src.begin(); it != src.end(); ++it) {
-    insert(*it, update_map, ret);
+  if (!update_map) {
+    return convertc(src);
+  }
+  // assign ids first; resizing a sparse vector drops its coefficients
+  indexed_fv_t mapped;
+  ids_.convert(src, mapped);
+  eigen_svec_t ret(ids_.get_dimension());
+  for (indexed_fv_t::const_iterator it = mapped.begin();
+       it != mapped.end(); ++it) {
+    ret.coeffRef(it->first) = it->second;
   }
   return ret;
 }
 
 eigen_svec_t eigen_feature_mapper::convertc(const common::sfv_t& src) const {
-  eigen_svec_t ret(d_);
-  for (common::sfv_t::const_iterator it = src.begin(); it != src.end(); ++it) {
-    insertc(*it, ret);
+  indexed_fv_t mapped;
+  ids_.convertc(src, mapped);
+  eigen_svec_t ret(ids_.get_dimension());
+  for (indexed_fv_t::const_iterator it = mapped.begin();
+       it != mapped.end(); ++it) {
+    ret.coeffRef(it->first) = it->second;
   }
   return ret;
 }
@@ -76,7 +84,11 @@ eigen_svec_list_t eigen_feature_mapper::convert(
     ++ib;
   }
   for (ob = ret.begin(); ob != ret.end(); ++ob) {
-    ob->resize(d_);
+    eigen_svec_t v(ids_.get_dimension());
+    for (eigen_svec_t::InnerIterator it(*ob); it; ++it) {
+      v.coeffRef(it.index()) = it.value();
+    }
+    *ob = v;
   }
   return ret;
 }
@@ -93,7 +105,7 @@ eigen_wsvec_list_t eigen_feature_mapper::convert(
     ++ib;
   }
   for (ob = ret.begin(); ob != ret.end(); ++ob) {
-    eigen_svec_t v(d_);
+    eigen_svec_t v(ids_.get_dimension());
     for (eigen_svec_t::InnerIterator it(ob->data); it; ++it) {
       v.coeffRef(it.index()) = it.value();
     }
@@ -144,39 +156,11 @@ wplist eigen_feature_mapper::revert(
   return ret;
 }
 
-void eigen_feature_mapper::insert(
-    const pair<std::string, float>& item,
-    bool update_map,
-    eigen_svec_t& dst) {
-  if (dst.rows() < d_) {
-    dst.resize(d_);
-  }
-  if (map_.find(item.first) != map_.end()) {
-    dst.coeffRef(map_[item.first]) = item.second;
-  } else if (update_map) {
-    rmap_[d_] = item.first;
-    map_[item.first] = d_++;
-    insert(item, update_map, dst);
-  }
-}
-
-void eigen_feature_mapper::insertc(
-    const pair<std::string, float>& item,
-    eigen_svec_t& dst) const {
-  if (dst.rows() < d_) {
-    dst.resize(d_);
-  }
-  if (map_.find(item.first) != map_.end()) {
-    dst.coeffRef((map_.find(item.first))->second) = item.second;
-  }
-}
-
 void eigen_feature_mapper::rinsert(
     const pair<int, float>& item,
     common::sfv_t& dst) const {
-  if (rmap_.find(item.first) != rmap_.end()) {
-    dst.push_back(
-        make_pair((rmap_.find(item.first))->second, item.second));
+  if (static_cast<size_t>(item.first) < ids_.get_dimension()) {
+    dst.push_back(make_pair(ids_.get_key(item.first), item.second));
   }
 }
 
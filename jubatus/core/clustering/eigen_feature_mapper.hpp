@@ -20,7 +20,7 @@
 #include <string>
 #include <utility>
 #include <vector>
-#include "jubatus/util/data/unordered_map.h"
+#include "feature_mapper.hpp"
 #include "gmm_types.hpp"
 #include "types.hpp"
 
@@ -30,9 +30,15 @@ namespace clustering {
 
 class eigen_feature_mapper {
  public:
-  eigen_feature_mapper() : d_(0) {}
+  eigen_feature_mapper() {}
   void clear();
   int  get_dimension();
+  void start_run() {
+    ids_.start_run();
+  }
+  bool should_rebuild() const {
+    return ids_.should_rebuild();
+  }
   eigen_wsvec_list_t convert(const wplist& src, bool update_map = true);
   eigen_svec_list_t convert(const std::vector<common::sfv_t>& src,
       bool update_map = true);
@@ -46,23 +52,11 @@ class eigen_feature_mapper {
   weighted_point revert(const eigen_wsvec_t& src) const;
 
  private:
-  jubatus::util::data::unordered_map<std::string, size_t> map_;
-  jubatus::util::data::unordered_map<size_t, std::string> rmap_;
-
-  void insert(
-      const std::pair<std::string, float>& item,
-      bool update_map,
-      eigen_svec_t& dst);
-
-  void insertc(
-      const std::pair<std::string, float>&,
-      eigen_svec_t& dst) const;
-
   void rinsert(
       const std::pair<int, float>&,
       common::sfv_t& dst) const;
 
-  int d_;
+  feature_mapper ids_;
 };
 
 }  // namespace clustering
@@ -0,0 +1,98 @@
+// Jubatus: Online machine learning framework for distributed environment
+// Copyright (C) 2015 Preferred Networks and Nippon Telegraph and Telephone Corporation.
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License version 2.1 as published by the Free Software Foundation.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+#include "feature_mapper.hpp"
+
+#include <string>
+#include <utility>
+
+namespace jubatus {
+namespace core {
+namespace clustering {
+
+feature_mapper::feature_mapper()
+    : run_(0), active_(0) {
+}
+
+void feature_mapper::clear() {
+  map_.clear();
+  keys_.clear();
+  last_run_.clear();
+  active_ = 0;
+}
+
+void feature_mapper::start_run() {
+  ++run_;
+  active_ = 0;
+}
+
+bool feature_mapper::should_rebuild() const {
+  return active_ * 2 < keys_.size();
+}
+
+size_t feature_mapper::insert(const std::string& key) {
+  jubatus::util::data::unordered_map<std::string, size_t>::const_iterator it =
+      map_.find(key);
+  size_t id;
+  if (it != map_.end()) {
+    id = it->second;
+  } else {
+    id = keys_.size();
+    map_.insert(std::make_pair(key, id));
+    keys_.push_back(key);
+    last_run_.push_back(0);
+  }
+  if (last_run_[id] != run_) {
+    last_run_[id] = run_;
+    ++active_;
+  }
+  return id;
+}
+
+bool feature_mapper::find(const std::string& key, size_t& id) const {
+  jubatus::util::data::unordered_map<std::string, size_t>::const_iterator it =
+      map_.find(key);
+  if (it == map_.end()) {
+    return false;
+  }
+  id = it->second;
+  return true;
+}
+
+void feature_mapper::convert(const common::sfv_t& src, indexed_fv_t& dst) {
+  dst.clear();
+  dst.reserve(src.size());
+  for (common::sfv_t::const_iterator it = src.begin(); it != src.end(); ++it) {
+    dst.push_back(std::make_pair(insert(it->first), it->second));
+  }
+}
+
+void feature_mapper::convertc(
+    const common::sfv_t& src,
+    indexed_fv_t& dst) const {
+  dst.clear();
+  dst.reserve(src.size());
+  size_t id;
+  for (common::sfv_t::const_iterator it = src.begin(); it != src.end(); ++it) {
+    if (find(it->first, id)) {
+      dst.push_back(std::make_pair(id, it->second));
+    }
+  }
+}
+
+}  // namespace clustering
+}  // namespace core
+}  // namespace jubatus
@@ -0,0 +1,71 @@
+// Jubatus: Online machine learning framework for distributed environment
+// Copyright (C) 2015 Preferred Networks and Nippon Telegraph and Telephone Corporation.
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License version 2.1 as published by the Free Software Foundation.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+#ifndef JUBATUS_CORE_CLUSTERING_FEATURE_MAPPER_HPP_
+#define JUBATUS_CORE_CLUSTERING_FEATURE_MAPPER_HPP_
+
+#include <string>
+#include <utility>
+#include <vector>
+#include "jubatus/util/data/unordered_map.h"
+#include "types.hpp"
+
+namespace jubatus {
+namespace core {
+namespace clustering {
+
+typedef std::vector<std::pair<size_t, float> > indexed_fv_t;
+
+// Maps feature keys to dense integer ids shared by the clustering methods.
+// Ids are kept across clustering runs, so a run only pays for keys it has
+// not seen before.  Keys unused in the current run keep their ids until
+// should_rebuild() tells the caller that most of the space is stale.
+class feature_mapper {
+ public:
+  feature_mapper();
+
+  void clear();
+  void start_run();
+  bool should_rebuild() const;
+
+  size_t get_dimension() const {
+    return keys_.size();
+  }
+  const std::string& get_key(size_t id) const {
+    return keys_[id];
+  }
+
+  // returns the id of key, assigning a new one if needed
+  size_t insert(const std::string& key);
+  bool find(const std::string& key, size_t& id) const;
+
+  void convert(const common::sfv_t& src, indexed_fv_t& dst);
+  // skips keys without id
+  void convertc(const common::sfv_t& src, indexed_fv_t& dst) const;
+
+ private:
+  jubatus::util::data::unordered_map<std::string, size_t> map_;
+  std::vector<std::string> keys_;
+  std::vector<uint64_t> last_run_;
+  uint64_t run_;
+  size_t active_;
+};
+
+}  // namespace clustering
+}  // namespace core
+}  // namespace jubatus
+
+#endif  // JUBATUS_CORE_CLUSTERING_FEATURE_MAPPER_HPP_
@@ -0,0 +1,90 @@
+// Jubatus: Online machine learning framework for distributed environment
+// Copyright (C) 2015 Preferred Networks and Nippon Telegraph and Telephone Corporation.
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License version 2.1 as published by the Free Software Foundation.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+#include <string>
+#include <utility>
+#include <gtest/gtest.h>
+#include "feature_mapper.hpp"
+
+namespace jubatus {
+namespace core {
+namespace clustering {
+
+namespace {
+
+common::sfv_t make_fv(const std::string& k1, const std::string& k2) {
+  common::sfv_t fv;
+  fv.push_back(std::make_pair(k1, 1.0f));
+  fv.push_back(std::make_pair(k2, 2.0f));
+  return fv;
+}
+
+}  // namespace
+
+TEST(feature_mapper, convert) {
+  feature_mapper m;
+  indexed_fv_t v;
+  m.start_run();
+  m.convert(make_fv("a", "b"), v);
+  ASSERT_EQ(2u, v.size());
+  EXPECT_EQ(0u, v[0].first);
+  EXPECT_EQ(1.0f, v[0].second);
+  EXPECT_EQ(1u, v[1].first);
+  EXPECT_EQ(2.0f, v[1].second);
+  m.convert(make_fv("b", "c"), v);
+  EXPECT_EQ(1u, v[0].first);
+  EXPECT_EQ(2u, v[1].first);
+  EXPECT_EQ(3u, m.get_dimension());
+  EXPECT_EQ("c", m.get_key(2));
+
+  m.convertc(make_fv("a", "x"), v);
+  ASSERT_EQ(1u, v.size());
+  EXPECT_EQ(0u, v[0].first);
+  EXPECT_EQ(3u, m.get_dimension());
+
+  size_t id;
+  EXPECT_TRUE(m.find("b", id));
+  EXPECT_EQ(1u, id);
+  EXPECT_FALSE(m.find("x", id));
+}
+
+TEST(feature_mapper, ids_are_kept_across_runs) {
+  feature_mapper m;
+  indexed_fv_t v;
+  m.start_run();
+  m.convert(make_fv("a", "b"), v);
+  m.convert(make_fv("c", "d"), v);
+  EXPECT_FALSE(m.should_rebuild());
+
+  m.start_run();
+  m.convert(make_fv("c", "d"), v);
+  EXPECT_EQ(2u, v[0].first);
+  EXPECT_EQ(3u, v[1].first);
+  EXPECT_FALSE(m.should_rebuild());
+
+  // most ids are stale
+  m.start_run();
+  m.convert(make_fv("e", "e"), v);
+  EXPECT_TRUE(m.should_rebuild());
+
+  m.clear();
+  EXPECT_EQ(0u, m.get_dimension());
+  EXPECT_FALSE(m.should_rebuild());
+}
+
+}  // namespace clustering
+}  // namespace core
+}  // namespace jubatus
@@ -23,9 +23,13 @@
 #include <iostream>
 #include <utility>
 #include <vector>
+#include "jubatus/util/concurrent/thread.h"
+#include "jubatus/util/lang/bind.h"
 #include "jubatus/util/math/random.h"
 #include "../common/exception.hpp"
 
+using jubatus::util::concurrent::thread;
+using jubatus::util::lang::bind;
 using jubatus::util::lang::shared_ptr;
 using std::max;
 using std::min;
@@ -36,52 +40,124 @@ namespace jubatus {
 namespace core {
 namespace clustering {
 
+namespace {
+
+// covariances up to this dimension are factorized as dense matrices
+const int DENSE_DIMENSION_MAX = 256;
+
+}  // namespace
+
+// sufficient statistics accumulated over data[begin, end) in an E-step
+struct gmm::estep_result {
+  estep_result(size_t b, size_t e, int d, int k, bool diagonal)
+      : begin(b),
+        end(e),
+        means(k, eigen_svec_t(d)),
+        covs(diagonal ? 0 : k, eigen_smat_t(d, d)),
+        sq_sums(diagonal ? k : 0, eigen_dvec_t::Zero(d)),
+        weights(k),
+        obj(0) {
+  }
+
+  void add(const estep_result& r) {
+    for (size_t c = 0; c < weights.size(); ++c) {
+      means[c] += r.means[c];
+      if (!covs.empty()) {
+        covs[c] += r.covs[c];
+      } else {
+        sq_sums[c] += r.sq_sums[c];
+      }
+      weights[c] += r.weights[c];
+    }
+    obj += r.obj;
+  }
+
+  size_t begin;
+  size_t end;
+  eigen_svec_list_t means;
+  eigen_smat_list_t covs;  // full covariance only
+  vector<eigen_dvec_t> sq_sums;  // diagonal covariance only
+  vector<double> weights;
+  double obj;
+};
+
+gmm::gmm()
+    : d_(0), k_(0), diagonal_(false), num_threads_(1), rand_(time(NULL)) {
+}
+
+gmm::gmm(bool diagonal, int num_threads)
+    : d_(0), k_(0), diagonal_(diagonal), num_threads_(max(num_threads, 1)),
+      rand_(time(NULL)) {
+}
+
+gmm::gmm(bool diagonal, int num_threads, uint32_t seed)
+    : d_(0), k_(0), diagonal_(diagonal), num_threads_(max(num_threads, 1)),
+      rand_(seed) {
+}
+
 void gmm::batch(const eigen_wsvec_list_t& data, int d, int k) {
   if (data.empty()) {
-    *this = gmm();
+    // keep the random stream so that a seeded model stays reproducible
+    jubatus::util::math::random::mtrand r = rand_;
+    *this = gmm(diagonal_, num_threads_);
+    rand_ = r;
     return;
   }
 
-  typedef eigen_wsvec_list_t::const_iterator data_iter;
   initialize(data, d, k);
 
+  const size_t num_threads = min(static_cast<size_t>(num_threads_),
+                                 data.size());
   eigen_svec_list_t old_means;
-  eigen_smat_list_t old_covs;
-  eigen_solver_list_t old_solvers;
   double old_obj = 0, obj = 0;
-  vector<double> weights(k);
 
   bool converged = false;
   int64_t niter = 1;
   while (!converged) {
-    old_covs = covs_;
     old_means = means_;
-    old_solvers = cov_solvers_;
     old_obj = obj;
-    obj = 0;
-    fill(weights.begin(), weights.end(), 0);
-    fill(means_.begin(), means_.end(), eigen_svec_t(d));
-    fill(covs_.begin(), covs_.end(), eigen_smat_t(d, d));
-
-    for (data_iter i = data.begin(); i != data.end(); ++i) {
-      eigen_svec_t cps =
-          cluster_probs(i->data, old_means, old_covs, old_solvers);
-      for (int c = 0; c < k; ++c) {
-        double cp = i->weight * cps.coeff(c);
-        means_[c] += cp * i->data;
-        covs_[c] += i->data * (i->data.transpose()) * cp;
-        weights[c] += cp;
-        obj -= std::log(cp);
+
+    vector<estep_result> results;
+    for (size_t t = 0; t < num_threads; ++t) {
+      results.push_back(estep_result(data.size() * t / num_threads,
+                                     data.size() * (t + 1) / num_threads,
+                                     d, k, diagonal_));
+    }
+    if (num_threads == 1) {
+      estep(&data, &results[0]);
+    } else {
+      vector<shared_ptr<thread> > threads;
+      for (size_t t = 0; t < num_threads; ++t) {
+        threads.push_back(shared_ptr<thread>(
+            new thread(bind(&gmm::estep, this, &data, &results[t]))));
+        threads.back()->start();
       }
+      for (size_t t = 0; t < num_threads; ++t) {
+        threads[t]->join();
+      }
+    }
+    estep_result& r = results[0];
+    for (size_t t = 1; t < num_threads; ++t) {
+      r.add(results[t]);
     }
+    obj = r.obj;
+
+    const double eps = 0.1;
     for (int c = 0; c < k; ++c) {
-      means_[c] /= weights[c];
-      covs_[c] /= weights[c];
-      double eps = 0.1;
-      covs_[c] -= means_[c] * means_[c].transpose();
-      covs_[c] += eps * eye_;
-      cov_solvers_[c] =
-          shared_ptr<eigen_solver_t>(new eigen_solver_t(covs_[c]));
+      means_[c] = r.means[c] / r.weights[c];
+      if (diagonal_) {
+        covs_[c] = eigen_smat_t(d, d);
+        for (int i = 0; i < d; ++i) {
+          const double m = means_[c].coeff(i);
+          covs_[c].insert(i, i) =
+              r.sq_sums[c](i) / r.weights[c] - m * m + eps;
+        }
+      } else {
+        covs_[c] = r.covs[c] / r.weights[c];
+        covs_[c] -= means_[c] * means_[c].transpose();
+        covs_[c] += eps * eye_;
+      }
+      cov_factors_[c] = factorize(covs_[c]);
     }
     converged = is_converged(niter++, means_, old_means, obj, old_obj);
   }
@@ -99,7 +175,7 @@ int64_t gmm::get_nearest_center_index(const eigen_svec_t& p) const {
 
   double max_prob = 0;
   int64_t max_idx = 0;
-  eigen_svec_t cps = cluster_probs(p, means_, covs_, cov_solvers_);
+  eigen_svec_t cps = cluster_probs(p, means_, cov_factors_);
   for (int c = 0; c < k_; ++c) {
     double cp = cps.coeff(c);
     if (cp > max_prob) {
@@ -115,20 +191,19 @@ void gmm::initialize(const eigen_wsvec_list_t& data, int d, int k) {
   k_ = k;
   means_ = eigen_svec_list_t(k);
   covs_ = eigen_smat_list_t(k, eigen_smat_t(d, d));
-  cov_solvers_ = eigen_solver_list_t(k);
+  cov_factors_ = eigen_cov_factor_list_t(k);
   eye_ = eigen_smat_t(d, d);
 
   for (int i = 0; i < d; ++i) {
     eye_.insert(i, i) = 1;
   }
 
-  jubatus::util::math::random::mtrand r(time(NULL));
   for (int c = 0; c < k; ++c) {
-    means_[c] = data[r.next_int(0, data.size()-1)].data;
+    means_[c] = data[rand_.next_int(0, data.size()-1)].data;
     for (int i = 0; i < d; ++i) {
       covs_[c].insert(i, i) = 1;
     }
-    cov_solvers_[c] = shared_ptr<eigen_solver_t>(new eigen_solver_t(covs_[c]));
+    cov_factors_[c] = factorize(covs_[c]);
   }
 }
 
@@ -145,18 +220,85 @@ bool gmm::is_converged(
   return (max_dist < 1e-09 || niter > 1e05);
 }
 
+void gmm::estep(
+    const eigen_wsvec_list_t* data,
+    estep_result* result) const {
+  for (size_t n = result->begin; n < result->end; ++n) {
+    const eigen_wsvec_t& p = (*data)[n];
+    eigen_svec_t cps = cluster_probs(p.data, means_, cov_factors_);
+    for (int c = 0; c < k_; ++c) {
+      double cp = p.weight * cps.coeff(c);
+      result->means[c] += cp * p.data;
+      if (diagonal_) {
+        for (eigen_svec_t::InnerIterator it(p.data); it; ++it) {
+          result->sq_sums[c](it.index()) += cp * it.value() * it.value();
+        }
+      } else {
+        result->covs[c] += p.data * (p.data.transpose()) * cp;
+      }
+      result->weights[c] += cp;
+      result->obj -= std::log(cp);
+    }
+  }
+}
+
+eigen_cov_factor_t gmm::factorize(const eigen_smat_t& cov) const {
+  eigen_cov_factor_t f;
+  f.log_det = 0;
+  if (diagonal_) {
+    f.inv_diag = eigen_dvec_t(d_);
+    for (int i = 0; i < d_; ++i) {
+      const double v = cov.coeff(i, i);
+      f.inv_diag(i) = 1 / v;
+      f.log_det += std::log(v);
+    }
+    return f;
+  }
+
+  if (d_ <= DENSE_DIMENSION_MAX) {
+    shared_ptr<eigen_dense_solver_t> llt(
+        new eigen_dense_solver_t(eigen_dmat_t(cov)));
+    if (llt->info() == Eigen::Success) {
+      const eigen_dmat_t& l = llt->matrixLLT();
+      for (int i = 0; i < d_; ++i) {
+        f.log_det += 2 * std::log(l(i, i));
+      }
+      f.dense_solver = llt;
+      return f;
+    }
+    // not positive definite; fall back to LDLT below
+  }
+
+  f.sparse_solver.reset(new eigen_solver_t(cov));
+  const eigen_dvec_t diag = f.sparse_solver->vectorD();
+  for (int i = 0; i < diag.size(); ++i) {
+    f.log_det += std::log(std::abs(diag(i)));
+  }
+  return f;
+}
+
 eigen_svec_t gmm::cluster_probs(
     const eigen_svec_t& x,
     const eigen_svec_list_t& means,
-    const eigen_smat_list_t& covs,
-    const eigen_solver_list_t& cov_solvers) const {
+    const eigen_cov_factor_list_t& factors) const {
   double den = DBL_MIN;
   eigen_svec_t ret(k_);
   for (int i = 0; i < k_; ++i) {
+    const eigen_cov_factor_t& f = factors[i];
     eigen_svec_t dif = x - means[i];
-    double det = std::abs(cov_solvers[i]->determinant());
-    double quad = (dif.transpose() * cov_solvers[i]->solve(dif)).sum();
-    double lp = -1 / 2. * (std::log(det) + quad);
+    double quad = 0;
+    if (f.dense_solver) {
+      eigen_dvec_t y = dif;
+      f.dense_solver->matrixL().solveInPlace(y);
+      quad = y.squaredNorm();
+    } else if (f.sparse_solver) {
+      quad = (dif.transpose() * f.sparse_solver->solve(dif)).sum();
+    } else {
+      for (eigen_svec_t::InnerIterator it(dif); it; ++it) {
+        quad += it.value() * it.value() * f.inv_diag(it.index());
+      }
+    }
+    double lp = -1 / 2. * (f.log_det + quad);
     ret.coeffRef(i) = lp;
     den = (den == DBL_MIN) ?
         lp : std::max(den, lp) +
@@ -17,6 +17,7 @@
 #ifndef JUBATUS_CORE_CLUSTERING_GMM_HPP_
 #define JUBATUS_CORE_CLUSTERING_GMM_HPP_
 
+#include "jubatus/util/math/random.h"
 #include "gmm_types.hpp"
 
 namespace jubatus {
@@ -25,6 +26,11 @@ namespace clustering {
 
 class gmm {
  public:
+  gmm();
+  gmm(bool diagonal, int num_threads);
+  // seed fixes the choice of initial means (time-seeded otherwise)
+  gmm(bool diagonal, int num_threads, uint32_t seed);
+
   void batch(const eigen_wsvec_list_t& data, int d, int k);
   eigen_svec_list_t get_centers() {
     return means_;
@@ -36,6 +42,8 @@ class gmm {
   int64_t get_nearest_center_index(const eigen_svec_t& p) const;
 
  private:
+  struct estep_result;
+
   void initialize(const eigen_wsvec_list_t& data, int d, int k);
   bool is_converged(
       int64_t niter,
@@ -43,17 +51,21 @@ class gmm {
       const eigen_svec_list_t& old_means,
       double obj,
       double old_obj);
+  void estep(const eigen_wsvec_list_t* data, estep_result* result) const;
+  eigen_cov_factor_t factorize(const eigen_smat_t& cov) const;
   eigen_svec_t cluster_probs(
       const eigen_svec_t& x,
       const eigen_svec_list_t& mean,
-      const eigen_smat_list_t& cov,
-      const eigen_solver_list_t& solvers) const;
+      const eigen_cov_factor_list_t& factors) const;
   eigen_svec_list_t means_;
   eigen_smat_list_t covs_;
   eigen_smat_t eye_;
-  eigen_solver_list_t cov_solvers_;
+  eigen_cov_factor_list_t cov_factors_;
   int d_;
   int k_;
+  bool diagonal_;
+  int num_threads_;
+  jubatus::util::math::random::mtrand rand_;
 };
 
 }  // namespace clustering
@@ -31,21 +31,43 @@ gmm_clustering_method::gmm_clustering_method(size_t k)
     : k_(k), kcenters_(), mapper_(), gmm_() {
 }
 
+gmm_clustering_method::gmm_clustering_method(
+    size_t k,
+    bool diagonal,
+    int num_threads)
+    : k_(k), kcenters_(), mapper_(), gmm_(diagonal, num_threads) {
+}
+
 gmm_clustering_method::~gmm_clustering_method() {
 }
 
 void gmm_clustering_method::batch_update(wplist points) {
   if (points.empty()) {
-    *this = gmm_clustering_method(k_);
+    mapper_.clear();
+    kcenters_.clear();
+    gmm_.batch(eigen_wsvec_list_t(), 0, k_);
     return;
   }
-  mapper_.clear();
+  mapper_.start_run();
   eigen_wsvec_list_t data = mapper_.convert(points, true);
+  if (mapper_.should_rebuild()) {
+    mapper_.clear();
+    mapper_.start_run();
+    data = mapper_.convert(points, true);
+  }
   gmm_.batch(data, mapper_.get_dimension(), k_);
   kcenters_ = mapper_.revert(gmm_.get_centers());
 }
 
-void gmm_clustering_method::online_update(wplist points) {
+void gmm_clustering_method::online_update(const wplist& points) {
+}
+
+void gmm_clustering_method::pack(framework::packer& packer) const {
+  // everything is recomputed from the storage
+  packer.pack_nil();
+}
+
+void gmm_clustering_method::unpack(msgpack::object o) {
 }
 
 std::vector<common::sfv_t> gmm_clustering_method::get_k_center() const {
@@ -30,16 +30,20 @@ namespace clustering {
 class gmm_clustering_method : public clustering_method {
  public:
   explicit gmm_clustering_method(size_t k);
+  gmm_clustering_method(size_t k, bool diagonal, int num_threads);
   ~gmm_clustering_method();
 
   void batch_update(wplist points);
-  void online_update(wplist points);
+  void online_update(const wplist& points);
   std::vector<common::sfv_t> get_k_center() const;
   common::sfv_t get_nearest_center(const common::sfv_t& point) const;
   int64_t get_nearest_center_index(const common::sfv_t& point) const;
   wplist get_cluster(size_t cluster_id, const wplist& points) const;
   std::vector<wplist> get_clusters(const wplist& points) const;
 
+  void pack(framework::packer& packer) const;
+  void unpack(msgpack::object o);
+
  private:
   size_t k_;
   std::vector<common::sfv_t> kcenters_;
@@ -27,20 +27,27 @@ namespace clustering {
 
 class gmm_test : public ::testing::Test {
  protected:
+  // fixed seeds so that neither the data nor the initial means vary by run
+  static const uint32_t seed_ = 1;
+
+  gmm_test()
+      : r_(seed_) {
+  }
+
   static const size_t k_ = 2;
   static const size_t d_ = 2;
   static const double epsilon_ = 0.3;
 
   virtual void SetUp() {
-    gmm_.reset(new gmm);
+    gmm_.reset(new gmm(false, 1, seed_));
   }
 
-  void do_batch(size_t num) {
+  void do_batch(size_t num, size_t d = d_) {
     eigen_wsvec_list_t vs;
     for (size_t i = 0; i < num; ++i) {
       eigen_wsvec_t wsvec_a, wsvec_b;
-      wsvec_a.data = eigen_svec_t(2);
-      wsvec_b.data = eigen_svec_t(2);
+      wsvec_a.data = eigen_svec_t(d);
+      wsvec_b.data = eigen_svec_t(d);
       wsvec_a.data.coeffRef(0) = r_.next_gaussian() + 2.0;
       wsvec_a.data.coeffRef(1) = r_.next_gaussian() + 2.0;
       wsvec_b.data.coeffRef(0) = r_.next_gaussian() - 2.0;
@@ -50,7 +57,22 @@ class gmm_test : public ::testing::Test {
       vs.push_back(wsvec_a);
       vs.push_back(wsvec_b);
     }
-    gmm_->batch(vs, k_, d_);
+    gmm_->batch(vs, d, k_);
+  }
+
+  void expect_separated() {
+    eigen_svec_t svec_a(gmm_->get_centers()[0].size());
+    eigen_svec_t svec_b(svec_a.size());
+    svec_a.coeffRef(0) = 2.0;
+    svec_a.coeffRef(1) = 2.0;
+    svec_b.coeffRef(0) = -2.0;
+    svec_b.coeffRef(1) = -2.0;
+    eigen_svec_t nc_a = gmm_->get_nearest_center(svec_a);
+    eigen_svec_t nc_b = gmm_->get_nearest_center(svec_b);
+    EXPECT_NEAR(nc_a.coeffRef(0), 2.0, epsilon_);
+    EXPECT_NEAR(nc_a.coeffRef(1), 2.0, epsilon_);
+    EXPECT_NEAR(nc_b.coeffRef(0), -2.0, epsilon_);
+    EXPECT_NEAR(nc_b.coeffRef(1), -2.0, epsilon_);
   }
 
   jubatus::util::math::random::mtrand r_;
@@ -114,6 +136,29 @@ TEST_F(gmm_test, clear_with_empty_list) {
     common::exception::runtime_error);
 }
 
+TEST_F(gmm_test, diagonal_covariance) {
+  gmm_.reset(new gmm(true, 1, seed_));
+  do_batch(500);
+  expect_separated();
+
+  eigen_smat_list_t covs = gmm_->get_covs();
+  EXPECT_NEAR(covs[0].coeffRef(0, 0), 1.0, epsilon_);
+  EXPECT_EQ(0.0, covs[0].coeffRef(0, 1));
+  EXPECT_EQ(0.0, covs[1].coeffRef(1, 0));
+}
+
+TEST_F(gmm_test, multi_thread) {
+  gmm_.reset(new gmm(false, 4, seed_));
+  do_batch(500);
+  expect_separated();
+}
+
+TEST_F(gmm_test, high_dimension) {
+  // factorized with the sparse solver instead of the dense one
+  do_batch(500, 300);
+  expect_separated();
+}
+
 }  // namespace clustering
 }  // namespace core
 }  // namespace jubatus
@@ -20,6 +20,7 @@
 #include <algorithm>
 #include <vector>
 #include "jubatus/util/lang/shared_ptr.h"
+#include "../third_party/Eigen/Cholesky"
 #include "../third_party/Eigen/Sparse"
 
 namespace jubatus {
@@ -33,6 +34,20 @@ typedef std::vector<eigen_svec_t> eigen_svec_list_t;
 typedef std::vector<eigen_smat_t> eigen_smat_list_t;
 typedef std::vector<jubatus::util::lang::shared_ptr<eigen_solver_t> >
   eigen_solver_list_t;
+typedef Eigen::VectorXd eigen_dvec_t;
+typedef Eigen::MatrixXd eigen_dmat_t;
+typedef Eigen::LLT<eigen_dmat_t> eigen_dense_solver_t;
+
+// covariance of a cluster, factorized once per M-step;
+// which member is used depends on the dimension and covariance mode
+struct eigen_cov_factor_t {
+  double log_det;
+  eigen_dvec_t inv_diag;
+  jubatus::util::lang::shared_ptr<eigen_dense_solver_t> dense_solver;
+  jubatus::util::lang::shared_ptr<eigen_solver_t> sparse_solver;
+};
+
+typedef std::vector<eigen_cov_factor_t> eigen_cov_factor_list_t;
 
 struct eigen_wsvec_t {
   double weight;
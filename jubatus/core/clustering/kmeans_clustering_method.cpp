@@ -16,11 +16,13 @@
 
 #include "kmeans_clustering_method.hpp"
 
-#include <iostream>
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
 #include <utility>
 #include <vector>
 #include "../common/exception.hpp"
-#include "util.hpp"
+#include "discrete_distribution.hpp"
 
 using std::pair;
 using std::vector;
@@ -29,8 +31,48 @@ namespace jubatus {
 namespace core {
 namespace clustering {
 
+namespace {
+
+typedef vector<pair<size_t, double> > id_sums;
+
+bool id_less(const pair<size_t, float>& lhs, const pair<size_t, float>& rhs) {
+  return lhs.first < rhs.first;
+}
+
+bool sum_id_less(
+    const pair<size_t, double>& lhs,
+    const pair<size_t, double>& rhs) {
+  return lhs.first < rhs.first;
+}
+
+void add_point(const indexed_fv_t& p, double w, id_sums& sums) {
+  for (indexed_fv_t::const_iterator it = p.begin(); it != p.end(); ++it) {
+    sums.push_back(std::make_pair(it->first, w * it->second));
+  }
+}
+
+// sorts sums by id and adds up the values of the same id
+void reduce_sums(id_sums& sums) {
+  std::sort(sums.begin(), sums.end(), sum_id_less);
+  id_sums::iterator out = sums.begin();
+  for (id_sums::const_iterator it = sums.begin(); it != sums.end(); ++it) {
+    if (out != sums.begin() && (out - 1)->first == it->first) {
+      (out - 1)->second += it->second;
+    } else {
+      *out++ = *it;
+    }
+  }
+  sums.erase(out, sums.end());
+}
+
+}  // namespace
+
 kmeans_clustering_method::kmeans_clustering_method(size_t k)
-    : k_(k) {
+    : k_(k), streaming_(false) {
+}
+
+kmeans_clustering_method::kmeans_clustering_method(size_t k, bool streaming)
+    : k_(k), streaming_(streaming) {
 }
 
 kmeans_clustering_method::~kmeans_clustering_method() {
@@ -39,61 +81,285 @@ kmeans_clustering_method::~kmeans_clustering_method() {
 void kmeans_clustering_method::batch_update(wplist points) {
   if (points.empty()) {
     kcenters_.clear();
+    mapper_.clear();
+    centers_.clear();
+    warmup_.clear();
     return;
   }
-  initialize_centers(points);
-  do_batch_update(points);
-}
-
-void kmeans_clustering_method::initialize_centers(wplist& points) {
   if (points.size() < k_) {
     return;
   }
-  kcenters_.clear();
-  kcenters_.push_back(points[0].data);
+  warmup_.clear();
+  vector<indexed_fv_t> data;
+  map_points(points, data);
+  initialize_centers(points, data);
+  do_batch_update(points, data);
+
+  kcenters_.resize(k_);
+  for (size_t c = 0; c < k_; ++c) {
+    kcenters_[c] = revert_center(c);
+  }
+}
+
+void kmeans_clustering_method::map_points(
+    const wplist& points,
+    vector<indexed_fv_t>& data) {
+  data.resize(points.size());
+  mapper_.start_run();
+  for (size_t i = 0; i < points.size(); ++i) {
+    mapper_.convert(points[i].data, data[i]);
+  }
+  if (mapper_.should_rebuild()) {
+    mapper_.clear();
+    mapper_.start_run();
+    for (size_t i = 0; i < points.size(); ++i) {
+      mapper_.convert(points[i].data, data[i]);
+    }
+  }
+  for (size_t i = 0; i < data.size(); ++i) {
+    std::sort(data[i].begin(), data[i].end(), id_less);
+  }
+}
+
+void kmeans_clustering_method::initialize_centers(
+    const wplist& points,
+    const vector<indexed_fv_t>& data) {
+  centers_.resize(k_);
+  set_center(0, data[0]);
   vector<double> weights;
-  while (kcenters_.size() < k_) {
+  for (size_t c = 1; c < k_; ++c) {
     weights.clear();
-    for (wplist::iterator it = points.begin(); it != points.end(); ++it) {
-      pair<int64_t, double> m = min_dist((*it).data, kcenters_);
-      weights.push_back(m.second * it->weight);
+    for (size_t i = 0; i < data.size(); ++i) {
+      weights.push_back(nearest(data[i], c).second * points[i].weight);
     }
     discrete_distribution d(weights.begin(), weights.end());
-    kcenters_.push_back(points[d()].data);
+    set_center(c, data[d()]);
   }
 }
 
-void kmeans_clustering_method::do_batch_update(wplist& points) {
-  static jubatus::util::math::random::mtrand r;
+void kmeans_clustering_method::do_batch_update(
+    const wplist& points,
+    const vector<indexed_fv_t>& data) {
+  vector<id_sums> sums(k_);
+  vector<double> center_count(k_);
   bool terminated = false;
-  if (points.size() < k_) {
-    return;
-  }
   while (!terminated) {
-    vector<common::sfv_t> kcenters_new(k_);
-    vector<double> center_count(k_, 0);
-    for (wplist::iterator it = points.begin(); it != points.end(); ++it) {
-      pair<int64_t, double> m = min_dist((*it).data, kcenters_);
-      scalar_mul_and_add(it->data, it->weight, kcenters_new[m.first]);
-      center_count[m.first] += it->weight;
+    for (size_t c = 0; c < k_; ++c) {
+      sums[c].clear();
+    }
+    std::fill(center_count.begin(), center_count.end(), 0);
+    for (size_t i = 0; i < data.size(); ++i) {
+      const size_t c = nearest(data[i], k_).first;
+      add_point(data[i], points[i].weight, sums[c]);
+      center_count[c] += points[i].weight;
     }
     terminated = true;
-    for (size_t i = 0; i < k_; ++i) {
-      if (center_count[i] == 0) {
-        kcenters_new[i] = kcenters_[i];
+    for (size_t c = 0; c < k_; ++c) {
+      if (center_count[c] == 0) {
         continue;
       }
-      kcenters_new[i] = scalar_dot(kcenters_new[i], 1.0 / center_count[i]);
-      double d = dist(kcenters_new[i], kcenters_[i]);
-      if (d > 1e-9) {
+      reduce_sums(sums[c]);
+      center next;
+      next.weight = 0;
+      next.sum_norm2 = 0;
+      add_to_center(next, sums[c], center_count[c]);
+
+      // squared distance between the old and the new center
+      center& prev = centers_[c];
+      double d = 0;
+      indexed_fv_t::const_iterator it = prev.sum.begin();
+      indexed_fv_t::const_iterator jt = next.sum.begin();
+      while (it != prev.sum.end() || jt != next.sum.end()) {
+        double u = 0, v = 0;
+        if (jt == next.sum.end() ||
+            (it != prev.sum.end() && it->first < jt->first)) {
+          u = it++->second / prev.weight;
+        } else if (it == prev.sum.end() || jt->first < it->first) {
+          v = jt++->second / next.weight;
+        } else {
+          u = it++->second / prev.weight;
+          v = jt++->second / next.weight;
+        }
+        d += (u - v) * (u - v);
+      }
+      prev.sum.swap(next.sum);
+      prev.weight = next.weight;
+      prev.sum_norm2 = next.sum_norm2;
+      if (std::sqrt(d) > 1e-9) {
         terminated = false;
       }
     }
-    kcenters_ = kcenters_new;
   }
 }
 
-void kmeans_clustering_method::online_update(wplist points) {
+void kmeans_clustering_method::set_center(size_t c, const indexed_fv_t& p) {
+  center& ct = centers_[c];
+  ct.sum = p;
+  ct.weight = 1;
+  ct.sum_norm2 = 0;
+  for (indexed_fv_t::const_iterator it = p.begin(); it != p.end(); ++it) {
+    ct.sum_norm2 += static_cast<double>(it->second) * it->second;
+  }
+}
+
+// Adds |sum|, sorted by id, to the sum of |c|; ids already in the center
+// are updated in place, so only new ids move the others.
+void kmeans_clustering_method::add_to_center(
+    center& c,
+    const id_sums& sum,
+    double weight) {
+  indexed_fv_t added;
+  indexed_fv_t::iterator s = c.sum.begin();
+  for (id_sums::const_iterator it = sum.begin(); it != sum.end(); ++it) {
+    s = std::lower_bound(s, c.sum.end(),
+                         std::make_pair(it->first, 0.0f), id_less);
+    if (s != c.sum.end() && s->first == it->first) {
+      c.sum_norm2 -= static_cast<double>(s->second) * s->second;
+      s->second += it->second;
+      c.sum_norm2 += static_cast<double>(s->second) * s->second;
+    } else {
+      added.push_back(std::make_pair(it->first, it->second));
+      c.sum_norm2 += static_cast<double>(added.back().second) *
+          added.back().second;
+    }
+  }
+  if (!added.empty()) {
+    const size_t n = c.sum.size();
+    c.sum.insert(c.sum.end(), added.begin(), added.end());
+    std::inplace_merge(c.sum.begin(), c.sum.begin() + n, c.sum.end(), id_less);
+  }
+  c.weight += weight;
+}
+
+// |p|, sorted by id, and the center are sparse:
+// |p - s/w|^2 = |s|^2/w^2 + sum_i p_i (p_i - 2 s_i/w) over non-zeros of p
+double kmeans_clustering_method::distance2(
+    const center& c,
+    const indexed_fv_t& p) {
+  double d2 = c.sum_norm2 / (c.weight * c.weight);
+  indexed_fv_t::const_iterator s = c.sum.begin();
+  for (indexed_fv_t::const_iterator it = p.begin(); it != p.end(); ++it) {
+    s = std::lower_bound(s, c.sum.end(), *it, id_less);
+    const double x = it->second;
+    const double y = s != c.sum.end() && s->first == it->first ?
+        s->second / c.weight : 0;
+    d2 += x * (x - 2 * y);
+  }
+  return d2;
+}
+
+pair<size_t, double> kmeans_clustering_method::nearest(
+    const indexed_fv_t& p,
+    size_t num_centers) const {
+  size_t idx = 0;
+  double min_d2 = DBL_MAX;
+  for (size_t c = 0; c < num_centers; ++c) {
+    const double d2 = distance2(centers_[c], p);
+    if (min_d2 > d2) {
+      idx = c;
+      min_d2 = d2;
+    }
+  }
+  return std::make_pair(idx, std::sqrt(std::max(min_d2, 0.0)));
+}
+
+common::sfv_t kmeans_clustering_method::revert_center(size_t c) const {
+  common::sfv_t ret;
+  const center& ct = centers_[c];
+  for (indexed_fv_t::const_iterator it = ct.sum.begin();
+       it != ct.sum.end(); ++it) {
+    const float v = it->second / ct.weight;
+    if (v != 0) {
+      ret.push_back(std::make_pair(mapper_.get_key(it->first), v));
+    }
+  }
+  std::sort(ret.begin(), ret.end());
+  return ret;
+}
+
+void kmeans_clustering_method::online_update(const wplist& points) {
+  if (!streaming_ || points.empty()) {
+    return;
+  }
+  if (centers_.size() < k_) {
+    // the first k points pushed give the initial centers
+    warmup_.insert(warmup_.end(), points.begin(), points.end());
+    if (warmup_.size() >= k_) {
+      wplist warmup;
+      warmup.swap(warmup_);
+      batch_update(warmup);
+    }
+    return;
+  }
+
+  // assign the whole mini-batch with the current centers, then move each
+  // center to the weighted mean of its previous members and new members;
+  // only the ids in the mini-batch are touched
+  vector<id_sums> sums(k_);
+  vector<double> batch_weights(k_);
+  indexed_fv_t p;
+  for (size_t i = 0; i < points.size(); ++i) {
+    mapper_.convert(points[i].data, p);
+    std::sort(p.begin(), p.end(), id_less);
+    const size_t c = nearest(p, k_).first;
+    add_point(p, points[i].weight, sums[c]);
+    batch_weights[c] += points[i].weight;
+  }
+  for (size_t c = 0; c < k_; ++c) {
+    if (batch_weights[c] <= 0) {
+      continue;
+    }
+    reduce_sums(sums[c]);
+    add_to_center(centers_[c], sums[c], batch_weights[c]);
+    kcenters_[c] = revert_center(c);
+  }
+}
+
+void kmeans_clustering_method::pack(framework::packer& packer) const {
+  vector<double> weights(centers_.size());
+  for (size_t c = 0; c < centers_.size(); ++c) {
+    weights[c] = centers_[c].weight;
+  }
+  packer.pack_array(3);
+  packer.pack(kcenters_);
+  packer.pack(weights);
+  packer.pack(warmup_);
+}
+
+void kmeans_clustering_method::unpack(msgpack::object o) {
+  if (o.type != msgpack::type::ARRAY || o.via.array.size != 3) {
+    throw msgpack::type_error();
+  }
+  vector<common::sfv_t> kcenters;
+  vector<double> weights;
+  wplist warmup;
+  o.via.array.ptr[0].convert(&kcenters);
+  o.via.array.ptr[1].convert(&weights);
+  o.via.array.ptr[2].convert(&warmup);
+  if (kcenters.size() != weights.size() ||
+      (!kcenters.empty() && kcenters.size() != k_)) {
+    throw msgpack::type_error();
+  }
+
+  // centers are saved as key-addressed means; ids are assigned anew
+  mapper_.clear();
+  centers_.resize(kcenters.size());
+  for (size_t c = 0; c < kcenters.size(); ++c) {
+    center& ct = centers_[c];
+    ct.sum.clear();
+    ct.weight = weights[c];
+    ct.sum_norm2 = 0;
+    for (common::sfv_t::const_iterator it = kcenters[c].begin();
+         it != kcenters[c].end(); ++it) {
+      ct.sum.push_back(std::make_pair(mapper_.insert(it->first),
+                                      it->second * weights[c]));
+      ct.sum_norm2 += static_cast<double>(ct.sum.back().second) *
+          ct.sum.back().second;
+    }
+    std::sort(ct.sum.begin(), ct.sum.end(), id_less);
+  }
+  kcenters_.swap(kcenters);
+  warmup_.swap(warmup);
 }
 
 vector<common::sfv_t> kmeans_clustering_method::get_k_center() const {
@@ -102,7 +368,10 @@ vector<common::sfv_t> kmeans_clustering_method::get_k_center() const {
 
 int64_t kmeans_clustering_method::get_nearest_center_index(
     const common::sfv_t& point) const {
-  return min_dist(point, kcenters_).first;
+  indexed_fv_t p;
+  mapper_.convertc(point, p);
+  std::sort(p.begin(), p.end(), id_less);
+  return nearest(p, centers_.size()).first;
 }
 
 common::sfv_t kmeans_clustering_method::get_nearest_center(
@@ -122,9 +391,11 @@ wplist kmeans_clustering_method::get_cluster(
 vector<wplist> kmeans_clustering_method::get_clusters(
     const wplist& points) const {
   vector<wplist> ret(k_);
+  indexed_fv_t p;
   for (wplist::const_iterator it = points.begin(); it != points.end(); ++it) {
-    pair<int64_t, double> m = min_dist(it->data, kcenters_);
-    ret[m.first].push_back(*it);
+    mapper_.convertc(it->data, p);
+    std::sort(p.begin(), p.end(), id_less);
+    ret[nearest(p, centers_.size()).first].push_back(*it);
   }
   return ret;
 }
@@ -17,8 +17,10 @@
 #ifndef JUBATUS_CORE_CLUSTERING_KMEANS_CLUSTERING_METHOD_HPP_
 #define JUBATUS_CORE_CLUSTERING_KMEANS_CLUSTERING_METHOD_HPP_
 
+#include <utility>
 #include <vector>
 #include "clustering_method.hpp"
+#include "feature_mapper.hpp"
 
 namespace jubatus {
 namespace core {
@@ -27,22 +29,60 @@ namespace clustering {
 class kmeans_clustering_method : public clustering_method {
  public:
   explicit kmeans_clustering_method(size_t k);
+  // in streaming mode, online_update() refines the centers with each
+  // pushed mini-batch instead of waiting for the next batch_update();
+  // until there are centers, pushed points are kept and the centers are
+  // initialized from them once there are k
+  kmeans_clustering_method(size_t k, bool streaming);
   ~kmeans_clustering_method();
 
   void batch_update(wplist points);
-  void online_update(wplist points);
+  void online_update(const wplist& points);
   std::vector<common::sfv_t> get_k_center() const;
   common::sfv_t get_nearest_center(const common::sfv_t& point) const;
   int64_t get_nearest_center_index(const common::sfv_t& point) const;
   wplist get_cluster(size_t cluster_id, const wplist& points) const;
   std::vector<wplist> get_clusters(const wplist& points) const;
 
+  void pack(framework::packer& packer) const;
+  void unpack(msgpack::object o);
+
  private:
-  void initialize_centers(wplist& points);
-  void do_batch_update(wplist& points);
+  // a center as the weighted sum of its members, sorted by id, and their
+  // total weight; the center itself is sum / weight
+  struct center {
+    indexed_fv_t sum;
+    double weight;
+    double sum_norm2;  // |sum|^2
+  };
+
+  void map_points(const wplist& points, std::vector<indexed_fv_t>& data);
+  void initialize_centers(
+      const wplist& points,
+      const std::vector<indexed_fv_t>& data);
+  void do_batch_update(
+      const wplist& points,
+      const std::vector<indexed_fv_t>& data);
+  void set_center(size_t c, const indexed_fv_t& p);
+  static void add_to_center(
+      center& c,
+      const std::vector<std::pair<size_t, double> >& sum,
+      double weight);
+  static double distance2(const center& c, const indexed_fv_t& p);
+  std::pair<size_t, double> nearest(
+      const indexed_fv_t& p,
+      size_t num_centers) const;
+  common::sfv_t revert_center(size_t c) const;
 
   std::vector<common::sfv_t> kcenters_;
   size_t k_;
+  bool streaming_;
+
+  // centers over the ids of mapper_
+  feature_mapper mapper_;
+  std::vector<center> centers_;
+  // points pushed in streaming mode before the centers are initialized
+  wplist warmup_;
 };
 
 }  // namespace clustering
@@ -0,0 +1,225 @@
+// Jubatus: Online machine learning framework for distributed environment
+// Copyright (C) 2015 Preferred Networks and Nippon Telegraph and Telephone Corporation.
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License version 2.1 as published by the Free Software Foundation.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+
+#include "metrics.hpp"
+
+#include <time.h>
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "jubatus/util/concurrent/lock.h"
+#include "jubatus/util/lang/cast.h"
+
+using jubatus::util::concurrent::mutex;
+using jubatus::util::concurrent::scoped_lock;
+using jubatus::util::lang::lexical_cast;
+
+namespace jubatus {
+namespace core {
+namespace common {
+namespace metrics {
+
+namespace {
+
+const char* const operation_names[NUM_OPERATIONS] = {
+  "convert",
+  "train",
+  "classify",
+  "neighbor_search",
+  "get_diff",
+  "put_diff",
+  "pack",
+  "unpack",
+};
+
+const uint64_t max_value = (1LLU << histogram::MAX_BITS) - 1;
+
+// Index of the shard the calling thread records to, plus one (zero means
+// not assigned yet).  Threads are assigned shards in round robin.
+__thread size_t thread_shard = 0;
+
+mutex shard_counter_mutex;
+size_t shard_counter = 0;
+
+size_t get_thread_shard() {
+  if (thread_shard == 0) {
+    scoped_lock lk(shard_counter_mutex);
+    thread_shard = shard_counter++ % recorder::NUM_SHARDS + 1;
+  }
+  return thread_shard - 1;
+}
+
+}  // namespace
+
+const int histogram::SUB_BUCKET_BITS;
+const int histogram::MAX_BITS;
+const size_t histogram::NUM_BUCKETS;
+const size_t recorder::NUM_SHARDS;
+
+const char* operation_name(operation op) {
+  return 0 <= op && op < NUM_OPERATIONS ? operation_names[op] : "unknown";
+}
+
+uint64_t now_ns() {
+  timespec ts;
+  if (clock_gettime(CLOCK_MONOTONIC, &ts) != 0) {
+    return 0;
+  }
+  return static_cast<uint64_t>(ts.tv_sec) * 1000000000LLU + ts.tv_nsec;
+}
+
+histogram::histogram()
+    : buckets_(NUM_BUCKETS),
+      count_(0),
+      sum_(0),
+      min_(0),
+      max_(0) {
+}
+
+size_t histogram::bucket_index(uint64_t value) {
+  value = std::min(value, max_value);
+  if (value < (1LLU << SUB_BUCKET_BITS)) {
+    return value;
+  }
+  const int msb = 63 - __builtin_clzll(value);
+  const int shift = msb - SUB_BUCKET_BITS;
+  return (static_cast<size_t>(shift + 1) << SUB_BUCKET_BITS) +
+      ((value >> shift) - (1LLU << SUB_BUCKET_BITS));
+}
+
+uint64_t histogram::bucket_upper_bound(size_t index) {
+  if (index < (1LLU << SUB_BUCKET_BITS)) {
+    return index;
+  }
+  const int shift = (index >> SUB_BUCKET_BITS) - 1;
+  const uint64_t sub = (1LLU << SUB_BUCKET_BITS) +
+      (index & ((1LLU << SUB_BUCKET_BITS) - 1));
+  return ((sub + 1) << shift) - 1;
+}
+
+void histogram::record(uint64_t value) {
+  ++buckets_[bucket_index(value)];
+  if (count_ == 0 || value < min_) {
+    min_ = value;
+  }
+  if (value > max_) {
+    max_ = value;
+  }
+  ++count_;
+  sum_ += value;
+}
+
+void histogram::merge(const histogram& h) {
+  if (h.count_ == 0) {
+    return;
+  }
+  for (size_t i = 0; i < NUM_BUCKETS; ++i) {
+    buckets_[i] += h.buckets_[i];
+  }
+  if (count_ == 0 || h.min_ < min_) {
+    min_ = h.min_;
+  }
+  max_ = std::max(max_, h.max_);
+  count_ += h.count_;
+  sum_ += h.sum_;
+}
+
+void histogram::clear() {
+  std::fill(buckets_.begin(), buckets_.end(), 0);
+  count_ = 0;
+  sum_ = 0;
+  min_ = 0;
+  max_ = 0;
+}
+
+uint64_t histogram::value_at_quantile(double q) const {
+  if (count_ == 0) {
+    return 0;
+  }
+  if (q <= 0) {
+    return min_;
+  }
+  const uint64_t rank = std::max<uint64_t>(
+      1, static_cast<uint64_t>(std::ceil(std::min(q, 1.0) * count_)));
+  uint64_t seen = 0;
+  for (size_t i = 0; i < NUM_BUCKETS; ++i) {
+    seen += buckets_[i];
+    if (seen >= rank) {
+      return std::max(min_, std::min(max_, bucket_upper_bound(i)));
+    }
+  }
+  return max_;
+}
+
+recorder::shard::shard()
+    : histograms(NUM_OPERATIONS) {
+}
+
+recorder::recorder() {
+}
+
+void recorder::record(operation op, uint64_t latency_ns) {
+  shard& s = shards_[get_thread_shard()];
+  scoped_lock lk(s.mutex);
+  s.histograms[op].record(latency_ns);
+}
+
+histogram recorder::get(operation op) const {
+  histogram h;
+  for (size_t i = 0; i < NUM_SHARDS; ++i) {
+    scoped_lock lk(shards_[i].mutex);
+    h.merge(shards_[i].histograms[op]);
+  }
+  return h;
+}
+
+void recorder::get_status(std::map<std::string, std::string>& status) const {
+  for (int op = 0; op < NUM_OPERATIONS; ++op) {
+    const histogram h = get(static_cast<operation>(op));
+    if (h.count() == 0) {
+      continue;
+    }
+    const std::string prefix =
+        std::string("metrics.") + operation_names[op] + ".";
+    status[prefix + "count"] = lexical_cast<std::string>(h.count());
+    status[prefix + "mean_ns"] =
+        lexical_cast<std::string>(static_cast<uint64_t>(h.mean()));
+    status[prefix + "p50_ns"] =
+        lexical_cast<std::string>(h.value_at_quantile(0.5));
+    status[prefix + "p99_ns"] =
+        lexical_cast<std::string>(h.value_at_quantile(0.99));
+    status[prefix + "max_ns"] = lexical_cast<std::string>(h.max());
+  }
+}
+
+void recorder::clear() {
+  for (size_t i = 0; i < NUM_SHARDS; ++i) {
+    scoped_lock lk(shards_[i].mutex);
+    for (size_t j = 0; j < shards_[i].histograms.size(); ++j) {
+      shards_[i].histograms[j].clear();
+    }
+  }
+}
+
+}  // namespace metrics
+}  // namespace common
+}  // namespace core
+}  // namespace jubatus
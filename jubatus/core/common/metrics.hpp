@@ -0,0 +1,171 @@
+// Jubatus: Online machine learning framework for distributed environment
+// Copyright (C) 2015 Preferred Networks and Nippon Telegraph and Telephone Corporation.
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License version 2.1 as published by the Free Software Foundation.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+
+#ifndef JUBATUS_CORE_COMMON_METRICS_HPP_
+#define JUBATUS_CORE_COMMON_METRICS_HPP_
+
+#include <stdint.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "jubatus/util/concurrent/mutex.h"
+
+namespace jubatus {
+namespace core {
+namespace common {
+namespace metrics {
+
+// Operations timed by drivers.
+enum operation {
+  CONVERT = 0,
+  TRAIN,
+  CLASSIFY,
+  NEIGHBOR_SEARCH,
+  GET_DIFF,
+  PUT_DIFF,
+  PACK,
+  UNPACK,
+  NUM_OPERATIONS
+};
+
+const char* operation_name(operation op);
+
+// Monotonic clock in nanoseconds.
+uint64_t now_ns();
+
+// Latency histogram with log-linear buckets in the manner of HDR histograms:
+// each power of two is split into 2^SUB_BUCKET_BITS buckets, so a recorded
+// value is reported with a relative error below 1 / 2^SUB_BUCKET_BITS.
+// Values above 2^MAX_BITS ns (about 18 minutes) fall into the last bucket.
+class histogram {
+ public:
+  static const int SUB_BUCKET_BITS = 3;
+  static const int MAX_BITS = 40;
+  static const size_t NUM_BUCKETS =
+      (MAX_BITS - SUB_BUCKET_BITS + 1) << SUB_BUCKET_BITS;
+
+  histogram();
+
+  void record(uint64_t value);
+  void merge(const histogram& h);
+  void clear();
+
+  uint64_t count() const {
+    return count_;
+  }
+  uint64_t sum() const {
+    return sum_;
+  }
+  uint64_t min() const {
+    return count_ ? min_ : 0;
+  }
+  uint64_t max() const {
+    return max_;
+  }
+  double mean() const {
+    return count_ ? static_cast<double>(sum_) / count_ : 0;
+  }
+
+  // Returns the highest value equivalent to the recorded value at the given
+  // quantile (0 <= q <= 1), clamped to [min(), max()].
+  uint64_t value_at_quantile(double q) const;
+
+  static size_t bucket_index(uint64_t value);
+  static uint64_t bucket_upper_bound(size_t index);
+
+ private:
+  std::vector<uint64_t> buckets_;
+  uint64_t count_;
+  uint64_t sum_;
+  uint64_t min_;
+  uint64_t max_;
+};
+
+// Collects latencies of operations.  Each recording thread writes to its own
+// shard (threads are spread over NUM_SHARDS shards, each guarded by its own
+// mutex), so concurrent drivers do not contend on a single counter; shards
+// are merged when statistics are read.
+class recorder {
+ public:
+  static const size_t NUM_SHARDS = 8;
+
+  recorder();
+
+  void record(operation op, uint64_t latency_ns);
+
+  // Returns the latencies of |op| merged over all threads.
+  histogram get(operation op) const;
+
+  // Adds "metrics.<operation>.{count,mean_ns,p50_ns,p99_ns,max_ns}" for
+  // every operation recorded at least once.
+  void get_status(std::map<std::string, std::string>& status) const;
+
+  void clear();
+
+ private:
+  struct shard {
+    shard();
+
+    mutable jubatus::util::concurrent::mutex mutex;
+    std::vector<histogram> histograms;
+  };
+
+  shard shards_[NUM_SHARDS];
+
+  recorder(const recorder&);
+  void operator=(const recorder&);
+};
+
+// Records the time spent in the enclosing scope.
+class scoped_timer {
+ public:
+  scoped_timer(recorder& r, operation op)
+      : recorder_(r),
+        op_(op),
+        start_(now_ns()) {
+  }
+
+  ~scoped_timer() {
+    recorder_.record(op_, now_ns() - start_);
+  }
+
+ private:
+  recorder& recorder_;
+  const operation op_;
+  const uint64_t start_;
+};
+
+}  // namespace metrics
+}  // namespace common
+}  // namespace core
+}  // namespace jubatus
+
+// Times the rest of the enclosing scope as |op| (an operation in
+// jubatus::core::common::metrics); use at most once per scope.  Compiles to
+// nothing when JUBATUS_DISABLE_METRICS is defined.
+#ifdef JUBATUS_DISABLE_METRICS
+#define JUBATUS_METRICS_SCOPE(recorder, op)
+#else
+#define JUBATUS_METRICS_SCOPE(recorder, op)                      \
+  ::jubatus::core::common::metrics::scoped_timer                 \
+      jubatus_metrics_scoped_timer_(                             \
+          (recorder), ::jubatus::core::common::metrics::op)
+#endif
+
+#endif  // JUBATUS_CORE_COMMON_METRICS_HPP_
@@ -0,0 +1,167 @@
+// Jubatus: Online machine learning framework for distributed environment
+// Copyright (C) 2015 Preferred Networks and Nippon Telegraph and Telephone Corporation.
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License version 2.1 as published by the Free Software Foundation.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+
+#include <map>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+#include "jubatus/util/concurrent/thread.h"
+#include "jubatus/util/lang/bind.h"
+#include "jubatus/util/lang/shared_ptr.h"
+#include "metrics.hpp"
+
+using std::map;
+using std::string;
+using std::vector;
+using jubatus::util::concurrent::thread;
+
+namespace jubatus {
+namespace core {
+namespace common {
+namespace metrics {
+
+TEST(histogram, bucket_index) {
+  // Small values have their own buckets.
+  for (uint64_t v = 0; v < 8; ++v) {
+    EXPECT_EQ(v, histogram::bucket_index(v));
+    EXPECT_EQ(v, histogram::bucket_upper_bound(v));
+  }
+
+  // Every value falls in a bucket whose upper bound is within the precision.
+  size_t last = 0;
+  for (uint64_t v = 8; v < 100000; v += v / 100 + 1) {
+    const size_t index = histogram::bucket_index(v);
+    EXPECT_LE(last, index);
+    EXPECT_LE(v, histogram::bucket_upper_bound(index));
+    EXPECT_LT(histogram::bucket_upper_bound(index), v + v / 8 + 1);
+    if (index > 0) {
+      EXPECT_GT(v, histogram::bucket_upper_bound(index - 1));
+    }
+    last = index;
+  }
+
+  EXPECT_EQ(histogram::NUM_BUCKETS - 1,
+            histogram::bucket_index(0xFFFFFFFFFFFFFFFFLLU));
+}
+
+TEST(histogram, record) {
+  histogram h;
+  EXPECT_EQ(0u, h.count());
+  EXPECT_EQ(0u, h.value_at_quantile(0.5));
+
+  for (uint64_t v = 1; v <= 1000; ++v) {
+    h.record(v * 1000);
+  }
+  EXPECT_EQ(1000u, h.count());
+  EXPECT_EQ(1000u, h.min());
+  EXPECT_EQ(1000000u, h.max());
+  EXPECT_DOUBLE_EQ(500500.0, h.mean());
+
+  const uint64_t p50 = h.value_at_quantile(0.5);
+  EXPECT_LE(500000u, p50);
+  EXPECT_GE(500000u * 9 / 8, p50);
+  const uint64_t p99 = h.value_at_quantile(0.99);
+  EXPECT_LE(990000u, p99);
+  EXPECT_GE(1000000u, p99);
+  EXPECT_EQ(1000u, h.value_at_quantile(0));
+  EXPECT_EQ(1000000u, h.value_at_quantile(1));
+
+  h.clear();
+  EXPECT_EQ(0u, h.count());
+  EXPECT_EQ(0u, h.max());
+}
+
+TEST(histogram, merge) {
+  histogram h1, h2;
+  h1.record(10);
+  h1.record(20);
+  h2.record(5);
+  h2.record(40);
+  h1.merge(h2);
+  EXPECT_EQ(4u, h1.count());
+  EXPECT_EQ(75u, h1.sum());
+  EXPECT_EQ(5u, h1.min());
+  EXPECT_EQ(40u, h1.max());
+}
+
+namespace {
+
+void record_many(recorder* r, size_t n) {
+  for (size_t i = 0; i < n; ++i) {
+    r->record(TRAIN, i);
+  }
+}
+
+}  // namespace
+
+TEST(recorder, concurrent_record) {
+  recorder r;
+  vector<jubatus::util::lang::shared_ptr<thread> > threads;
+  for (size_t i = 0; i < 12; ++i) {
+    threads.push_back(jubatus::util::lang::shared_ptr<thread>(new thread(
+        jubatus::util::lang::bind(&record_many, &r, 1000))));
+    threads.back()->start();
+  }
+  for (size_t i = 0; i < threads.size(); ++i) {
+    threads[i]->join();
+  }
+
+  EXPECT_EQ(12000u, r.get(TRAIN).count());
+  EXPECT_EQ(999u, r.get(TRAIN).max());
+  EXPECT_EQ(0u, r.get(CLASSIFY).count());
+
+  r.clear();
+  EXPECT_EQ(0u, r.get(TRAIN).count());
+}
+
+TEST(recorder, get_status) {
+  recorder r;
+  map<string, string> status;
+  r.get_status(status);
+  EXPECT_TRUE(status.empty());
+
+  r.record(CONVERT, 100);
+  r.record(CONVERT, 300);
+  r.get_status(status);
+  EXPECT_EQ(5u, status.size());
+  EXPECT_EQ("2", status["metrics.convert.count"]);
+  EXPECT_EQ("200", status["metrics.convert.mean_ns"]);
+  EXPECT_EQ("300", status["metrics.convert.max_ns"]);
+  EXPECT_EQ(0u, status.count("metrics.train.count"));
+}
+
+TEST(recorder, scoped_timer) {
+  recorder r;
+  {
+    JUBATUS_METRICS_SCOPE(r, PACK);
+  }
+#ifdef JUBATUS_DISABLE_METRICS
+  EXPECT_EQ(0u, r.get(PACK).count());
+#else
+  EXPECT_EQ(1u, r.get(PACK).count());
+#endif
+}
+
+TEST(operation_name, name) {
+  EXPECT_STREQ("neighbor_search", operation_name(NEIGHBOR_SEARCH));
+  EXPECT_STREQ("unpack", operation_name(UNPACK));
+}
+
+}  // namespace metrics
+}  // namespace common
+}  // namespace core
+}  // namespace jubatus
@@ -77,16 +77,24 @@ pair<string, float> anomaly::add(
 
 float anomaly::update(const string& id, const fv_converter::datum& d) {
   common::sfv_t v;
-  converter_->convert_and_update_weight(d, v);
+  {
+    JUBATUS_METRICS_SCOPE(metrics_, CONVERT);
+    converter_->convert_and_update_weight(d, v);
+  }
 
+  JUBATUS_METRICS_SCOPE(metrics_, TRAIN);
   anomaly_->update_row(id, v);
   return anomaly_->calc_anomaly_score(id);
 }
 
 float anomaly::overwrite(const string& id, const fv_converter::datum& d) {
   common::sfv_t v;
-  converter_->convert_and_update_weight(d, v);
+  {
+    JUBATUS_METRICS_SCOPE(metrics_, CONVERT);
+    converter_->convert_and_update_weight(d, v);
+  }
 
+  JUBATUS_METRICS_SCOPE(metrics_, TRAIN);
   anomaly_->set_row(id, v);
   return anomaly_->calc_anomaly_score(id);
 }
@@ -98,7 +106,11 @@ void anomaly::clear() {
 
 float anomaly::calc_score(const fv_converter::datum& d) const {
   common::sfv_t v;
-  converter_->convert(d, v);
+  {
+    JUBATUS_METRICS_SCOPE(metrics_, CONVERT);
+    converter_->convert(d, v);
+  }
+  JUBATUS_METRICS_SCOPE(metrics_, CLASSIFY);
   return anomaly_->calc_anomaly_score(v);
 }
 
@@ -113,6 +125,7 @@ uint64_t anomaly::find_max_int_id() const {
 }
 
 void anomaly::pack(framework::packer& pk) const {
+  JUBATUS_METRICS_SCOPE(metrics_, PACK);
   pk.pack_array(2);
   anomaly_->pack(pk);
   wm_.get_model()->pack(pk);
@@ -123,6 +136,7 @@ void anomaly::unpack(msgpack::object o) {
     throw msgpack::type_error();
   }
 
+  JUBATUS_METRICS_SCOPE(metrics_, UNPACK);
   // clear before load
   anomaly_->clear();
   converter_->clear_weights();
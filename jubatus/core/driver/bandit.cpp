@@ -48,6 +48,11 @@ std::string bandit::select_arm(const std::string& player_id) {
   return bandit_->select_arm(player_id);
 }
 
+std::vector<std::string> bandit::select_arms(
+    const std::vector<std::string>& player_ids) {
+  return bandit_->select_arms(player_ids);
+}
+
 bool bandit::register_reward(const std::string& player_id,
                              const std::string& arm_id,
                              double reward) {
@@ -67,9 +72,11 @@ void bandit::clear() {
   bandit_->clear();
 }
 void bandit::pack(framework::packer& pk) const {
+  JUBATUS_METRICS_SCOPE(metrics_, PACK);
   bandit_->pack(pk);
 }
 void bandit::unpack(msgpack::object o) {
+  JUBATUS_METRICS_SCOPE(metrics_, UNPACK);
   bandit_->unpack(o);
 }
 
@@ -42,6 +42,8 @@ class bandit : public driver_base {
   bool delete_arm(const std::string& arm_id);
 
   std::string select_arm(const std::string& player_id);
+  std::vector<std::string> select_arms(
+      const std::vector<std::string>& player_ids);
 
   bool register_reward(const std::string& player_id,
                        const std::string& arm_id,
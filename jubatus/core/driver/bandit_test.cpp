@@ -90,6 +90,62 @@ TEST(bandit, epsilon_greedy) {
   EXPECT_DOUBLE_EQ(total_reward, total_reward_actual);
 }
 
+TEST(bandit, weighted_selection) {
+  const char* methods[] = {"softmax", "exp3"};
+  for (size_t m = 0; m < 2; ++m) {
+    json::json js(new json::json_object);
+    if (m == 0) {
+      js["tau"] = json::to_json(0.05);
+    } else {
+      js["gamma"] = json::to_json(0.01);
+    }
+    // fixed seeds keep the draws, and so the counts below, reproducible;
+    // rewards come from a different seed not to correlate with the choices
+    js["seed"] = json::to_json(0);
+    bandit b(methods[m], common::jsonconfig::config(js));
+    b.register_arm("hoge");
+    b.register_arm("fuga");
+    b.register_arm("piyo");
+
+    mtrand rand(1);
+    const int trial = 10000;
+    int fuga_count = 0;
+    for (int i = 0; i < trial; ++i) {
+      std::string arm = b.select_arm("player");
+      b.register_reward("player", arm, simulate_reward(arm, rand));
+      if (arm == "fuga") {
+        ++fuga_count;
+      }
+    }
+    if (std::string(methods[m]) == "softmax") {
+      // the best arm is chosen in more than half of the draws; fewer draws
+      // leave room for the small tau to lock in on an early lucky arm
+      EXPECT_LT(trial / 2, fuga_count);
+    }
+
+    b.delete_arm("fuga");
+    for (int i = 0; i < 100; ++i) {
+      EXPECT_NE("fuga", b.select_arm("player")) << methods[m];
+    }
+  }
+}
+
+TEST(bandit, select_arms) {
+  bandit b("ucb1", common::jsonconfig::config());
+  b.register_arm("hoge");
+  b.register_arm("fuga");
+  b.register_reward("player1", "hoge", 1.0);
+
+  std::vector<std::string> players;
+  players.push_back("player1");
+  players.push_back("player2");
+  std::vector<std::string> arms = b.select_arms(players);
+  ASSERT_EQ(2u, arms.size());
+  // ucb1 selects an arm not tried yet
+  EXPECT_EQ("fuga", arms[0]);
+  EXPECT_EQ("hoge", arms[1]);
+}
+
 }  // driver namespace
 }  // core namespace
 }  // jubatus namespace
@@ -94,6 +94,7 @@ void burst::get_status(std::map<std::string, std::string>& status) const {
       keywords_to_string(burst_->get_all_keywords());
   status["processed_keywords"] =
       keywords_to_string(burst_->get_processed_keywords());
+  driver_base::get_status(status);
 }
 
 bool burst::has_been_mixed() const {
@@ -104,9 +105,11 @@ void burst::set_processed_keywords(const std::vector<std::string>& keywords) {
 }
 
 void burst::pack(framework::packer& pk) const {
+  JUBATUS_METRICS_SCOPE(metrics_, PACK);
   burst_->pack(pk);
 }
 void burst::unpack(msgpack::object o) {
+  JUBATUS_METRICS_SCOPE(metrics_, UNPACK);
   burst_->unpack(o);
 }
 void burst::clear() {
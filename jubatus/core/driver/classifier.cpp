@@ -54,43 +54,76 @@ classifier::~classifier() {
 }
 
 void classifier::train(const string& label, const fv_converter::datum& data) {
+  scoped_model_wlock lk(*this);
   common::sfv_t v;
-  converter_->convert_and_update_weight(data, v);
-  common::sort_and_merge(v);
+  {
+    JUBATUS_METRICS_SCOPE(metrics_, CONVERT);
+    converter_->convert_and_update_weight(data, v);
+    common::sort_and_merge(v);
+  }
+  JUBATUS_METRICS_SCOPE(metrics_, TRAIN);
   classifier_->train(v, label);
 }
 
+void classifier::batch_train(
+    const vector<std::pair<string, fv_converter::datum> >& data,
+    size_t num_threads) {
+  scoped_model_wlock lk(*this);
+  core::classifier::labeled_fv_list fvs(data.size());
+  for (size_t i = 0; i < data.size(); ++i) {
+    JUBATUS_METRICS_SCOPE(metrics_, CONVERT);
+    fvs[i].first = data[i].first;
+    converter_->convert_and_update_weight(data[i].second, fvs[i].second);
+    common::sort_and_merge(fvs[i].second);
+  }
+  JUBATUS_METRICS_SCOPE(metrics_, TRAIN);
+  classifier_->batch_train(fvs, num_threads);
+}
+
 jubatus::core::classifier::classify_result classifier::classify(
     const fv_converter::datum& data) const {
+  scoped_model_rlock lk(*this);
   common::sfv_t v;
-  converter_->convert(data, v);
+  {
+    JUBATUS_METRICS_SCOPE(metrics_, CONVERT);
+    converter_->convert(data, v);
+  }
 
+  JUBATUS_METRICS_SCOPE(metrics_, CLASSIFY);
   jubatus::core::classifier::classify_result scores;
   classifier_->classify_with_scores(v, scores);
   return scores;
 }
 
 void classifier::get_status(std::map<string, string>& status) const {
+  scoped_model_rlock lk(*this);
   classifier_->get_status(status);
+  driver_base::get_status(status);
 }
 
 bool classifier::delete_label(const std::string& label) {
+  scoped_model_wlock lk(*this);
   return classifier_->delete_label(label);
 }
 
 void classifier::clear() {
+  scoped_model_wlock lk(*this);
   classifier_->clear();
   converter_->clear_weights();
 }
 
 std::vector<std::string> classifier::get_labels() const {
+  scoped_model_rlock lk(*this);
   return classifier_->get_labels();
 }
 bool classifier::set_label(const std::string& label) {
+  scoped_model_wlock lk(*this);
   return classifier_->set_label(label);
 }
 
 void classifier::pack(framework::packer& pk) const {
+  scoped_model_rlock lk(*this);
+  JUBATUS_METRICS_SCOPE(metrics_, PACK);
   pk.pack_array(2);
   classifier_->pack(pk);
   wm_.get_model()->pack(pk);
@@ -101,6 +134,9 @@ void classifier::unpack(msgpack::object o) {
     throw msgpack::type_error();
   }
 
+  scoped_model_wlock lk(*this);
+  JUBATUS_METRICS_SCOPE(metrics_, UNPACK);
+
   // clear before load
   classifier_->clear();
   converter_->clear_weights();
@@ -108,6 +144,10 @@ void classifier::unpack(msgpack::object o) {
   wm_.get_model()->unpack(o.via.array.ptr[1]);
 }
 
+void classifier::enable_concurrent_mode() {
+  enable_model_lock();
+}
+
 }  // namespace driver
 }  // namespace core
 }  // namespace jubatus
@@ -19,6 +19,7 @@
 
 #include <map>
 #include <string>
+#include <utility>
 #include <vector>
 #include "jubatus/util/lang/shared_ptr.h"
 #include "../classifier/classifier_type.hpp"
@@ -45,6 +46,11 @@ class classifier : public driver_base {
   virtual ~classifier();
 
   void train(const std::string&, const fv_converter::datum&);
+  // Converts every datum first, then lets the algorithm train on the batch
+  // with up to |num_threads| threads (see classifier_base::batch_train).
+  void batch_train(
+      const std::vector<std::pair<std::string, fv_converter::datum> >& data,
+      size_t num_threads);
   jubatus::core::classifier::classify_result classify(
       const fv_converter::datum& data) const;
 
@@ -58,6 +64,11 @@ class classifier : public driver_base {
   std::vector<std::string> get_labels() const;
   bool set_label(const std::string& label);
 
+  // Makes classify, which takes a shared lock, callable from many threads
+  // at once; updating APIs and MIX are serialized by an exclusive lock.
+  // Call this before sharing the driver among threads.
+  void enable_concurrent_mode();
+
  private:
   jubatus::util::lang::shared_ptr<fv_converter::datum_to_fv_converter>
       converter_;
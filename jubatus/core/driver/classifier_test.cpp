@@ -24,11 +24,14 @@
 
 #include <gtest/gtest.h>
 
+#include "jubatus/util/concurrent/thread.h"
+#include "jubatus/util/lang/bind.h"
 #include "jubatus/util/lang/cast.h"
 #include "jubatus/util/text/json.h"
 
 #include "../storage/storage_type.hpp"
 #include "../storage/local_storage.hpp"
+#include "../storage/local_storage_mixture.hpp"
 #include "../classifier/classifier_test_util.hpp"
 #include "../classifier/classifier.hpp"
 #include "../fv_converter/datum.hpp"
@@ -78,6 +81,62 @@ void make_random_data(
   }
 }
 
+void train_all(
+    core::driver::classifier* classifier,
+    const vector<pair<string, datum> >* data) {
+  for (size_t i = 0; i < data->size(); ++i) {
+    classifier->train((*data)[i].first, (*data)[i].second);
+  }
+}
+
+void classify_all(
+    const core::driver::classifier* classifier,
+    const vector<pair<string, datum> >* data,
+    size_t* result_count) {
+  for (size_t i = 0; i < data->size(); ++i) {
+    *result_count += classifier->classify((*data)[i].second).size();
+  }
+}
+
+void get_diff(framework::linear_mixable* mixable, msgpack::sbuffer& buf) {
+  framework::stream_writer<msgpack::sbuffer> st(buf);
+  framework::jubatus_packer jp(st);
+  framework::packer pk(jp);
+  mixable->get_diff(pk);
+}
+
+// MIX of a single node: its own diff is the average.
+void mix_self(framework::linear_mixable* mixable) {
+  msgpack::sbuffer buf;
+  get_diff(mixable, buf);
+  msgpack::unpacked msg;
+  msgpack::unpack(&msg, buf.data(), buf.size());
+  mixable->put_diff(mixable->convert_diff_object(msg.get()));
+}
+
+shared_ptr<core::driver::classifier> make_mixture_classifier() {
+  shared_ptr<storage_base> storage(new core::storage::local_storage_mixture);
+  return shared_ptr<core::driver::classifier>(new core::driver::classifier(
+      shared_ptr<classifier_base>(
+          new core::classifier::passive_aggressive(storage)),
+      make_fv_converter()));
+}
+
+void expect_same_scores(
+    const core::driver::classifier& expect,
+    const core::driver::classifier& actual,
+    const vector<pair<string, datum> >& data) {
+  for (size_t i = 0; i < data.size(); ++i) {
+    classify_result e = expect.classify(data[i].second);
+    classify_result a = actual.classify(data[i].second);
+    ASSERT_EQ(e.size(), a.size());
+    for (size_t j = 0; j < e.size(); ++j) {
+      EXPECT_EQ(e[j].label, a[j].label);
+      EXPECT_NEAR(e[j].score, a[j].score, 1e-4);
+    }
+  }
+}
+
 string get_max_label(const classify_result& result) {
   string max_label = "";
   double max_prob = 0;
@@ -211,6 +270,56 @@ TEST_P(classifier_test, duplicated_keys) {
   }
 }
 
+TEST_P(classifier_test, concurrent_mode) {
+  using jubatus::util::concurrent::thread;
+  using jubatus::util::lang::bind;
+
+  classifier_->enable_concurrent_mode();
+
+  jubatus::util::math::random::mtrand rand(0);
+  vector<pair<string, datum> > data;
+  make_random_data(rand, data, 1000);
+
+  vector<size_t> result_counts(4, 0);
+  vector<shared_ptr<thread> > threads;
+  threads.push_back(shared_ptr<thread>(new thread(
+      bind(&train_all, classifier_.get(), &data))));
+  for (size_t i = 0; i < result_counts.size(); ++i) {
+    threads.push_back(shared_ptr<thread>(new thread(
+        bind(&classify_all, classifier_.get(), &data, &result_counts[i]))));
+  }
+  for (size_t i = 0; i < threads.size(); ++i) {
+    ASSERT_TRUE(threads[i]->start());
+  }
+  for (size_t i = 0; i < threads.size(); ++i) {
+    ASSERT_TRUE(threads[i]->join());
+  }
+
+  // each classify returns a score for at most two labels ("OK" and "NG")
+  for (size_t i = 0; i < result_counts.size(); ++i) {
+    EXPECT_LE(result_counts[i], 2 * data.size());
+  }
+  EXPECT_EQ(2u, classifier_->classify(data[0].second).size());
+  my_test();
+}
+
+TEST_P(classifier_test, batch_train) {
+  jubatus::util::math::random::mtrand rand(0);
+  vector<pair<string, datum> > data;
+  make_random_data(rand, data, 1000);
+  classifier_->batch_train(data, 4);
+
+  size_t count = 0;
+  for (size_t i = 0; i < data.size(); ++i) {
+    classify_result result = classifier_->classify(data[i].second);
+    ASSERT_EQ(2u, result.size());
+    if (get_max_label(result) == data[i].first) {
+      ++count;
+    }
+  }
+  EXPECT_GE(count, data.size() - 50);
+}
+
 TEST_P(classifier_test, save_load) {
   jubatus::util::math::random::mtrand rand(0);
   const size_t example_size = 1000;
@@ -334,6 +443,101 @@ TEST_P(classifier_test, nan) {
   EXPECT_FALSE(isfinite(result[0].score));
 }
 
+#ifndef JUBATUS_DISABLE_METRICS
+TEST_P(classifier_test, metrics) {
+  datum d;
+  d.num_values_.push_back(make_pair("value", 1.0));
+  classifier_->train("l1", d);
+  classifier_->train("l2", d);
+  classifier_->classify(d);
+
+  const core::common::metrics::recorder& metrics =
+      classifier_->get_metrics();
+  EXPECT_EQ(3u, metrics.get(core::common::metrics::CONVERT).count());
+  EXPECT_EQ(2u, metrics.get(core::common::metrics::TRAIN).count());
+  EXPECT_EQ(1u, metrics.get(core::common::metrics::CLASSIFY).count());
+  EXPECT_EQ(0u, metrics.get(core::common::metrics::PACK).count());
+
+  std::map<string, string> status;
+  classifier_->get_status(status);
+  EXPECT_EQ("2", status["metrics.train.count"]);
+  EXPECT_EQ(1u, status.count("metrics.classify.p99_ns"));
+  EXPECT_EQ(0u, status.count("metrics.pack.count"));
+}
+#endif
+
+// In concurrent mode, get_diff freezes the diff so that training can go on
+// during MIX; the updates after get_diff are kept for the next MIX.
+TEST(classifier_mix_test, train_during_mix) {
+  jubatus::util::math::random::mtrand rand(0);
+  vector<pair<string, datum> > data;
+  make_random_data(rand, data, 200);
+  const vector<pair<string, datum> > first(data.begin(), data.begin() + 100);
+  const vector<pair<string, datum> > second(data.begin() + 100, data.end());
+
+  shared_ptr<core::driver::classifier> expect = make_mixture_classifier();
+  train_all(expect.get(), &data);
+  mix_self(dynamic_cast<framework::linear_mixable*>(expect->get_mixable()));
+
+  shared_ptr<core::driver::classifier> actual = make_mixture_classifier();
+  actual->enable_concurrent_mode();
+  framework::linear_mixable* mixable =
+      dynamic_cast<framework::linear_mixable*>(actual->get_mixable());
+  ASSERT_TRUE(mixable);
+  train_all(actual.get(), &first);
+
+  msgpack::sbuffer buf;
+  get_diff(mixable, buf);
+  train_all(actual.get(), &second);
+  expect_same_scores(*expect, *actual, data);
+
+  msgpack::unpacked msg;
+  msgpack::unpack(&msg, buf.data(), buf.size());
+  EXPECT_TRUE(mixable->put_diff(mixable->convert_diff_object(msg.get())));
+  expect_same_scores(*expect, *actual, data);
+
+  // the second half is still in the diff
+  mix_self(mixable);
+  expect_same_scores(*expect, *actual, data);
+}
+
+TEST(classifier_mix_test, failed_mix) {
+  jubatus::util::math::random::mtrand rand(0);
+  vector<pair<string, datum> > data;
+  make_random_data(rand, data, 200);
+  const vector<pair<string, datum> > first(data.begin(), data.begin() + 100);
+  const vector<pair<string, datum> > second(data.begin() + 100, data.end());
+
+  shared_ptr<core::driver::classifier> expect = make_mixture_classifier();
+  train_all(expect.get(), &data);
+  mix_self(dynamic_cast<framework::linear_mixable*>(expect->get_mixable()));
+
+  shared_ptr<core::driver::classifier> actual = make_mixture_classifier();
+  actual->enable_concurrent_mode();
+  framework::linear_mixable* mixable =
+      dynamic_cast<framework::linear_mixable*>(actual->get_mixable());
+  ASSERT_TRUE(mixable);
+  train_all(actual.get(), &first);
+
+  // put_diff fails and puts the frozen diff back
+  msgpack::sbuffer buf;
+  get_diff(mixable, buf);
+  EXPECT_THROW(mixable->put_diff(framework::diff_object()),
+               core::common::exception::runtime_error);
+  train_all(actual.get(), &second);
+  expect_same_scores(*expect, *actual, data);
+
+  // MIX is aborted by the caller
+  buf.clear();
+  get_diff(mixable, buf);
+  mixable->abort_diff();
+  expect_same_scores(*expect, *actual, data);
+
+  // both halves are mixed at once
+  mix_self(mixable);
+  expect_same_scores(*expect, *actual, data);
+}
+
 vector<shared_ptr<classifier_base> > create_classifiers() {
   vector<shared_ptr<classifier_base> > method;
 
@@ -53,19 +53,24 @@ clustering::~clustering() {
 }
 
 void clustering::push(const vector<datum>& points) {
-  clustering_->push(to_weighted_point_vector(points));
+  const vector<core::clustering::weighted_point> wpoints =
+      to_weighted_point_vector(points);
+  JUBATUS_METRICS_SCOPE(metrics_, TRAIN);
+  clustering_->push(wpoints);
 }
 
 datum clustering::get_nearest_center(
     const datum& point) const {
-  return to_datum(
-      clustering_->get_nearest_center(to_sfv_const(point)));
+  const common::sfv_t v = to_sfv_const(point);
+  JUBATUS_METRICS_SCOPE(metrics_, NEIGHBOR_SEARCH);
+  return to_datum(clustering_->get_nearest_center(v));
 }
 
 core::clustering::cluster_unit
     clustering::get_nearest_members(const datum& point) const {
-  return to_weighted_datum_vector(
-      clustering_->get_nearest_members(to_sfv_const(point)));
+  const common::sfv_t v = to_sfv_const(point);
+  JUBATUS_METRICS_SCOPE(metrics_, NEIGHBOR_SEARCH);
+  return to_weighted_datum_vector(clustering_->get_nearest_members(v));
 }
 
 vector<datum> clustering::get_k_center() const {
@@ -101,6 +106,7 @@ void clustering::do_clustering() {
 // private
 
 common::sfv_t clustering::to_sfv(const datum& dat) {
+  JUBATUS_METRICS_SCOPE(metrics_, CONVERT);
   common::sfv_t ret;
   converter_->convert_and_update_weight(dat, ret);
   common::sort_and_merge(ret);
@@ -108,6 +114,7 @@ common::sfv_t clustering::to_sfv(const datum& dat) {
 }
 
 common::sfv_t clustering::to_sfv_const(const datum& dat) const {
+  JUBATUS_METRICS_SCOPE(metrics_, CONVERT);
   common::sfv_t ret;
   converter_->convert(dat, ret);
   common::sort_and_merge(ret);
@@ -179,16 +186,21 @@ core::clustering::cluster_unit
 }
 
 void clustering::pack(framework::packer& pk) const {
-  pk.pack_array(2);
+  JUBATUS_METRICS_SCOPE(metrics_, PACK);
+  pk.pack_array(3);
   clustering_->pack(pk);
   wm_.get_model()->pack(pk);
+  clustering_->pack_method(pk);
 }
 
 void clustering::unpack(msgpack::object o) {
-  if (o.type != msgpack::type::ARRAY || o.via.array.size != 2) {
+  // models saved before the method state was added have 2 elements
+  if (o.type != msgpack::type::ARRAY ||
+      (o.via.array.size != 2 && o.via.array.size != 3)) {
     throw msgpack::type_error();
   }
 
+  JUBATUS_METRICS_SCOPE(metrics_, UNPACK);
   // clear
   clustering_->clear();
   converter_->clear_weights();
@@ -196,6 +208,9 @@ void clustering::unpack(msgpack::object o) {
   // load
   clustering_->unpack(o.via.array.ptr[0]);
   wm_.get_model()->unpack(o.via.array.ptr[1]);
+  if (o.via.array.size == 3) {
+    clustering_->unpack_method(o.via.array.ptr[2]);
+  }
 }
 
 void clustering::clear() {
@@ -130,6 +130,12 @@ TEST_P(clustering_test, save_load) {
   msgpack::unpacked unpacked;
   msgpack::unpack(&unpacked, sbuf.data(), sbuf.size());
   clustering_->unpack(unpacked.get());
+
+  // models saved without the state of the clustering method still load
+  msgpack::object old_model = unpacked.get();
+  ASSERT_EQ(3u, old_model.via.array.size);
+  old_model.via.array.size = 2;
+  clustering_->unpack(old_model);
 }
 
 TEST_P(clustering_test, get_k_center) {
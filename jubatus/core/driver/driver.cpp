@@ -16,6 +16,7 @@
 
 #include "driver.hpp"
 #include <algorithm>
+#include <map>
 #include <numeric>
 #include <string>
 #include <set>
@@ -140,6 +141,86 @@ void driver_base::mixable_holder::mix(
 }
 
 void driver_base::mixable_holder::get_diff(packer& pk) const {
+  JUBATUS_METRICS_SCOPE(*metrics_, GET_DIFF);
+
+  std::vector<diff_object> frozen(mixables_.size());
+  if (!model_mutex_) {
+    // The model is locked by the caller, maybe only for reading, so it
+    // must not be changed here; pack the diffs in place.
+    pack_diff(frozen, pk);
+    return;
+  }
+
+  // Swap out the diffs of double-buffered mixables; this is the only part
+  // that blocks updates for them.
+  bool all_frozen = true;
+  {
+    scoped_model_lock lk(model_mutex_, true);
+    for (size_t i = 0; i < mixables_.size(); i++) {
+      linear_mixable* mixable = dynamic_cast<linear_mixable*>(mixables_[i]);
+      if (!mixable) {
+        continue;
+      }
+      frozen[i] = mixable->freeze_diff();
+      all_frozen = all_frozen && frozen[i];
+    }
+  }
+
+  try {
+    // Frozen diffs are immutable, so they are packed without the lock.
+    scoped_model_lock lk(all_frozen ? NULL : model_mutex_, false);
+    pack_diff(frozen, pk);
+  } catch (...) {
+    scoped_model_lock lk(model_mutex_, true);
+    abort_frozen_diff();
+    throw;
+  }
+}
+
+void driver_base::mixable_holder::abort_diff() {
+  scoped_model_lock lk(model_mutex_, true);
+  abort_frozen_diff();
+}
+
+bool driver_base::mixable_holder::put_diff(const diff_object& obj) {
+  scoped_model_lock lk(model_mutex_, true);
+  JUBATUS_METRICS_SCOPE(*metrics_, PUT_DIFF);
+  try {
+    internal_diff_object* diff_obj =
+      dynamic_cast<internal_diff_object*>(obj.get());
+    if (!diff_obj) {
+      throw JUBATUS_EXCEPTION(
+          core::common::exception::runtime_error("bad diff_object"));
+    }
+
+    if (count_mixable<linear_mixable>(mixables_) != diff_obj->diffs_.size()) {
+      throw JUBATUS_EXCEPTION(
+          core::common::exception::runtime_error("diff size is wrong"));
+    }
+
+    bool success = true;
+    for (size_t i = 0; i < mixables_.size(); i++) {
+      linear_mixable* mixable = dynamic_cast<linear_mixable*>(mixables_[i]);
+      if (!mixable) {
+        continue;
+      }
+      success = mixable->put_diff(diff_obj->diffs_[i]) && success;
+    }
+    if (mixed_callback_) {
+      mixed_callback_();
+    }
+
+    return success;
+  } catch (...) {
+    // MIX failed; diffs frozen by get_diff are kept for the next one
+    abort_frozen_diff();
+    throw;
+  }
+}
+
+void driver_base::mixable_holder::pack_diff(
+    const std::vector<diff_object>& frozen,
+    packer& pk) const {
   pk.pack_array(count_mixable<linear_mixable>(mixables_));
   for (size_t i = 0; i < mixables_.size(); i++) {
     const linear_mixable* mixable =
@@ -147,36 +228,27 @@ void driver_base::mixable_holder::get_diff(packer& pk) const {
     if (!mixable) {
       continue;
     }
-    mixable->get_diff(pk);
+    if (frozen[i]) {
+      frozen[i]->convert_binary(pk);
+    } else {
+      mixable->get_diff(pk);
+    }
   }
 }
 
-bool driver_base::mixable_holder::put_diff(const diff_object& obj) {
-  internal_diff_object* diff_obj =
-    dynamic_cast<internal_diff_object*>(obj.get());
-  if (!diff_obj) {
-    throw JUBATUS_EXCEPTION(
-        core::common::exception::runtime_error("bad diff_object"));
-  }
-
-  if (count_mixable<linear_mixable>(mixables_) != diff_obj->diffs_.size()) {
-    throw JUBATUS_EXCEPTION(
-        core::common::exception::runtime_error("diff size is wrong"));
-  }
-
-  bool success = true;
+// The caller must hold the model write lock.
+void driver_base::mixable_holder::abort_frozen_diff() const {
   for (size_t i = 0; i < mixables_.size(); i++) {
     linear_mixable* mixable = dynamic_cast<linear_mixable*>(mixables_[i]);
     if (!mixable) {
       continue;
     }
-    success = mixable->put_diff(diff_obj->diffs_[i]) && success;
+    mixable->abort_diff();
   }
-
-  return success;
 }
 
 void driver_base::mixable_holder::get_argument(packer& pk) const {
+  scoped_model_lock lk(model_mutex_, false);
   pk.pack_array(count_mixable<push_mixable>(mixables_));
   for (size_t i = 0; i < mixables_.size(); i++) {
     const push_mixable* mixable =
@@ -197,6 +269,7 @@ void driver_base::mixable_holder::pull(
         core::common::exception::runtime_error("pull array failed"));
   }
 
+  scoped_model_lock lk(model_mutex_, false);
   pk.pack_array(count_mixable<push_mixable>(mixables_));
   for (size_t i = 0, obj_index = 0; i < mixables_.size(); i++) {
     const push_mixable* mixable =
@@ -216,6 +289,7 @@ void driver_base::mixable_holder::push(const msgpack::object& o) {
         core::common::exception::runtime_error("push failed"));
   }
 
+  scoped_model_lock lk(model_mutex_, true);
   for (size_t i = 0, obj_index = 0; i < mixables_.size(); i++) {
     push_mixable* mixable = dynamic_cast<push_mixable*>(mixables_[i]);
     if (!mixable) {
@@ -224,6 +298,9 @@ void driver_base::mixable_holder::push(const msgpack::object& o) {
     mixable->push(o.via.array.ptr[obj_index]);
     obj_index++;
   }
+  if (mixed_callback_) {
+    mixed_callback_();
+  }
 }
 
 std::vector<storage::version>
@@ -235,7 +312,12 @@ driver_base::mixable_holder::get_versions() const {
   return ret;
 }
 
+void driver_base::get_status(std::map<string, string>& status) const {
+  metrics_.get_status(status);
+}
+
 std::vector<storage::version> driver_base::get_versions() const {
+  scoped_model_rlock lk(*this);
   return holder_.get_versions();
 }
 
@@ -243,6 +325,11 @@ void driver_base::register_mixable(framework::mixable* mixable) {
   holder_.register_mixable(mixable);
 }
 
+void driver_base::enable_model_lock() {
+  concurrent_ = true;
+  holder_.set_model_mutex(&model_mutex_);
+}
+
 
 }  // namespace driver
 }  // namespace core
@@ -17,9 +17,13 @@
 #ifndef JUBATUS_CORE_DRIVER_DRIVER_HPP_
 #define JUBATUS_CORE_DRIVER_DRIVER_HPP_
 
+#include <map>
 #include <string>
 #include <set>
 #include <vector>
+#include "jubatus/util/concurrent/rwmutex.h"
+#include "jubatus/util/lang/function.h"
+#include "../common/metrics.hpp"
 #include "../framework/model.hpp"
 #include "../framework/linear_mixable.hpp"
 #include "../framework/push_mixable.hpp"
@@ -30,7 +34,10 @@ namespace driver {
 
 class driver_base {
  public:
-  driver_base() {}
+  driver_base()
+      : concurrent_(false) {
+    holder_.set_metrics(&metrics_);
+  }
   virtual ~driver_base() {}
   virtual framework::mixable* get_mixable() {
     return &holder_;
@@ -41,20 +48,98 @@ class driver_base {
   virtual void unpack(msgpack::object o) = 0;
   virtual void clear() = 0;
 
+  // Adds latencies of the operations timed by the driver (see
+  // common::metrics::recorder::get_status).  Drivers reporting the status
+  // of their models call this after adding their own entries.
+  virtual void get_status(std::map<std::string, std::string>& status) const;
+
+  const common::metrics::recorder& get_metrics() const {
+    return metrics_;
+  }
+
  protected:
   void register_mixable(framework::mixable* mixable);
 
+  // Makes the model guarded by a reader-writer lock.  Drivers supporting
+  // concurrent mode take a shared lock in APIs which only read the model
+  // and an exclusive lock in APIs which update it; MIX through
+  // get_mixable() is also locked.  This must be called before the driver
+  // is shared among threads.
+  void enable_model_lock();
+
+  // Locks the model only when enable_model_lock() has been called.
+  class scoped_model_lock {
+   public:
+    scoped_model_lock(jubatus::util::concurrent::rw_mutex* mutex, bool write)
+        : mutex_(mutex) {
+      if (mutex_) {
+        if (write) {
+          mutex_->write_lock();
+        } else {
+          mutex_->read_lock();
+        }
+      }
+    }
+    ~scoped_model_lock() {
+      if (mutex_) {
+        mutex_->unlock();
+      }
+    }
+
+   private:
+    jubatus::util::concurrent::rw_mutex* mutex_;
+  };
+
+  class scoped_model_rlock : public scoped_model_lock {
+   public:
+    explicit scoped_model_rlock(const driver_base& d)
+        : scoped_model_lock(d.model_mutex(), false) {
+    }
+  };
+
+  class scoped_model_wlock : public scoped_model_lock {
+   public:
+    explicit scoped_model_wlock(const driver_base& d)
+        : scoped_model_lock(d.model_mutex(), true) {
+    }
+  };
+
+  jubatus::util::concurrent::rw_mutex* model_mutex() const {
+    return concurrent_ ? &model_mutex_ : NULL;
+  }
+
   class mixable_holder : public framework::linear_mixable,
     public framework::push_mixable {
    public:
+    mixable_holder()
+        : model_mutex_(NULL),
+          metrics_(NULL) {
+    }
+
     std::set<std::string> mixables() const;
     void register_mixable(framework::mixable* mixable);
+    void set_model_mutex(jubatus::util::concurrent::rw_mutex* mutex) {
+      model_mutex_ = mutex;
+    }
+    void set_metrics(common::metrics::recorder* metrics) {
+      metrics_ = metrics;
+    }
+    // Called under the model lock after put_diff or push has updated the
+    // registered mixables.
+    void set_mixed_callback(
+        const jubatus::util::lang::function<void()>& callback) {
+      mixed_callback_ = callback;
+    }
 
     // linear_mixable
     framework::diff_object convert_diff_object(const msgpack::object&) const;
     void mix(const msgpack::object& obj, framework::diff_object) const;
     void get_diff(framework::packer&) const;
     bool put_diff(const framework::diff_object& obj);
+    // Puts back the diffs frozen by get_diff when the MIX failed.  Diffs
+    // are frozen only when the model lock is enabled; otherwise get_diff
+    // packs them in place under the caller's lock.
+    void abort_diff();
 
     // push_mixable
     void get_argument(framework::packer&) const;
@@ -63,12 +148,24 @@ class driver_base {
 
     std::vector<storage::version> get_versions() const;
    private:
+    void pack_diff(
+        const std::vector<framework::diff_object>& frozen,
+        framework::packer& pk) const;
+    void abort_frozen_diff() const;
+
     std::vector<mixable*> mixables_;
+    jubatus::util::concurrent::rw_mutex* model_mutex_;
+    common::metrics::recorder* metrics_;
+    jubatus::util::lang::function<void()> mixed_callback_;
   };
 
+  mutable common::metrics::recorder metrics_;
   mixable_holder holder_;
 
  private:
+  bool concurrent_;
+  mutable jubatus::util::concurrent::rw_mutex model_mutex_;
+
   driver_base(const driver_base&);
   void operator=(const driver_base&);
 };
@@ -166,10 +166,12 @@ void graph::create_edge_here(
 }
 
 void graph::pack(framework::packer& pk) const {
+  JUBATUS_METRICS_SCOPE(metrics_, PACK);
   graph_->pack(pk);
 }
 
 void graph::unpack(msgpack::object o) {
+  JUBATUS_METRICS_SCOPE(metrics_, UNPACK);
   graph_->unpack(o);
 }
 
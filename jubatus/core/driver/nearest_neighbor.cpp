@@ -65,12 +65,17 @@ void nearest_neighbor::set_row(
     unlearner_->touch(id);
   }
   common::sfv_t v;
-  converter_->convert_and_update_weight(datum, v);
+  {
+    JUBATUS_METRICS_SCOPE(metrics_, CONVERT);
+    converter_->convert_and_update_weight(datum, v);
+  }
+  JUBATUS_METRICS_SCOPE(metrics_, TRAIN);
   nn_->set_row(id, v);
 }
 
 std::vector<std::pair<std::string, float> >
 nearest_neighbor::neighbor_row_from_id(const std::string& id, size_t size) {
+  JUBATUS_METRICS_SCOPE(metrics_, NEIGHBOR_SEARCH);
   std::vector<std::pair<std::string, float> > ret;
   nn_->neighbor_row(id, ret, size);
   return ret;
@@ -81,7 +86,11 @@ nearest_neighbor::neighbor_row_from_datum(
     const fv_converter::datum& datum,
     size_t size) {
   common::sfv_t v;
-  converter_->convert(datum, v);
+  {
+    JUBATUS_METRICS_SCOPE(metrics_, CONVERT);
+    converter_->convert(datum, v);
+  }
+  JUBATUS_METRICS_SCOPE(metrics_, NEIGHBOR_SEARCH);
   std::vector<std::pair<std::string, float> > ret;
   nn_->neighbor_row(v, ret, size);
   return ret;
@@ -89,6 +98,7 @@ nearest_neighbor::neighbor_row_from_datum(
 
 std::vector<std::pair<std::string, float> >
 nearest_neighbor::similar_row(const std::string& id, size_t ret_num) {
+  JUBATUS_METRICS_SCOPE(metrics_, NEIGHBOR_SEARCH);
   std::vector<std::pair<std::string, float> > ret;
   nn_->similar_row(id, ret, ret_num);
   return ret;
@@ -99,7 +109,11 @@ nearest_neighbor::similar_row(
     const core::fv_converter::datum& datum,
     size_t ret_num) {
   common::sfv_t v;
-  converter_->convert(datum, v);
+  {
+    JUBATUS_METRICS_SCOPE(metrics_, CONVERT);
+    converter_->convert(datum, v);
+  }
+  JUBATUS_METRICS_SCOPE(metrics_, NEIGHBOR_SEARCH);
   std::vector<std::pair<std::string, float> > ret;
   nn_->similar_row(v, ret, ret_num);
   return ret;
@@ -120,6 +134,7 @@ void nearest_neighbor::clear() {
 }
 
 void nearest_neighbor::pack(framework::packer& pk) const {
+  JUBATUS_METRICS_SCOPE(metrics_, PACK);
   pk.pack_array(2);
   nn_->pack(pk);
   wm_.get_model()->pack(pk);
@@ -130,6 +145,8 @@ void nearest_neighbor::unpack(msgpack::object o) {
     throw msgpack::type_error();
   }
 
+  JUBATUS_METRICS_SCOPE(metrics_, UNPACK);
+
   // clear
   nn_->clear();
   converter_->clear_weights();
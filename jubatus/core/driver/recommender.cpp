@@ -20,6 +20,7 @@
 #include <utility>
 #include <vector>
 
+#include "jubatus/util/lang/bind.h"
 #include "jubatus/util/lang/shared_ptr.h"
 
 #include "../common/exception.hpp"
@@ -49,6 +50,10 @@ recommender::recommender(
       wm_(mixable_weight_manager::model_ptr(new weight_manager)) {
   register_mixable(recommender_->get_mixable());
   register_mixable(&wm_);
+  // MIX may change the neighbors of any row.
+  holder_.set_mixed_callback(jubatus::util::lang::bind(
+      &core::recommender::recommender_base::clear_complete_row_cache,
+      recommender_.get()));
 
   converter_->set_weight_manager(wm_.get_model());
 }
@@ -64,7 +69,11 @@ void recommender::update_row(
     const std::string& id,
     const fv_converter::datum& dat) {
   core::recommender::sfv_diff_t v;
-  converter_->convert_and_update_weight(dat, v);
+  {
+    JUBATUS_METRICS_SCOPE(metrics_, CONVERT);
+    converter_->convert_and_update_weight(dat, v);
+  }
+  JUBATUS_METRICS_SCOPE(metrics_, TRAIN);
   recommender_->update_row(id, v);
 }
 
@@ -96,6 +105,7 @@ fv_converter::datum recommender::complete_row_from_datum(
 std::vector<std::pair<std::string, float> > recommender::similar_row_from_id(
     const std::string& id,
     size_t ret_num) {
+  JUBATUS_METRICS_SCOPE(metrics_, NEIGHBOR_SEARCH);
   std::vector<std::pair<std::string, float> > ret;
   recommender_->similar_row(id, ret, ret_num);
   return ret;
@@ -106,8 +116,12 @@ recommender::similar_row_from_datum(
     const fv_converter::datum& data,
     size_t size) {
   common::sfv_t v;
-  converter_->convert(data, v);
+  {
+    JUBATUS_METRICS_SCOPE(metrics_, CONVERT);
+    converter_->convert(data, v);
+  }
 
+  JUBATUS_METRICS_SCOPE(metrics_, NEIGHBOR_SEARCH);
   std::vector<std::pair<std::string, float> > ret;
   recommender_->similar_row(v, ret, size);
   return ret;
@@ -144,6 +158,7 @@ std::vector<std::string> recommender::get_all_rows() {
 }
 
 void recommender::pack(framework::packer& pk) const {
+  JUBATUS_METRICS_SCOPE(metrics_, PACK);
   pk.pack_array(2);
   recommender_->pack(pk);
   wm_.get_model()->pack(pk);
@@ -154,6 +169,7 @@ void recommender::unpack(msgpack::object o) {
     throw msgpack::type_error();
   }
 
+  JUBATUS_METRICS_SCOPE(metrics_, UNPACK);
   // clear before load
   recommender_->clear();
   converter_->clear_weights();
@@ -83,6 +83,52 @@ TEST_F(recommender_test, small) {
   recommender_->complete_row_from_id("key");
 }
 
+void put_diff_from(driver_base& from, driver_base& to) {
+  framework::linear_mixable* from_mixable =
+      dynamic_cast<framework::linear_mixable*>(from.get_mixable());
+  framework::linear_mixable* to_mixable =
+      dynamic_cast<framework::linear_mixable*>(to.get_mixable());
+  ASSERT_TRUE(from_mixable);
+  ASSERT_TRUE(to_mixable);
+
+  msgpack::sbuffer sbuf;
+  core::framework::stream_writer<msgpack::sbuffer> st(sbuf);
+  core::framework::jubatus_packer jp(st);
+  core::framework::packer pk(jp);
+  from_mixable->get_diff(pk);
+
+  msgpack::unpacked msg;
+  msgpack::unpack(&msg, sbuf.data(), sbuf.size());
+  to_mixable->put_diff(to_mixable->convert_diff_object(msg.get()));
+}
+
+TEST(recommender, complete_row_cache_is_cleared_by_mix) {
+  shared_ptr<recommender_base> method(new core::recommender::inverted_index);
+  method->set_complete_row_cache_size(16);
+  driver::recommender local(method, make_fv_converter());
+  driver::recommender remote(
+      shared_ptr<recommender_base>(new core::recommender::inverted_index),
+      make_fv_converter());
+
+  datum a, b;
+  a.num_values_.push_back(make_pair("f1", 1.0));
+  b.num_values_.push_back(make_pair("f1", 1.0));
+  b.num_values_.push_back(make_pair("f2", 1.0));
+  local.update_row("a", a);
+  local.update_row("b", b);
+  put_diff_from(local, local);
+  remote.update_row("a", a);
+  remote.update_row("b", b);
+  put_diff_from(remote, remote);
+
+  EXPECT_EQ(2u, local.complete_row_from_id("a").num_values_.size());
+
+  // "b" is no longer a neighbor of "a" after MIX
+  remote.clear_row("b");
+  put_diff_from(remote, local);
+  EXPECT_EQ(1u, local.complete_row_from_id("a").num_values_.size());
+}
+
 class nn_recommender_test
     : public ::testing::TestWithParam<
         shared_ptr<core::recommender::recommender_base> > {
@@ -53,29 +53,44 @@ regression::~regression() {
 }
 
 void regression::train(const pair<float, fv_converter::datum>& data) {
+  scoped_model_wlock lk(*this);
   common::sfv_t v;
-  converter_->convert_and_update_weight(data.second, v);
+  {
+    JUBATUS_METRICS_SCOPE(metrics_, CONVERT);
+    converter_->convert_and_update_weight(data.second, v);
+  }
+  JUBATUS_METRICS_SCOPE(metrics_, TRAIN);
   regression_->train(v, data.first);
 }
 
 float regression::estimate(
     const fv_converter::datum& data) const {
+  scoped_model_rlock lk(*this);
   common::sfv_t v;
-  converter_->convert(data, v);
+  {
+    JUBATUS_METRICS_SCOPE(metrics_, CONVERT);
+    converter_->convert(data, v);
+  }
+  JUBATUS_METRICS_SCOPE(metrics_, CLASSIFY);
   float value = regression_->estimate(v);
   return value;
 }
 
 void regression::get_status(std::map<string, string>& status) const {
+  scoped_model_rlock lk(*this);
   regression_->get_status(status);
+  driver_base::get_status(status);
 }
 
 void regression::clear() {
+  scoped_model_wlock lk(*this);
   regression_->clear();
   converter_->clear_weights();
 }
 
 void regression::pack(framework::packer& pk) const {
+  scoped_model_rlock lk(*this);
+  JUBATUS_METRICS_SCOPE(metrics_, PACK);
   pk.pack_array(2);
   regression_->get_storage()->pack(pk);
   wm_.get_model()->pack(pk);
@@ -86,6 +101,9 @@ void regression::unpack(msgpack::object o) {
     throw msgpack::type_error();
   }
 
+  scoped_model_wlock lk(*this);
+  JUBATUS_METRICS_SCOPE(metrics_, UNPACK);
+
   // clear before load
   regression_->clear();
   converter_->clear_weights();
@@ -93,6 +111,10 @@ void regression::unpack(msgpack::object o) {
   wm_.get_model()->unpack(o.via.array.ptr[1]);
 }
 
+void regression::enable_concurrent_mode() {
+  enable_model_lock();
+}
+
 }  // namespace driver
 }  // namespace core
 }  // namespace jubatus
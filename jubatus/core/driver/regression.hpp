@@ -53,6 +53,9 @@ class regression : public driver_base {
   void pack(framework::packer& pk) const;
   void unpack(msgpack::object o);
 
+  // Lets estimate run in parallel (see driver_base::enable_model_lock()).
+  void enable_concurrent_mode();
+
  private:
   jubatus::util::lang::shared_ptr<fv_converter::datum_to_fv_converter>
     converter_;
@@ -64,10 +64,12 @@ double stat::moment(const std::string& key, int n, double c) const {
 }
 
 void stat::pack(framework::packer& pk) const {
+  JUBATUS_METRICS_SCOPE(metrics_, PACK);
   stat_->pack(pk);
 }
 
 void stat::unpack(msgpack::object o) {
+  JUBATUS_METRICS_SCOPE(metrics_, UNPACK);
   stat_->unpack(o);
 }
 
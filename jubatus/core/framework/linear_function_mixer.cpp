@@ -62,6 +62,22 @@ struct internal_diff_object : diff_object_raw {
   diffv diff_;
 };
 
+struct frozen_diff_object : diff_object_raw {
+  explicit frozen_diff_object(
+      jubatus::util::lang::shared_ptr<const storage::frozen_diff> diff)
+      : diff_(diff) {
+  }
+
+  void convert_binary(packer& pk) const {
+    diffv diff;
+    diff.count = 1;
+    diff_->get_diff(diff.v);
+    pk.pack(diff);
+  }
+
+  jubatus::util::lang::shared_ptr<const storage::frozen_diff> diff_;
+};
+
 }  // namespace
 
 void linear_function_mixer::mix(const diffv& lhs, diffv& mixed) const {
@@ -158,6 +174,19 @@ bool linear_function_mixer::put_diff(const diff_object& ptr) {
   return put_diff(diff_obj->diff_);
 }
 
+diff_object linear_function_mixer::freeze_diff() {
+  jubatus::util::lang::shared_ptr<const storage::frozen_diff> diff =
+      get_model()->freeze_diff();
+  if (!diff) {
+    return diff_object();
+  }
+  return diff_object(new frozen_diff_object(diff));
+}
+
+void linear_function_mixer::abort_diff() {
+  get_model()->abort_diff();
+}
+
 }  // namespace framework
 }  // namespace core
 }  // namespace jubatus
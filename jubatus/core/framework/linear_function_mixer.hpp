@@ -61,6 +61,8 @@ class linear_function_mixer : public linear_mixable {
   void mix(const msgpack::object& obj, diff_object) const;
   void get_diff(packer&) const;
   bool put_diff(const diff_object& obj);
+  diff_object freeze_diff();
+  void abort_diff();
 
   jubatus::util::lang::shared_ptr<unlearner::unlearner_base>
   get_unlearner() const {
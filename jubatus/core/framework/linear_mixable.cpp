@@ -29,6 +29,13 @@ linear_mixable::linear_mixable() : mixable("linear_mixable") {
 linear_mixable::~linear_mixable() {
 }
 
+diff_object linear_mixable::freeze_diff() {
+  return diff_object();
+}
+
+void linear_mixable::abort_diff() {
+}
+
 }  // namespace framework
 }  // namespace core
 }  // namespace jubatus
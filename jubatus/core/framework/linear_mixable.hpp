@@ -45,6 +45,16 @@ class linear_mixable : public virtual mixable {
   virtual void mix(const msgpack::object& obj, diff_object) const = 0;
   virtual void get_diff(packer&) const = 0;
   virtual bool put_diff(const diff_object& obj) = 0;
+
+  // Optional double buffering of the diff.  freeze_diff() is called under
+  // the model write lock and moves the current diff aside in O(1); the
+  // returned object packs it (see diff_object_raw::convert_binary) without
+  // the model lock while updates go to a fresh diff.  The frozen diff is
+  // still visible to queries, and is dropped by put_diff() or merged back
+  // by abort_diff() when the MIX failed.  Returns an empty pointer if not
+  // supported; get_diff() is used then.
+  virtual diff_object freeze_diff();
+  virtual void abort_diff();
 };
 
 
@@ -115,6 +115,43 @@ class linear_mixable_helper : public linear_mixable {
   model_ptr model_;
 };
 
+// linear_mixable_helper for models supporting double-buffered diffs:
+//   jubatus::util::lang::shared_ptr<const Diff> freeze_diff();
+//   void abort_diff();
+template <typename Model, typename Diff>
+class double_buffered_mixable_helper
+    : public linear_mixable_helper<Model, Diff> {
+ public:
+  typedef typename linear_mixable_helper<Model, Diff>::model_ptr model_ptr;
+
+  explicit double_buffered_mixable_helper(model_ptr model)
+    : linear_mixable_helper<Model, Diff>(model) {
+  }
+
+  diff_object freeze_diff() {
+    return diff_object(
+        new frozen_diff_object(this->get_model()->freeze_diff()));
+  }
+
+  void abort_diff() {
+    this->get_model()->abort_diff();
+  }
+
+ private:
+  struct frozen_diff_object : diff_object_raw {
+    explicit frozen_diff_object(
+        jubatus::util::lang::shared_ptr<const Diff> diff)
+        : diff_(diff) {
+    }
+
+    void convert_binary(packer& pk) const {
+      pk.pack(*diff_);
+    }
+
+    jubatus::util::lang::shared_ptr<const Diff> diff_;
+  };
+};
+
 }  // namespace framework
 }  // namespace core
 }  // namespace jubatus
@@ -28,7 +28,6 @@
 
 typedef jubatus::core::table::column_table::version_t version_t;
 
-using jubatus::util::lang::shared_ptr;
 using jubatus::core::framework::diff_object;
 using jubatus::core::framework::diff_object_raw;
 using jubatus::core::framework::stream_writer;
@@ -56,41 +55,88 @@ std::string get_row_key(const std::string& packed) {
 
 namespace {
 
+// returns the byte length of the msgpack array header at the head of p
+size_t read_array_header(const char* p, size_t size, uint64_t& count) {
+  const unsigned char* u = reinterpret_cast<const unsigned char*>(p);
+  if (size >= 1 && (u[0] & 0xf0) == 0x90) {  // fix array
+    count = u[0] & 0x0f;
+    return 1;
+  } else if (size >= 3 && u[0] == 0xdc) {  // array 16
+    count = (static_cast<uint64_t>(u[1]) << 8) | u[2];
+    return 3;
+  } else if (size >= 5 && u[0] == 0xdd) {  // array 32
+    count = (static_cast<uint64_t>(u[1]) << 24) |
+        (static_cast<uint64_t>(u[2]) << 16) |
+        (static_cast<uint64_t>(u[3]) << 8) | u[4];
+    return 5;
+  }
+  throw JUBATUS_EXCEPTION(
+      core::common::exception::runtime_error("bad diff_object"));
+}
+
+size_t array_header_size(uint64_t count) {
+  return count < 16 ? 1 : count < 65536 ? 3 : 5;
+}
+
+// The diff keeps the packed rows it received as a list of chunks instead of
+// decoding them.  Chunks refer to (not copy) the raw bytes of the objects
+// given to convert_diff_object() and mix(), which must outlive the diff as
+// before.  convert_binary() gathers the chunks under one array header, and
+// rows are decoded only once, in put_diff().
 struct internal_diff : framework::diff_object_raw {
+  struct chunk {
+    const char* body;  // packed rows without the array header
+    size_t size;
+    uint64_t rows;
+  };
+
+  void add_chunk(const msgpack::object& obj) {
+    if (obj.type != msgpack::type::RAW) {
+      throw JUBATUS_EXCEPTION(
+          core::common::exception::runtime_error("bad diff_object"));
+    }
+    chunk c;
+    const size_t header = read_array_header(
+        obj.via.raw.ptr, obj.via.raw.size, c.rows);
+    c.body = obj.via.raw.ptr + header;
+    c.size = obj.via.raw.size - header;
+    if (c.rows > 0) {
+      chunks.push_back(c);
+    }
+  }
+
+  uint64_t rows() const {
+    uint64_t n = 0;
+    for (size_t i = 0; i < chunks.size(); ++i) {
+      n += chunks[i].rows;
+    }
+    return n;
+  }
+
   void convert_binary(framework::packer& pk) const {
-    msgpack::sbuffer data;
-    core::framework::stream_writer<msgpack::sbuffer> st(data);
-    core::framework::jubatus_packer jp(st);
-    core::framework::packer p(jp);
-    p.pack(objs);
-
-    pk.pack_raw(data.size());
-    pk.pack_raw_body(data.data(), data.size());
+    const uint64_t n = rows();
+    size_t size = array_header_size(n);
+    for (size_t i = 0; i < chunks.size(); ++i) {
+      size += chunks[i].size;
+    }
+
+    pk.pack_raw(size);
+    pk.pack_array(n);
+    for (size_t i = 0; i < chunks.size(); ++i) {
+      pk.pack_raw_body(chunks[i].body, chunks[i].size);
+    }
   }
 
-  vector<msgpack::object> objs;
-  vector<shared_ptr<msgpack::zone> > zones;
+  vector<chunk> chunks;
 };
 
 }  // namespace
 
 framework::diff_object mixable_versioned_table::convert_diff_object(
     const msgpack::object& obj) const {
-  if (obj.type != msgpack::type::RAW) {
-    throw JUBATUS_EXCEPTION(
-        core::common::exception::runtime_error("bad diff_object"));
-  }
   internal_diff* diff = new internal_diff;
   diff_object diff_obj(diff);
-
-  msgpack::unpacked msg;
-  msgpack::unpack(&msg, obj.via.raw.ptr, obj.via.raw.size);
-
-  msg.get().convert(&diff->objs);
-  if (!diff->objs.empty()) {
-    shared_ptr<msgpack::zone> owner(msg.zone().release());
-    diff->zones.push_back(owner);
-  }
+  diff->add_chunk(obj);
   return diff_obj;
 }
 
@@ -101,7 +147,7 @@ void mixable_versioned_table::get_diff(framework::packer& pk) const {
   core::framework::packer p(jp);
   pull_impl(vc_, p);
 
-  // Wrap msgpack binary more for holding msgpack::zone in internal diff_object.
+  // Wrap msgpack binary more for referring it as chunks in internal diff.
   pk.pack_raw(data.size());
   pk.pack_raw_body(data.data(), data.size());
 }
@@ -113,12 +159,15 @@ bool mixable_versioned_table::put_diff(const framework::diff_object& ptr) {
         core::common::exception::runtime_error("bad diff_object"));
   }
 
-  msgpack::object obj;
-  obj.type = msgpack::type::ARRAY;
-  obj.via.array.ptr = &diff_obj->objs[0];
-  obj.via.array.size = diff_obj->objs.size();
-
-  push_impl(obj);
+  msgpack::unpacked row;
+  for (size_t i = 0; i < diff_obj->chunks.size(); ++i) {
+    const internal_diff::chunk& c = diff_obj->chunks[i];
+    size_t offset = 0;
+    for (uint64_t j = 0; j < c.rows; ++j) {
+      msgpack::unpack(&row, c.body, c.size, &offset);
+      set_row(row.get());
+    }
+  }
 
   return true;
 }
@@ -131,26 +180,7 @@ void mixable_versioned_table::mix(
     throw JUBATUS_EXCEPTION(
         core::common::exception::runtime_error("bad diff_object"));
   }
-
-  if (obj.type != msgpack::type::RAW) {
-    throw JUBATUS_EXCEPTION(
-        core::common::exception::runtime_error("bad diff_object"));
-  }
-  msgpack::unpacked msg;
-  msgpack::unpack(&msg, obj.via.raw.ptr, obj.via.raw.size);
-  msgpack::object o = msg.get();
-  if (o.type != msgpack::type::ARRAY) {
-    throw JUBATUS_EXCEPTION(
-        core::common::exception::runtime_error("bad diff_object"));
-  }
-  for (size_t i = 0; i < o.via.array.size; i++) {
-    diff_obj->objs.push_back(o.via.array.ptr[i]);
-  }
-
-  if (o.via.array.size > 0) {
-    shared_ptr<msgpack::zone> owner(msg.zone().release());
-    diff_obj->zones.push_back(owner);
-  }
+  diff_obj->add_chunk(obj);
 }
 
 void mixable_versioned_table::get_argument(framework::packer& pk) const {
@@ -171,39 +201,25 @@ void mixable_versioned_table::push(const msgpack::object& diff) {
 
 void mixable_versioned_table::pull_impl(
     const version_clock& vc, framework::packer& pk) const {
-
-  model_ptr table = get_model();
-  const uint64_t table_size = table->size();
-
-  size_t pack_size = 0;
-  for (uint64_t i = 0; i < table_size; ++i) {
-    const version_t version = table->get_version(i);
-    version_clock::const_iterator it = vc.find(version.first);
-    if (it == vc.end() || it->second < version.second) {
-      pack_size++;
-    }
-  }
-  pk.pack_array(pack_size);
-
-  for (uint64_t i = 0; i < table_size; ++i) {
-    const version_t version = table->get_version(i);
-    version_clock::const_iterator it = vc.find(version.first);
-    if (it == vc.end() || it->second < version.second) {
-      table->get_row(i, pk);
-    }
-  }
+  get_model()->get_rows_since(vc, pk);
 }
 
 void mixable_versioned_table::push_impl(
     const msgpack::object& o) {
-  model_ptr table = get_model();
   if (o.type != msgpack::type::ARRAY) {
     throw JUBATUS_EXCEPTION(
         core::common::exception::runtime_error("bad diff_object"));
   }
   for (uint64_t i = 0; i < o.via.array.size; ++i) {
-    const version_t version = table->set_row(o.via.array.ptr[i]);
-    update_version(version);
+    set_row(o.via.array.ptr[i]);
+  }
+}
+
+void mixable_versioned_table::set_row(const msgpack::object& row) {
+  update_version(model_->set_row(row));
+  if (row_callback_) {
+    // set_row() has checked that the row is [key, version, values]
+    row_callback_(row.via.array.ptr[0].as<std::string>());
   }
 }
 
@@ -20,6 +20,7 @@
 #include <map>
 #include <string>
 #include <vector>
+#include "jubatus/util/lang/function.h"
 #include "../../core/common/version.hpp"
 #include "../../core/framework/push_mixable.hpp"
 #include "../../core/framework/linear_mixable.hpp"
@@ -42,6 +43,13 @@ class mixable_versioned_table : public core::framework::push_mixable,
     unlearner_ = unlearner;
   }
 
+  // Called with the key of each row put into the model by MIX, so that
+  // indexes built over the table can follow it.
+  void set_row_callback(
+      jubatus::util::lang::function<void(const std::string&)> callback) {
+    row_callback_ = callback;
+  }
+
   // linear mixable
   framework::diff_object convert_diff_object(const msgpack::object&) const;
   void mix(const msgpack::object& obj, framework::diff_object) const;
@@ -72,9 +80,11 @@ class mixable_versioned_table : public core::framework::push_mixable,
   void push_impl(const msgpack::object&);
 
   void update_version(const table::column_table::version_t& version);
+  void set_row(const msgpack::object& row);
 
   model_ptr model_;
   jubatus::util::lang::shared_ptr<unlearner::unlearner_base> unlearner_;
+  jubatus::util::lang::function<void(const std::string&)> row_callback_;
   version_clock vc_;
 };
 
@@ -0,0 +1,124 @@
+// Jubatus: Online machine learning framework for distributed environment
+// Copyright (C) 2015 Preferred Networks and Nippon Telegraph and Telephone Corporation.
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License version 2.1 as published by the Free Software Foundation.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "../../util/lang/shared_ptr.h"
+#include "../table/column/column_table.hpp"
+#include "mixable_versioned_table.hpp"
+#include "stream_writer.hpp"
+
+using std::string;
+using std::vector;
+using jubatus::util::lang::shared_ptr;
+using jubatus::core::table::column_table;
+using jubatus::core::table::column_type;
+using jubatus::core::table::owner;
+
+namespace jubatus {
+namespace core {
+namespace framework {
+
+namespace {
+
+shared_ptr<mixable_versioned_table> make_mixable() {
+  shared_ptr<column_table> table(new column_table);
+  vector<column_type> schema;
+  schema.push_back(column_type(column_type::int32_type));
+  table->init(schema);
+  shared_ptr<mixable_versioned_table> mixable(new mixable_versioned_table);
+  mixable->set_model(table);
+  return mixable;
+}
+
+void get_diff(const mixable_versioned_table& m, msgpack::sbuffer& buf) {
+  stream_writer<msgpack::sbuffer> st(buf);
+  jubatus_packer jp(st);
+  packer pk(jp);
+  m.get_diff(pk);
+}
+
+}  // namespace
+
+TEST(mixable_versioned_table, mix_round_trip) {
+  shared_ptr<mixable_versioned_table> m1 = make_mixable();
+  shared_ptr<mixable_versioned_table> m2 = make_mixable();
+  shared_ptr<mixable_versioned_table> m3 = make_mixable();
+  m1->get_model()->add("a", owner("m1"), 1);
+  m1->get_model()->add("b", owner("m1"), 2);
+  m2->get_model()->add("c", owner("m2"), 3);
+
+  msgpack::sbuffer buf1, buf2, empty;
+  get_diff(*m1, buf1);
+  get_diff(*m2, buf2);
+  get_diff(*m3, empty);
+
+  msgpack::unpacked msg1, msg2, msg3;
+  msgpack::unpack(&msg1, buf1.data(), buf1.size());
+  msgpack::unpack(&msg2, buf2.data(), buf2.size());
+  msgpack::unpack(&msg3, empty.data(), empty.size());
+  diff_object diff = m1->convert_diff_object(msg1.get());
+  m1->mix(msg2.get(), diff);
+  m1->mix(msg3.get(), diff);
+
+  // the mixed diff is serialized again and applied on another node
+  msgpack::sbuffer mixed;
+  {
+    stream_writer<msgpack::sbuffer> st(mixed);
+    jubatus_packer jp(st);
+    packer pk(jp);
+    diff->convert_binary(pk);
+  }
+  msgpack::unpacked mixed_msg;
+  msgpack::unpack(&mixed_msg, mixed.data(), mixed.size());
+  ASSERT_EQ(msgpack::type::RAW, mixed_msg.get().type);
+  {
+    msgpack::unpacked rows;
+    msgpack::unpack(&rows, mixed_msg.get().via.raw.ptr,
+                    mixed_msg.get().via.raw.size);
+    ASSERT_EQ(msgpack::type::ARRAY, rows.get().type);
+    EXPECT_EQ(3u, rows.get().via.array.size);
+  }
+
+  EXPECT_TRUE(m3->put_diff(m3->convert_diff_object(mixed_msg.get())));
+  shared_ptr<column_table> table = m3->get_model();
+  ASSERT_EQ(3u, table->size());
+  EXPECT_EQ(1, table->get_int32_column(0)[table->exact_match("a").second]);
+  EXPECT_EQ(2, table->get_int32_column(0)[table->exact_match("b").second]);
+  EXPECT_EQ(3, table->get_int32_column(0)[table->exact_match("c").second]);
+}
+
+TEST(mixable_versioned_table, bad_diff) {
+  shared_ptr<mixable_versioned_table> m = make_mixable();
+  msgpack::sbuffer buf;
+  msgpack::pack(buf, 1);
+  msgpack::unpacked msg;
+  msgpack::unpack(&msg, buf.data(), buf.size());
+  EXPECT_THROW(m->convert_diff_object(msg.get()),
+               core::common::exception::runtime_error);
+
+  msgpack::sbuffer raw;
+  msgpack::pack(raw, string("x"));
+  msgpack::unpack(&msg, raw.data(), raw.size());
+  EXPECT_THROW(m->convert_diff_object(msg.get()),
+               core::common::exception::runtime_error);
+}
+
+}  // namespace framework
+}  // namespace core
+}  // namespace jubatus
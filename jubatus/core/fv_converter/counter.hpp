@@ -17,6 +17,7 @@
 #ifndef JUBATUS_CORE_FV_CONVERTER_COUNTER_HPP_
 #define JUBATUS_CORE_FV_CONVERTER_COUNTER_HPP_
 
+#include <algorithm>
 #include <ostream>
 #include <sstream>
 
@@ -76,6 +77,10 @@ class counter {
     jubatus::util::data::unordered_map<T, double>().swap(data_);
   }
 
+  void swap(counter<T>& counts) {
+    data_.swap(counts.data_);
+  }
+
   void add(const counter<T>& counts) {
     for (const_iterator it = counts.begin(); it != counts.end(); ++it) {
       (*this)[it->first] += it->second;
@@ -29,6 +29,7 @@
 #include "datum.hpp"
 #include "exception.hpp"
 #include "feature_hasher.hpp"
+#include "key_matcher_cache.hpp"
 #include "match_all.hpp"
 #include "mixable_weight_manager.hpp"
 #include "num_feature.hpp"
@@ -45,37 +46,51 @@ namespace fv_converter {
 
 /// impl
 
+namespace {
+
+// Datum keys are usually a small and stable set, so the matching results
+// for this number of keys are kept.
+const size_t MATCHER_CACHE_SIZE = 4096;
+
+}  // namespace
+
 class datum_to_fv_converter_impl {
  private:
   typedef jubatus::util::data::unordered_map<std::string, float> weight_t;
 
   struct string_filter_rule {
-    jubatus::util::lang::shared_ptr<key_matcher> matcher_;
+    size_t matcher_id_;
     jubatus::util::lang::shared_ptr<string_filter> filter_;
     std::string suffix_;
 
-    void filter(const datum::sv_t& string_values, datum::sv_t& filtered) const {
+    void filter(
+        const key_matcher_cache& matchers,
+        const datum::sv_t& string_values,
+        datum::sv_t& filtered) const {
       for (size_t i = 0; i < string_values.size(); ++i) {
         const std::pair<std::string, std::string>& value = string_values[i];
-        if (matcher_->match(value.first)) {
-          std::string out;
-          filter_->filter(value.second, out);
-          std::string dest = value.first + suffix_;
-          filtered.push_back(std::make_pair(dest, out));
+        if (matchers.match(matcher_id_, value.first)) {
+          // filter directly into the new element not to copy the output
+          filtered.push_back(
+              std::make_pair(value.first + suffix_, std::string()));
+          filter_->filter(value.second, filtered.back().second);
         }
       }
     }
   };
 
   struct num_filter_rule {
-    jubatus::util::lang::shared_ptr<key_matcher> matcher_;
+    size_t matcher_id_;
     jubatus::util::lang::shared_ptr<num_filter> filter_;
     std::string suffix_;
 
-    void filter(const datum::nv_t& num_values, datum::nv_t& filtered) const {
+    void filter(
+        const key_matcher_cache& matchers,
+        const datum::nv_t& num_values,
+        datum::nv_t& filtered) const {
       for (size_t i = 0; i < num_values.size(); ++i) {
         const std::pair<std::string, double>& value = num_values[i];
-        if (matcher_->match(value.first)) {
+        if (matchers.match(matcher_id_, value.first)) {
           double out = filter_->filter(value.second);
           std::string dest = value.first + suffix_;
           filtered.push_back(std::make_pair(dest, out));
@@ -86,48 +101,57 @@ class datum_to_fv_converter_impl {
 
   struct string_feature_rule {
     std::string name_;
-    jubatus::util::lang::shared_ptr<key_matcher> matcher_;
+    size_t matcher_id_;
     jubatus::util::lang::shared_ptr<string_feature> splitter_;
     std::vector<splitter_weight_type> weights_;
+    // "@<FEATURE_TYPE>#<SAMPLE_WEIGHT>/<GLOBAL_WEIGHT>" for each weights_,
+    // which does not depend on the datum
+    std::vector<std::string> feature_suffixes_;
 
     string_feature_rule(
         const std::string& name,
-        jubatus::util::lang::shared_ptr<key_matcher> matcher,
+        size_t matcher_id,
         jubatus::util::lang::shared_ptr<string_feature> splitter,
         const std::vector<splitter_weight_type>& weights)
         : name_(name),
-          matcher_(matcher),
+          matcher_id_(matcher_id),
           splitter_(splitter),
           weights_(weights) {
+      for (size_t i = 0; i < weights.size(); ++i) {
+        feature_suffixes_.push_back(
+            "@" + name + "#" +
+            get_sample_weight_name(weights[i].freq_weight_type_) + "/" +
+            get_global_weight_name(weights[i].term_weight_type_));
+      }
     }
   };
 
   struct num_feature_rule {
     std::string name_;
-    jubatus::util::lang::shared_ptr<key_matcher> matcher_;
+    size_t matcher_id_;
     jubatus::util::lang::shared_ptr<num_feature> feature_func_;
 
     num_feature_rule(
         const std::string& name,
-        jubatus::util::lang::shared_ptr<key_matcher> matcher,
+        size_t matcher_id,
         jubatus::util::lang::shared_ptr<num_feature> feature_func)
         : name_(name),
-          matcher_(matcher),
+          matcher_id_(matcher_id),
           feature_func_(feature_func) {
     }
   };
 
   struct binary_feature_rule {
     std::string name_;
-    jubatus::util::lang::shared_ptr<key_matcher> matcher_;
+    size_t matcher_id_;
     jubatus::util::lang::shared_ptr<binary_feature> feature_func_;
 
     binary_feature_rule(
         const std::string& name,
-        jubatus::util::lang::shared_ptr<key_matcher> matcher,
+        size_t matcher_id,
         jubatus::util::lang::shared_ptr<binary_feature> feature_func)
         : name_(name),
-          matcher_(matcher),
+          matcher_id_(matcher_id),
           feature_func_(feature_func) {
     }
   };
@@ -163,12 +187,17 @@ class datum_to_fv_converter_impl {
 
   jubatus::util::data::optional<feature_hasher> hasher_;
 
+  // matchers of all rules except combination rules, which are applied to
+  // feature keys rather than datum keys
+  key_matcher_cache matchers_;
+
  public:
   datum_to_fv_converter_impl()
     : mixable_weights_(
         new mixable_weight_manager(
             jubatus::util::lang::shared_ptr<weight_manager>(
-                new weight_manager))) {
+                new weight_manager))),
+      matchers_(MATCHER_CACHE_SIZE) {
   }
 
   void clear_rules() {
@@ -178,13 +207,16 @@ class datum_to_fv_converter_impl {
     num_rules_.clear();
     binary_rules_.clear();
     combination_rules_.clear();
+    matchers_.clear();
   }
 
   void register_string_filter(
       jubatus::util::lang::shared_ptr<key_matcher> matcher,
       jubatus::util::lang::shared_ptr<string_filter> filter,
       const std::string& suffix) {
-    string_filter_rule rule = { matcher, filter, suffix };
+    string_filter_rule rule = {
+      matchers_.add_matcher(matcher), filter, suffix
+    };
     string_filter_rules_.push_back(rule);
   }
 
@@ -192,7 +224,9 @@ class datum_to_fv_converter_impl {
       jubatus::util::lang::shared_ptr<key_matcher> matcher,
       jubatus::util::lang::shared_ptr<num_filter> filter,
       const std::string& suffix) {
-    num_filter_rule rule = { matcher, filter, suffix };
+    num_filter_rule rule = {
+      matchers_.add_matcher(matcher), filter, suffix
+    };
     num_filter_rules_.push_back(rule);
   }
 
@@ -202,21 +236,25 @@ class datum_to_fv_converter_impl {
       jubatus::util::lang::shared_ptr<string_feature> splitter,
       const std::vector<splitter_weight_type>& weights) {
     string_rules_.push_back(
-        string_feature_rule(name, matcher, splitter, weights));
+        string_feature_rule(
+            name, matchers_.add_matcher(matcher), splitter, weights));
   }
 
   void register_num_rule(
       const std::string& name,
       jubatus::util::lang::shared_ptr<key_matcher> matcher,
       jubatus::util::lang::shared_ptr<num_feature> feature_func) {
-    num_rules_.push_back(num_feature_rule(name, matcher, feature_func));
+    num_rules_.push_back(
+        num_feature_rule(name, matchers_.add_matcher(matcher), feature_func));
   }
 
   void register_binary_rule(
       const std::string& name,
       jubatus::util::lang::shared_ptr<key_matcher> matcher,
       jubatus::util::lang::shared_ptr<binary_feature> feature_func) {
-    binary_rules_.push_back(binary_feature_rule(name, matcher, feature_func));
+    binary_rules_.push_back(
+        binary_feature_rule(
+            name, matchers_.add_matcher(matcher), feature_func));
   }
 
   void register_combination_rule(
@@ -349,11 +387,16 @@ class datum_to_fv_converter_impl {
       datum::sv_t& filtered_values) const {
     for (size_t i = 0; i < string_filter_rules_.size(); ++i) {
       datum::sv_t update;
-      string_filter_rules_[i].filter(string_values, update);
-      string_filter_rules_[i].filter(filtered_values, update);
-
-      filtered_values.insert(filtered_values.end(), update.begin(),
-                             update.end());
+      string_filter_rules_[i].filter(matchers_, string_values, update);
+      string_filter_rules_[i].filter(matchers_, filtered_values, update);
+
+      // move filtered texts, which may be large, instead of copying them
+      const size_t offset = filtered_values.size();
+      filtered_values.resize(offset + update.size());
+      for (size_t j = 0; j < update.size(); ++j) {
+        filtered_values[offset + j].first.swap(update[j].first);
+        filtered_values[offset + j].second.swap(update[j].second);
+      }
     }
   }
 
@@ -362,8 +405,8 @@ class datum_to_fv_converter_impl {
       datum::nv_t& filtered_values) const {
     for (size_t i = 0; i < num_filter_rules_.size(); ++i) {
       datum::nv_t update;
-      num_filter_rules_[i].filter(num_values, update);
-      num_filter_rules_[i].filter(filtered_values, update);
+      num_filter_rules_[i].filter(matchers_, num_values, update);
+      num_filter_rules_[i].filter(matchers_, filtered_values, update);
 
       filtered_values.insert(
           filtered_values.end(), update.begin(), update.end());
@@ -397,7 +440,11 @@ class datum_to_fv_converter_impl {
       count_words(splitter, key, value, counter);
       for (size_t i = 0; i < splitter.weights_.size(); ++i) {
         make_string_features(
-            key, splitter.name_, splitter.weights_[i], counter, ret_fv);
+            key,
+            splitter.feature_suffixes_[i],
+            splitter.weights_[i],
+            counter,
+            ret_fv);
       }
     }
   }
@@ -416,32 +463,13 @@ class datum_to_fv_converter_impl {
     for (size_t j = 0; j < binary_values.size(); ++j) {
       const std::string& key = binary_values[j].first;
       const std::string& value = binary_values[j].second;
-      if (feature.matcher_->match(key)) {
+      if (matchers_.match(feature.matcher_id_, key)) {
         check_key(key);
         feature.feature_func_->add_feature(key, value, ret_fv);
       }
     }
   }
 
-  static std::string make_feature(
-      const std::string& key,
-      const std::string& value,
-      const std::string& splitter,
-      const std::string& sample_weight,
-      const std::string& global_weight) {
-    check_key(key);
-    return key + "$" + value + "@" + splitter + "#" + sample_weight + "/" +
-        global_weight;
-  }
-
-  static std::string make_feature_key(
-      const std::string& key,
-      const std::string& value,
-      const std::string& splitter) {
-    check_key(key);
-    return key + "$" + value + "@" + splitter;
-  }
-
   static void check_key(const std::string& key) {
     if (key.find('$') != std::string::npos) {
       throw JUBATUS_EXCEPTION(
@@ -454,7 +482,7 @@ class datum_to_fv_converter_impl {
       const std::string& key,
       const std::string& value,
       counter<std::string>& counter) const {
-    if (splitter.matcher_->match(key)) {
+    if (matchers_.match(splitter.matcher_id_, key)) {
       std::vector<string_feature_element> elements;
       splitter.splitter_->extract(value, elements);
 
@@ -464,21 +492,15 @@ class datum_to_fv_converter_impl {
     }
   }
 
-  double get_sample_weight(
-      frequency_weight_type type,
-      double tf,
-      std::string& name) const {
+  static double get_sample_weight(frequency_weight_type type, double tf) {
     switch (type) {
       case FREQ_BINARY:
-        name = "bin";
         return 1.0;
 
       case TERM_FREQUENCY:
-        name = "tf";
         return tf;
 
       case LOG_TERM_FREQUENCY:
-        name = "log_tf";
         return std::log(1. + tf);
 
       default:
@@ -486,7 +508,20 @@ class datum_to_fv_converter_impl {
     }
   }
 
-  std::string get_global_weight_name(term_weight_type type) const {
+  static std::string get_sample_weight_name(frequency_weight_type type) {
+    switch (type) {
+      case FREQ_BINARY:
+        return "bin";
+      case TERM_FREQUENCY:
+        return "tf";
+      case LOG_TERM_FREQUENCY:
+        return "log_tf";
+      default:
+        return "";
+    }
+  }
+
+  static std::string get_global_weight_name(term_weight_type type) {
     switch (type) {
       case TERM_BINARY:
         return "bin";
@@ -503,24 +538,25 @@ class datum_to_fv_converter_impl {
 
   void make_string_features(
       const std::string& key,
-      const std::string& splitter_name,
+      const std::string& feature_suffix,
       const splitter_weight_type& weight_type,
       const counter<std::string>& count,
       common::sfv_t& ret_fv) const {
+    if (count.begin() == count.end()) {
+      return;
+    }
+    check_key(key);
     for (counter<std::string>::const_iterator it = count.begin();
          it != count.end(); ++it) {
-      std::string sample_weight_name;
-      double sample_weight = get_sample_weight(
-          weight_type.freq_weight_type_, it->second, sample_weight_name);
-
-      std::string global_weight_name = get_global_weight_name(
-          weight_type.term_weight_type_);
-      float v = static_cast<float>(sample_weight);
+      float v = static_cast<float>(
+          get_sample_weight(weight_type.freq_weight_type_, it->second));
       if (v != 0.0) {
-        std::string f = make_feature(
-            key, it->first, splitter_name, sample_weight_name,
-            global_weight_name);
-        ret_fv.push_back(std::make_pair(f, v));
+        // build "<KEY_NAME>$<VALUE><FEATURE_SUFFIX>" in place to avoid
+        // temporary strings for each token
+        ret_fv.push_back(std::make_pair(std::string(), v));
+        std::string& f = ret_fv.back().first;
+        f.reserve(key.size() + 1 + it->first.size() + feature_suffix.size());
+        f.append(key).append(1, '$').append(it->first).append(feature_suffix);
       }
     }
   }
@@ -537,7 +573,7 @@ class datum_to_fv_converter_impl {
                    common::sfv_t& ret_fv) const {
     for (size_t i = 0; i < num_rules_.size(); ++i) {
       const num_feature_rule& r = num_rules_[i];
-      if (r.matcher_->match(key)) {
+      if (matchers_.match(r.matcher_id_, key)) {
         check_key(key);
         std::string k = key + "@" + r.name_;
         r.feature_func_->add_feature(k, value, ret_fv);
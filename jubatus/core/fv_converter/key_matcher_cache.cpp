@@ -0,0 +1,99 @@
+// Jubatus: Online machine learning framework for distributed environment
+// Copyright (C) 2015 Preferred Networks and Nippon Telegraph and Telephone Corporation.
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License version 2.1 as published by the Free Software Foundation.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+
+#include "key_matcher_cache.hpp"
+
+#include <string>
+#include <utility>
+#include "exception.hpp"
+#include "key_matcher.hpp"
+
+using jubatus::util::concurrent::scoped_rlock;
+using jubatus::util::concurrent::scoped_wlock;
+
+namespace jubatus {
+namespace core {
+namespace fv_converter {
+
+key_matcher_cache::key_matcher_cache(size_t max_size)
+    : max_size_(max_size) {
+  if (max_size == 0) {
+    throw JUBATUS_EXCEPTION(
+        converter_exception("cache size must be a positive integer"));
+  }
+}
+
+key_matcher_cache::~key_matcher_cache() {
+}
+
+size_t key_matcher_cache::add_matcher(
+    jubatus::util::lang::shared_ptr<key_matcher> matcher) {
+  scoped_wlock lk(mutex_);
+  matchers_.push_back(matcher);
+  // cached bitsets do not know the new matcher
+  cache_.clear();
+  return matchers_.size() - 1;
+}
+
+bool key_matcher_cache::match(
+    size_t matcher_id,
+    const std::string& key) const {
+  {
+    scoped_rlock lk(mutex_);
+    cache_t::const_iterator it = cache_.find(key);
+    if (it != cache_.end()) {
+      return test(it->second, matcher_id);
+    }
+  }
+
+  match_bits bits;
+  evaluate(key, bits);
+  const bool result = test(bits, matcher_id);
+
+  scoped_wlock lk(mutex_);
+  if (cache_.size() >= max_size_) {
+    cache_.clear();
+  }
+  cache_[key].swap(bits);
+  return result;
+}
+
+void key_matcher_cache::clear() {
+  scoped_wlock lk(mutex_);
+  matchers_.clear();
+  cache_.clear();
+}
+
+size_t key_matcher_cache::size() const {
+  scoped_rlock lk(mutex_);
+  return cache_.size();
+}
+
+void key_matcher_cache::evaluate(
+    const std::string& key,
+    match_bits& bits) const {
+  bits.assign((matchers_.size() + 63) / 64, 0);
+  for (size_t i = 0; i < matchers_.size(); ++i) {
+    if (matchers_[i]->match(key)) {
+      bits[i / 64] |= static_cast<uint64_t>(1) << (i % 64);
+    }
+  }
+}
+
+}  // namespace fv_converter
+}  // namespace core
+}  // namespace jubatus
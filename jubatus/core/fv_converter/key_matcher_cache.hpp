@@ -0,0 +1,79 @@
+// Jubatus: Online machine learning framework for distributed environment
+// Copyright (C) 2015 Preferred Networks and Nippon Telegraph and Telephone Corporation.
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License version 2.1 as published by the Free Software Foundation.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+
+#ifndef JUBATUS_CORE_FV_CONVERTER_KEY_MATCHER_CACHE_HPP_
+#define JUBATUS_CORE_FV_CONVERTER_KEY_MATCHER_CACHE_HPP_
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "jubatus/util/concurrent/rwmutex.h"
+#include "jubatus/util/data/unordered_map.h"
+#include "jubatus/util/lang/shared_ptr.h"
+
+namespace jubatus {
+namespace core {
+namespace fv_converter {
+
+class key_matcher;
+
+// Memoizes the results of a set of key_matchers.
+// Each registered matcher gets an id; the first lookup of a key evaluates
+// all matchers at once and stores the results as a bitset, so subsequent
+// lookups of the same key cost one hash lookup and a bit test.
+// The cache is safe to be used from multiple threads.  When it reaches
+// max_size it is flushed, so the memory usage is bounded even if keys are
+// not stable.
+class key_matcher_cache {
+ public:
+  explicit key_matcher_cache(size_t max_size);
+  ~key_matcher_cache();
+
+  size_t add_matcher(jubatus::util::lang::shared_ptr<key_matcher> matcher);
+
+  bool match(size_t matcher_id, const std::string& key) const;
+
+  // Removes all matchers and cached results.
+  void clear();
+
+  size_t size() const;
+  size_t matcher_size() const {
+    return matchers_.size();
+  }
+
+ private:
+  typedef std::vector<uint64_t> match_bits;
+  typedef jubatus::util::data::unordered_map<std::string, match_bits>
+      cache_t;
+
+  static bool test(const match_bits& bits, size_t matcher_id) {
+    return (bits[matcher_id / 64] >> (matcher_id % 64)) & 1;
+  }
+
+  void evaluate(const std::string& key, match_bits& bits) const;
+
+  const size_t max_size_;
+  std::vector<jubatus::util::lang::shared_ptr<key_matcher> > matchers_;
+  mutable cache_t cache_;
+  mutable jubatus::util::concurrent::rw_mutex mutex_;
+};
+
+}  // namespace fv_converter
+}  // namespace core
+}  // namespace jubatus
+
+#endif  // JUBATUS_CORE_FV_CONVERTER_KEY_MATCHER_CACHE_HPP_
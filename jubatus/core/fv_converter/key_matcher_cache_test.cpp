@@ -0,0 +1,133 @@
+// Jubatus: Online machine learning framework for distributed environment
+// Copyright (C) 2015 Preferred Networks and Nippon Telegraph and Telephone Corporation.
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License version 2.1 as published by the Free Software Foundation.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+
+#include <string>
+#include <gtest/gtest.h>
+#include "jubatus/util/lang/shared_ptr.h"
+#include "exact_match.hpp"
+#include "exception.hpp"
+#include "key_matcher.hpp"
+#include "key_matcher_cache.hpp"
+#include "prefix_match.hpp"
+
+using jubatus::util::lang::shared_ptr;
+
+namespace jubatus {
+namespace core {
+namespace fv_converter {
+
+namespace {
+
+class counting_match : public key_matcher {
+ public:
+  explicit counting_match(const std::string& key)
+      : key_(key),
+        count_(0) {
+  }
+
+  bool match(const std::string& key) {
+    ++count_;
+    return key == key_;
+  }
+
+  int count() const {
+    return count_;
+  }
+
+ private:
+  const std::string key_;
+  int count_;
+};
+
+}  // namespace
+
+TEST(key_matcher_cache, match) {
+  key_matcher_cache cache(10);
+  size_t a = cache.add_matcher(
+      shared_ptr<key_matcher>(new exact_match("a")));
+  size_t p = cache.add_matcher(
+      shared_ptr<key_matcher>(new prefix_match("a")));
+  EXPECT_EQ(2u, cache.matcher_size());
+
+  EXPECT_TRUE(cache.match(a, "a"));
+  EXPECT_TRUE(cache.match(p, "a"));
+  EXPECT_FALSE(cache.match(a, "ab"));
+  EXPECT_TRUE(cache.match(p, "ab"));
+  EXPECT_FALSE(cache.match(a, "b"));
+  EXPECT_FALSE(cache.match(p, "b"));
+  EXPECT_EQ(3u, cache.size());
+}
+
+TEST(key_matcher_cache, evaluate_once) {
+  key_matcher_cache cache(10);
+  shared_ptr<counting_match> m1(new counting_match("a"));
+  shared_ptr<counting_match> m2(new counting_match("b"));
+  size_t id1 = cache.add_matcher(m1);
+  size_t id2 = cache.add_matcher(m2);
+
+  for (int i = 0; i < 5; ++i) {
+    EXPECT_TRUE(cache.match(id1, "a"));
+    EXPECT_FALSE(cache.match(id2, "a"));
+  }
+  EXPECT_EQ(1, m1->count());
+  EXPECT_EQ(1, m2->count());
+}
+
+TEST(key_matcher_cache, many_matchers) {
+  key_matcher_cache cache(10);
+  std::vector<size_t> ids;
+  for (int i = 0; i < 100; ++i) {
+    ids.push_back(cache.add_matcher(
+        shared_ptr<key_matcher>(new exact_match(i == 70 ? "x" : "y"))));
+  }
+  for (size_t i = 0; i < ids.size(); ++i) {
+    EXPECT_EQ(i == 70, cache.match(ids[i], "x"));
+  }
+}
+
+TEST(key_matcher_cache, bounded) {
+  key_matcher_cache cache(3);
+  size_t id = cache.add_matcher(
+      shared_ptr<key_matcher>(new prefix_match("k")));
+  for (int i = 0; i < 10; ++i) {
+    EXPECT_TRUE(cache.match(id, std::string(i + 1, 'k')));
+    EXPECT_GE(3u, cache.size());
+  }
+}
+
+TEST(key_matcher_cache, clear) {
+  key_matcher_cache cache(10);
+  cache.add_matcher(shared_ptr<key_matcher>(new exact_match("a")));
+  cache.match(0, "a");
+  cache.clear();
+  EXPECT_EQ(0u, cache.size());
+  EXPECT_EQ(0u, cache.matcher_size());
+
+  size_t id = cache.add_matcher(
+      shared_ptr<key_matcher>(new exact_match("b")));
+  EXPECT_EQ(0u, id);
+  EXPECT_FALSE(cache.match(id, "a"));
+  EXPECT_TRUE(cache.match(id, "b"));
+}
+
+TEST(key_matcher_cache, zero_size) {
+  EXPECT_THROW(key_matcher_cache(0), converter_exception);
+}
+
+}  // namespace fv_converter
+}  // namespace core
+}  // namespace jubatus
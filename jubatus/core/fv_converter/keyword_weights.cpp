@@ -14,6 +14,7 @@
 // License along with this library; if not, write to the Free Software
 // Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 
+#include <algorithm>
 #include <cmath>
 #include <string>
 #include <sstream>
@@ -81,6 +82,12 @@ void keyword_weights::clear() {
   weight_t().swap(weights_);
 }
 
+void keyword_weights::swap(keyword_weights& w) {
+  std::swap(document_count_, w.document_count_);
+  document_frequencies_.swap(w.document_frequencies_);
+  weights_.swap(w.weights_);
+}
+
 string keyword_weights::to_string() const {
   stringstream ss;
   ss << "document_count: " << document_count_
@@ -17,6 +17,7 @@
 #ifndef JUBATUS_CORE_FV_CONVERTER_KEYWORD_WEIGHTS_HPP_
 #define JUBATUS_CORE_FV_CONVERTER_KEYWORD_WEIGHTS_HPP_
 
+#include <algorithm>
 #include <string>
 #include <msgpack.hpp>
 #include "jubatus/util/data/unordered_map.h"
@@ -50,6 +51,8 @@ class keyword_weights {
 
   void clear();
 
+  void swap(keyword_weights& w);
+
   MSGPACK_DEFINE(document_count_, document_frequencies_, weights_);
 
   std::string to_string() const;
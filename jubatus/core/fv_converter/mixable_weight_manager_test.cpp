@@ -189,6 +189,37 @@ TEST_F(mixable_weight_manager_test, put_diff) {
   ASSERT_EQ(3, result[1].second);
 }
 
+TEST_F(mixable_weight_manager_test, freeze_diff) {
+  shared_ptr<weight_manager> m = mw->get_model();
+  shared_ptr<const versioned_weight_diff> frozen = m->freeze_diff();
+  ASSERT_EQ(1u, frozen->weights_.get_document_count());
+
+  // updates during MIX go to a new diff, and frozen ones are still counted
+  common::sfv_t fv;
+  fv.push_back(make_pair("a", 1));
+  m->update_weight(fv);
+  EXPECT_EQ(1u, frozen->weights_.get_document_count());
+  versioned_weight_diff got;
+  m->get_diff(got);
+  EXPECT_EQ(2u, got.weights_.get_document_count());
+  EXPECT_EQ(2u, got.weights_.get_document_frequency("a"));
+
+  // a failed MIX puts the frozen diff back
+  m->abort_diff();
+  m->get_diff(got);
+  EXPECT_EQ(2u, got.weights_.get_document_count());
+
+  // only the updates after freeze_diff() are left after MIX
+  frozen = m->freeze_diff();
+  m->update_weight(fv);
+  EXPECT_TRUE(m->put_diff(*frozen));
+  m->get_diff(got);
+  EXPECT_EQ(1u, got.version_.get_number());
+  EXPECT_EQ(1u, got.weights_.get_document_count());
+  EXPECT_EQ(1u, got.weights_.get_document_frequency("a"));
+  EXPECT_EQ(0u, got.weights_.get_document_frequency("b"));
+}
+
 }  // namespace fv_converter
 }  // namespace core
 }  // namespace jubatus
@@ -63,9 +63,10 @@ void iter_convert(
     }
 
     case msgpack::type::RAW: {
+      // copy the value from the zone only once, directly into the datum
       const msgpack::object_raw& raw = object.via.raw;
-      datum.string_values_.push_back(
-          std::make_pair(path, std::string(raw.ptr, raw.size)));
+      datum.string_values_.push_back(std::make_pair(path, std::string()));
+      datum.string_values_.back().second.assign(raw.ptr, raw.size);
       break;
     }
 
@@ -22,6 +22,8 @@
 #include "../common/type.hpp"
 #include "datum_to_fv_converter.hpp"
 
+using jubatus::util::lang::shared_ptr;
+
 namespace jubatus {
 namespace core {
 namespace fv_converter {
@@ -69,26 +71,29 @@ void weight_manager::update_weight(const common::sfv_t& fv) {
 }
 
 void weight_manager::get_weight(common::sfv_t& fv) const {
+  // document count is common to all features
+  const double doc_count = get_document_count();
   for (common::sfv_t::iterator it = fv.begin(); it != fv.end(); ++it) {
-    double global_weight = get_global_weight(it->first);
+    double global_weight = get_global_weight(it->first, doc_count);
     it->second = static_cast<float>(it->second * global_weight);
   }
   fv.erase(remove_if(fv.begin(), fv.end(), is_zero()), fv.end());
 }
 
-double weight_manager::get_global_weight(const std::string& key) const {
+double weight_manager::get_global_weight(
+    const std::string& key,
+    double doc_count) const {
   size_t p = key.find_last_of('/');
   if (p == std::string::npos) {
     return 1.0;
   }
-  std::string type = key.substr(p + 1);
-  if (type == "bin") {
+  // compare the type in place not to allocate a substring for each feature
+  if (key.compare(p + 1, std::string::npos, "bin") == 0) {
     return 1.0;
-  } else if (type == "idf") {
-    double doc_count = get_document_count();
+  } else if (key.compare(p + 1, std::string::npos, "idf") == 0) {
     double doc_freq = get_document_frequency(key);
     return std::log((doc_count + 1) / (doc_freq + 1));
-  } else if (type == "weight") {
+  } else if (key.compare(p + 1, std::string::npos, "weight") == 0) {
     p = key.find_last_of('#');
     if (p == std::string::npos) {
       return 0;
@@ -104,6 +109,63 @@ void weight_manager::add_weight(const std::string& key, float weight) {
   diff_weights_.add_weight(key, weight);
 }
 
+void weight_manager::get_diff(versioned_weight_diff& diff) const {
+  if (!mixing_diff_) {
+    diff = versioned_weight_diff(diff_weights_, version_);
+  } else {
+    keyword_weights weights;
+    get_merged_diff(weights);
+    diff = versioned_weight_diff(weights, version_);
+  }
+}
+
+bool weight_manager::put_diff(const versioned_weight_diff& diff) {
+  if (diff.version_ == version_) {
+    master_weights_.merge(diff.weights_);
+    if (mixing_diff_) {
+      // updates after freeze_diff() are left for the next MIX
+      mixing_diff_.reset();
+    } else {
+      diff_weights_.clear();
+    }
+    version_.increment();
+    return true;
+  } else {
+    abort_diff();
+    return false;
+  }
+}
+
+shared_ptr<const versioned_weight_diff> weight_manager::freeze_diff() {
+  shared_ptr<versioned_weight_diff> diff(new versioned_weight_diff);
+  if (mixing_diff_) {
+    // previous MIX did not finish; mix both of them
+    get_merged_diff(diff->weights_);
+    diff_weights_.clear();
+  } else {
+    diff->weights_.swap(diff_weights_);
+  }
+  diff->version_ = version_;
+  mixing_diff_ = diff;
+  return mixing_diff_;
+}
+
+void weight_manager::abort_diff() {
+  if (!mixing_diff_) {
+    return;
+  }
+  keyword_weights weights;
+  get_merged_diff(weights);
+  diff_weights_.swap(weights);
+  mixing_diff_.reset();
+}
+
+void weight_manager::get_merged_diff(keyword_weights& diff) const {
+  // newer user weights in |diff_weights_| take precedence
+  diff = mixing_diff_->weights_;
+  diff.merge(diff_weights_);
+}
+
 }  // namespace fv_converter
 }  // namespace core
 }  // namespace jubatus
@@ -23,6 +23,7 @@
 #include <string>
 #include <msgpack.hpp>
 #include "jubatus/util/data/unordered_map.h"
+#include "jubatus/util/lang/shared_ptr.h"
 #include "../framework/model.hpp"
 #include "../common/type.hpp"
 #include "../common/version.hpp"
@@ -56,20 +57,12 @@ class weight_manager : public framework::model {
 
   void add_weight(const std::string& key, float weight);
 
-  void get_diff(versioned_weight_diff& diff) const {
-    diff = versioned_weight_diff(diff_weights_, version_);
-  }
+  void get_diff(versioned_weight_diff& diff) const;
+  bool put_diff(const versioned_weight_diff& diff);
 
-  bool put_diff(const versioned_weight_diff& diff) {
-    if (diff.version_ == version_) {
-      master_weights_.merge(diff.weights_);
-      diff_weights_.clear();
-      version_.increment();
-      return true;
-    } else {
-      return false;
-    }
-  }
+  // see framework::linear_mixable::freeze_diff
+  jubatus::util::lang::shared_ptr<const versioned_weight_diff> freeze_diff();
+  void abort_diff();
 
   void mix(
       const versioned_weight_diff& lhs,
@@ -84,13 +77,30 @@ class weight_manager : public framework::model {
   void clear() {
     diff_weights_.clear();
     master_weights_.clear();
+    mixing_diff_.reset();
   }
 
   storage::version get_version() const {
     return version_;
   }
 
-  MSGPACK_DEFINE(version_, diff_weights_, master_weights_);
+  template<class Packer>
+  void msgpack_pack(Packer& packer) const {
+    if (!mixing_diff_) {
+      msgpack::type::make_define(version_, diff_weights_, master_weights_)
+          .msgpack_pack(packer);
+    } else {
+      keyword_weights diff;
+      get_merged_diff(diff);
+      msgpack::type::make_define(version_, diff, master_weights_)
+          .msgpack_pack(packer);
+    }
+  }
+  void msgpack_unpack(msgpack::object o) {
+    msgpack::type::make_define(version_, diff_weights_, master_weights_)
+        .msgpack_unpack(o);
+    mixing_diff_.reset();
+  }
 
   void pack(framework::packer& pk) const {
     pk.pack(*this);
@@ -109,25 +119,33 @@ class weight_manager : public framework::model {
   }
 
  private:
+  void get_merged_diff(keyword_weights& diff) const;
+
   uint64_t get_document_count() const {
     return diff_weights_.get_document_count() +
+        (mixing_diff_ ? mixing_diff_->weights_.get_document_count() : 0) +
         master_weights_.get_document_count();
   }
 
   size_t get_document_frequency(const std::string& key) const {
     return diff_weights_.get_document_frequency(key) +
+        (mixing_diff_ ?
+         mixing_diff_->weights_.get_document_frequency(key) : 0) +
         master_weights_.get_document_frequency(key);
   }
 
   double get_user_weight(const std::string& key) const {
     return diff_weights_.get_user_weight(key) +
+        (mixing_diff_ ? mixing_diff_->weights_.get_user_weight(key) : 0) +
         master_weights_.get_user_weight(key);
   }
 
-  double get_global_weight(const std::string& key) const;
+  double get_global_weight(const std::string& key, double doc_count) const;
 
   storage::version version_;
   keyword_weights diff_weights_;
+  // diff being mixed; weights are master + mixing diff + diff
+  jubatus::util::lang::shared_ptr<const versioned_weight_diff> mixing_diff_;
   keyword_weights master_weights_;
 };
 
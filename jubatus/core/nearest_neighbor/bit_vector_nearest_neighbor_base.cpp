@@ -65,26 +65,26 @@ void bit_vector_nearest_neighbor_base::set_row(
   get_table()->add(id, owner(my_id_), hash(sfv));
 }
 
-void bit_vector_nearest_neighbor_base::neighbor_row(
+void bit_vector_nearest_neighbor_base::neighbor_row_index(
     const common::sfv_t& query,
-    vector<pair<string, float> >& ids,
+    vector<pair<uint64_t, float> >& rows,
     uint64_t ret_num) const {
-  neighbor_row_from_hash(hash(query), ids, ret_num);
+  neighbor_row_from_hash(hash(query), rows, ret_num);
 }
 
-void bit_vector_nearest_neighbor_base::neighbor_row(
+void bit_vector_nearest_neighbor_base::neighbor_row_index(
     const string& query_id,
-    vector<pair<string, float> >& ids,
+    vector<pair<uint64_t, float> >& rows,
     uint64_t ret_num) const {
   const table::column_table& table = *get_const_table();
   const pair<bool, uint64_t> maybe_index = table.exact_match(query_id);
   if (!maybe_index.first) {
-    ids.clear();
+    rows.clear();
     return;
   }
 
   const_bit_vector_column& col = bit_vector_column();
-  neighbor_row_from_hash(col[maybe_index.second], ids, ret_num);
+  neighbor_row_from_hash(col[maybe_index.second], rows, ret_num);
 }
 
 void bit_vector_nearest_neighbor_base::fill_schema(
@@ -100,16 +100,9 @@ const_bit_vector_column& bit_vector_nearest_neighbor_base::bit_vector_column()
 
 void bit_vector_nearest_neighbor_base::neighbor_row_from_hash(
     const bit_vector& query,
-    vector<pair<string, float> >& ids,
+    vector<pair<uint64_t, float> >& rows,
     uint64_t ret_num) const {
-  vector<pair<uint64_t, float> > scores;
-  ranking_hamming_bit_vectors(query, bit_vector_column(), scores, ret_num);
-
-  jubatus::util::lang::shared_ptr<const column_table> table = get_const_table();
-  ids.clear();
-  for (size_t i = 0; i < scores.size(); ++i) {
-    ids.push_back(make_pair(table->get_key(scores[i].first), scores[i].second));
-  }
+  ranking_hamming_bit_vectors(query, bit_vector_column(), rows, ret_num);
 }
 
 }  // namespace nearest_neighbor
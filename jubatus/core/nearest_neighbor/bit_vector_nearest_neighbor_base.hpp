@@ -43,26 +43,29 @@ class bit_vector_nearest_neighbor_base : public nearest_neighbor_base {
   uint32_t bitnum() const { return bitnum_; }
 
   virtual void set_row(const std::string& id, const common::sfv_t& sfv);
-  virtual void neighbor_row(
+  virtual void neighbor_row_index(
       const common::sfv_t& query,
-      std::vector<std::pair<std::string, float> >& ids,
+      std::vector<std::pair<uint64_t, float> >& rows,
       uint64_t ret_num) const;
-  virtual void neighbor_row(
+  virtual void neighbor_row_index(
       const std::string& query_id,
-      std::vector<std::pair<std::string, float> >& ids,
+      std::vector<std::pair<uint64_t, float> >& rows,
       uint64_t ret_num) const;
 
- private:
-  virtual table::bit_vector hash(const common::sfv_t& sfv) const = 0;
-
-  void fill_schema(std::vector<table::column_type>& schema);
+ protected:
   table::const_bit_vector_column& bit_vector_column() const;
 
-  void neighbor_row_from_hash(
+  // Scans all rows by default.
+  virtual void neighbor_row_from_hash(
       const table::bit_vector& query,
-      std::vector<std::pair<std::string, float> >& ids,
+      std::vector<std::pair<uint64_t, float> >& rows,
       uint64_t ret_num) const;
 
+ private:
+  virtual table::bit_vector hash(const common::sfv_t& sfv) const = 0;
+
+  void fill_schema(std::vector<table::column_type>& schema);
+
   uint64_t bit_vector_column_id_;
   uint32_t bitnum_;
 };
@@ -85,31 +85,31 @@ void euclid_lsh::set_row(const string& id, const common::sfv_t& sfv) {
   get_table()->add(id, owner(my_id_), cosine_lsh(sfv, hash_num_), l2norm(sfv));
 }
 
-void euclid_lsh::neighbor_row(
+void euclid_lsh::neighbor_row_index(
     const common::sfv_t& query,
-    vector<pair<string, float> >& ids,
+    vector<pair<uint64_t, float> >& rows,
     uint64_t ret_num) const {
   neighbor_row_from_hash(
       cosine_lsh(query, hash_num_),
       l2norm(query),
-      ids,
+      rows,
       ret_num);
 }
 
-void euclid_lsh::neighbor_row(
+void euclid_lsh::neighbor_row_index(
     const std::string& query_id,
-    vector<pair<string, float> >& ids,
+    vector<pair<uint64_t, float> >& rows,
     uint64_t ret_num) const {
   const pair<bool, uint64_t> maybe_index =
       get_const_table()->exact_match(query_id);
   if (!maybe_index.first) {
-    ids.clear();
+    rows.clear();
     return;
   }
 
   const bit_vector bv = lsh_column()[maybe_index.second];
   const float norm = norm_column()[maybe_index.second];
-  neighbor_row_from_hash(bv, norm, ids, ret_num);
+  neighbor_row_from_hash(bv, norm, rows, ret_num);
 }
 
 void euclid_lsh::set_config(const config& conf) {
@@ -138,7 +138,7 @@ const_float_column& euclid_lsh::norm_column() const {
 void euclid_lsh::neighbor_row_from_hash(
     const bit_vector& bv,
     float norm,
-    vector<pair<string, float> >& ids,
+    vector<pair<uint64_t, float> >& rows,
     uint64_t ret_num) const {
   jubatus::util::lang::shared_ptr<const column_table> table = get_const_table();
 
@@ -160,11 +160,12 @@ void euclid_lsh::neighbor_row_from_hash(
   vector<pair<float, size_t> > sorted;
   heap.get_sorted(sorted);
 
-  ids.clear();
+  rows.clear();
+  rows.reserve(sorted.size());
   const float squared_norm = norm * norm;
   for (size_t i = 0; i < sorted.size(); ++i) {
-    ids.push_back(make_pair(table->get_key(sorted[i].second),
-                            std::sqrt(squared_norm + sorted[i].first)));
+    rows.push_back(make_pair(sorted[i].second,
+                             std::sqrt(squared_norm + sorted[i].first)));
   }
 }
 
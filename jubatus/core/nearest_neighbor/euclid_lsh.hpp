@@ -60,13 +60,13 @@ class euclid_lsh : public nearest_neighbor_base {
   }
 
   virtual void set_row(const std::string& id, const common::sfv_t& sfv);
-  virtual void neighbor_row(
+  virtual void neighbor_row_index(
       const common::sfv_t& query,
-      std::vector<std::pair<std::string, float> >& ids,
+      std::vector<std::pair<uint64_t, float> >& rows,
       uint64_t ret_num) const;
-  virtual void neighbor_row(
+  virtual void neighbor_row_index(
       const std::string& query,
-      std::vector<std::pair<std::string, float> >& ids,
+      std::vector<std::pair<uint64_t, float> >& rows,
       uint64_t ret_num) const;
 
   virtual float calc_similarity(float distance) const {
@@ -82,7 +82,7 @@ class euclid_lsh : public nearest_neighbor_base {
   void neighbor_row_from_hash(
       const table::bit_vector& bv,
       float norm,
-      std::vector<std::pair<std::string, float> >& ids,
+      std::vector<std::pair<uint64_t, float> >& rows,
       uint64_t ret_num) const;
 
   uint64_t first_column_id_;
@@ -0,0 +1,369 @@
+// Jubatus: Online machine learning framework for distributed environment
+// Copyright (C) 2015 Preferred Networks and Nippon Telegraph and Telephone Corporation.
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License version 2.1 as published by the Free Software Foundation.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+
+#include "hnsw.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <queue>
+#include <string>
+#include <utility>
+#include <vector>
+#include "jubatus/util/data/unordered_set.h"
+#include "jubatus/util/lang/bind.h"
+#include "../common/exception.hpp"
+#include "lsh_function.hpp"
+
+using std::make_pair;
+using std::pair;
+using std::string;
+using std::vector;
+using jubatus::util::lang::shared_ptr;
+using jubatus::core::table::bit_vector;
+using jubatus::core::table::column_table;
+
+namespace jubatus {
+namespace core {
+namespace nearest_neighbor {
+
+namespace {
+
+const int MAX_LEVEL = 32;
+
+}  // namespace
+
+hnsw::hnsw(
+    const config& conf,
+    shared_ptr<column_table> table,
+    const std::string& id)
+    : bit_vector_nearest_neighbor_base(conf.hash_num, table, id),
+      rand_(0) {
+  init(conf);
+}
+
+hnsw::hnsw(
+    const config& conf,
+    shared_ptr<column_table> table,
+    vector<table::column_type>& schema,
+    const std::string& id)
+    : bit_vector_nearest_neighbor_base(conf.hash_num, table, schema, id),
+      rand_(0) {
+  init(conf);
+}
+
+void hnsw::init(const config& conf) {
+  if (!(1 <= conf.hash_num)) {
+    throw JUBATUS_EXCEPTION(
+        common::invalid_parameter("1 <= hash_num"));
+  }
+  if (conf.m && !(2 <= *conf.m)) {
+    throw JUBATUS_EXCEPTION(
+        common::invalid_parameter("2 <= m"));
+  }
+  if (conf.ef_construction && !(1 <= *conf.ef_construction)) {
+    throw JUBATUS_EXCEPTION(
+        common::invalid_parameter("1 <= ef_construction"));
+  }
+  if (conf.ef_search && !(1 <= *conf.ef_search)) {
+    throw JUBATUS_EXCEPTION(
+        common::invalid_parameter("1 <= ef_search"));
+  }
+
+  m_ = conf.m ? *conf.m : 16;
+  ef_construction_ = conf.ef_construction ? *conf.ef_construction : 100;
+  ef_search_ = conf.ef_search ? *conf.ef_search : 64;
+  level_factor_ = 1.0 / std::log(static_cast<double>(m_));
+  blocks_ = bit_vector::memory_size(bitnum()) / sizeof(uint64_t);
+  clear_graph();
+
+  set_row_callback(
+      jubatus::util::lang::bind(
+          &hnsw::sync_row, this, jubatus::util::lang::_1));
+}
+
+void hnsw::set_row(const string& id, const common::sfv_t& sfv) {
+  bit_vector_nearest_neighbor_base::set_row(id, sfv);
+  sync_row(id);
+}
+
+void hnsw::clear() {
+  bit_vector_nearest_neighbor_base::clear();
+  clear_graph();
+}
+
+void hnsw::unpack(msgpack::object o) {
+  bit_vector_nearest_neighbor_base::unpack(o);
+  rebuild();
+}
+
+bit_vector hnsw::hash(const common::sfv_t& sfv) const {
+  return cosine_lsh(sfv, bitnum());
+}
+
+void hnsw::neighbor_row_from_hash(
+    const bit_vector& query,
+    vector<pair<uint64_t, float> >& rows,
+    uint64_t ret_num) const {
+  rows.clear();
+  if (nodes_.empty() || ret_num == 0) {
+    return;
+  }
+
+  vector<uint64_t> q(blocks_);
+  copy_hash(query, &q[0]);
+  const uint32_t entry = greedy_search(&q[0], entry_point_, max_level_, 1);
+  vector<candidate> found;
+  search_layer(&q[0], entry, std::max<size_t>(ef_search_, ret_num), 0, found);
+
+  shared_ptr<const column_table> table = get_const_table();
+  const float denom = query.bit_num();
+  for (size_t i = 0; i < found.size() && rows.size() < ret_num; ++i) {
+    const node& n = nodes_[found[i].second];
+    if (n.removed) {
+      continue;
+    }
+    // rows deleted from the table are skipped here
+    const pair<bool, uint64_t> hit = table->exact_match(n.key);
+    if (hit.first) {
+      rows.push_back(make_pair(hit.second, found[i].first / denom));
+    }
+  }
+}
+
+void hnsw::sync_row(const string& key) {
+  shared_ptr<const column_table> table = get_const_table();
+  const pair<bool, uint64_t> hit = table->exact_match(key);
+  if (!hit.first) {
+    return;
+  }
+  const bit_vector hash = bit_vector_column()[hit.second];
+
+  jubatus::util::data::unordered_map<string, uint32_t>::const_iterator it =
+      node_ids_.find(key);
+  if (it != node_ids_.end()) {
+    vector<uint64_t> h(blocks_);
+    copy_hash(hash, &h[0]);
+    if (std::equal(h.begin(), h.end(), hash_of(it->second))) {
+      return;
+    }
+    nodes_[it->second].removed = true;
+  }
+
+  if (nodes_.size() >= 2 * table->size() + MAX_LEVEL) {
+    rebuild();
+  } else {
+    insert(key, hash);
+  }
+}
+
+void hnsw::insert(const string& key, const bit_vector& hash) {
+  const uint32_t id = nodes_.size();
+  const int level = random_level();
+  nodes_.push_back(node());
+  nodes_.back().key = key;
+  nodes_.back().links.resize(level + 1);
+  nodes_.back().removed = false;
+  hashes_.resize(hashes_.size() + blocks_);
+  copy_hash(hash, &hashes_[id * blocks_]);
+  node_ids_[key] = id;
+
+  if (id == 0) {
+    entry_point_ = id;
+    max_level_ = level;
+    return;
+  }
+
+  const uint64_t* query = hash_of(id);
+  uint32_t entry = greedy_search(query, entry_point_, max_level_, level + 1);
+  vector<candidate> found;
+  for (int l = std::min(level, max_level_); l >= 0; --l) {
+    search_layer(query, entry, ef_construction_, l, found);
+    select_neighbors(found, m_, nodes_[id].links[l]);
+    const vector<uint32_t>& links = nodes_[id].links[l];
+    for (size_t i = 0; i < links.size(); ++i) {
+      add_link(links[i], id, l);
+    }
+    entry = found[0].second;
+  }
+
+  if (level > max_level_) {
+    entry_point_ = id;
+    max_level_ = level;
+  }
+}
+
+void hnsw::rebuild() {
+  clear_graph();
+  shared_ptr<const column_table> table = get_const_table();
+  const table::const_bit_vector_column& column = bit_vector_column();
+  for (uint64_t i = 0; i < table->size(); ++i) {
+    insert(table->get_key_ref(i), column[i]);
+  }
+}
+
+void hnsw::clear_graph() {
+  nodes_.clear();
+  hashes_.clear();
+  node_ids_.clear();
+  entry_point_ = 0;
+  max_level_ = 0;
+}
+
+int hnsw::random_level() {
+  const double level = -std::log(1.0 - rand_.next_double()) * level_factor_;
+  return std::min(static_cast<int>(level), MAX_LEVEL);
+}
+
+uint32_t hnsw::distance(const uint64_t* query, uint32_t n) const {
+  const uint64_t* h = hash_of(n);
+  uint32_t dist = 0;
+  for (size_t i = 0; i < blocks_; ++i) {
+    dist += table::detail::bitcount(query[i] ^ h[i]);
+  }
+  return dist;
+}
+
+void hnsw::copy_hash(const bit_vector& hash, uint64_t* out) const {
+  // bit_vector leaves its storage unallocated until a bit is set
+  const uint64_t* bits = hash.raw_data_unsafe();
+  if (bits == NULL) {
+    std::fill(out, out + blocks_, 0);
+  } else {
+    std::memcpy(out, bits, blocks_ * sizeof(uint64_t));
+  }
+}
+
+uint32_t hnsw::greedy_search(
+    const uint64_t* query,
+    uint32_t entry,
+    int from_level,
+    int to_level) const {
+  uint32_t current = entry;
+  uint32_t current_dist = distance(query, current);
+  for (int level = from_level; level >= to_level; --level) {
+    bool changed = true;
+    while (changed) {
+      changed = false;
+      const vector<uint32_t>& links = nodes_[current].links[level];
+      for (size_t i = 0; i < links.size(); ++i) {
+        const uint32_t dist = distance(query, links[i]);
+        if (dist < current_dist) {
+          current = links[i];
+          current_dist = dist;
+          changed = true;
+        }
+      }
+    }
+  }
+  return current;
+}
+
+void hnsw::search_layer(
+    const uint64_t* query,
+    uint32_t entry,
+    size_t ef,
+    int level,
+    vector<candidate>& result) const {
+  jubatus::util::data::unordered_set<uint32_t> visited;
+  std::priority_queue<candidate, vector<candidate>,
+      std::greater<candidate> > candidates;
+  std::priority_queue<candidate> nearest;
+
+  const candidate start(distance(query, entry), entry);
+  visited.insert(entry);
+  candidates.push(start);
+  nearest.push(start);
+
+  while (!candidates.empty()) {
+    const candidate c = candidates.top();
+    if (c.first > nearest.top().first) {
+      break;
+    }
+    candidates.pop();
+
+    const vector<uint32_t>& links = nodes_[c.second].links[level];
+    for (size_t i = 0; i < links.size(); ++i) {
+      if (!visited.insert(links[i]).second) {
+        continue;
+      }
+      const candidate e(distance(query, links[i]), links[i]);
+      if (nearest.size() < ef || e.first < nearest.top().first) {
+        candidates.push(e);
+        nearest.push(e);
+        if (nearest.size() > ef) {
+          nearest.pop();
+        }
+      }
+    }
+  }
+
+  result.resize(nearest.size());
+  for (size_t i = result.size(); i > 0; --i) {
+    result[i - 1] = nearest.top();
+    nearest.pop();
+  }
+}
+
+void hnsw::select_neighbors(
+    const vector<candidate>& candidates,
+    size_t max_links,
+    vector<uint32_t>& links) const {
+  vector<uint32_t> selected;
+  vector<uint32_t> pruned;
+  for (size_t i = 0;
+       i < candidates.size() && selected.size() < max_links; ++i) {
+    const uint64_t* h = hash_of(candidates[i].second);
+    bool diverse = true;
+    for (size_t j = 0; j < selected.size(); ++j) {
+      if (distance(h, selected[j]) < candidates[i].first) {
+        diverse = false;
+        break;
+      }
+    }
+    (diverse ? selected : pruned).push_back(candidates[i].second);
+  }
+
+  // keep pruned candidates rather than leaving slots empty
+  for (size_t i = 0; i < pruned.size() && selected.size() < max_links; ++i) {
+    selected.push_back(pruned[i]);
+  }
+  links.swap(selected);
+}
+
+void hnsw::add_link(uint32_t from, uint32_t to, int level) {
+  vector<uint32_t>& links = nodes_[from].links[level];
+  links.push_back(to);
+  const size_t max_links = level == 0 ? 2 * m_ : m_;
+  if (links.size() <= max_links) {
+    return;
+  }
+
+  const uint64_t* h = hash_of(from);
+  vector<candidate> candidates;
+  candidates.reserve(links.size());
+  for (size_t i = 0; i < links.size(); ++i) {
+    candidates.push_back(candidate(distance(h, links[i]), links[i]));
+  }
+  std::sort(candidates.begin(), candidates.end());
+  select_neighbors(candidates, max_links, links);
+}
+
+}  // namespace nearest_neighbor
+}  // namespace core
+}  // namespace jubatus
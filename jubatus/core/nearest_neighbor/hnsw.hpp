@@ -0,0 +1,157 @@
+// Jubatus: Online machine learning framework for distributed environment
+// Copyright (C) 2015 Preferred Networks and Nippon Telegraph and Telephone Corporation.
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License version 2.1 as published by the Free Software Foundation.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+
+#ifndef JUBATUS_CORE_NEAREST_NEIGHBOR_HNSW_HPP_
+#define JUBATUS_CORE_NEAREST_NEIGHBOR_HNSW_HPP_
+
+#include <stdint.h>
+#include <string>
+#include <utility>
+#include <vector>
+#include "jubatus/util/data/optional.h"
+#include "jubatus/util/data/serialization.h"
+#include "jubatus/util/data/unordered_map.h"
+#include "jubatus/util/lang/shared_ptr.h"
+#include "jubatus/util/math/random.h"
+#include "bit_vector_nearest_neighbor_base.hpp"
+
+namespace jubatus {
+namespace core {
+namespace nearest_neighbor {
+
+// Hierarchical navigable small world graph (Malkov and Yashunin) over the
+// cosine LSH hashes used by lsh.  Queries walk the graph instead of
+// scanning the table, and return the same distances as lsh.
+//
+// The table stays the model: rows put by MIX are linked into the graph as
+// they arrive, and the graph is rebuilt from the table on unpack().  Rows
+// deleted from the table (e.g. by an unlearner) are left in the graph to
+// route searches but never returned; the graph is rebuilt once such nodes
+// outnumber the rows.
+class hnsw : public bit_vector_nearest_neighbor_base {
+ public:
+  struct config {
+    config()
+        : hash_num(64u) {
+    }
+
+    int32_t hash_num;
+    // number of links of each node on upper levels (twice on the lowest)
+    jubatus::util::data::optional<int32_t> m;
+    // size of the candidate lists while inserting and querying
+    jubatus::util::data::optional<int32_t> ef_construction;
+    jubatus::util::data::optional<int32_t> ef_search;
+
+    template <typename Ar>
+    void serialize(Ar& ar) {
+      ar & JUBA_MEMBER(hash_num)
+          & JUBA_MEMBER(m)
+          & JUBA_MEMBER(ef_construction)
+          & JUBA_MEMBER(ef_search);
+    }
+  };
+
+  hnsw(const config& conf,
+       jubatus::util::lang::shared_ptr<table::column_table> table,
+       const std::string& id);
+  hnsw(const config& conf,
+       jubatus::util::lang::shared_ptr<table::column_table> table,
+       std::vector<table::column_type>& schema,
+       const std::string& id);
+
+  virtual std::string type() const {
+    return "hnsw";
+  }
+
+  virtual void set_row(const std::string& id, const common::sfv_t& sfv);
+  virtual void clear();
+  virtual void unpack(msgpack::object o);
+
+  // Number of nodes in the graph, including ones of deleted rows.
+  size_t graph_size() const {
+    return nodes_.size();
+  }
+
+ private:
+  struct node {
+    std::string key;
+    // links[level] for each level of the node
+    std::vector<std::vector<uint32_t> > links;
+    // replaced by a newer node of the same key
+    bool removed;
+  };
+  // (hamming distance, node)
+  typedef std::pair<uint32_t, uint32_t> candidate;
+
+  virtual table::bit_vector hash(const common::sfv_t& sfv) const;
+  virtual void neighbor_row_from_hash(
+      const table::bit_vector& query,
+      std::vector<std::pair<uint64_t, float> >& rows,
+      uint64_t ret_num) const;
+
+  void init(const config& conf);
+  void sync_row(const std::string& key);
+  void insert(const std::string& key, const table::bit_vector& hash);
+  void rebuild();
+  void clear_graph();
+
+  int random_level();
+  uint32_t distance(const uint64_t* query, uint32_t n) const;
+  const uint64_t* hash_of(uint32_t n) const {
+    return &hashes_[n * blocks_];
+  }
+  void copy_hash(const table::bit_vector& hash, uint64_t* out) const;
+
+  uint32_t greedy_search(
+      const uint64_t* query,
+      uint32_t entry,
+      int from_level,
+      int to_level) const;
+  // Returns up to ef nodes near the query on the level, nearest first.
+  void search_layer(
+      const uint64_t* query,
+      uint32_t entry,
+      size_t ef,
+      int level,
+      std::vector<candidate>& result) const;
+  // Chooses up to max_links of sorted candidates, preferring ones which are
+  // closer to the base node than to already chosen ones.
+  void select_neighbors(
+      const std::vector<candidate>& candidates,
+      size_t max_links,
+      std::vector<uint32_t>& links) const;
+  void add_link(uint32_t from, uint32_t to, int level);
+
+  size_t m_;
+  size_t ef_construction_;
+  size_t ef_search_;
+  double level_factor_;
+  size_t blocks_;
+
+  std::vector<node> nodes_;
+  std::vector<uint64_t> hashes_;
+  jubatus::util::data::unordered_map<std::string, uint32_t> node_ids_;
+  uint32_t entry_point_;
+  int max_level_;
+  jubatus::util::math::random::mtrand rand_;
+};
+
+}  // namespace nearest_neighbor
+}  // namespace core
+}  // namespace jubatus
+
+#endif  // JUBATUS_CORE_NEAREST_NEIGHBOR_HNSW_HPP_
@@ -0,0 +1,224 @@
+// Jubatus: Online machine learning framework for distributed environment
+// Copyright (C) 2015 Preferred Networks and Nippon Telegraph and Telephone Corporation.
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License version 2.1 as published by the Free Software Foundation.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+
+#include <string>
+#include <utility>
+#include <vector>
+#include <gtest/gtest.h>
+#include "jubatus/util/lang/cast.h"
+#include "jubatus/util/lang/shared_ptr.h"
+#include "jubatus/util/math/random.h"
+#include "../framework/stream_writer.hpp"
+#include "hnsw.hpp"
+#include "lsh.hpp"
+
+using std::make_pair;
+using std::pair;
+using std::string;
+using std::vector;
+using jubatus::util::lang::lexical_cast;
+using jubatus::util::lang::shared_ptr;
+using jubatus::core::table::column_table;
+
+namespace jubatus {
+namespace core {
+namespace nearest_neighbor {
+
+namespace {
+
+common::sfv_t random_sfv(jubatus::util::math::random::mtrand& rand) {
+  common::sfv_t sfv;
+  for (int i = 0; i < 10; ++i) {
+    sfv.push_back(make_pair(lexical_cast<string>(i), rand.next_gaussian()));
+  }
+  return sfv;
+}
+
+shared_ptr<hnsw> make_hnsw(const hnsw::config& conf = hnsw::config()) {
+  return shared_ptr<hnsw>(
+      new hnsw(conf, shared_ptr<column_table>(new column_table), "test"));
+}
+
+}  // namespace
+
+TEST(hnsw, recall) {
+  jubatus::util::math::random::mtrand rand(0);
+  lsh::config lsh_conf;
+  lsh_conf.hash_num = 64;
+  lsh exact(lsh_conf, shared_ptr<column_table>(new column_table), "test");
+  shared_ptr<hnsw> nn = make_hnsw();
+
+  for (int i = 0; i < 1000; ++i) {
+    const common::sfv_t sfv = random_sfv(rand);
+    exact.set_row(lexical_cast<string>(i), sfv);
+    nn->set_row(lexical_cast<string>(i), sfv);
+  }
+  EXPECT_EQ(1000u, nn->graph_size());
+
+  // ties make ids ambiguous, so count results within the exact k-th score
+  size_t found = 0;
+  size_t total = 0;
+  for (int i = 0; i < 20; ++i) {
+    const common::sfv_t query = random_sfv(rand);
+    vector<pair<string, float> > expect, actual;
+    exact.neighbor_row(query, expect, 10);
+    nn->neighbor_row(query, actual, 10);
+    ASSERT_EQ(10u, expect.size());
+    ASSERT_EQ(10u, actual.size());
+    for (size_t j = 0; j < actual.size(); ++j) {
+      if (actual[j].second <= expect.back().second) {
+        ++found;
+      }
+    }
+    total += expect.size();
+  }
+  EXPECT_LE(0.9 * total, found);
+}
+
+TEST(hnsw, deleted_rows_are_not_returned) {
+  jubatus::util::math::random::mtrand rand(0);
+  shared_ptr<hnsw> nn = make_hnsw();
+  for (int i = 0; i < 100; ++i) {
+    nn->set_row(lexical_cast<string>(i), random_sfv(rand));
+  }
+  for (int i = 0; i < 80; ++i) {
+    nn->get_table()->delete_row(lexical_cast<string>(i));
+  }
+
+  vector<pair<string, float> > ids;
+  nn->neighbor_row(random_sfv(rand), ids, 10);
+  ASSERT_EQ(10u, ids.size());
+  for (size_t i = 0; i < ids.size(); ++i) {
+    EXPECT_LE(80, lexical_cast<int>(ids[i].first));
+  }
+
+  // stale nodes are dropped once they outnumber the rows
+  EXPECT_EQ(100u, nn->graph_size());
+  nn->set_row("100", random_sfv(rand));
+  EXPECT_EQ(21u, nn->graph_size());
+}
+
+TEST(hnsw, update_row) {
+  shared_ptr<hnsw> nn = make_hnsw();
+  common::sfv_t x, y;
+  x.push_back(make_pair("x", 1.0));
+  y.push_back(make_pair("y", 1.0));
+  nn->set_row("a", x);
+  nn->set_row("b", x);
+  nn->set_row("a", x);
+  EXPECT_EQ(2u, nn->graph_size());
+
+  nn->set_row("a", y);
+  vector<pair<string, float> > ids;
+  nn->neighbor_row(y, ids, 2);
+  ASSERT_EQ(2u, ids.size());
+  EXPECT_EQ("a", ids[0].first);
+  EXPECT_EQ(0.0f, ids[0].second);
+  EXPECT_EQ("b", ids[1].first);
+}
+
+TEST(hnsw, mix) {
+  jubatus::util::math::random::mtrand rand(0);
+  shared_ptr<hnsw> nn = make_hnsw();
+  shared_ptr<hnsw> other = make_hnsw();
+  for (int i = 0; i < 100; ++i) {
+    nn->set_row(lexical_cast<string>(i), random_sfv(rand));
+  }
+
+  framework::linear_mixable* mixable =
+      dynamic_cast<framework::linear_mixable*>(nn->get_mixable());
+  framework::linear_mixable* other_mixable =
+      dynamic_cast<framework::linear_mixable*>(other->get_mixable());
+  ASSERT_TRUE(mixable);
+  ASSERT_TRUE(other_mixable);
+
+  msgpack::sbuffer buf;
+  {
+    framework::stream_writer<msgpack::sbuffer> st(buf);
+    framework::jubatus_packer jp(st);
+    framework::packer pk(jp);
+    mixable->get_diff(pk);
+  }
+  msgpack::unpacked msg;
+  msgpack::unpack(&msg, buf.data(), buf.size());
+  other_mixable->put_diff(other_mixable->convert_diff_object(msg.get()));
+
+  // rows put by MIX are linked and can be found
+  EXPECT_EQ(100u, other->graph_size());
+  for (int i = 0; i < 100; ++i) {
+    vector<pair<string, float> > ids;
+    other->neighbor_row(lexical_cast<string>(i), ids, 1);
+    ASSERT_EQ(1u, ids.size());
+    EXPECT_EQ(0.0f, ids[0].second);
+  }
+}
+
+TEST(hnsw, unpack) {
+  jubatus::util::math::random::mtrand rand(0);
+  shared_ptr<hnsw> nn = make_hnsw();
+  for (int i = 0; i < 100; ++i) {
+    nn->set_row(lexical_cast<string>(i), random_sfv(rand));
+  }
+
+  msgpack::sbuffer buf;
+  {
+    framework::stream_writer<msgpack::sbuffer> st(buf);
+    framework::jubatus_packer jp(st);
+    framework::packer pk(jp);
+    nn->pack(pk);
+  }
+  shared_ptr<hnsw> other = make_hnsw();
+  msgpack::unpacked msg;
+  msgpack::unpack(&msg, buf.data(), buf.size());
+  other->unpack(msg.get());
+  EXPECT_EQ(100u, other->graph_size());
+
+  const common::sfv_t query = random_sfv(rand);
+  vector<pair<string, float> > expect, actual;
+  nn->neighbor_row(query, expect, 10);
+  other->neighbor_row(query, actual, 10);
+  ASSERT_EQ(10u, actual.size());
+  EXPECT_EQ(expect[0].second, actual[0].second);
+
+  other->clear();
+  EXPECT_EQ(0u, other->graph_size());
+  other->neighbor_row(query, actual, 10);
+  EXPECT_TRUE(actual.empty());
+}
+
+TEST(hnsw, config_validation) {
+  hnsw::config conf;
+
+  conf.m = 1;
+  EXPECT_THROW(make_hnsw(conf), common::invalid_parameter);
+  conf.m = 2;
+  EXPECT_NO_THROW(make_hnsw(conf));
+
+  conf.ef_construction = 0;
+  EXPECT_THROW(make_hnsw(conf), common::invalid_parameter);
+  conf.ef_construction = 1;
+  EXPECT_NO_THROW(make_hnsw(conf));
+
+  conf.ef_search = 0;
+  EXPECT_THROW(make_hnsw(conf), common::invalid_parameter);
+  conf.ef_search = 1;
+  EXPECT_NO_THROW(make_hnsw(conf));
+}
+
+}  // namespace nearest_neighbor
+}  // namespace core
+}  // namespace jubatus
@@ -18,6 +18,7 @@
 #define JUBATUS_CORE_NEAREST_NEIGHBOR_NEAREST_NEIGHBOR_HPP_
 
 #include "euclid_lsh.hpp"
+#include "hnsw.hpp"
 #include "lsh.hpp"
 #include "minhash.hpp"
 
@@ -52,6 +52,24 @@ void nearest_neighbor_base::clear() {
   mixable_table_->get_model()->clear();
 }
 
+void nearest_neighbor_base::neighbor_row(
+    const common::sfv_t& query,
+    vector<pair<string, float> >& ids,
+    uint64_t ret_num) const {
+  vector<pair<uint64_t, float> > rows;
+  neighbor_row_index(query, rows, ret_num);
+  get_keys(rows, ids);
+}
+
+void nearest_neighbor_base::neighbor_row(
+    const string& query_id,
+    vector<pair<string, float> >& ids,
+    uint64_t ret_num) const {
+  vector<pair<uint64_t, float> > rows;
+  neighbor_row_index(query_id, rows, ret_num);
+  get_keys(rows, ids);
+}
+
 void nearest_neighbor_base::similar_row(
     const common::sfv_t& query,
     vector<pair<string, float> >& ids,
@@ -84,6 +102,22 @@ framework::mixable* nearest_neighbor_base::get_mixable() const {
   return mixable_table_.get();
 }
 
+void nearest_neighbor_base::set_row_callback(
+    jubatus::util::lang::function<void(const string&)> callback) {
+  mixable_table_->set_row_callback(callback);
+}
+
+void nearest_neighbor_base::get_keys(
+    const vector<pair<uint64_t, float> >& rows,
+    vector<pair<string, float> >& ids) const {
+  shared_ptr<const table::column_table> table = get_const_table();
+  ids.resize(rows.size());
+  for (size_t i = 0; i < rows.size(); ++i) {
+    ids[i].first = table->get_key(rows[i].first);
+    ids[i].second = rows[i].second;
+  }
+}
+
 }  // namespace nearest_neighbor
 }  // namespcae core
 }  // namespace jubatus
@@ -22,6 +22,7 @@
 #include <string>
 #include <utility>
 #include <vector>
+#include "jubatus/util/lang/function.h"
 #include "jubatus/util/lang/shared_ptr.h"
 #include "../common/type.hpp"
 #include "../framework/mixable_versioned_table.hpp"
@@ -54,14 +55,27 @@ class nearest_neighbor_base {
   virtual void clear();
 
   virtual void set_row(const std::string& id, const common::sfv_t& sfv) = 0;
+
+  // Returns neighbors as pairs of a row index of get_const_table() and the
+  // distance, so that callers working on the table need not look keys up.
+  // Indexes are valid until the table is modified.
+  virtual void neighbor_row_index(
+      const common::sfv_t& query,
+      std::vector<std::pair<uint64_t, float> >& rows,
+      uint64_t ret_num) const = 0;
+  virtual void neighbor_row_index(
+      const std::string& query_id,
+      std::vector<std::pair<uint64_t, float> >& rows,
+      uint64_t ret_num) const = 0;
+
   virtual void neighbor_row(
       const common::sfv_t& query,
       std::vector<std::pair<std::string, float> >& ids,
-      uint64_t ret_num) const = 0;
+      uint64_t ret_num) const;
   virtual void neighbor_row(
       const std::string& query_id,
       std::vector<std::pair<std::string, float> >& ids,
-      uint64_t ret_num) const = 0;
+      uint64_t ret_num) const;
   virtual float calc_similarity(float distance) const {
     return 1 - distance;
   }
@@ -76,14 +90,22 @@ class nearest_neighbor_base {
       uint64_t ret_num) const;
 
   void pack(framework::packer& packer) const;
-  void unpack(msgpack::object o);
+  virtual void unpack(msgpack::object o);
 
   framework::mixable* get_mixable() const;
 
  protected:
+  // Called with the key of each row put into the table by MIX.
+  void set_row_callback(
+      jubatus::util::lang::function<void(const std::string&)> callback);
+
   std::string my_id_;
 
  private:
+  void get_keys(
+      const std::vector<std::pair<uint64_t, float> >& rows,
+      std::vector<std::pair<std::string, float> >& ids) const;
+
   jubatus::util::lang::shared_ptr<framework::mixable_versioned_table>
       mixable_table_;
 };
@@ -39,8 +39,8 @@ class nearest_neighbor_mock : public nearest_neighbor_base {
       jubatus::util::lang::shared_ptr<table::column_table> table)
       : nearest_neighbor_base(table, "test") {}
 
-  void add_next_answer(const string& id, float dist) {
-    answer_.push_back(make_pair(id, dist));
+  void add_next_answer(uint64_t row, float dist) {
+    answer_.push_back(make_pair(row, dist));
   }
 
   virtual string type() const {
@@ -49,34 +49,38 @@ class nearest_neighbor_mock : public nearest_neighbor_base {
 
   virtual void set_row(const string&, const common::sfv_t&) {}
 
-  virtual void neighbor_row(
+  virtual void neighbor_row_index(
       const common::sfv_t&,
-      vector<pair<string, float> >& ids,
+      vector<pair<uint64_t, float> >& rows,
       uint64_t ret_num) const {
-    ids = answer_;
-    if (ids.size() > ret_num) {
-      ids.resize(ret_num);
+    rows = answer_;
+    if (rows.size() > ret_num) {
+      rows.resize(ret_num);
     }
   }
 
-  virtual void neighbor_row(
+  virtual void neighbor_row_index(
       const string&,
-      vector<pair<string, float> >& ids,
+      vector<pair<uint64_t, float> >& rows,
       uint64_t ret_num) const {
-    ids = answer_;
-    if (ids.size() > ret_num) {
-      ids.resize(ret_num);
+    rows = answer_;
+    if (rows.size() > ret_num) {
+      rows.resize(ret_num);
     }
   }
 
  private:
-  vector<pair<string, float> > answer_;
+  vector<pair<uint64_t, float> > answer_;
 };
 
 class nearest_neighbor_base_test : public testing::Test {
  protected:
   virtual void SetUp() {
     ct_.reset(new table::column_table);
+    ct_->init(vector<table::column_type>(
+        1, table::column_type(table::column_type::float_type)));
+    ct_->add("a", table::owner("test"), 0.f);
+    ct_->add("b", table::owner("test"), 0.f);
     mock_.reset(new nearest_neighbor_mock(ct_));
   }
 
@@ -99,11 +103,11 @@ TEST_F(nearest_neighbor_base_test, order_of_calc_similarity) {
 }
 
 TEST_F(nearest_neighbor_base_test, similar_row) {
-  mock_->add_next_answer("a", 0);
-  mock_->add_next_answer("a", 0.25);
-  mock_->add_next_answer("a", 0.5);
-  mock_->add_next_answer("a", 0.75);
-  mock_->add_next_answer("a", 1);
+  mock_->add_next_answer(0, 0);
+  mock_->add_next_answer(0, 0.25);
+  mock_->add_next_answer(0, 0.5);
+  mock_->add_next_answer(0, 0.75);
+  mock_->add_next_answer(0, 1);
 
   vector<pair<string, float> > neighbors, similars;
   mock_->neighbor_row("", neighbors, 5);
@@ -116,6 +120,17 @@ TEST_F(nearest_neighbor_base_test, similar_row) {
   }
 }
 
+TEST_F(nearest_neighbor_base_test, neighbor_row_resolves_keys) {
+  mock_->add_next_answer(1, 0.5);
+  mock_->add_next_answer(0, 0.75);
+
+  vector<pair<string, float> > neighbors;
+  mock_->neighbor_row(common::sfv_t(), neighbors, 5);
+  ASSERT_EQ(2u, neighbors.size());
+  EXPECT_EQ(make_pair(string("b"), 0.5f), neighbors[0]);
+  EXPECT_EQ(make_pair(string("a"), 0.75f), neighbors[1]);
+}
+
 }  // namespace nearest_neighbor
 }  // namespace core
 }  // namespace jubatus
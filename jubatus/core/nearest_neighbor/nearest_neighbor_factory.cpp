@@ -48,6 +48,9 @@ shared_ptr<nearest_neighbor_base> create_nearest_neighbor(
   } else if (name == "minhash") {
     return shared_ptr<nearest_neighbor_base>(
         new minhash(config_cast_check<minhash::config>(config), table, id));
+  } else if (name == "hnsw") {
+    return shared_ptr<nearest_neighbor_base>(
+        new hnsw(config_cast_check<hnsw::config>(config), table, id));
   } else {
     throw JUBATUS_EXCEPTION(common::unsupported_method(name));
   }
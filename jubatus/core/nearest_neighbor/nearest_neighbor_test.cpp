@@ -149,6 +149,30 @@ TEST_P(nearest_neighbor_test, empty_neighbor_row) {
   EXPECT_TRUE(ids.empty());
 }
 
+TEST_P(nearest_neighbor_test, neighbor_row_index) {
+  nearest_neighbor_base* nn = get_nn();
+  for (int i = 0; i < 10; ++i) {
+    common::sfv_t v;
+    v.push_back(std::make_pair("x", i));
+    v.push_back(std::make_pair("y", 10 - i));
+    nn->set_row(jubatus::util::lang::lexical_cast<string>(i), v);
+  }
+
+  vector<std::pair<uint64_t, float> > rows;
+  nn->neighbor_row_index("3", rows, 4);
+  vector<std::pair<string, float> > ids;
+  nn->neighbor_row("3", ids, 4);
+  ASSERT_EQ(4u, rows.size());
+  ASSERT_EQ(rows.size(), ids.size());
+  for (size_t i = 0; i < rows.size(); ++i) {
+    EXPECT_EQ(ids[i].first, nn->get_const_table()->get_key(rows[i].first));
+    EXPECT_EQ(ids[i].second, rows[i].second);
+  }
+
+  nn->neighbor_row_index("unknown", rows, 4);
+  EXPECT_TRUE(rows.empty());
+}
+
 // TODO(beam2d): Write approximated test of neighbor_row().
 
 const map<string, string> configs[] = {
@@ -156,7 +180,8 @@ const map<string, string> configs[] = {
   make_config("nearest_neighbor:name", "minhash")("hash_num", "64")(),
   make_config(
       "nearest_neighbor:name", "euclid_lsh")(
-      "hash_num", "64")()
+      "hash_num", "64")(),
+  make_config("nearest_neighbor:name", "hnsw")("hash_num", "64")()
 };
 
 INSTANTIATE_TEST_CASE_P(
@@ -201,7 +226,8 @@ REGISTER_TYPED_TEST_CASE_P(
     nearest_neighbor_config_test, config_validation);
 
 typedef testing::Types<nearest_neighbor::lsh,
-  nearest_neighbor::minhash, nearest_neighbor::euclid_lsh> nn_types;
+  nearest_neighbor::minhash, nearest_neighbor::euclid_lsh,
+  nearest_neighbor::hnsw> nn_types;
 
 INSTANTIATE_TYPED_TEST_CASE_P(nn_config_test,
   nearest_neighbor_config_test, nn_types);
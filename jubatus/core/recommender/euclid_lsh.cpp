@@ -190,7 +190,8 @@ void euclid_lsh::similar_row(
 }
 
 void euclid_lsh::clear() {
-  orig_.clear();
+  orig_->clear();
+  clear_complete_row_cache();
   mixable_storage_->get_model()->clear();
 
   // Clear projection cache
@@ -199,15 +200,17 @@ void euclid_lsh::clear() {
 }
 
 void euclid_lsh::clear_row(const string& id) {
-  orig_.remove_row(id);
+  orig_->remove_row(id);
+  invalidate_complete_row_cache(id);
   mixable_storage_->get_model()->remove_row(id);
 }
 
 void euclid_lsh::update_row(const string& id, const sfv_diff_t& diff) {
   storage::lsh_index_storage& lsh_index = *mixable_storage_->get_model();
-  orig_.set_row(id, diff);
+  orig_->set_row(id, diff);
+  invalidate_complete_row_cache(id);
   common::sfv_t row;
-  orig_.get_row(id, row);
+  orig_->get_row(id, row);
 
   const vector<float> hash = lsh_function(
       row, lsh_index.all_lsh_num(), bin_width_);
@@ -264,7 +267,7 @@ void euclid_lsh::initialize_model() {
 
 void euclid_lsh::pack(framework::packer& packer) const {
   packer.pack_array(2);
-  orig_.pack(packer);
+  orig_->pack(packer);
   mixable_storage_->get_model()->pack(packer);
 }
 
@@ -272,7 +275,8 @@ void euclid_lsh::unpack(msgpack::object o) {
   if (o.type != msgpack::type::ARRAY || o.via.array.size != 2) {
     throw msgpack::type_error();
   }
-  orig_.unpack(o.via.array.ptr[0]);
+  orig_->unpack(o.via.array.ptr[0]);
+  clear_complete_row_cache();
   mixable_storage_->get_model()->unpack(o.via.array.ptr[1]);
 }
 
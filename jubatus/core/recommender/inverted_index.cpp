@@ -65,22 +65,25 @@ void inverted_index::neighbor_row(
 }
 
 void inverted_index::clear() {
-  orig_.clear();
+  orig_->clear();
+  clear_complete_row_cache();
   mixable_storage_->get_model()->clear();
 }
 
 void inverted_index::clear_row(const std::string& id) {
   vector<pair<string, float> > columns;
-  orig_.get_row(id, columns);
+  orig_->get_row(id, columns);
   storage::inverted_index_storage& inv = *mixable_storage_->get_model();
   for (size_t i = 0; i < columns.size(); ++i) {
     inv.remove(columns[i].first, id);
   }
-  orig_.remove_row(id);
+  orig_->remove_row(id);
+  invalidate_complete_row_cache(id);
 }
 
 void inverted_index::update_row(const std::string& id, const sfv_diff_t& diff) {
-  orig_.set_row(id, diff);
+  orig_->set_row(id, diff);
+  invalidate_complete_row_cache(id);
   storage::inverted_index_storage& inv = *mixable_storage_->get_model();
   for (size_t i = 0; i < diff.size(); ++i) {
     inv.set(diff[i].first, id, diff[i].second);
@@ -97,7 +100,7 @@ string inverted_index::type() const {
 
 void inverted_index::pack(framework::packer& packer) const {
   packer.pack_array(2);
-  orig_.pack(packer);
+  orig_->pack(packer);
   mixable_storage_->get_model()->pack(packer);
 }
 
@@ -105,7 +108,8 @@ void inverted_index::unpack(msgpack::object o) {
   if (o.type != msgpack::type::ARRAY || o.via.array.size != 2) {
     throw msgpack::type_error();
   }
-  orig_.unpack(o.via.array.ptr[0]);
+  orig_->unpack(o.via.array.ptr[0]);
+  clear_complete_row_cache();
   mixable_storage_->get_model()->unpack(o.via.array.ptr[1]);
 }
 
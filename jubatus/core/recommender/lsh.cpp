@@ -93,14 +93,16 @@ void lsh::neighbor_row(
 }
 
 void lsh::clear() {
-  orig_.clear();
+  orig_->clear();
+  clear_complete_row_cache();
   jubatus::util::data::unordered_map<std::string, std::vector<float> >()
     .swap(column2baseval_);
   mixable_storage_->get_model()->clear();
 }
 
 void lsh::clear_row(const string& id) {
-  orig_.remove_row(id);
+  orig_->remove_row(id);
+  invalidate_complete_row_cache(id);
   mixable_storage_->get_model()->remove_row(id);
 }
 
@@ -128,9 +130,10 @@ void lsh::generate_column_base(const string& column) {
 
 void lsh::update_row(const string& id, const sfv_diff_t& diff) {
   generate_column_bases(diff);
-  orig_.set_row(id, diff);
+  orig_->set_row(id, diff);
+  invalidate_complete_row_cache(id);
   common::sfv_t row;
-  orig_.get_row(id, row);
+  orig_->get_row(id, row);
   bit_vector bv;
   calc_lsh_values(row, bv);
   mixable_storage_->get_model()->set_row(id, bv);
@@ -157,7 +160,7 @@ void lsh::initialize_model() {
 
 void lsh::pack(framework::packer& packer) const {
   packer.pack_array(2);
-  orig_.pack(packer);
+  orig_->pack(packer);
   mixable_storage_->get_model()->pack(packer);
 }
 
@@ -165,7 +168,8 @@ void lsh::unpack(msgpack::object o) {
   if (o.type != msgpack::type::ARRAY || o.via.array.size != 2) {
     throw msgpack::type_error();
   }
-  orig_.unpack(o.via.array.ptr[0]);
+  orig_->unpack(o.via.array.ptr[0]);
+  clear_complete_row_cache();
   mixable_storage_->get_model()->unpack(o.via.array.ptr[1]);
 }
 
@@ -81,12 +81,14 @@ void minhash::neighbor_row(
 }
 
 void minhash::clear() {
-  orig_.clear();
+  orig_->clear();
+  clear_complete_row_cache();
   mixable_storage_->get_model()->clear();
 }
 
 void minhash::clear_row(const string& id) {
-  orig_.remove_row(id);
+  orig_->remove_row(id);
+  invalidate_complete_row_cache(id);
   mixable_storage_->get_model()->remove_row(id);
 }
 
@@ -115,10 +117,11 @@ void minhash::calc_minhash_values(const common::sfv_t& sfv,
 }
 
 void minhash::update_row(const string& id, const sfv_diff_t& diff) {
-  orig_.set_row(id, diff);
+  orig_->set_row(id, diff);
+  invalidate_complete_row_cache(id);
 
   common::sfv_t row;
-  orig_.get_row(id, row);
+  orig_->get_row(id, row);
   bit_vector bv;
   calc_minhash_values(row, bv);
   mixable_storage_->get_model()->set_row(id, bv);
@@ -191,7 +194,7 @@ void minhash::initialize_model() {
 
 void minhash::pack(framework::packer& packer) const {
   packer.pack_array(2);
-  orig_.pack(packer);
+  orig_->pack(packer);
   mixable_storage_->get_model()->pack(packer);
 }
 
@@ -199,7 +202,8 @@ void minhash::unpack(msgpack::object o) {
   if (o.type != msgpack::type::ARRAY || o.via.array.size != 2) {
     throw msgpack::type_error();
   }
-  orig_.unpack(o.via.array.ptr[0]);
+  orig_->unpack(o.via.array.ptr[0]);
+  clear_complete_row_cache();
   mixable_storage_->get_model()->unpack(o.via.array.ptr[1]);
 }
 
@@ -73,7 +73,8 @@ void nearest_neighbor_recommender::neighbor_row(
 }
 
 void nearest_neighbor_recommender::clear() {
-  orig_.clear();
+  orig_->clear();
+  clear_complete_row_cache();
   nearest_neighbor_engine_->clear();
   if (unlearner_) {
     unlearner_->clear();
@@ -81,7 +82,8 @@ void nearest_neighbor_recommender::clear() {
 }
 
 void nearest_neighbor_recommender::clear_row(const std::string& id) {
-  orig_.remove_row(id);
+  orig_->remove_row(id);
+  invalidate_complete_row_cache(id);
   get_table()->delete_row(id);
   if (unlearner_) {
     unlearner_->remove(id);
@@ -92,7 +94,8 @@ void nearest_neighbor_recommender::clear_row(const std::string& id) {
  * Callback from unlearner
  */
 void nearest_neighbor_recommender::unlearn_row(const std::string& id) {
-  orig_.remove_row(id);
+  orig_->remove_row(id);
+  invalidate_complete_row_cache(id);
   get_table()->delete_row(id);
 }
 
@@ -105,9 +108,10 @@ void nearest_neighbor_recommender::update_row(
           "no more space available to add new ID: " + id));
     }
   }
-  orig_.set_row(id, diff);
+  orig_->set_row(id, diff);
+  invalidate_complete_row_cache(id);
   common::sfv_t row;
-  orig_.get_row(id, row);
+  orig_->get_row(id, row);
   nearest_neighbor_engine_->set_row(id, row);
 }
 
@@ -126,7 +130,7 @@ framework::mixable* nearest_neighbor_recommender::get_mixable() const {
 
 void nearest_neighbor_recommender::pack(framework::packer& packer) const {
   packer.pack_array(2);
-  orig_.pack(packer);
+  orig_->pack(packer);
   nearest_neighbor_engine_->pack(packer);
 }
 
@@ -134,7 +138,8 @@ void nearest_neighbor_recommender::unpack(msgpack::object o) {
   if (o.type != msgpack::type::ARRAY || o.via.array.size != 2) {
     throw msgpack::type_error();
   }
-  orig_.unpack(o.via.array.ptr[0]);
+  orig_->unpack(o.via.array.ptr[0]);
+  clear_complete_row_cache();
   nearest_neighbor_engine_->unpack(o.via.array.ptr[1]);
 }
 
@@ -20,8 +20,9 @@
 #include <utility>
 #include <vector>
 #include "recommender_base.hpp"
-#include "../common/vector_util.hpp"
+#include "../storage/sparse_matrix_storage.hpp"
 
+using jubatus::util::concurrent::scoped_lock;
 using std::make_pair;
 using std::pair;
 using std::string;
@@ -34,7 +35,9 @@ namespace recommender {
 
 const uint64_t recommender_base::complete_row_similar_num_ = 128;
 
-recommender_base::recommender_base() {
+recommender_base::recommender_base()
+    : orig_(new core::storage::sparse_matrix_storage),
+      complete_row_cache_size_(0) {
 }
 
 recommender_base::~recommender_base() {
@@ -45,7 +48,7 @@ void recommender_base::similar_row(
     size_t ret_num) const {
   ids.clear();
   common::sfv_t sfv;
-  orig_.get_row(id, sfv);
+  orig_->get_row(id, sfv);
   similar_row(sfv, ids, ret_num);
 }
 
@@ -55,22 +58,55 @@ void recommender_base::neighbor_row(
     size_t ret_num) const {
   ids.clear();
   common::sfv_t sfv;
-  orig_.get_row(id, sfv);
+  orig_->get_row(id, sfv);
   neighbor_row(sfv, ids, ret_num);
 }
 
 void recommender_base::decode_row(const std::string& id,
                                   common::sfv_t& ret) const {
   ret.clear();
-  orig_.get_row(id, ret);
+  orig_->get_row(id, ret);
 }
 
 void recommender_base::complete_row(const std::string& id,
                                     common::sfv_t& ret) const {
   ret.clear();
+  if (complete_row_cache_size_ > 0) {
+    scoped_lock lk(completion_mutex_);
+    completion_cache_t::iterator it = completion_cache_.find(id);
+    if (it != completion_cache_.end()) {
+      completion_lru_.splice(
+          completion_lru_.begin(), completion_lru_, it->second.lru_pos);
+      ret = it->second.result;
+      return;
+    }
+  }
+
   common::sfv_t sfv;
-  orig_.get_row(id, sfv);
-  complete_row(sfv, ret);
+  orig_->get_row(id, sfv);
+  vector<pair<string, float> > ids;
+  similar_row(sfv, ids, complete_row_similar_num_);
+  aggregate_neighbors(ids, ret);
+  if (complete_row_cache_size_ == 0) {
+    return;
+  }
+
+  scoped_lock lk(completion_mutex_);
+  if (completion_cache_.count(id) != 0) {
+    return;
+  }
+  while (completion_cache_.size() >= complete_row_cache_size_) {
+    erase_completion(completion_cache_.find(completion_lru_.back()));
+  }
+  completion_lru_.push_front(id);
+  completion_entry& entry = completion_cache_[id];
+  entry.result = ret;
+  entry.lru_pos = completion_lru_.begin();
+  entry.neighbors.reserve(ids.size());
+  for (size_t i = 0; i < ids.size(); ++i) {
+    entry.neighbors.push_back(ids[i].first);
+    completion_dependents_[ids[i].first].insert(id);
+  }
 }
 
 void recommender_base::complete_row(const common::sfv_t& query,
@@ -78,33 +114,99 @@ void recommender_base::complete_row(const common::sfv_t& query,
   ret.clear();
   vector<pair<string, float> > ids;
   similar_row(query, ids, complete_row_similar_num_);
-  if (ids.size() == 0) {
-    return;
-  }
+  aggregate_neighbors(ids, ret);
+}
 
+void recommender_base::aggregate_neighbors(
+    const vector<pair<string, float> >& ids,
+    common::sfv_t& ret) const {
+  // Sum up neighbor rows by internal column id and decode each column name
+  // only once.
+  vector<pair<uint64_t, float> > acc;
   size_t exist_row_num = 0;
   for (size_t i = 0; i < ids.size(); ++i) {
-    common::sfv_t row;
-    orig_.get_row(ids[i].first, row);
-    if (row.size() == 0) {
-      continue;
-    } else {
+    if (orig_->accumulate_row(ids[i].first, acc)) {
       ++exist_row_num;
     }
-    for (size_t j = 0; j < row.size(); ++j) {
-      ret.push_back(make_pair(row[j].first, row[j].second));
-    }
   }
-
   if (exist_row_num == 0) {
     return;
   }
-  common::sort_and_merge(ret);
+
+  sort(acc.begin(), acc.end());
+  for (size_t i = 0; i < acc.size();) {
+    const uint64_t column = acc[i].first;
+    float sum = 0.f;
+    for (; i < acc.size() && acc[i].first == column; ++i) {
+      sum += acc[i].second;
+    }
+    ret.push_back(make_pair(orig_->get_column_key(column), sum));
+  }
+  sort(ret.begin(), ret.end());
   for (size_t i = 0; i < ret.size(); ++i) {
     ret[i].second /= exist_row_num;
   }
 }
 
+void recommender_base::set_orig_storage(
+    jubatus::util::lang::shared_ptr<core::storage::sparse_matrix_storage_base>
+        orig) {
+  orig_ = orig;
+  clear_complete_row_cache();
+}
+
+void recommender_base::set_complete_row_cache_size(size_t size) {
+  scoped_lock lk(completion_mutex_);
+  complete_row_cache_size_ = size;
+  while (completion_cache_.size() > complete_row_cache_size_) {
+    erase_completion(completion_cache_.find(completion_lru_.back()));
+  }
+}
+
+void recommender_base::clear_complete_row_cache() {
+  scoped_lock lk(completion_mutex_);
+  completion_cache_t().swap(completion_cache_);
+  completion_lru_.clear();
+  dependents_t().swap(completion_dependents_);
+}
+
+void recommender_base::invalidate_complete_row_cache(const std::string& id) {
+  if (complete_row_cache_size_ == 0) {
+    return;
+  }
+  scoped_lock lk(completion_mutex_);
+  completion_cache_t::iterator it = completion_cache_.find(id);
+  if (it != completion_cache_.end()) {
+    erase_completion(it);
+  }
+  dependents_t::iterator dep = completion_dependents_.find(id);
+  if (dep == completion_dependents_.end()) {
+    return;
+  }
+  // erase_completion() updates completion_dependents_, so take a copy.
+  const vector<string> dependents(dep->second.begin(), dep->second.end());
+  for (size_t i = 0; i < dependents.size(); ++i) {
+    erase_completion(completion_cache_.find(dependents[i]));
+  }
+}
+
+void recommender_base::erase_completion(completion_cache_t::iterator it)
+    const {
+  const vector<string>& neighbors = it->second.neighbors;
+  for (size_t i = 0; i < neighbors.size(); ++i) {
+    dependents_t::iterator dep = completion_dependents_.find(neighbors[i]);
+    if (dep == completion_dependents_.end()) {
+      continue;
+    }
+    dep->second.erase(it->first);
+    if (dep->second.empty()) {
+      completion_dependents_.erase(dep);
+    }
+  }
+  completion_lru_.erase(it->second.lru_pos);
+  completion_cache_.erase(it);
+}
+
 float recommender_base::calc_similality(common::sfv_t& q1, common::sfv_t& q2) {
   float q1_norm = calc_l2norm(q1);
   float q2_norm = calc_l2norm(q2);
@@ -17,16 +17,19 @@
 #ifndef JUBATUS_CORE_RECOMMENDER_RECOMMENDER_BASE_HPP_
 #define JUBATUS_CORE_RECOMMENDER_RECOMMENDER_BASE_HPP_
 
+#include <list>
 #include <vector>
 #include <string>
 #include <utility>
+#include "jubatus/util/concurrent/mutex.h"
 #include "jubatus/util/data/unordered_map.h"
+#include "jubatus/util/data/unordered_set.h"
 #include "jubatus/util/lang/shared_ptr.h"
 #include "../table/column/column_table.hpp"
 #include "../common/type.hpp"
 #include "../framework/mixable.hpp"
 #include "../framework/model.hpp"
-#include "../storage/sparse_matrix_storage.hpp"
+#include "../storage/sparse_matrix_storage_base.hpp"
 #include "../storage/recommender_storage_base.hpp"
 #include "../unlearner/unlearner_base.hpp"
 #include "recommender_type.hpp"
@@ -89,6 +92,22 @@ class recommender_base : public framework::model {
   void complete_row(const common::sfv_t& query, common::sfv_t& ret) const;
   void decode_row(const std::string& id, common::sfv_t& ret) const;
 
+  // Caches up to `size` results of complete_row(id); 0 disables the cache.
+  // A cached result is dropped when its row or one of the neighbors it was
+  // aggregated from is updated.  Rows that newly become neighbors are not
+  // tracked, so callers must clear the cache after mix.
+  void set_complete_row_cache_size(size_t size);
+  size_t get_complete_row_cache_size() const {
+    return complete_row_cache_size_;
+  }
+  void clear_complete_row_cache();
+
+  // Replaces the storage of raw rows (sparse_matrix_storage by default).
+  // This must be called before any row is added.
+  void set_orig_storage(
+      jubatus::util::lang::shared_ptr<core::storage::sparse_matrix_storage_base>
+          orig);
+
   virtual framework::mixable* get_mixable() const = 0;
 
   static float calc_similality(common::sfv_t& q1, common::sfv_t& q2);
@@ -97,8 +116,37 @@ class recommender_base : public framework::model {
  protected:
   static const uint64_t complete_row_similar_num_;
 
+  // Derived classes must call this whenever row `id` of orig_ changes.
+  void invalidate_complete_row_cache(const std::string& id);
+
   // TODO(beam2d): Workaround to correctly store the storage on save.
-  core::storage::sparse_matrix_storage orig_;
+  jubatus::util::lang::shared_ptr<core::storage::sparse_matrix_storage_base>
+      orig_;
+
+ private:
+  struct completion_entry {
+    common::sfv_t result;
+    std::vector<std::string> neighbors;
+    std::list<std::string>::iterator lru_pos;
+  };
+  typedef jubatus::util::data::unordered_map<std::string, completion_entry>
+      completion_cache_t;
+  typedef jubatus::util::data::unordered_map<std::string,
+      jubatus::util::data::unordered_set<std::string> > dependents_t;
+
+  void aggregate_neighbors(
+      const std::vector<std::pair<std::string, float> >& ids,
+      common::sfv_t& ret) const;
+  void erase_completion(completion_cache_t::iterator it) const;
+
+  size_t complete_row_cache_size_;
+  // complete_row is const and may run concurrently under a read lock, so
+  // the cache has its own mutex.
+  mutable jubatus::util::concurrent::mutex completion_mutex_;
+  mutable completion_cache_t completion_cache_;
+  mutable std::list<std::string> completion_lru_;
+  // neighbor row -> cached rows aggregated from it
+  mutable dependents_t completion_dependents_;
 };
 
 }  // namespace recommender
@@ -37,14 +37,14 @@ class recommender_impl : public recommender_base {
   recommender_impl()
       : recommender_base() {
     // make mock
-    orig_.set("r1", "a1", 1.0);
-    orig_.set("r1", "a2", 1.0);
+    orig_->set("r1", "a1", 1.0);
+    orig_->set("r1", "a2", 1.0);
 
-    orig_.set("r2", "b1", 1.0);
-    orig_.set("r2", "b2", 1.0);
+    orig_->set("r2", "b1", 1.0);
+    orig_->set("r2", "b2", 1.0);
 
-    orig_.set("r3", "a1", 1.0);
-    orig_.set("r3", "b1", 1.0);
+    orig_->set("r3", "a1", 1.0);
+    orig_->set("r3", "b1", 1.0);
   }
 
   void similar_row(
@@ -72,6 +72,13 @@ class recommender_impl : public recommender_base {
   }
 
   void update_row(const string& id, const sfv_diff_t& diff) {
+    orig_->set_row(id, diff);
+    invalidate_complete_row_cache(id);
+  }
+
+  // updates orig_ without telling the completion cache
+  void set_silently(const string& row, const string& column, float val) {
+    orig_->set(row, column, val);
   }
 
   void get_all_row_ids(vector<string>& ids) const {
@@ -106,6 +113,72 @@ TEST(recommender_base, complete_row) {
   EXPECT_EQ("b1", ret[2].first);
 }
 
+TEST(recommender_base, complete_row_from_id) {
+  recommender_impl r;
+  common::sfv_t ret;
+  r.complete_row("r2", ret);
+  ASSERT_EQ(3u, ret.size());
+  EXPECT_EQ("a1", ret[0].first);
+  EXPECT_FLOAT_EQ(1.0, ret[0].second);
+  EXPECT_EQ("a2", ret[1].first);
+  EXPECT_FLOAT_EQ(0.5, ret[1].second);
+  EXPECT_EQ("b1", ret[2].first);
+  EXPECT_FLOAT_EQ(0.5, ret[2].second);
+
+  // without cache, changes are visible immediately
+  r.set_silently("r3", "c1", 1.0);
+  r.complete_row("r2", ret);
+  ASSERT_EQ(4u, ret.size());
+  EXPECT_EQ("c1", ret[3].first);
+}
+
+TEST(recommender_base, complete_row_cache) {
+  recommender_impl r;
+  r.set_complete_row_cache_size(1);
+  EXPECT_EQ(1u, r.get_complete_row_cache_size());
+
+  common::sfv_t ret;
+  r.complete_row("r2", ret);
+  ASSERT_EQ(3u, ret.size());
+
+  // cached result is returned
+  r.set_silently("r3", "c1", 1.0);
+  r.complete_row("r2", ret);
+  ASSERT_EQ(3u, ret.size());
+
+  // updating a neighbor invalidates the result
+  sfv_diff_t diff;
+  diff.push_back(make_pair("c2", 1.0));
+  r.update_row("r1", diff);
+  r.complete_row("r2", ret);
+  ASSERT_EQ(5u, ret.size());
+  EXPECT_EQ("c1", ret[3].first);
+  EXPECT_EQ("c2", ret[4].first);
+
+  // updating a row which is not a neighbor keeps the result
+  r.update_row("r4", diff);
+  r.set_silently("r3", "c3", 1.0);
+  r.complete_row("r2", ret);
+  ASSERT_EQ(5u, ret.size());
+
+  // "r2" is evicted by "r4"
+  r.complete_row("r4", ret);
+  EXPECT_EQ(6u, ret.size());
+  r.complete_row("r2", ret);
+  EXPECT_EQ(6u, ret.size());
+
+  r.set_silently("r3", "c4", 1.0);
+  r.clear_complete_row_cache();
+  r.complete_row("r2", ret);
+  EXPECT_EQ(7u, ret.size());
+
+  // disabling the cache
+  r.set_complete_row_cache_size(0);
+  r.set_silently("r3", "c5", 1.0);
+  r.complete_row("r2", ret);
+  EXPECT_EQ(8u, ret.size());
+}
+
 TEST(recommender_base, get_all_row_ids) {
   vector<string> ids;
   recommender_impl r;
@@ -21,6 +21,8 @@
 #include "../common/exception.hpp"
 #include "../common/jsonconfig.hpp"
 #include "../nearest_neighbor/nearest_neighbor_factory.hpp"
+#include "../storage/compact_sparse_matrix_storage.hpp"
+#include "../storage/sparse_matrix_storage.hpp"
 #include "../table/column/column_table.hpp"
 #include "../unlearner/unlearner_factory.hpp"
 #include "recommender_factory.hpp"
@@ -28,6 +30,7 @@
 
 using std::string;
 using jubatus::util::text::json::json;
+using jubatus::util::text::json::json_object;
 using jubatus::util::lang::shared_ptr;
 using jubatus::util::data::string::starts_with;
 using jubatus::core::common::jsonconfig::config;
@@ -51,9 +54,71 @@ struct nearest_neighbor_recommender_config {
         JUBA_MEMBER(unlearner) & JUBA_MEMBER(unlearner_parameter);
   }
 };
-}  // namespace
 
-shared_ptr<recommender_base> recommender_factory::create_recommender(
+// Parameters accepted by every method.
+struct common_recommender_config {
+  jubatus::util::data::optional<int> complete_row_cache_size;
+  jubatus::util::data::optional<std::string> orig_storage;
+  jubatus::util::data::optional<config> orig_storage_parameter;
+
+  template<typename Ar>
+  void serialize(Ar& ar) {
+    ar & JUBA_MEMBER(complete_row_cache_size) & JUBA_MEMBER(orig_storage) &
+        JUBA_MEMBER(orig_storage_parameter);
+  }
+};
+
+bool is_common_parameter(const std::string& key) {
+  return key == "complete_row_cache_size" || key == "orig_storage" ||
+      key == "orig_storage_parameter";
+}
+
+// Splits `param` into the parameters accepted by every method and the rest,
+// which are checked by config_cast_check for each method.
+void split_common_parameters(
+    const config& param,
+    config& common_param,
+    config& method_param) {
+  json common_json(new json_object);
+  if (param.type() != json::Object) {
+    common_param = config(common_json, param.path());
+    method_param = param;
+    return;
+  }
+  json method_json(new json_object);
+  for (config::iterator it = param.begin(); it != param.end(); ++it) {
+    if (is_common_parameter(it.key())) {
+      common_json[it.key()] = it.value().get();
+    } else {
+      method_json[it.key()] = it.value().get();
+    }
+  }
+  common_param = config(common_json, param.path());
+  method_param = config(method_json, param.path());
+}
+
+shared_ptr<storage::sparse_matrix_storage_base> create_orig_storage(
+    const common_recommender_config& conf) {
+  const std::string name =
+      conf.orig_storage ? *conf.orig_storage : "sparse_matrix";
+  if (name == "sparse_matrix") {
+    return shared_ptr<storage::sparse_matrix_storage_base>(
+        new storage::sparse_matrix_storage);
+  } else if (name == "compact") {
+    storage::compact_sparse_matrix_storage::config storage_conf;
+    if (conf.orig_storage_parameter) {
+      storage_conf = config_cast_check<
+          storage::compact_sparse_matrix_storage::config>(
+              *conf.orig_storage_parameter);
+    }
+    return shared_ptr<storage::sparse_matrix_storage_base>(
+        new storage::compact_sparse_matrix_storage(storage_conf));
+  } else {
+    throw JUBATUS_EXCEPTION(common::unsupported_method(name));
+  }
+}
+
+shared_ptr<recommender_base> create_recommender_method(
     const string& name,
     const config& param,
     const string& id) {
@@ -95,6 +160,31 @@ shared_ptr<recommender_base> recommender_factory::create_recommender(
   }
 }
 
+}  // namespace
+
+shared_ptr<recommender_base> recommender_factory::create_recommender(
+    const string& name,
+    const config& param,
+    const string& id) {
+  config common_param;
+  config method_param;
+  split_common_parameters(param, common_param, method_param);
+  const common_recommender_config conf =
+      config_cast_check<common_recommender_config>(common_param);
+  if (conf.complete_row_cache_size && *conf.complete_row_cache_size < 0) {
+    throw JUBATUS_EXCEPTION(
+        common::invalid_parameter("0 <= complete_row_cache_size"));
+  }
+
+  shared_ptr<recommender_base> recommender =
+      create_recommender_method(name, method_param, id);
+  recommender->set_orig_storage(create_orig_storage(conf));
+  if (conf.complete_row_cache_size) {
+    recommender->set_complete_row_cache_size(*conf.complete_row_cache_size);
+  }
+  return recommender;
+}
+
 }  // namespace recommender
 }  // namespace core
 }  // namespace jubatus
@@ -14,12 +14,16 @@
 // License along with this library; if not, write to the Free Software
 // Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 
+#include <algorithm>
 #include <string>
 #include <vector>
 #include <utility>
 #include <gtest/gtest.h>
 
+#include "jubatus/util/lang/shared_ptr.h"
 #include "recommender_factory.hpp"
+#include "recommender_base.hpp"
+#include "../common/exception.hpp"
 #include "../common/jsonconfig.hpp"
 
 
@@ -30,6 +34,7 @@ using std::make_pair;
 using jubatus::util::text::json::json;
 using jubatus::util::text::json::json_object;
 using jubatus::util::text::json::to_json;
+using jubatus::util::lang::shared_ptr;
 
 typedef std::pair<
     std::string, jubatus::core::common::jsonconfig::config>
@@ -151,6 +156,69 @@ TEST(recommender_factory, no_unlearner_parameter) {
       common::config_exception);
 }
 
+TEST(recommender_factory, complete_row_cache_size) {
+  json js(new json_object);
+  js["hash_num"] = to_json(64);
+  js["complete_row_cache_size"] = to_json(16);
+  shared_ptr<recommender_base> r = recommender_factory::create_recommender(
+      "minhash", common::jsonconfig::config(js), "id");
+  EXPECT_EQ(16u, r->get_complete_row_cache_size());
+  // the common parameter must not be removed from the given config
+  EXPECT_EQ(1u, js.count("complete_row_cache_size"));
+
+  json js_inverted_index(new json_object);
+  js_inverted_index["complete_row_cache_size"] = to_json(8);
+  r = recommender_factory::create_recommender(
+      "inverted_index", common::jsonconfig::config(js_inverted_index), "id");
+  EXPECT_EQ(8u, r->get_complete_row_cache_size());
+
+  js["complete_row_cache_size"] = to_json(-1);
+  EXPECT_THROW(
+      recommender_factory::create_recommender(
+          "minhash", common::jsonconfig::config(js), "id"),
+      common::invalid_parameter);
+
+  js["complete_row_cache_size"] = to_json(16);
+  js["unknown"] = to_json(1);
+  EXPECT_THROW(
+      recommender_factory::create_recommender(
+          "minhash", common::jsonconfig::config(js), "id"),
+      common::jsonconfig::cast_check_error);
+}
+
+TEST(recommender_factory, orig_storage) {
+  json js(new json_object);
+  js["hash_num"] = to_json(64);
+  js["orig_storage"] = to_json(std::string("compact"));
+  js["orig_storage_parameter"] = json(new json_object);
+  js["orig_storage_parameter"]["value_type"] = to_json(std::string("float16"));
+  js["orig_storage_parameter"]["compress"] = to_json(true);
+  shared_ptr<recommender_base> r = recommender_factory::create_recommender(
+      "minhash", common::jsonconfig::config(js), "id");
+
+  sfv_diff_t row;
+  row.push_back(make_pair("c1", 1.0));
+  row.push_back(make_pair("c2", 0.5));
+  r->update_row("r1", row);
+  common::sfv_t decoded;
+  r->decode_row("r1", decoded);
+  std::sort(decoded.begin(), decoded.end());
+  EXPECT_EQ(row, decoded);
+
+  js["orig_storage"] = to_json(std::string("unknown"));
+  EXPECT_THROW(
+      recommender_factory::create_recommender(
+          "minhash", common::jsonconfig::config(js), "id"),
+      common::unsupported_method);
+
+  js["orig_storage"] = to_json(std::string("compact"));
+  js["orig_storage_parameter"]["value_type"] = to_json(std::string("double"));
+  EXPECT_THROW(
+      recommender_factory::create_recommender(
+          "minhash", common::jsonconfig::config(js), "id"),
+      common::invalid_parameter);
+}
+
 }  // namespace recommender
 }  // namespace core
 }  // namespace jubatus
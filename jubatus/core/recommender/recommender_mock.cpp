@@ -83,7 +83,8 @@ void recommender_mock::neighbor_row(
 
 void recommender_mock::clear() {
   mixable_storage_->get_model()->clear();
-  orig_.clear();
+  orig_->clear();
+  clear_complete_row_cache();
 }
 
 void recommender_mock::clear_row(const string& id) {
@@ -91,22 +92,24 @@ void recommender_mock::clear_row(const string& id) {
   decode_row(id, sfv);
   mixable_storage_->get_model()->remove(sfv);
 
-  orig_.remove_row(id);
+  orig_->remove_row(id);
+  invalidate_complete_row_cache(id);
 }
 
 void recommender_mock::update_row(const string& id, const sfv_diff_t& diff) {
   common::sfv_t old_sfv;
-  orig_.get_row(id, old_sfv);
+  orig_->get_row(id, old_sfv);
 
-  orig_.set_row(id, diff);
+  orig_->set_row(id, diff);
+  invalidate_complete_row_cache(id);
   common::sfv_t new_sfv;
-  orig_.get_row(id, new_sfv);
+  orig_->get_row(id, new_sfv);
 
   mixable_storage_->get_model()->update(old_sfv, new_sfv);
 }
 
 void recommender_mock::get_all_row_ids(vector<string>& ids) const {
-  orig_.get_all_row_ids(ids);
+  orig_->get_all_row_ids(ids);
 }
 
 string recommender_mock::type() const {
@@ -114,7 +117,7 @@ string recommender_mock::type() const {
 }
 
 void recommender_mock::pack(framework::packer& packer) const {
-  orig_.pack(packer);
+  orig_->pack(packer);
   mixable_storage_->get_model()->pack(packer);
 }
 
@@ -124,7 +127,8 @@ void recommender_mock::unpack(msgpack::object o) {
   if (mems.size() != 2) {
     throw msgpack::type_error();
   }
-  orig_.unpack(mems[0]);
+  orig_->unpack(mems[0]);
+  clear_complete_row_cache();
   mixable_storage_->get_model()->unpack(mems[1]);
 }
 
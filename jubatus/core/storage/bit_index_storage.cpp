@@ -30,6 +30,7 @@ using std::make_pair;
 using std::pair;
 using std::string;
 using std::vector;
+using jubatus::util::lang::shared_ptr;
 
 namespace jubatus {
 namespace core {
@@ -46,25 +47,35 @@ void bit_index_storage::set_row(const string& row, const bit_vector& bv) {
 }
 
 void bit_index_storage::get_row(const string& row, bit_vector& bv) const {
-  {
-    bit_table_t::const_iterator it = bitvals_diff_.find(row);
-    if (it != bitvals_diff_.end()) {
-      bv = it->second;
-      return;
-    }
+  const bit_vector* found = find_row(row);
+  if (found) {
+    bv = *found;
+  } else {
+    bv = bit_vector();
   }
-  {
-    bit_table_t::const_iterator it = bitvals_.find(row);
-    if (it != bitvals_.end()) {
-      bv = it->second;
-      return;
+}
+
+const bit_vector* bit_index_storage::find_row(const string& row) const {
+  bit_table_t::const_iterator it = bitvals_diff_.find(row);
+  if (it != bitvals_diff_.end()) {
+    return &it->second;
+  }
+  if (mixing_diff_) {
+    it = mixing_diff_->find(row);
+    if (it != mixing_diff_->end()) {
+      return &it->second;
     }
   }
-  bv = bit_vector();
+  it = bitvals_.find(row);
+  if (it != bitvals_.end()) {
+    return &it->second;
+  }
+  return NULL;
 }
 
 void bit_index_storage::remove_row(const string& row) {
-  if (bitvals_.find(row) == bitvals_.end()) {
+  if (bitvals_.find(row) == bitvals_.end() &&
+      !(mixing_diff_ && mixing_diff_->count(row))) {
     // The row is not in the master table; we can
     // immedeately remove it from the diff table.
     bitvals_diff_.erase(row);
@@ -78,6 +89,7 @@ void bit_index_storage::remove_row(const string& row) {
 void bit_index_storage::clear() {
   bit_table_t().swap(bitvals_);
   bit_table_t().swap(bitvals_diff_);
+  mixing_diff_.reset();
 }
 
 void bit_index_storage::get_all_row_ids(std::vector<std::string>& ids) const {
@@ -86,16 +98,33 @@ void bit_index_storage::get_all_row_ids(std::vector<std::string>& ids) const {
       ++it) {
     ids.push_back(it->first);
   }
+  if (mixing_diff_) {
+    for (bit_table_t::const_iterator it = mixing_diff_->begin();
+        it != mixing_diff_->end(); ++it) {
+      if (bitvals_.find(it->first) == bitvals_.end()) {
+        ids.push_back(it->first);
+      }
+    }
+  }
   for (bit_table_t::const_iterator it = bitvals_diff_.begin();
       it != bitvals_diff_.end(); ++it) {
-    if (bitvals_.find(it->first) == bitvals_.end()) {
+    if (bitvals_.find(it->first) == bitvals_.end() &&
+        !(mixing_diff_ && mixing_diff_->count(it->first))) {
       ids.push_back(it->first);
     }
   }
 }
 
 void bit_index_storage::get_diff(bit_table_t& diff) const {
-  diff = bitvals_diff_;
+  if (!mixing_diff_) {
+    diff = bitvals_diff_;
+    return;
+  }
+  diff = *mixing_diff_;
+  for (bit_table_t::const_iterator it = bitvals_diff_.begin();
+      it != bitvals_diff_.end(); ++it) {
+    diff[it->first] = it->second;
+  }
 }
 
 bool bit_index_storage::put_diff(
@@ -108,10 +137,37 @@ bool bit_index_storage::put_diff(
       bitvals_[it->first] = it->second;
     }
   }
-  bitvals_diff_.clear();
+  if (mixing_diff_) {
+    // updates after freeze_diff() are left for the next MIX
+    mixing_diff_.reset();
+  } else {
+    bitvals_diff_.clear();
+  }
   return true;
 }
 
+shared_ptr<const bit_table_t> bit_index_storage::freeze_diff() {
+  shared_ptr<bit_table_t> frozen(new bit_table_t);
+  if (mixing_diff_) {
+    // previous MIX did not finish; mix both of them
+    get_diff(*frozen);
+    bitvals_diff_.clear();
+  } else {
+    frozen->swap(bitvals_diff_);
+  }
+  mixing_diff_ = frozen;
+  return mixing_diff_;
+}
+
+void bit_index_storage::abort_diff() {
+  if (!mixing_diff_) {
+    return;
+  }
+  // newer updates take precedence
+  bitvals_diff_.insert(mixing_diff_->begin(), mixing_diff_->end());
+  mixing_diff_.reset();
+}
+
 void bit_index_storage::mix(const bit_table_t& lhs, bit_table_t& rhs) const {
   for (bit_table_t::const_iterator it = lhs.begin(); it != lhs.end(); ++it) {
     rhs[it->first] = it->second;
@@ -145,9 +201,19 @@ void bit_index_storage::similar_row(
       it != bitvals_diff_.end(); ++it) {
     similar_row_one(bv, *it, heap);
   }
+  if (mixing_diff_) {
+    for (bit_table_t::const_iterator it = mixing_diff_->begin();
+        it != mixing_diff_->end(); ++it) {
+      if (bitvals_diff_.find(it->first) != bitvals_diff_.end()) {
+        continue;
+      }
+      similar_row_one(bv, *it, heap);
+    }
+  }
   for (bit_table_t::const_iterator it = bitvals_.begin(); it != bitvals_.end();
       ++it) {
-    if (bitvals_diff_.find(it->first) != bitvals_diff_.end()) {
+    if (bitvals_diff_.find(it->first) != bitvals_diff_.end() ||
+        (mixing_diff_ && mixing_diff_->count(it->first))) {
       continue;
     }
     similar_row_one(bv, *it, heap);
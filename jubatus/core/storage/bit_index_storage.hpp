@@ -21,6 +21,7 @@
 #include <utility>
 #include <vector>
 #include "jubatus/util/data/unordered_map.h"
+#include "jubatus/util/lang/shared_ptr.h"
 #include "../common/key_manager.hpp"
 #include "../common/unordered_map.hpp"
 #include "../framework/mixable_helper.hpp"
@@ -55,19 +56,42 @@ class bit_index_storage : public framework::model {
   void pack(framework::packer& packer) const;
   void unpack(msgpack::object o);
 
+  // get_diff returns the frozen diff (if any) and the current diff.
   void get_diff(bit_table_t& diff) const;
   bool put_diff(const bit_table_t& mixed_diff);
   void mix(const bit_table_t& lhs, bit_table_t& rhs) const;
 
-  MSGPACK_DEFINE(bitvals_, bitvals_diff_);
+  // see framework::linear_mixable::freeze_diff
+  jubatus::util::lang::shared_ptr<const bit_table_t> freeze_diff();
+  void abort_diff();
+
+  template<class Packer>
+  void msgpack_pack(Packer& packer) const {
+    if (!mixing_diff_) {
+      msgpack::type::make_define(bitvals_, bitvals_diff_)
+          .msgpack_pack(packer);
+    } else {
+      bit_table_t diff;
+      get_diff(diff);
+      msgpack::type::make_define(bitvals_, diff).msgpack_pack(packer);
+    }
+  }
+  void msgpack_unpack(msgpack::object o) {
+    msgpack::type::make_define(bitvals_, bitvals_diff_).msgpack_unpack(o);
+    mixing_diff_.reset();
+  }
 
  private:
+  const bit_vector* find_row(const std::string& row) const;
+
   bit_table_t bitvals_;
   bit_table_t bitvals_diff_;
+  // diff being mixed; rows in |bitvals_diff_| take precedence over it
+  jubatus::util::lang::shared_ptr<const bit_table_t> mixing_diff_;
 };
 
-typedef framework::linear_mixable_helper<bit_index_storage, bit_table_t>
-    mixable_bit_index_storage;
+typedef framework::double_buffered_mixable_helper<
+    bit_index_storage, bit_table_t> mixable_bit_index_storage;
 
 }  // namespace storage
 }  // namespace core
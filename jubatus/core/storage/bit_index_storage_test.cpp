@@ -200,6 +200,45 @@ TEST(bit_index_storage, mix) {
   EXPECT_EQ(2u, ids.size());
 }
 
+TEST(bit_index_storage, freeze_diff) {
+  bit_index_storage s;
+  s.set_row("r1", make_vector("0101"));
+  jubatus::util::lang::shared_ptr<const bit_table_t> frozen =
+      s.freeze_diff();
+  ASSERT_EQ(1u, frozen->size());
+
+  // updates during MIX go to the new diff
+  s.set_row("r2", make_vector("1010"));
+  bit_vector v;
+  s.get_row("r1", v);
+  EXPECT_TRUE(make_vector("0101") == v);
+
+  s.put_diff(*frozen);
+  bit_table_t d;
+  s.get_diff(d);
+  ASSERT_EQ(1u, d.size());
+  EXPECT_TRUE(make_vector("1010") == d["r2"]);
+
+  vector<string> ids;
+  s.get_all_row_ids(ids);
+  EXPECT_EQ(2u, ids.size());
+}
+
+TEST(bit_index_storage, abort_diff) {
+  bit_index_storage s;
+  s.set_row("r1", make_vector("0101"));
+  s.set_row("r2", make_vector("0011"));
+  s.freeze_diff();
+  s.set_row("r1", make_vector("1111"));
+  s.abort_diff();
+
+  bit_table_t d;
+  s.get_diff(d);
+  ASSERT_EQ(2u, d.size());
+  EXPECT_TRUE(make_vector("1111") == d["r1"]);
+  EXPECT_TRUE(make_vector("0011") == d["r2"]);
+}
+
 }  // namespace storage
 }  // namespace core
 }  // namespace jubatus
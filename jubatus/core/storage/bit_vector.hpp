@@ -52,6 +52,11 @@ class bit_vector {
     return bit_num_;
   }
 
+  // 64-bit blocks of the bits; unused bits of the last block are zero
+  const std::vector<uint64_t>& blocks() const {
+    return bits_;
+  }
+
   void debug_print(std::ostream& os) const {
     for (uint64_t i = 0; i < bit_num_; ++i) {
       if ((bits_[i / 64] >> (i % 64)) & 1LLU) {
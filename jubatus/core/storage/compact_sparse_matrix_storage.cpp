@@ -0,0 +1,488 @@
+// Jubatus: Online machine learning framework for distributed environment
+// Copyright (C) 2015 Preferred Networks and Nippon Telegraph and Telephone Corporation.
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License version 2.1 as published by the Free Software Foundation.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+
+#include "compact_sparse_matrix_storage.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+#include "../common/exception.hpp"
+
+using std::make_pair;
+using std::pair;
+using std::string;
+using std::vector;
+
+namespace jubatus {
+namespace core {
+namespace storage {
+
+namespace {
+
+// The arena is not compacted until it has this many bytes of garbage.
+const uint64_t MIN_COMPACTION_GARBAGE = 1 << 16;
+
+struct less_column_id {
+  bool operator()(
+      const pair<uint64_t, float>& lhs,
+      const pair<uint64_t, float>& rhs) const {
+    return lhs.first < rhs.first;
+  }
+};
+
+// IEEE 754 binary16 conversion, rounding to nearest even.
+uint16_t float_to_half(float f) {
+  uint32_t x;
+  std::memcpy(&x, &f, sizeof(x));
+  const uint16_t sign = (x >> 16) & 0x8000;
+  const uint32_t float_exp = (x >> 23) & 0xff;
+  uint32_t mant = x & 0x7fffff;
+
+  if (float_exp == 0xff) {
+    // inf or NaN
+    return sign | 0x7c00 | (mant ? 0x200 : 0);
+  }
+  const int32_t exp = static_cast<int32_t>(float_exp) - 127 + 15;
+  if (exp >= 0x1f) {
+    return sign | 0x7c00;
+  }
+  if (exp <= 0) {
+    // subnormal or zero
+    if (exp < -10) {
+      return sign;
+    }
+    mant |= 0x800000;
+    const uint32_t shift = 14 - exp;
+    uint32_t half_mant = mant >> shift;
+    const uint32_t rem = mant & ((1u << shift) - 1);
+    const uint32_t halfway = 1u << (shift - 1);
+    if (rem > halfway || (rem == halfway && (half_mant & 1))) {
+      ++half_mant;
+    }
+    return sign | half_mant;
+  }
+  uint32_t half = (exp << 10) | (mant >> 13);
+  const uint32_t rem = mant & 0x1fff;
+  if (rem > 0x1000 || (rem == 0x1000 && (half & 1))) {
+    // may carry into the exponent, which is still correctly rounded
+    ++half;
+  }
+  return sign | half;
+}
+
+float half_to_float(uint16_t h) {
+  const uint32_t sign = static_cast<uint32_t>(h & 0x8000) << 16;
+  int32_t exp = (h >> 10) & 0x1f;
+  uint32_t mant = h & 0x3ff;
+  uint32_t x;
+  if (exp == 0x1f) {
+    x = sign | 0x7f800000 | (mant << 13);
+  } else if (exp == 0) {
+    if (mant == 0) {
+      x = sign;
+    } else {
+      exp = 1;
+      while (!(mant & 0x400)) {
+        mant <<= 1;
+        --exp;
+      }
+      mant &= 0x3ff;
+      x = sign | ((exp + 127 - 15) << 23) | (mant << 13);
+    }
+  } else {
+    x = sign | ((exp + 127 - 15) << 23) | (mant << 13);
+  }
+  float f;
+  std::memcpy(&f, &x, sizeof(f));
+  return f;
+}
+
+void put_varint(uint64_t v, vector<uint8_t>& buf) {
+  while (v >= 0x80) {
+    buf.push_back(static_cast<uint8_t>(v | 0x80));
+    v >>= 7;
+  }
+  buf.push_back(static_cast<uint8_t>(v));
+}
+
+uint64_t get_varint(const uint8_t*& p) {
+  uint64_t v = 0;
+  for (int shift = 0; ; shift += 7) {
+    const uint8_t b = *p++;
+    v |= static_cast<uint64_t>(b & 0x7f) << shift;
+    if (!(b & 0x80)) {
+      return v;
+    }
+  }
+}
+
+template <typename T>
+void put_fixed(T v, vector<uint8_t>& buf) {
+  const size_t pos = buf.size();
+  buf.resize(pos + sizeof(T));
+  std::memcpy(&buf[pos], &v, sizeof(T));
+}
+
+template <typename T>
+T get_fixed(const uint8_t*& p) {
+  T v;
+  std::memcpy(&v, p, sizeof(T));
+  p += sizeof(T);
+  return v;
+}
+
+}  // namespace
+
+compact_sparse_matrix_storage::compact_sparse_matrix_storage() {
+  init(config());
+}
+
+compact_sparse_matrix_storage::compact_sparse_matrix_storage(
+    const config& conf) {
+  init(conf);
+}
+
+compact_sparse_matrix_storage::~compact_sparse_matrix_storage() {
+}
+
+void compact_sparse_matrix_storage::init(const config& conf) {
+  garbage_ = 0;
+  const string value_type = conf.value_type ? *conf.value_type : "float32";
+  if (value_type == "float32") {
+    half_ = false;
+  } else if (value_type == "float16") {
+    half_ = true;
+  } else {
+    throw JUBATUS_EXCEPTION(
+        common::invalid_parameter("value_type in (float32, float16)"));
+  }
+  compress_ = conf.compress ? *conf.compress : false;
+}
+
+void compact_sparse_matrix_storage::set(
+    const string& row,
+    const string& column,
+    float val) {
+  set_row(row, vector<pair<string, float> >(1, make_pair(column, val)));
+}
+
+void compact_sparse_matrix_storage::set_row(
+    const string& row,
+    const vector<pair<string, float> >& columns) {
+  entries_t updates;
+  updates.reserve(columns.size());
+  for (size_t i = 0; i < columns.size(); ++i) {
+    updates.push_back(
+        make_pair(column2id_.get_id(columns[i].first), columns[i].second));
+  }
+  // stable, so that the last value wins for duplicated columns
+  std::stable_sort(updates.begin(), updates.end(), less_column_id());
+
+  entries_t current;
+  const row_ref* ref = find_row(row);
+  if (ref) {
+    decode(*ref, current);
+  }
+
+  entries_t merged;
+  merged.reserve(current.size() + updates.size());
+  size_t i = 0;
+  size_t j = 0;
+  while (i < current.size() || j < updates.size()) {
+    if (j == updates.size() ||
+        (i < current.size() && current[i].first < updates[j].first)) {
+      merged.push_back(current[i++]);
+      continue;
+    }
+    while (j + 1 < updates.size() &&
+        updates[j + 1].first == updates[j].first) {
+      ++j;
+    }
+    if (i < current.size() && current[i].first == updates[j].first) {
+      ++i;
+    }
+    merged.push_back(updates[j++]);
+  }
+  store(row, merged);
+}
+
+float compact_sparse_matrix_storage::get(
+    const string& row,
+    const string& column) const {
+  const row_ref* ref = find_row(row);
+  if (!ref) {
+    return 0.f;
+  }
+  uint64_t id = column2id_.get_id_const(column);
+  if (id == common::key_manager::NOTFOUND) {
+    return 0.f;
+  }
+
+  entries_t entries;
+  decode(*ref, entries);
+  entries_t::const_iterator it = std::lower_bound(
+      entries.begin(), entries.end(), make_pair(id, 0.f), less_column_id());
+  if (it == entries.end() || it->first != id) {
+    return 0.f;
+  }
+  return it->second;
+}
+
+void compact_sparse_matrix_storage::get_row(
+    const string& row,
+    vector<pair<string, float> >& columns) const {
+  columns.clear();
+  const row_ref* ref = find_row(row);
+  if (!ref) {
+    return;
+  }
+  entries_t entries;
+  decode(*ref, entries);
+  columns.reserve(entries.size());
+  for (size_t i = 0; i < entries.size(); ++i) {
+    columns.push_back(
+        make_pair(column2id_.get_key(entries[i].first), entries[i].second));
+  }
+}
+
+bool compact_sparse_matrix_storage::accumulate_row(
+    const string& row,
+    vector<pair<uint64_t, float> >& acc) const {
+  const row_ref* ref = find_row(row);
+  if (!ref || ref->size == 0) {
+    return false;
+  }
+  decode(*ref, acc);
+  return true;
+}
+
+float compact_sparse_matrix_storage::calc_l2norm(const string& row) const {
+  const row_ref* ref = find_row(row);
+  if (!ref) {
+    return 0.f;
+  }
+  entries_t entries;
+  decode(*ref, entries);
+  float sq_norm = 0.f;
+  for (size_t i = 0; i < entries.size(); ++i) {
+    sq_norm += entries[i].second * entries[i].second;
+  }
+  return std::sqrt(sq_norm);
+}
+
+void compact_sparse_matrix_storage::remove(
+    const string& row,
+    const string& column) {
+  const row_ref* ref = find_row(row);
+  if (!ref) {
+    return;
+  }
+  uint64_t id = column2id_.get_id_const(column);
+  if (id == common::key_manager::NOTFOUND) {
+    return;
+  }
+
+  entries_t entries;
+  decode(*ref, entries);
+  entries_t::iterator it = std::lower_bound(
+      entries.begin(), entries.end(), make_pair(id, 0.f), less_column_id());
+  if (it == entries.end() || it->first != id) {
+    return;
+  }
+  entries.erase(it);
+  store(row, entries);
+}
+
+void compact_sparse_matrix_storage::remove_row(const string& row) {
+  index_t::iterator it = rows_.find(row);
+  if (it == rows_.end()) {
+    return;
+  }
+  garbage_ += it->second.bytes;
+  rows_.erase(it);
+  if (rows_.empty()) {
+    vector<uint8_t>().swap(arena_);
+    garbage_ = 0;
+  }
+}
+
+void compact_sparse_matrix_storage::get_all_row_ids(
+    vector<string>& ids) const {
+  ids.clear();
+  ids.reserve(rows_.size());
+  for (index_t::const_iterator it = rows_.begin(); it != rows_.end(); ++it) {
+    ids.push_back(it->first);
+  }
+}
+
+void compact_sparse_matrix_storage::clear() {
+  index_t().swap(rows_);
+  vector<uint8_t>().swap(arena_);
+  garbage_ = 0;
+  common::key_manager().swap(column2id_);
+}
+
+void compact_sparse_matrix_storage::pack(framework::packer& packer) const {
+  packer.pack(*this);
+}
+
+void compact_sparse_matrix_storage::unpack(msgpack::object o) {
+  o.convert(this);
+}
+
+void compact_sparse_matrix_storage::msgpack_unpack(msgpack::object o) {
+  if (o.type != msgpack::type::ARRAY || o.via.array.size != 2) {
+    throw msgpack::type_error();
+  }
+  const msgpack::object& tbl = o.via.array.ptr[0];
+  if (tbl.type != msgpack::type::MAP) {
+    throw msgpack::type_error();
+  }
+
+  compact_sparse_matrix_storage s;
+  s.half_ = half_;
+  s.compress_ = compress_;
+  o.via.array.ptr[1].convert(&s.column2id_);
+  entries_t entries;
+  for (size_t i = 0; i < tbl.via.map.size; ++i) {
+    const msgpack::object& row = tbl.via.map.ptr[i].val;
+    if (row.type != msgpack::type::MAP) {
+      throw msgpack::type_error();
+    }
+    entries.resize(row.via.map.size);
+    for (size_t j = 0; j < entries.size(); ++j) {
+      row.via.map.ptr[j].key.convert(&entries[j].first);
+      row.via.map.ptr[j].val.convert(&entries[j].second);
+    }
+    std::sort(entries.begin(), entries.end(), less_column_id());
+    string name;
+    tbl.via.map.ptr[i].key.convert(&name);
+    s.store(name, entries);
+  }
+
+  rows_.swap(s.rows_);
+  arena_.swap(s.arena_);
+  garbage_ = s.garbage_;
+  column2id_.swap(s.column2id_);
+}
+
+const compact_sparse_matrix_storage::row_ref*
+compact_sparse_matrix_storage::find_row(const string& row) const {
+  index_t::const_iterator it = rows_.find(row);
+  return it == rows_.end() ? NULL : &it->second;
+}
+
+void compact_sparse_matrix_storage::decode(
+    const row_ref& ref,
+    entries_t& entries) const {
+  if (ref.size == 0) {
+    return;
+  }
+  const size_t base = entries.size();
+  entries.resize(base + ref.size);
+  const uint8_t* p = &arena_[ref.offset];
+  if (compress_) {
+    uint64_t id = 0;
+    for (size_t i = 0; i < ref.size; ++i) {
+      id += get_varint(p);
+      entries[base + i].first = id;
+    }
+  } else {
+    for (size_t i = 0; i < ref.size; ++i) {
+      entries[base + i].first = get_fixed<uint32_t>(p);
+    }
+  }
+  if (half_) {
+    for (size_t i = 0; i < ref.size; ++i) {
+      entries[base + i].second = half_to_float(get_fixed<uint16_t>(p));
+    }
+  } else {
+    for (size_t i = 0; i < ref.size; ++i) {
+      entries[base + i].second = get_fixed<float>(p);
+    }
+  }
+}
+
+void compact_sparse_matrix_storage::store(
+    const string& row,
+    const entries_t& entries) {
+  vector<uint8_t> buf;
+  // large enough for uncompressed ids and float32 values
+  buf.reserve(entries.size() * 8);
+  uint64_t prev = 0;
+  for (size_t i = 0; i < entries.size(); ++i) {
+    const uint64_t id = entries[i].first;
+    if (compress_) {
+      put_varint(id - prev, buf);
+      prev = id;
+    } else {
+      if (id > 0xffffffffLLU) {
+        throw JUBATUS_EXCEPTION(common::exception::runtime_error(
+            "too many columns for compact_sparse_matrix_storage"));
+      }
+      put_fixed(static_cast<uint32_t>(id), buf);
+    }
+  }
+  for (size_t i = 0; i < entries.size(); ++i) {
+    if (half_) {
+      put_fixed(float_to_half(entries[i].second), buf);
+    } else {
+      put_fixed(entries[i].second, buf);
+    }
+  }
+
+  row_ref& ref = rows_[row];
+  if (buf.size() <= ref.bytes) {
+    // reuse the current place of the row
+    garbage_ += ref.bytes - buf.size();
+  } else {
+    garbage_ += ref.bytes;
+    ref.offset = arena_.size();
+    arena_.resize(arena_.size() + buf.size());
+  }
+  if (!buf.empty()) {
+    std::memcpy(&arena_[ref.offset], &buf[0], buf.size());
+  }
+  ref.bytes = buf.size();
+  ref.size = entries.size();
+
+  if (garbage_ >= MIN_COMPACTION_GARBAGE && garbage_ * 2 > arena_.size()) {
+    compact_arena();
+  }
+}
+
+void compact_sparse_matrix_storage::compact_arena() {
+  vector<uint8_t> arena;
+  arena.reserve(arena_.size() - garbage_);
+  for (index_t::iterator it = rows_.begin(); it != rows_.end(); ++it) {
+    row_ref& ref = it->second;
+    const uint64_t offset = arena.size();
+    arena.insert(arena.end(),
+                 arena_.begin() + ref.offset,
+                 arena_.begin() + ref.offset + ref.bytes);
+    ref.offset = offset;
+  }
+  arena_.swap(arena);
+  garbage_ = 0;
+}
+
+}  // namespace storage
+}  // namespace core
+}  // namespace jubatus
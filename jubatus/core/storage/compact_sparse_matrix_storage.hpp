@@ -0,0 +1,150 @@
+// Jubatus: Online machine learning framework for distributed environment
+// Copyright (C) 2015 Preferred Networks and Nippon Telegraph and Telephone Corporation.
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License version 2.1 as published by the Free Software Foundation.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+
+#ifndef JUBATUS_CORE_STORAGE_COMPACT_SPARSE_MATRIX_STORAGE_HPP_
+#define JUBATUS_CORE_STORAGE_COMPACT_SPARSE_MATRIX_STORAGE_HPP_
+
+#include <stdint.h>
+#include <string>
+#include <utility>
+#include <vector>
+#include <msgpack.hpp>
+#include "jubatus/util/data/optional.h"
+#include "jubatus/util/data/serialization.h"
+#include "jubatus/util/data/unordered_map.h"
+#include "../common/key_manager.hpp"
+#include "sparse_matrix_storage_base.hpp"
+
+namespace jubatus {
+namespace core {
+namespace storage {
+
+// Memory-efficient alternative to sparse_matrix_storage.  Each row is
+// encoded as sorted column ids followed by their values and kept in a
+// single byte arena; an update re-encodes the row and leaves the old bytes
+// as garbage until the arena is compacted.  Values can be stored as IEEE
+// half-precision floats, and column ids can be delta/varint encoded.
+//
+// The serialized form is the same as sparse_matrix_storage.
+class compact_sparse_matrix_storage : public sparse_matrix_storage_base {
+ public:
+  struct config {
+    // "float32" (default) or "float16"
+    jubatus::util::data::optional<std::string> value_type;
+    // delta/varint encodes column ids (default: false)
+    jubatus::util::data::optional<bool> compress;
+
+    template<typename Ar>
+    void serialize(Ar& ar) {
+      ar & JUBA_MEMBER(value_type) & JUBA_MEMBER(compress);
+    }
+  };
+
+  compact_sparse_matrix_storage();
+  explicit compact_sparse_matrix_storage(const config& conf);
+  ~compact_sparse_matrix_storage();
+
+  void set(const std::string& row, const std::string& column, float val);
+  void set_row(
+      const std::string& row,
+      const std::vector<std::pair<std::string, float> >& columns);
+
+  float get(const std::string& row, const std::string& column) const;
+  void get_row(
+      const std::string& row,
+      std::vector<std::pair<std::string, float> >& columns) const;
+
+  bool accumulate_row(
+      const std::string& row,
+      std::vector<std::pair<uint64_t, float> >& acc) const;
+  const std::string& get_column_key(uint64_t id) const {
+    return column2id_.get_key(id);
+  }
+
+  float calc_l2norm(const std::string& row) const;
+  void remove(const std::string& row, const std::string& column);
+  void remove_row(const std::string& row);
+  void get_all_row_ids(std::vector<std::string>& ids) const;
+  void clear();
+
+  storage::version get_version() const {
+    return storage::version();
+  }
+
+  // bytes used by encoded rows, including garbage
+  size_t arena_size() const {
+    return arena_.size();
+  }
+
+  void pack(framework::packer& packer) const;
+  void unpack(msgpack::object o);
+
+  template <class Packer>
+  void msgpack_pack(Packer& pk) const {
+    std::vector<std::pair<uint64_t, float> > entries;
+    pk.pack_array(2);
+    pk.pack_map(rows_.size());
+    for (index_t::const_iterator it = rows_.begin(); it != rows_.end();
+        ++it) {
+      entries.clear();
+      decode(it->second, entries);
+      pk.pack(it->first);
+      pk.pack_map(entries.size());
+      for (size_t i = 0; i < entries.size(); ++i) {
+        pk.pack(entries[i].first);
+        pk.pack(entries[i].second);
+      }
+    }
+    pk.pack(column2id_);
+  }
+  void msgpack_unpack(msgpack::object o);
+
+ private:
+  typedef std::vector<std::pair<uint64_t, float> > entries_t;
+
+  struct row_ref {
+    row_ref()
+        : offset(0),
+          bytes(0),
+          size(0) {
+    }
+    uint64_t offset;
+    uint32_t bytes;
+    uint32_t size;
+  };
+  typedef jubatus::util::data::unordered_map<std::string, row_ref> index_t;
+
+  void init(const config& conf);
+  const row_ref* find_row(const std::string& row) const;
+  void decode(const row_ref& ref, entries_t& entries) const;
+  // `entries` must be sorted by column id without duplicates.
+  void store(const std::string& row, const entries_t& entries);
+  void compact_arena();
+
+  index_t rows_;
+  std::vector<uint8_t> arena_;
+  uint64_t garbage_;
+  common::key_manager column2id_;
+  bool half_;
+  bool compress_;
+};
+
+}  // namespace storage
+}  // namespace core
+}  // namespace jubatus
+
+#endif  // JUBATUS_CORE_STORAGE_COMPACT_SPARSE_MATRIX_STORAGE_HPP_
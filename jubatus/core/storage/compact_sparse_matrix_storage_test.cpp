@@ -0,0 +1,224 @@
+// Jubatus: Online machine learning framework for distributed environment
+// Copyright (C) 2015 Preferred Networks and Nippon Telegraph and Telephone Corporation.
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License version 2.1 as published by the Free Software Foundation.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <utility>
+#include <vector>
+#include <gtest/gtest.h>
+#include "../common/exception.hpp"
+#include "compact_sparse_matrix_storage.hpp"
+#include "sparse_matrix_storage.hpp"
+
+using std::make_pair;
+using std::pair;
+using std::string;
+using std::vector;
+
+namespace jubatus {
+namespace core {
+namespace storage {
+
+class compact_sparse_matrix_storage_test
+    : public ::testing::TestWithParam<pair<string, bool> > {
+ protected:
+  compact_sparse_matrix_storage::config make_config() const {
+    compact_sparse_matrix_storage::config conf;
+    conf.value_type = GetParam().first;
+    conf.compress = GetParam().second;
+    return conf;
+  }
+};
+
+TEST_P(compact_sparse_matrix_storage_test, empty) {
+  compact_sparse_matrix_storage s(make_config());
+  EXPECT_EQ(0.0, s.get("row", "column"));
+
+  vector<pair<string, float> > row;
+  s.get_row("row", row);
+  EXPECT_TRUE(row.empty());
+
+  vector<string> ids;
+  s.get_all_row_ids(ids);
+  EXPECT_TRUE(ids.empty());
+}
+
+TEST_P(compact_sparse_matrix_storage_test, set_row) {
+  compact_sparse_matrix_storage s(make_config());
+  vector<pair<string, float> > r1, r2;
+  r1.push_back(make_pair("c2", 2.0));
+  r1.push_back(make_pair("c1", 1.0));
+  s.set_row("r1", r1);
+  r2.push_back(make_pair("c2", 4.0));
+  r2.push_back(make_pair("c3", 5.0));
+  s.set_row("r2", r2);
+
+  EXPECT_EQ(2.0, s.get("r1", "c2"));
+  EXPECT_EQ(1.0, s.get("r1", "c1"));
+  EXPECT_EQ(0.0, s.get("unknown", "c2"));
+  EXPECT_EQ(0.0, s.get("r1", "unknown"));
+  EXPECT_EQ(0.0, s.get("r1", "c3"));
+
+  // overwrites a column and keeps the others
+  vector<pair<string, float> > r1_diff;
+  r1_diff.push_back(make_pair("c3", 3.0));
+  r1_diff.push_back(make_pair("c1", 6.0));
+  r1_diff.push_back(make_pair("c1", 7.0));
+  s.set_row("r1", r1_diff);
+
+  vector<pair<string, float> > p;
+  s.get_row("r1", p);
+  std::sort(p.begin(), p.end());
+  ASSERT_EQ(3u, p.size());
+  EXPECT_EQ(make_pair(string("c1"), 7.0f), p[0]);
+  EXPECT_EQ(make_pair(string("c2"), 2.0f), p[1]);
+  EXPECT_EQ(make_pair(string("c3"), 3.0f), p[2]);
+
+  vector<string> ids;
+  s.get_all_row_ids(ids);
+  ASSERT_EQ(2u, ids.size());
+  std::sort(ids.begin(), ids.end());
+  EXPECT_EQ("r1", ids[0]);
+  EXPECT_EQ("r2", ids[1]);
+}
+
+TEST_P(compact_sparse_matrix_storage_test, remove) {
+  compact_sparse_matrix_storage s(make_config());
+  s.set("r1", "c1", 1.0);
+  s.set("r1", "c2", 2.0);
+  s.remove("r1", "c1");
+  s.remove("r1", "unknown");
+  s.remove("unknown", "c2");
+  EXPECT_EQ(0.0, s.get("r1", "c1"));
+  EXPECT_EQ(2.0, s.get("r1", "c2"));
+  EXPECT_FLOAT_EQ(2.0, s.calc_l2norm("r1"));
+
+  s.remove_row("r1");
+  s.remove_row("unknown");
+  EXPECT_EQ(0.0, s.get("r1", "c2"));
+  vector<string> ids;
+  s.get_all_row_ids(ids);
+  EXPECT_TRUE(ids.empty());
+
+  s.set("r1", "c1", 1.0);
+  s.clear();
+  EXPECT_EQ(0.0, s.get("r1", "c1"));
+}
+
+TEST_P(compact_sparse_matrix_storage_test, accumulate_row) {
+  compact_sparse_matrix_storage s(make_config());
+  s.set("r1", "c1", 1.0);
+  s.set("r1", "c2", 2.0);
+  s.set("r2", "c2", 3.0);
+
+  vector<pair<uint64_t, float> > acc;
+  EXPECT_TRUE(s.accumulate_row("r1", acc));
+  EXPECT_TRUE(s.accumulate_row("r2", acc));
+  EXPECT_FALSE(s.accumulate_row("unknown", acc));
+  ASSERT_EQ(3u, acc.size());
+  EXPECT_EQ("c1", s.get_column_key(acc[0].first));
+  EXPECT_EQ("c2", s.get_column_key(acc[1].first));
+  EXPECT_EQ(acc[1].first, acc[2].first);
+  EXPECT_EQ(3.0, acc[2].second);
+}
+
+TEST_P(compact_sparse_matrix_storage_test, pack_and_unpack) {
+  compact_sparse_matrix_storage s(make_config());
+  s.set("r1", "c1", 1.0);
+  s.set("r1", "c2", 2.0);
+  s.set("r2", "c2", 3.0);
+  msgpack::sbuffer buf;
+  msgpack::pack(buf, s);
+
+  msgpack::unpacked unpacked;
+  msgpack::unpack(&unpacked, buf.data(), buf.size());
+  compact_sparse_matrix_storage s2(make_config());
+  unpacked.get().convert(&s2);
+  EXPECT_EQ(1.0, s2.get("r1", "c1"));
+  EXPECT_EQ(3.0, s2.get("r2", "c2"));
+
+  // compatible with sparse_matrix_storage
+  sparse_matrix_storage s3;
+  unpacked.get().convert(&s3);
+  EXPECT_EQ(2.0, s3.get("r1", "c2"));
+  EXPECT_EQ(3.0, s3.get("r2", "c2"));
+
+  s3.set("r3", "c3", 4.0);
+  msgpack::sbuffer buf2;
+  msgpack::pack(buf2, s3);
+  msgpack::unpack(&unpacked, buf2.data(), buf2.size());
+  unpacked.get().convert(&s2);
+  EXPECT_EQ(1.0, s2.get("r1", "c1"));
+  EXPECT_EQ(4.0, s2.get("r3", "c3"));
+}
+
+TEST_P(compact_sparse_matrix_storage_test, compaction) {
+  compact_sparse_matrix_storage s(make_config());
+  vector<pair<string, float> > row;
+  for (int i = 0; i < 100; ++i) {
+    row.push_back(make_pair(string(1, 'a' + i % 26) + string(1, 'a' + i / 26),
+                            1.0));
+  }
+  s.set_row("r1", row);
+  s.set_row("r2", row);
+  const size_t initial_size = s.arena_size();
+  for (int i = 0; i < 10000; ++i) {
+    // the row grows and moves to the end of the arena
+    s.remove("r1", row[i % 100].first);
+    s.set("r1", row[i % 100].first, 2.0);
+  }
+  EXPECT_GT(initial_size * 200, s.arena_size());
+  EXPECT_EQ(2.0, s.get("r1", row[0].first));
+  EXPECT_EQ(1.0, s.get("r2", row[99].first));
+}
+
+INSTANTIATE_TEST_CASE_P(
+    compact_sparse_matrix_storage_test_instance,
+    compact_sparse_matrix_storage_test,
+    ::testing::Values(
+        make_pair(string("float32"), false),
+        make_pair(string("float32"), true),
+        make_pair(string("float16"), false),
+        make_pair(string("float16"), true)));
+
+TEST(compact_sparse_matrix_storage, float16) {
+  compact_sparse_matrix_storage::config conf;
+  conf.value_type = string("float16");
+  compact_sparse_matrix_storage s(conf);
+  s.set("r1", "one", 1.0);
+  s.set("r1", "third", 1.0 / 3);
+  s.set("r1", "negative", -1024.5);
+  s.set("r1", "tiny", 1e-6);
+  s.set("r1", "huge", 1e6);
+  EXPECT_EQ(1.0, s.get("r1", "one"));
+  EXPECT_NEAR(1.0 / 3, s.get("r1", "third"), 1e-3);
+  EXPECT_NEAR(-1024.5, s.get("r1", "negative"), 1.0);
+  EXPECT_NEAR(1e-6, s.get("r1", "tiny"), 1e-7);
+  EXPECT_TRUE(std::isinf(s.get("r1", "huge")));
+}
+
+TEST(compact_sparse_matrix_storage, invalid_value_type) {
+  compact_sparse_matrix_storage::config conf;
+  conf.value_type = string("float64");
+  EXPECT_THROW(compact_sparse_matrix_storage s(conf),
+               common::invalid_parameter);
+}
+
+}  // namespace storage
+}  // namespace core
+}  // namespace jubatus
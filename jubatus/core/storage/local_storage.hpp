@@ -85,6 +85,27 @@ class local_storage : public storage_base {
   }
   std::string type() const;
 
+  // Non-virtual accessors by label id for learners specialized on this
+  // storage (see weight_accessor.hpp).
+  uint64_t find_label_id(const std::string& label) const {
+    return class2id_.get_id_const(label);
+  }
+  uint64_t get_label_id(const std::string& label) {
+    return class2id_.get_id(label);
+  }
+  inline void get2_by_id(
+      const std::string& feature,
+      uint64_t id1,
+      val2_t& w1,
+      uint64_t id2,
+      val2_t& w2) const;
+  inline void set2_by_id(
+      const std::string& feature,
+      uint64_t id1,
+      const val2_t& w1,
+      uint64_t id2,
+      const val2_t& w2);
+
   MSGPACK_DEFINE(tbl_, class2id_);
 
  private:
@@ -130,6 +151,44 @@ class local_storage : public storage_base {
   }
 };
 
+void local_storage::get2_by_id(
+    const std::string& feature,
+    uint64_t id1,
+    val2_t& w1,
+    uint64_t id2,
+    val2_t& w2) const {
+  id_features3_t::const_iterator row = tbl_.find(feature);
+  if (row == tbl_.end()) {
+    return;
+  }
+  id_feature_val3_t::const_iterator it = row->second.find(id1);
+  if (it != row->second.end()) {
+    w1 = val2_t(it->second.v1, it->second.v2);
+  }
+  it = row->second.find(id2);
+  if (it != row->second.end()) {
+    w2 = val2_t(it->second.v1, it->second.v2);
+  }
+}
+
+// Skips |w2| when |id2| is NOTFOUND.
+void local_storage::set2_by_id(
+    const std::string& feature,
+    uint64_t id1,
+    const val2_t& w1,
+    uint64_t id2,
+    const val2_t& w2) {
+  id_feature_val3_t& row = tbl_[feature];
+  val3_t& val1 = row[id1];
+  val1.v1 = w1.v1;
+  val1.v2 = w1.v2;
+  if (id2 != common::key_manager::NOTFOUND) {
+    val3_t& val2 = row[id2];
+    val2.v1 = w2.v1;
+    val2.v2 = w2.v2;
+  }
+}
+
 }  // namespace storage
 }  // namespace core
 }  // namespace jubatus
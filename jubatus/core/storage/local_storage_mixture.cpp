@@ -22,6 +22,7 @@
 #include "jubatus/util/data/intern.h"
 
 using std::string;
+using jubatus::util::lang::shared_ptr;
 
 namespace jubatus {
 namespace core {
@@ -35,6 +36,68 @@ void increase(val3_t& a, const val3_t& b) {
   a.v3 += b.v3;
 }
 
+val3_t mixing_value(const id_feature_val3_t* mixing_row, uint64_t id) {
+  if (mixing_row) {
+    id_feature_val3_t::const_iterator it = mixing_row->find(id);
+    if (it != mixing_row->end()) {
+      return it->second;
+    }
+  }
+  return val3_t();
+}
+
+void add_weight(const id_features3_t& diff, id_features3_t& tbl) {
+  for (id_features3_t::const_iterator it = diff.begin(); it != diff.end();
+       ++it) {
+    id_feature_val3_t& row = tbl[it->first];
+    for (id_feature_val3_t::const_iterator it2 = it->second.begin();
+         it2 != it->second.end(); ++it2) {
+      increase(row[it2->first], it2->second);
+    }
+  }
+}
+
+void to_diff(
+    const id_features3_t& tbl,
+    const common::key_manager& class2id,
+    const version& model_version,
+    diff_t& ret) {
+  ret.diff.clear();
+  for (id_features3_t::const_iterator it = tbl.begin(); it != tbl.end();
+       ++it) {
+    id_feature_val3_t::const_iterator it2 = it->second.begin();
+    feature_val3_t fv3;
+    for (; it2 != it->second.end(); ++it2) {
+      fv3.push_back(make_pair(class2id.get_key(it2->first), it2->second));
+    }
+    ret.diff.push_back(make_pair(it->first, fv3));
+  }
+  ret.expect_version = model_version;
+}
+
+// Keeps its own copy of the labels as class2id_ can be updated while the
+// diff is packed.
+class mixture_frozen_diff : public frozen_diff {
+ public:
+  mixture_frozen_diff(
+      const shared_ptr<const id_features3_t>& diff,
+      const common::key_manager& class2id,
+      const version& model_version)
+      : diff_(diff),
+        class2id_(class2id),
+        model_version_(model_version) {
+  }
+
+  void get_diff(diff_t& ret) const {
+    to_diff(*diff_, class2id_, model_version_, ret);
+  }
+
+ private:
+  shared_ptr<const id_features3_t> diff_;
+  common::key_manager class2id_;
+  version model_version_;
+};
+
 void delete_label_from_weight(uint64_t delete_id, id_features3_t& tbl) {
   for (id_features3_t::iterator it = tbl.begin(); it != tbl.end(); ) {
     it->second.erase(delete_id);
@@ -75,9 +138,25 @@ bool local_storage_mixture::get_internal(
       increase(val3, it2->second);
     }
   }
+
+  const id_feature_val3_t* mixing_row = find_mixing_row(feature);
+  if (mixing_row) {
+    found = true;
+    for (id_feature_val3_t::const_iterator it2 = mixing_row->begin();
+        it2 != mixing_row->end(); ++it2) {
+      increase(ret[it2->first], it2->second);
+    }
+  }
   return found;
 }
 
+void local_storage_mixture::get_merged_diff(id_features3_t& ret) const {
+  ret = tbl_diff_;
+  if (mixing_diff_) {
+    add_weight(*mixing_diff_, ret);
+  }
+}
+
 void local_storage_mixture::get(
     const std::string& feature,
     feature_val1_t& ret) const {
@@ -150,7 +229,8 @@ void local_storage_mixture::set(
     const string& klass,
     const val1_t& w) {
   uint64_t class_id = class2id_.get_id(klass);
-  float w_in_table = tbl_[feature][class_id].v1;
+  float w_in_table = tbl_[feature][class_id].v1 +
+      mixing_value(find_mixing_row(feature), class_id).v1;
   tbl_diff_[feature][class_id].v1 = w - w_in_table;
 }
 
@@ -159,12 +239,8 @@ void local_storage_mixture::set2(
     const string& klass,
     const val2_t& w) {
   uint64_t class_id = class2id_.get_id(klass);
-  float w1_in_table = tbl_[feature][class_id].v1;
-  float w2_in_table = tbl_[feature][class_id].v2;
-
-  val3_t& triple = tbl_diff_[feature][class_id];
-  triple.v1 = w.v1 - w1_in_table;
-  triple.v2 = w.v2 - w2_in_table;
+  set_cell(tbl_[feature], find_mixing_row(feature), tbl_diff_[feature],
+           class_id, w);
 }
 
 void local_storage_mixture::set3(
@@ -172,7 +248,8 @@ void local_storage_mixture::set3(
     const string& klass,
     const val3_t& w) {
   uint64_t class_id = class2id_.get_id(klass);
-  val3_t v = tbl_[feature][class_id];
+  val3_t v = tbl_[feature][class_id] +
+      mixing_value(find_mixing_row(feature), class_id);
   tbl_diff_[feature][class_id] = w - v;
 }
 
@@ -221,17 +298,13 @@ void local_storage_mixture::bulk_update(
 }
 
 void local_storage_mixture::get_diff(diff_t& ret) const {
-  ret.diff.clear();
-  for (jubatus::util::data::unordered_map<string, id_feature_val3_t>::
-      const_iterator it = tbl_diff_.begin(); it != tbl_diff_.end(); ++it) {
-    id_feature_val3_t::const_iterator it2 = it->second.begin();
-    feature_val3_t fv3;
-    for (; it2 != it->second.end(); ++it2) {
-      fv3.push_back(make_pair(class2id_.get_key(it2->first), it2->second));
-    }
-    ret.diff.push_back(make_pair(it->first, fv3));
+  if (!mixing_diff_) {
+    to_diff(tbl_diff_, class2id_, model_version_, ret);
+  } else {
+    id_features3_t diff;
+    get_merged_diff(diff);
+    to_diff(diff, class2id_, model_version_, ret);
   }
-  ret.expect_version = model_version_;
 }
 
 bool local_storage_mixture::set_average_and_clear_diff(
@@ -249,13 +322,41 @@ bool local_storage_mixture::set_average_and_clear_diff(
       }
     }
     model_version_.increment();
-    tbl_diff_.clear();
+    if (mixing_diff_) {
+      // updates after freeze_diff() are left for the next MIX
+      mixing_diff_.reset();
+    } else {
+      tbl_diff_.clear();
+    }
     return true;
   } else {
+    abort_diff();
     return false;
   }
 }
 
+shared_ptr<const frozen_diff> local_storage_mixture::freeze_diff() {
+  shared_ptr<id_features3_t> diff(new id_features3_t);
+  if (mixing_diff_) {
+    // previous MIX did not finish; mix both of them
+    get_merged_diff(*diff);
+    tbl_diff_.clear();
+  } else {
+    diff->swap(tbl_diff_);
+  }
+  mixing_diff_ = diff;
+  return shared_ptr<const frozen_diff>(
+      new mixture_frozen_diff(mixing_diff_, class2id_, model_version_));
+}
+
+void local_storage_mixture::abort_diff() {
+  if (!mixing_diff_) {
+    return;
+  }
+  add_weight(*mixing_diff_, tbl_diff_);
+  mixing_diff_.reset();
+}
+
 void local_storage_mixture::register_label(const std::string& label) {
   // get_id method creates an entry when the label doesn't exist
   class2id_.get_id(label);
@@ -268,6 +369,12 @@ bool local_storage_mixture::delete_label(const std::string& label) {
   }
   delete_label_from_weight(delete_id, tbl_);
   delete_label_from_weight(delete_id, tbl_diff_);
+  if (mixing_diff_) {
+    // the frozen diff may be being packed; replace it instead
+    shared_ptr<id_features3_t> diff(new id_features3_t(*mixing_diff_));
+    delete_label_from_weight(delete_id, *diff);
+    mixing_diff_ = diff;
+  }
   class2id_.delete_key(label);
   return true;
 }
@@ -277,6 +384,7 @@ void local_storage_mixture::clear() {
   id_features3_t().swap(tbl_);
   common::key_manager().swap(class2id_);
   id_features3_t().swap(tbl_diff_);
+  mixing_diff_.reset();
 }
 
 std::vector<std::string> local_storage_mixture::get_labels() const {
@@ -44,6 +44,9 @@ class local_storage_mixture : public storage_base {
   void get_diff(diff_t& ret) const;
   bool set_average_and_clear_diff(const diff_t& average);
 
+  jubatus::util::lang::shared_ptr<const frozen_diff> freeze_diff();
+  void abort_diff();
+
   void set(
       const std::string& feature,
       const std::string& klass,
@@ -87,17 +90,171 @@ class local_storage_mixture : public storage_base {
 
   std::string type() const;
 
-  MSGPACK_DEFINE(tbl_, class2id_, tbl_diff_, model_version_);
+  // Non-virtual accessors by label id for learners specialized on this
+  // storage (see weight_accessor.hpp).
+  uint64_t find_label_id(const std::string& label) const {
+    return class2id_.get_id_const(label);
+  }
+  uint64_t get_label_id(const std::string& label) {
+    return class2id_.get_id(label);
+  }
+  inline void get2_by_id(
+      const std::string& feature,
+      uint64_t id1,
+      val2_t& w1,
+      uint64_t id2,
+      val2_t& w2) const;
+  inline void set2_by_id(
+      const std::string& feature,
+      uint64_t id1,
+      const val2_t& w1,
+      uint64_t id2,
+      const val2_t& w2);
+
+  template<class Packer>
+  void msgpack_pack(Packer& packer) const {
+    if (!mixing_diff_) {
+      msgpack::type::make_define(tbl_, class2id_, tbl_diff_, model_version_)
+          .msgpack_pack(packer);
+    } else {
+      id_features3_t diff;
+      get_merged_diff(diff);
+      msgpack::type::make_define(tbl_, class2id_, diff, model_version_)
+          .msgpack_pack(packer);
+    }
+  }
+  void msgpack_unpack(msgpack::object o) {
+    msgpack::type::make_define(tbl_, class2id_, tbl_diff_, model_version_)
+        .msgpack_unpack(o);
+    mixing_diff_.reset();
+  }
 
  private:
   bool get_internal(const std::string& feature, id_feature_val3_t& ret) const;
+  void get_merged_diff(id_features3_t& ret) const;
+  inline const id_feature_val3_t* find_mixing_row(
+      const std::string& feature) const;
+  static inline void get_cell(
+      const id_feature_val3_t* row,
+      const id_feature_val3_t* mixing_row,
+      const id_feature_val3_t* diff_row,
+      uint64_t id,
+      val2_t& w);
+  static inline void set_cell(
+      id_feature_val3_t& row,
+      const id_feature_val3_t* mixing_row,
+      id_feature_val3_t& diff_row,
+      uint64_t id,
+      const val2_t& w);
 
   id_features3_t tbl_;
   common::key_manager class2id_;
   id_features3_t tbl_diff_;
+  // diff being MIXed; weights are tbl_ + *mixing_diff_ + tbl_diff_
+  jubatus::util::lang::shared_ptr<const id_features3_t> mixing_diff_;
   version model_version_;
 };
 
+const id_feature_val3_t* local_storage_mixture::find_mixing_row(
+    const std::string& feature) const {
+  if (!mixing_diff_) {
+    return NULL;
+  }
+  id_features3_t::const_iterator it = mixing_diff_->find(feature);
+  return it == mixing_diff_->end() ? NULL : &it->second;
+}
+
+// Leaves |w| untouched when neither the table nor the diffs have the cell.
+void local_storage_mixture::get_cell(
+    const id_feature_val3_t* row,
+    const id_feature_val3_t* mixing_row,
+    const id_feature_val3_t* diff_row,
+    uint64_t id,
+    val2_t& w) {
+  bool found = false;
+  val3_t v;
+  if (row) {
+    id_feature_val3_t::const_iterator it = row->find(id);
+    if (it != row->end()) {
+      v = it->second;
+      found = true;
+    }
+  }
+  if (mixing_row) {
+    id_feature_val3_t::const_iterator it = mixing_row->find(id);
+    if (it != mixing_row->end()) {
+      v += it->second;
+      found = true;
+    }
+  }
+  if (diff_row) {
+    id_feature_val3_t::const_iterator it = diff_row->find(id);
+    if (it != diff_row->end()) {
+      v += it->second;
+      found = true;
+    }
+  }
+  if (found) {
+    w = val2_t(v.v1, v.v2);
+  }
+}
+
+void local_storage_mixture::get2_by_id(
+    const std::string& feature,
+    uint64_t id1,
+    val2_t& w1,
+    uint64_t id2,
+    val2_t& w2) const {
+  id_features3_t::const_iterator it = tbl_.find(feature);
+  id_features3_t::const_iterator it_diff = tbl_diff_.find(feature);
+  const id_feature_val3_t* row = it == tbl_.end() ? NULL : &it->second;
+  const id_feature_val3_t* diff_row =
+      it_diff == tbl_diff_.end() ? NULL : &it_diff->second;
+  const id_feature_val3_t* mixing_row = find_mixing_row(feature);
+  if (row || mixing_row || diff_row) {
+    get_cell(row, mixing_row, diff_row, id1, w1);
+    get_cell(row, mixing_row, diff_row, id2, w2);
+  }
+}
+
+// Same as set2: only the difference from the mixed table is stored.
+void local_storage_mixture::set_cell(
+    id_feature_val3_t& row,
+    const id_feature_val3_t* mixing_row,
+    id_feature_val3_t& diff_row,
+    uint64_t id,
+    const val2_t& w) {
+  const val3_t& in_table = row[id];
+  float w1_in_table = in_table.v1;
+  float w2_in_table = in_table.v2;
+  if (mixing_row) {
+    id_feature_val3_t::const_iterator it = mixing_row->find(id);
+    if (it != mixing_row->end()) {
+      w1_in_table += it->second.v1;
+      w2_in_table += it->second.v2;
+    }
+  }
+  val3_t& triple = diff_row[id];
+  triple.v1 = w.v1 - w1_in_table;
+  triple.v2 = w.v2 - w2_in_table;
+}
+
+// Skips |w2| when |id2| is NOTFOUND.
+void local_storage_mixture::set2_by_id(
+    const std::string& feature,
+    uint64_t id1,
+    const val2_t& w1,
+    uint64_t id2,
+    const val2_t& w2) {
+  id_feature_val3_t& row = tbl_[feature];
+  id_feature_val3_t& diff_row = tbl_diff_[feature];
+  const id_feature_val3_t* mixing_row = find_mixing_row(feature);
+  set_cell(row, mixing_row, diff_row, id1, w1);
+  if (id2 != common::key_manager::NOTFOUND) {
+    set_cell(row, mixing_row, diff_row, id2, w2);
+  }
+}
+
 }  // namespace storage
 }  // namespace core
 }  // namespace jubatus
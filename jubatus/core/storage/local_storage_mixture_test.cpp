@@ -204,6 +204,63 @@ TEST(local_storage_mixture, put_diff) {
   ASSERT_EQ(2u, s.get_version().get_number());
 }
 
+TEST(local_storage_mixture, freeze_diff) {
+  local_storage_mixture s;
+  s.set("a", "x", 1);
+  jubatus::util::lang::shared_ptr<const frozen_diff> frozen =
+      s.freeze_diff();
+  ASSERT_TRUE(frozen);
+
+  // weights in the frozen diff are still visible and can be updated
+  s.set("a", "x", 3);
+  s.update("a", "x", "y", 1);
+  feature_val1_t w;
+  s.get("a", w);
+  sort(w.begin(), w.end());
+  ASSERT_EQ(2u, w.size());
+  EXPECT_EQ(4, w[0].second);
+  EXPECT_EQ(-1, w[1].second);
+
+  diff_t diff;
+  frozen->get_diff(diff);
+  ASSERT_EQ(1u, diff.diff.size());
+  ASSERT_EQ(1u, diff.diff[0].second.size());
+  EXPECT_EQ(1, diff.diff[0].second[0].second.v1);
+
+  // updates after freeze_diff are left for the next MIX
+  ASSERT_TRUE(s.set_average_and_clear_diff(diff));
+  s.get("a", w);
+  sort(w.begin(), w.end());
+  ASSERT_EQ(2u, w.size());
+  EXPECT_EQ(4, w[0].second);
+  EXPECT_EQ(-1, w[1].second);
+
+  s.get_diff(diff);
+  ASSERT_EQ(1u, diff.diff.size());
+  feature_val3_t& a = diff.diff[0].second;
+  sort(a.begin(), a.end());
+  ASSERT_EQ(2u, a.size());
+  EXPECT_EQ(3, a[0].second.v1);
+  EXPECT_EQ(-1, a[1].second.v1);
+}
+
+TEST(local_storage_mixture, abort_diff) {
+  local_storage_mixture s;
+  s.set("a", "x", 1);
+  s.freeze_diff();
+  s.update("a", "x", "y", 1);
+  s.abort_diff();
+
+  diff_t diff;
+  s.get_diff(diff);
+  ASSERT_EQ(1u, diff.diff.size());
+  feature_val3_t& a = diff.diff[0].second;
+  sort(a.begin(), a.end());
+  ASSERT_EQ(2u, a.size());
+  EXPECT_EQ(2, a[0].second.v1);
+  EXPECT_EQ(-1, a[1].second.v1);
+}
+
 }  // namespace storage
 }  // namespace core
 }  // namespace jubatus
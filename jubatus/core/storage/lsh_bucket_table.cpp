@@ -0,0 +1,161 @@
+// Jubatus: Online machine learning framework for distributed environment
+// Copyright (C) 2015 Preferred Networks and Nippon Telegraph and Telephone Corporation.
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License version 2.1 as published by the Free Software Foundation.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+#include "lsh_bucket_table.hpp"
+
+#include <algorithm>
+#include <vector>
+
+namespace jubatus {
+namespace core {
+namespace storage {
+
+namespace {
+
+const size_t INITIAL_CAPACITY = 16;
+
+inline size_t slot_of(uint64_t key, size_t mask) {
+  // bucket keys are already hashed; mix the upper bits into the lower ones
+  key ^= key >> 33;
+  key *= 0xff51afd7ed558ccdLLU;
+  key ^= key >> 33;
+  return static_cast<size_t>(key) & mask;
+}
+
+}  // namespace
+
+lsh_bucket_table::lsh_bucket_table()
+    : size_(0) {
+}
+
+size_t lsh_bucket_table::find_slot(uint64_t key) const {
+  const size_t mask = keys_.size() - 1;
+  size_t i = slot_of(key, mask);
+  while (used_[i] && keys_[i] != key) {
+    i = (i + 1) & mask;
+  }
+  return i;
+}
+
+const lsh_bucket_table::bucket_t* lsh_bucket_table::find(uint64_t key) const {
+  if (size_ == 0) {
+    return 0;
+  }
+  const size_t i = find_slot(key);
+  return used_[i] ? &buckets_[i] : 0;
+}
+
+lsh_bucket_table::bucket_t* lsh_bucket_table::find(uint64_t key) {
+  if (size_ == 0) {
+    return 0;
+  }
+  const size_t i = find_slot(key);
+  return used_[i] ? &buckets_[i] : 0;
+}
+
+lsh_bucket_table::bucket_t& lsh_bucket_table::operator[](uint64_t key) {
+  // keep the load factor at most 1/2
+  if ((size_ + 1) * 2 > keys_.size()) {
+    rehash(std::max(INITIAL_CAPACITY, keys_.size() * 2));
+  }
+  const size_t i = find_slot(key);
+  if (!used_[i]) {
+    used_[i] = 1;
+    keys_[i] = key;
+    ++size_;
+  }
+  return buckets_[i];
+}
+
+void lsh_bucket_table::erase(uint64_t key) {
+  if (size_ == 0) {
+    return;
+  }
+  size_t i = find_slot(key);
+  if (!used_[i]) {
+    return;
+  }
+
+  // backward shift deletion: move following entries of the cluster into
+  // the hole unless it would place them before their home slot
+  const size_t mask = keys_.size() - 1;
+  for (size_t j = (i + 1) & mask; used_[j]; j = (j + 1) & mask) {
+    const size_t home = slot_of(keys_[j], mask);
+    const bool movable = (i <= j) ? (home <= i || j < home)
+                                  : (home <= i && j < home);
+    if (movable) {
+      keys_[i] = keys_[j];
+      buckets_[i].swap(buckets_[j]);
+      i = j;
+    }
+  }
+  used_[i] = 0;
+  bucket_t().swap(buckets_[i]);
+  --size_;
+}
+
+void lsh_bucket_table::clear() {
+  lsh_bucket_table().swap(*this);
+}
+
+void lsh_bucket_table::swap(lsh_bucket_table& other) {
+  keys_.swap(other.keys_);
+  used_.swap(other.used_);
+  buckets_.swap(other.buckets_);
+  std::swap(size_, other.size_);
+}
+
+void lsh_bucket_table::rehash(size_t capacity) {
+  std::vector<uint64_t> keys(capacity);
+  std::vector<char> used(capacity, 0);
+  std::vector<bucket_t> buckets(capacity);
+  const size_t mask = capacity - 1;
+  for (size_t i = 0; i < used_.size(); ++i) {
+    if (used_[i]) {
+      size_t j = slot_of(keys_[i], mask);
+      while (used[j]) {
+        j = (j + 1) & mask;
+      }
+      used[j] = 1;
+      keys[j] = keys_[i];
+      buckets[j].swap(buckets_[i]);
+    }
+  }
+  keys_.swap(keys);
+  used_.swap(used);
+  buckets_.swap(buckets);
+}
+
+void lsh_bucket_table::msgpack_unpack(msgpack::object o) {
+  if (o.type != msgpack::type::MAP) {
+    throw msgpack::type_error();
+  }
+  lsh_bucket_table tmp;
+  size_t capacity = INITIAL_CAPACITY;
+  while (capacity < o.via.map.size * 2) {
+    capacity *= 2;
+  }
+  tmp.rehash(capacity);
+  for (uint32_t i = 0; i < o.via.map.size; ++i) {
+    const uint64_t key = o.via.map.ptr[i].key.as<uint64_t>();
+    o.via.map.ptr[i].val.convert(&tmp[key]);
+  }
+  swap(tmp);
+}
+
+}  // namespace storage
+}  // namespace core
+}  // namespace jubatus
@@ -0,0 +1,80 @@
+// Jubatus: Online machine learning framework for distributed environment
+// Copyright (C) 2015 Preferred Networks and Nippon Telegraph and Telephone Corporation.
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License version 2.1 as published by the Free Software Foundation.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+#ifndef JUBATUS_CORE_STORAGE_LSH_BUCKET_TABLE_HPP_
+#define JUBATUS_CORE_STORAGE_LSH_BUCKET_TABLE_HPP_
+
+#include <stdint.h>
+#include <algorithm>
+#include <vector>
+#include <msgpack.hpp>
+
+namespace jubatus {
+namespace core {
+namespace storage {
+
+// Map from an LSH bucket key to the sorted row ids in the bucket.
+// Keys are stored in a flat open-addressing table with linear probing, so a
+// lookup touches a few adjacent slots instead of chasing hash nodes.
+// Serialized in the same format as unordered_map<uint64_t, vector<uint64_t> >.
+class lsh_bucket_table {
+ public:
+  typedef std::vector<uint64_t> bucket_t;
+
+  lsh_bucket_table();
+
+  // Returns NULL if the key does not exist.
+  const bucket_t* find(uint64_t key) const;
+  bucket_t* find(uint64_t key);
+
+  // Inserts an empty bucket if the key does not exist.
+  bucket_t& operator[](uint64_t key);
+
+  void erase(uint64_t key);
+  void clear();
+  void swap(lsh_bucket_table& other);
+
+  size_t size() const {
+    return size_;
+  }
+
+  template <class Packer>
+  void msgpack_pack(Packer& packer) const {
+    packer.pack_map(size_);
+    for (size_t i = 0; i < used_.size(); ++i) {
+      if (used_[i]) {
+        packer.pack(keys_[i]);
+        packer.pack(buckets_[i]);
+      }
+    }
+  }
+  void msgpack_unpack(msgpack::object o);
+
+ private:
+  size_t find_slot(uint64_t key) const;
+  void rehash(size_t capacity);
+
+  std::vector<uint64_t> keys_;
+  std::vector<char> used_;
+  std::vector<bucket_t> buckets_;
+  size_t size_;
+};
+
+}  // namespace storage
+}  // namespace core
+}  // namespace jubatus
+
+#endif  // JUBATUS_CORE_STORAGE_LSH_BUCKET_TABLE_HPP_
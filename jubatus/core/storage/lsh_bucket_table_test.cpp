@@ -0,0 +1,100 @@
+// Jubatus: Online machine learning framework for distributed environment
+// Copyright (C) 2015 Preferred Networks and Nippon Telegraph and Telephone Corporation.
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License version 2.1 as published by the Free Software Foundation.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+#include <map>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "jubatus/util/data/unordered_map.h"
+#include "jubatus/util/math/random.h"
+#include "lsh_bucket_table.hpp"
+#include "../common/unordered_map.hpp"
+#include "../framework/stream_writer.hpp"
+
+using std::vector;
+
+namespace jubatus {
+namespace core {
+namespace storage {
+
+TEST(lsh_bucket_table, insert_find_erase) {
+  lsh_bucket_table table;
+  std::map<uint64_t, vector<uint64_t> > expected;
+  jubatus::util::math::random::mtrand rand(0);
+
+  for (int i = 0; i < 3000; ++i) {
+    // small key space to cause both updates and collisions
+    const uint64_t key = rand.next_int(1000) * 0x100000000LLU;
+    if (rand.next_int(3) == 0) {
+      table.erase(key);
+      expected.erase(key);
+    } else {
+      table[key].push_back(i);
+      expected[key].push_back(i);
+    }
+  }
+
+  ASSERT_EQ(expected.size(), table.size());
+  for (uint64_t k = 0; k < 1000; ++k) {
+    const uint64_t key = k * 0x100000000LLU;
+    const vector<uint64_t>* bucket = table.find(key);
+    if (expected.count(key)) {
+      ASSERT_TRUE(bucket != NULL);
+      EXPECT_EQ(expected[key], *bucket);
+    } else {
+      EXPECT_TRUE(bucket == NULL);
+    }
+  }
+
+  table.clear();
+  EXPECT_EQ(0u, table.size());
+  EXPECT_TRUE(table.find(0) == NULL);
+}
+
+TEST(lsh_bucket_table, compatible_with_unordered_map) {
+  typedef jubatus::util::data::unordered_map<uint64_t, vector<uint64_t> >
+      map_t;
+  lsh_bucket_table table;
+  table[1].push_back(10);
+  table[2].push_back(20);
+  table[2].push_back(21);
+
+  msgpack::sbuffer buf;
+  msgpack::pack(buf, table);
+  msgpack::unpacked unpacked;
+  msgpack::unpack(&unpacked, buf.data(), buf.size());
+  map_t m;
+  unpacked.get().convert(&m);
+  ASSERT_EQ(2u, m.size());
+  EXPECT_EQ(vector<uint64_t>(1, 10), m[1]);
+  EXPECT_EQ(2u, m[2].size());
+
+  m[3].push_back(30);
+  msgpack::sbuffer buf2;
+  msgpack::pack(buf2, m);
+  msgpack::unpacked unpacked2;
+  msgpack::unpack(&unpacked2, buf2.data(), buf2.size());
+  lsh_bucket_table table2;
+  unpacked2.get().convert(&table2);
+  ASSERT_EQ(3u, table2.size());
+  ASSERT_TRUE(table2.find(3) != NULL);
+  EXPECT_EQ(vector<uint64_t>(1, 30), *table2.find(3));
+  EXPECT_EQ(m[2], *table2.find(2));
+}
+
+}  // namespace storage
+}  // namespace core
+}  // namespace jubatus
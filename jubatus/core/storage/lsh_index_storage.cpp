@@ -25,6 +25,7 @@
 #include "jubatus/util/data/unordered_set.h"
 #include "jubatus/util/lang/cast.h"
 #include "jubatus/util/math/random.h"
+#include "../common/exception.hpp"
 #include "lsh_util.hpp"
 
 using std::copy;
@@ -41,6 +42,7 @@ using std::partial_sort;
 using std::lower_bound;
 using jubatus::util::data::unordered_map;
 using jubatus::util::data::unordered_set;
+using jubatus::util::lang::shared_ptr;
 using jubatus::util::math::random::mtrand;
 
 namespace jubatus {
@@ -95,36 +97,69 @@ bit_vector binarize(const vector<float>& hash) {
   return bv;
 }
 
-float calc_euclidean_distance(
-    const lsh_entry& entry,
-    const bit_vector& bv,
-    float norm) {
-  const uint64_t hamm = bv.calc_hamming_similarity(entry.simhash_bv);
-  if (hamm == bv.bit_num()) {
-    // Avoid NaN caused by arithmetic error
-    return std::fabs(norm - entry.norm);
+// Counts matching bits of |num| signatures of |blocks| words each,
+// gathered at the given row ids from |simhashes|.
+void calc_hamming_similarities(
+    const uint64_t* query,
+    const uint64_t* simhashes,
+    size_t blocks,
+    uint64_t bit_num,
+    const uint64_t* row_ids,
+    size_t num,
+    uint32_t* similarities) {
+  for (size_t i = 0; i < num; ++i) {
+    const uint64_t* simhash = simhashes + row_ids[i] * blocks;
+    uint64_t diff = 0;
+    for (size_t j = 0; j < blocks; ++j) {
+      diff += bit_vector::pop_count(query[j] ^ simhash[j]);
+    }
+    similarities[i] = bit_num - diff;
+  }
+}
+
+// Estimates Euclidean distances from norms and cosines of angles.  Plain
+// loop over contiguous arrays, so that the compiler can vectorize it.
+void calc_euclidean_distances(
+    float query_norm,
+    const float* norms,
+    const float* coss,
+    size_t num,
+    float* distances) {
+  for (size_t i = 0; i < num; ++i) {
+    const float dot = norms[i] * query_norm * coss[i];
+    distances[i] = std::sqrt(
+        query_norm * query_norm + norms[i] * norms[i] - 2 * dot);
   }
-  const float angle = (1 - static_cast<float>(hamm) / bv.bit_num()) * M_PI;
-  const float dot = entry.norm * norm * std::cos(angle);
-  return std::sqrt(norm * norm + entry.norm * entry.norm - 2 * dot);
 }
 
+// Appends rows in the bucket which have entries and are not |seen| yet.
 void retrieve_hit_rows_from_table(
     uint64_t hash,
     const lsh_table_t& table,
-    unordered_set<uint64_t>& cands) {
-  lsh_table_t::const_iterator it = table.find(hash);
-  if (it != table.end()) {
-    const vector<uint64_t>& range = it->second;
-    for (size_t j = 0; j < range.size(); ++j) {
-      cands.insert(range[j]);
+    const vector<float>& norms,
+    vector<uint64_t>& seen,
+    vector<uint64_t>& cands) {
+  const lsh_table_t::bucket_t* range = table.find(hash);
+  if (range) {
+    for (size_t j = 0; j < range->size(); ++j) {
+      const uint64_t id = (*range)[j];
+      if (id >= norms.size() || norms[id] < 0) {
+        continue;
+      }
+      const uint64_t mask = 1LLU << (id % 64);
+      if (!(seen[id / 64] & mask)) {
+        seen[id / 64] |= mask;
+        cands.push_back(id);
+      }
     }
   }
 }
 
 }  // namespace
 
-lsh_index_storage::lsh_index_storage() {
+lsh_index_storage::lsh_index_storage()
+    : simhash_blocks_(0) {
+  init_row_cache();
 }
 
 lsh_index_storage::lsh_index_storage(
@@ -132,15 +167,19 @@ lsh_index_storage::lsh_index_storage(
     size_t table_num,
     uint32_t seed)
     : shift_(lsh_num * table_num),
-      table_num_(table_num) {
+      table_num_(table_num),
+      simhash_blocks_(0) {
   initialize_shift(seed, shift_);
+  init_row_cache();
 }
 
 lsh_index_storage::lsh_index_storage(
     size_t table_num,
     const vector<float>& shift)
     : shift_(shift),
-      table_num_(table_num) {
+      table_num_(table_num),
+      simhash_blocks_(0) {
+  init_row_cache();
 }
 
 lsh_index_storage::~lsh_index_storage() {
@@ -165,6 +204,7 @@ void lsh_index_storage::set_row(
       range.insert(it, id);
     }
   }
+  update_row_cache(id, &it->second);
 }
 
 void lsh_index_storage::remove_row(const string& row) {
@@ -175,16 +215,18 @@ void lsh_index_storage::remove_row(const string& row) {
   }
 
   lsh_master_table_t::iterator entry_it = master_table_.find(row);
-  if (entry_it == master_table_.end()) {
+  const lsh_entry* mixing_entry = get_mixing_entry(row);
+  if (entry_it == master_table_.end() && !mixing_entry) {
     // Since the row is not yet mixed, it can be immediately erased.
     master_table_diff_.erase(row);
+    update_row_cache(row_id, NULL);
     return;
   }
 
   // Otherwise, keep the row with empty entry until next MIX.
   master_table_diff_.insert(make_pair(row, lsh_entry()));
-  lsh_entry& entry = entry_it->second;
-  put_empty_entry(row_id, entry);
+  put_empty_entry(row_id, mixing_entry ? *mixing_entry : entry_it->second);
+  update_row_cache(row_id, NULL);
 
   return;
 }
@@ -194,7 +236,10 @@ void lsh_index_storage::clear() {
   lsh_master_table_t().swap(master_table_diff_);
   lsh_table_t().swap(lsh_table_);
   lsh_table_t().swap(lsh_table_diff_);
+  mixing_table_.reset();
   key_manager_.clear();
+  vector<uint64_t>().swap(row_simhash_);
+  vector<float>().swap(row_norm_);
 }
 
 void lsh_index_storage::get_all_row_ids(vector<string>& ids) const {
@@ -217,6 +262,14 @@ void lsh_index_storage::get_all_row_ids(vector<string>& ids) const {
       id_set.insert(it->first);
     }
   }
+  if (mixing_table_) {
+    for (lsh_master_table_t::const_iterator it = mixing_table_->begin();
+        it != mixing_table_->end(); ++it) {
+      if (!it->second.lsh_hash.empty()) {
+        id_set.insert(it->first);
+      }
+    }
+  }
 
   vector<string> ret(id_set.size());
   copy(id_set.begin(), id_set.end(), ret.begin());
@@ -233,12 +286,13 @@ void lsh_index_storage::similar_row(
   const bit_vector bv = binarize(hash);
 
   lsh_probe_generator gen(shifted, table_num_);
-  unordered_set<uint64_t> cands;
+  vector<uint64_t> seen((row_norm_.size() + 63) / 64);
+  vector<uint64_t> cands;
 
   for (uint64_t i = 0; i < table_num_; ++i) {
     lsh_vector key = gen.base(i);
     key.push_back(i);
-    if (retrieve_hit_rows(hash_lv(key), ret_num, cands)) {
+    if (retrieve_hit_rows(hash_lv(key), ret_num, seen, cands)) {
       get_sorted_similar_rows(cands, bv, norm, ret_num, ids);
       return;
     }
@@ -248,7 +302,7 @@ void lsh_index_storage::similar_row(
   for (uint64_t i = 0; i < probe_num; ++i) {
     pair<size_t, lsh_vector> p = gen.get_next_table_and_vector();
     p.second.push_back(p.first);
-    if (retrieve_hit_rows(hash_lv(p.second), ret_num, cands)) {
+    if (retrieve_hit_rows(hash_lv(p.second), ret_num, seen, cands)) {
       break;
     }
   }
@@ -259,24 +313,22 @@ void lsh_index_storage::similar_row(
     const string& id,
     uint64_t ret_num,
     vector<pair<string, float> >& ids) const {
-  lsh_master_table_t::const_iterator it = master_table_diff_.find(id);
-  if (it == master_table_diff_.end()) {
-    it = master_table_.find(id);
-    if (it == master_table_.end()) {
-      return;
-    }
+  const lsh_entry* entry = get_lsh_entry(id);
+  if (!entry) {
+    return;
   }
 
-  unordered_set<uint64_t> cands;
-  for (size_t i = 0; i < it->second.lsh_hash.size(); ++i) {
-    if (retrieve_hit_rows(it->second.lsh_hash[i], ret_num, cands)) {
+  vector<uint64_t> seen((row_norm_.size() + 63) / 64);
+  vector<uint64_t> cands;
+  for (size_t i = 0; i < entry->lsh_hash.size(); ++i) {
+    if (retrieve_hit_rows(entry->lsh_hash[i], ret_num, seen, cands)) {
       break;
     }
   }
 
   get_sorted_similar_rows(cands,
-                          it->second.simhash_bv,
-                          it->second.norm,
+                          entry->simhash_bv,
+                          entry->norm,
                           ret_num, ids);
 }
 
@@ -293,7 +345,15 @@ void lsh_index_storage::unpack(msgpack::object o) {
 }
 
 void lsh_index_storage::get_diff(lsh_master_table_t& diff) const {
-  diff = master_table_diff_;
+  if (!mixing_table_) {
+    diff = master_table_diff_;
+    return;
+  }
+  diff = *mixing_table_;
+  for (lsh_master_table_t::const_iterator it = master_table_diff_.begin();
+       it != master_table_diff_.end(); ++it) {
+    diff[it->first] = it->second;
+  }
 }
 
 bool lsh_index_storage::put_diff(
@@ -309,14 +369,63 @@ bool lsh_index_storage::put_diff(
     }
   }
 
-  master_table_diff_.clear();
+  lsh_master_table_t old_diff;
+  if (mixing_table_) {
+    // updates after freeze_diff() are left for the next MIX; lsh_table_diff_
+    // is rebuilt to hold only them
+    old_diff = *mixing_table_;
+    mixing_table_.reset();
+    lsh_table_diff_.clear();
+    for (lsh_master_table_t::const_iterator it = master_table_diff_.begin();
+         it != master_table_diff_.end(); ++it) {
+      const uint64_t row_id = key_manager_.get_id(it->first);
+      const vector<uint64_t>& lsh_hash = it->second.lsh_hash;
+      for (size_t i = 0; i < lsh_hash.size(); ++i) {
+        vector<uint64_t>& range = lsh_table_diff_[lsh_hash[i]];
+        range.insert(lower_bound(range.begin(), range.end(), row_id), row_id);
+      }
+    }
+  } else {
+    old_diff.swap(master_table_diff_);
+
+    // lsh_table_diff_ is actually not MIXed, but must be cleared as well as
+    // diff of usual model.
+    lsh_table_diff_.clear();
+  }
 
-  // lsh_table_diff_ is actually not MIXed, but must be cleared as well as diff
-  // of usual model.
-  lsh_table_diff_.clear();
+  for (lsh_master_table_t::const_iterator it = diff.begin(); it != diff.end();
+      ++it) {
+    update_row_cache(it->first);
+  }
+  for (lsh_master_table_t::const_iterator it = old_diff.begin();
+      it != old_diff.end(); ++it) {
+    update_row_cache(it->first);
+  }
   return true;
 }
 
+shared_ptr<const lsh_master_table_t> lsh_index_storage::freeze_diff() {
+  shared_ptr<lsh_master_table_t> frozen(new lsh_master_table_t);
+  if (mixing_table_) {
+    // previous MIX did not finish; mix both of them
+    get_diff(*frozen);
+    master_table_diff_.clear();
+  } else {
+    frozen->swap(master_table_diff_);
+  }
+  mixing_table_ = frozen;
+  return mixing_table_;
+}
+
+void lsh_index_storage::abort_diff() {
+  if (!mixing_table_) {
+    return;
+  }
+  // newer updates take precedence; lsh_table_diff_ still has all the rows
+  master_table_diff_.insert(mixing_table_->begin(), mixing_table_->end());
+  mixing_table_.reset();
+}
+
 void lsh_index_storage::mix(
     const lsh_master_table_t& lhs,
     lsh_master_table_t& rhs) const {
@@ -337,15 +446,21 @@ lsh_master_table_t::iterator lsh_index_storage::remove_and_get_row(
 
   lsh_master_table_t::iterator entry_it = master_table_diff_.find(row);
   lsh_master_table_t::iterator ret_it = entry_it;
+  const lsh_entry* entry = NULL;
   if (entry_it == master_table_diff_.end()) {
     ret_it = master_table_diff_.insert(make_pair(row, lsh_entry())).first;
-    entry_it = master_table_.find(row);
-    if (entry_it == master_table_.end()) {
-      return ret_it;
+    entry = get_mixing_entry(row);
+    if (!entry) {
+      entry_it = master_table_.find(row);
+      if (entry_it == master_table_.end()) {
+        return ret_it;
+      }
+      entry = &entry_it->second;
     }
+  } else {
+    entry = &entry_it->second;
   }
-  lsh_entry& entry = entry_it->second;
-  put_empty_entry(row_id, entry);
+  put_empty_entry(row_id, *entry);
 
   return ret_it;
 }
@@ -354,16 +469,15 @@ void lsh_index_storage::put_empty_entry(
     uint64_t row_id,
     const lsh_entry& entry) {
   for (size_t i = 0; i < entry.lsh_hash.size(); ++i) {
-    lsh_table_t::iterator it = lsh_table_diff_.find(entry.lsh_hash[i]);
-    if (it != lsh_table_diff_.end()) {
-      vector<uint64_t>& range = it->second;
-      vector<uint64_t>::iterator jt = lower_bound(range.begin(),
-                                                  range.end(),
+    vector<uint64_t>* range = lsh_table_diff_.find(entry.lsh_hash[i]);
+    if (range) {
+      vector<uint64_t>::iterator jt = lower_bound(range->begin(),
+                                                  range->end(),
                                                   row_id);
-      if (jt != range.end() && row_id == *jt) {
-        range.erase(jt);
-        if (range.empty()) {
-          lsh_table_diff_.erase(it);
+      if (jt != range->end() && row_id == *jt) {
+        range->erase(jt);
+        if (range->empty()) {
+          lsh_table_diff_.erase(entry.lsh_hash[i]);
         }
       }
     }
@@ -400,14 +514,14 @@ void lsh_index_storage::remove_model_row(const std::string& row) {
 
   const uint64_t row_id = key_manager_.get_id_const(row);
   for (size_t i = 0; i < entry->lsh_hash.size(); ++i) {
-    lsh_table_t::iterator it = lsh_table_.find(entry->lsh_hash[i]);
-    if (it != lsh_table_.end()) {
-      vector<uint64_t>& range = it->second;
-      vector<uint64_t>::iterator jt = find(range.begin(), range.end(), row_id);
-      if (jt != range.end()) {
-        range.erase(jt);
-        if (range.empty()) {
-          lsh_table_.erase(it);
+    vector<uint64_t>* range = lsh_table_.find(entry->lsh_hash[i]);
+    if (range) {
+      vector<uint64_t>::iterator jt = find(range->begin(), range->end(),
+                                           row_id);
+      if (jt != range->end()) {
+        range->erase(jt);
+        if (range->empty()) {
+          lsh_table_.erase(entry->lsh_hash[i]);
         }
       }
     }
@@ -427,30 +541,56 @@ void lsh_index_storage::set_mixed_row(
 bool lsh_index_storage::retrieve_hit_rows(
     uint64_t hash,
     size_t ret_num,
-    unordered_set<uint64_t>& cands) const {
-  retrieve_hit_rows_from_table(hash, lsh_table_diff_, cands);
-  retrieve_hit_rows_from_table(hash, lsh_table_, cands);
+    vector<uint64_t>& seen,
+    vector<uint64_t>& cands) const {
+  retrieve_hit_rows_from_table(hash, lsh_table_diff_, row_norm_, seen, cands);
+  retrieve_hit_rows_from_table(hash, lsh_table_, row_norm_, seen, cands);
   return cands.size() >= static_cast<uint64_t>(ret_num);
 }
 
 void lsh_index_storage::get_sorted_similar_rows(
-    const unordered_set<uint64_t>& cands,
+    const vector<uint64_t>& cands,
     const bit_vector& query_simhash,
     float query_norm,
     uint64_t ret_num,
     vector<pair<string, float> >& ids) const {
   // Avoid string copy as far as possible
-  vector<pair<uint64_t, float> > scored;
-  scored.reserve(cands.size());
-  for (unordered_set<uint64_t>::const_iterator it = cands.begin();
-      it != cands.end(); ++it) {
-    const lsh_entry* entry = get_lsh_entry(key_manager_.get_key(*it));
-    if (!entry || entry->lsh_hash.empty()) {
-      continue;
+  const vector<uint64_t>& row_ids = cands;
+  const size_t num = row_ids.size();
+  vector<float> norms(num);
+  for (size_t i = 0; i < num; ++i) {
+    norms[i] = row_norm_[row_ids[i]];
+  }
+
+  vector<pair<uint64_t, float> > scored(num);
+  if (num > 0) {
+    const uint64_t bit_num = cos_table_.size() - 1;
+    if (query_simhash.bit_num() != bit_num) {
+      throw JUBATUS_EXCEPTION(common::exception::runtime_error(
+          "unexpected hash length: " +
+          jubatus::util::lang::lexical_cast<string>(query_simhash.bit_num())));
+    }
+
+    vector<uint32_t> similarities(num);
+    calc_hamming_similarities(
+        &query_simhash.blocks()[0], &row_simhash_[0], simhash_blocks_,
+        bit_num, &row_ids[0], num, &similarities[0]);
+
+    vector<float> coss(num);
+    for (size_t i = 0; i < num; ++i) {
+      coss[i] = cos_table_[similarities[i]];
+    }
+    vector<float> distances(num);
+    calc_euclidean_distances(query_norm, &norms[0], &coss[0], num,
+                             &distances[0]);
+
+    for (size_t i = 0; i < num; ++i) {
+      if (similarities[i] == bit_num) {
+        // Avoid NaN caused by arithmetic error
+        distances[i] = std::fabs(query_norm - norms[i]);
+      }
+      scored[i] = make_pair(row_ids[i], -distances[i]);
     }
-    const float dist = calc_euclidean_distance(*entry, query_simhash,
-                                               query_norm);
-    scored.push_back(make_pair(*it, -dist));
   }
 
   if (scored.size() <= ret_num) {
@@ -469,9 +609,78 @@ void lsh_index_storage::get_sorted_similar_rows(
   }
 }
 
+void lsh_index_storage::init_row_cache() {
+  const uint64_t bit_num = shift_.size();
+  simhash_blocks_ = (bit_num + 63) / 64;
+  cos_table_.resize(bit_num + 1, 1);
+  for (uint64_t hamm = 0; hamm < bit_num; ++hamm) {
+    const float angle = (1 - static_cast<float>(hamm) / bit_num) * M_PI;
+    cos_table_[hamm] = std::cos(angle);
+  }
+}
+
+void lsh_index_storage::rebuild_row_cache() {
+  init_row_cache();
+  vector<uint64_t>().swap(row_simhash_);
+  vector<float>().swap(row_norm_);
+  for (lsh_master_table_t::const_iterator it = master_table_.begin();
+       it != master_table_.end(); ++it) {
+    update_row_cache(it->first);
+  }
+  for (lsh_master_table_t::const_iterator it = master_table_diff_.begin();
+       it != master_table_diff_.end(); ++it) {
+    update_row_cache(it->first);
+  }
+}
+
+void lsh_index_storage::update_row_cache(const string& row) {
+  const uint64_t row_id = key_manager_.get_id_const(row);
+  if (row_id != common::key_manager::NOTFOUND) {
+    update_row_cache(row_id, get_lsh_entry(row));
+  }
+}
+
+void lsh_index_storage::update_row_cache(
+    uint64_t row_id,
+    const lsh_entry* entry) {
+  if (row_id >= row_norm_.size()) {
+    if (!entry || entry->lsh_hash.empty()) {
+      return;
+    }
+    const size_t size = std::max(row_id + 1, row_norm_.size() * 2);
+    row_norm_.resize(size, -1);
+    row_simhash_.resize(size * simhash_blocks_, 0);
+  }
+
+  uint64_t* simhash = &row_simhash_[row_id * simhash_blocks_];
+  std::fill(simhash, simhash + simhash_blocks_, 0);
+  if (!entry || entry->lsh_hash.empty()) {
+    row_norm_[row_id] = -1;
+    return;
+  }
+  const vector<uint64_t>& blocks = entry->simhash_bv.blocks();
+  copy(blocks.begin(),
+       blocks.begin() + std::min(blocks.size(), simhash_blocks_),
+       simhash);
+  row_norm_[row_id] = entry->norm;
+}
+
+const lsh_entry* lsh_index_storage::get_mixing_entry(
+    const string& row) const {
+  if (!mixing_table_) {
+    return NULL;
+  }
+  lsh_master_table_t::const_iterator it = mixing_table_->find(row);
+  return it == mixing_table_->end() ? NULL : &it->second;
+}
+
 const lsh_entry* lsh_index_storage::get_lsh_entry(const string& row) const {
   lsh_master_table_t::const_iterator it = master_table_diff_.find(row);
   if (it == master_table_diff_.end()) {
+    const lsh_entry* mixing_entry = get_mixing_entry(row);
+    if (mixing_entry) {
+      return mixing_entry;
+    }
     it = master_table_.find(row);
     if (it == master_table_.end()) {
       return 0;
@@ -23,7 +23,8 @@
 #include <vector>
 #include <msgpack.hpp>
 #include "jubatus/util/data/unordered_map.h"
-#include "jubatus/util/data/unordered_set.h"
+#include "jubatus/util/lang/shared_ptr.h"
+#include "lsh_bucket_table.hpp"
 #include "lsh_vector.hpp"
 #include "storage_type.hpp"
 #include "../common/key_manager.hpp"
@@ -45,8 +46,7 @@ struct lsh_entry {
 typedef jubatus::util::data::unordered_map<std::string, lsh_entry>
   lsh_master_table_t;
 
-typedef jubatus::util::data::unordered_map<uint64_t, std::vector<uint64_t> >
-  lsh_table_t;
+typedef lsh_bucket_table lsh_table_t;
 
 class lsh_index_storage {
  public:
@@ -90,12 +90,36 @@ class lsh_index_storage {
   void pack(framework::packer& packer) const;
   void unpack(msgpack::object o);
 
+  // get_diff returns the frozen diff (if any) and the current diff.
   void get_diff(lsh_master_table_t& diff) const;
   bool put_diff(const lsh_master_table_t& mixed_diff);
   void mix(const lsh_master_table_t& lhs, lsh_master_table_t& rhs) const;
 
-  MSGPACK_DEFINE(master_table_, master_table_diff_, lsh_table_,
-      lsh_table_diff_, shift_, table_num_, key_manager_);
+  // see framework::linear_mixable::freeze_diff
+  jubatus::util::lang::shared_ptr<const lsh_master_table_t> freeze_diff();
+  void abort_diff();
+
+  template<class Packer>
+  void msgpack_pack(Packer& packer) const {
+    if (!mixing_table_) {
+      msgpack::type::make_define(master_table_, master_table_diff_,
+          lsh_table_, lsh_table_diff_, shift_, table_num_, key_manager_)
+          .msgpack_pack(packer);
+    } else {
+      lsh_master_table_t diff;
+      get_diff(diff);
+      msgpack::type::make_define(master_table_, diff,
+          lsh_table_, lsh_table_diff_, shift_, table_num_, key_manager_)
+          .msgpack_pack(packer);
+    }
+  }
+  void msgpack_unpack(msgpack::object o) {
+    msgpack::type::make_define(master_table_, master_table_diff_, lsh_table_,
+        lsh_table_diff_, shift_, table_num_, key_manager_)
+        .msgpack_unpack(o);
+    mixing_table_.reset();
+    rebuild_row_cache();
+  }
 
  private:
   lsh_master_table_t::iterator remove_and_get_row(const std::string& row);
@@ -109,20 +133,30 @@ class lsh_index_storage {
   bool retrieve_hit_rows(
       uint64_t hash,
       size_t ret_num,
-      jubatus::util::data::unordered_set<uint64_t>& cands) const;
+      std::vector<uint64_t>& seen,
+      std::vector<uint64_t>& cands) const;
 
   void get_sorted_similar_rows(
-      const jubatus::util::data::unordered_set<uint64_t>& cands,
+      const std::vector<uint64_t>& cands,
       const bit_vector& query_simhash,
       float query_norm,
       uint64_t ret_num,
       std::vector<std::pair<std::string, float> >& ids) const;
   const lsh_entry* get_lsh_entry(const std::string& row) const;
+  const lsh_entry* get_mixing_entry(const std::string& row) const;
   void remove_model_row(const std::string& row);
   void set_mixed_row(const std::string& row, const lsh_entry& entry);
 
+  void init_row_cache();
+  void rebuild_row_cache();
+  void update_row_cache(const std::string& row);
+  void update_row_cache(uint64_t row_id, const lsh_entry* entry);
+
   lsh_master_table_t master_table_;
   lsh_master_table_t master_table_diff_;
+  // diff being mixed; rows in |master_table_diff_| take precedence over it.
+  // Its rows stay in |lsh_table_diff_| until put_diff().
+  jubatus::util::lang::shared_ptr<const lsh_master_table_t> mixing_table_;
 
   lsh_table_t lsh_table_;
   lsh_table_t lsh_table_diff_;
@@ -130,10 +164,19 @@ class lsh_index_storage {
   std::vector<float> shift_;
   uint64_t table_num_;
   common::key_manager key_manager_;
+
+  // Simhash blocks and norms of the current entry of each row, laid out
+  // contiguously by row id for re-ranking; not serialized.  A negative
+  // norm marks a row without an entry.
+  std::vector<uint64_t> row_simhash_;
+  std::vector<float> row_norm_;
+  size_t simhash_blocks_;
+  // cos of the angle estimated from each number of matching simhash bits
+  std::vector<float> cos_table_;
 };
 
-typedef framework::linear_mixable_helper<lsh_index_storage, lsh_master_table_t>
-    mixable_lsh_index_storage;
+typedef framework::double_buffered_mixable_helper<
+    lsh_index_storage, lsh_master_table_t> mixable_lsh_index_storage;
 
 }  // namespace storage
 }  // namespace core
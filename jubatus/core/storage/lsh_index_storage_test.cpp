@@ -23,6 +23,7 @@
 #include <vector>
 #include <gtest/gtest.h>
 #include "lsh_index_storage.hpp"
+#include "../framework/stream_writer.hpp"
 
 using std::istringstream;
 using std::make_pair;
@@ -409,6 +410,90 @@ TEST(lsh_index_storage, row_operations) {
   EXPECT_EQ("r3", ids[0]);
 }
 
+TEST(lsh_index_storage, similar_row_after_mix_and_unpack) {
+  lsh_index_storage s(4, 2, 0);
+  s.set_row("r1", make_hash("1 2 3 4 1 2 3 4"), 1);
+  s.set_row("r2", make_hash("1 1 2 3 1 1 2 3"), 2);
+  s.set_row("r3", make_hash("1 1 1 2 1 1 1 2"), 3);
+
+  lsh_master_table_t d1;
+  s.get_diff(d1);
+  s.put_diff(d1);
+  // removed after MIX; must not appear even though it is still in buckets
+  s.remove_row("r2");
+  s.set_row("r3", make_hash("1 2 3 4 1 2 3 4"), 1.5);
+
+  vector<pair<string, float> > res;
+  s.similar_row(make_hash("1 2 3 4 1 2 3 4"), 1, 0, 10, res);
+  ASSERT_EQ(2u, res.size());
+  EXPECT_EQ("r1", res[0].first);
+  EXPECT_FLOAT_EQ(0, res[0].second);
+  EXPECT_EQ("r3", res[1].first);
+  EXPECT_FLOAT_EQ(-0.5, res[1].second);
+
+  msgpack::sbuffer buf;
+  {
+    framework::stream_writer<msgpack::sbuffer> st(buf);
+    framework::jubatus_packer jp(st);
+    framework::packer packer(jp);
+    s.pack(packer);
+  }
+  lsh_index_storage s2;
+  msgpack::unpacked unpacked;
+  msgpack::unpack(&unpacked, buf.data(), buf.size());
+  s2.unpack(unpacked.get());
+
+  vector<pair<string, float> > res2;
+  s2.similar_row(make_hash("1 2 3 4 1 2 3 4"), 1, 0, 10, res2);
+  ASSERT_EQ(res.size(), res2.size());
+  for (size_t i = 0; i < res.size(); ++i) {
+    EXPECT_EQ(res[i].first, res2[i].first);
+    EXPECT_FLOAT_EQ(res[i].second, res2[i].second);
+  }
+}
+
+TEST(lsh_index_storage, update_while_mixing) {
+  const vector<float> h1 = make_hash("1 2 3 4 1 2 3 4");
+  lsh_index_storage s(4, 2, 0);
+  s.set_row("r1", h1, 1);
+  s.set_row("r2", h1, 2);
+  jubatus::util::lang::shared_ptr<const lsh_master_table_t> frozen =
+      s.freeze_diff();
+  ASSERT_EQ(2u, frozen->size());
+
+  // frozen rows are still visible and can be updated
+  s.remove_row("r1");
+  s.set_row("r3", h1, 3);
+  vector<pair<string, float> > res;
+  s.similar_row(h1, 1, 0, 10, res);
+  ASSERT_EQ(2u, res.size());
+  EXPECT_EQ("r2", res[0].first);
+  EXPECT_EQ("r3", res[1].first);
+
+  s.put_diff(*frozen);
+  lsh_master_table_t d;
+  s.get_diff(d);
+  ASSERT_EQ(2u, d.size());
+  EXPECT_TRUE(d["r1"].lsh_hash.empty());
+  EXPECT_FALSE(d["r3"].lsh_hash.empty());
+
+  res.clear();
+  s.similar_row(h1, 1, 0, 10, res);
+  ASSERT_EQ(2u, res.size());
+  EXPECT_EQ("r2", res[0].first);
+  EXPECT_EQ("r3", res[1].first);
+
+  // abort merges the frozen diff back
+  s.freeze_diff();
+  s.abort_diff();
+  d.clear();
+  s.get_diff(d);
+  EXPECT_EQ(2u, d.size());
+  res.clear();
+  s.similar_row(h1, 1, 0, 10, res);
+  EXPECT_EQ(2u, res.size());
+}
+
 }  // namespace storage
 }  // namespace core
 }  // namespace jubatus
@@ -101,6 +101,18 @@ void sparse_matrix_storage::get_row(
   }
 }
 
+bool sparse_matrix_storage::accumulate_row(
+    const string& row,
+    vector<pair<uint64_t, float> >& acc) const {
+  tbl_t::const_iterator it = tbl_.find(row);
+  if (it == tbl_.end() || it->second.empty()) {
+    return false;
+  }
+  const row_t& row_v = it->second;
+  acc.insert(acc.end(), row_v.begin(), row_v.end());
+  return true;
+}
+
 float sparse_matrix_storage::calc_l2norm(const string& row) const {
   tbl_t::const_iterator it = tbl_.find(row);
   if (it == tbl_.end()) {
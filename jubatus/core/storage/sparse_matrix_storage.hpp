@@ -24,14 +24,14 @@
 #include "jubatus/util/data/unordered_map.h"
 #include "../common/key_manager.hpp"
 #include "../common/unordered_map.hpp"
-#include "../framework/model.hpp"
+#include "sparse_matrix_storage_base.hpp"
 #include "storage_type.hpp"
 
 namespace jubatus {
 namespace core {
 namespace storage {
 
-class sparse_matrix_storage : public framework::model {
+class sparse_matrix_storage : public sparse_matrix_storage_base {
  public:
   sparse_matrix_storage();
   ~sparse_matrix_storage();
@@ -48,6 +48,13 @@ class sparse_matrix_storage : public framework::model {
       const std::string& row,
       std::vector<std::pair<std::string, float> >& columns) const;
 
+  bool accumulate_row(
+      const std::string& row,
+      std::vector<std::pair<uint64_t, float> >& acc) const;
+  const std::string& get_column_key(uint64_t id) const {
+    return column2id_.get_key(id);
+  }
+
   float calc_l2norm(const std::string& row) const;
   void remove(const std::string& row, const std::string& column);
   void remove_row(const std::string& row);
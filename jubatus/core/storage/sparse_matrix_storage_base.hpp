@@ -0,0 +1,72 @@
+// Jubatus: Online machine learning framework for distributed environment
+// Copyright (C) 2015 Preferred Networks and Nippon Telegraph and Telephone Corporation.
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License version 2.1 as published by the Free Software Foundation.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+
+#ifndef JUBATUS_CORE_STORAGE_SPARSE_MATRIX_STORAGE_BASE_HPP_
+#define JUBATUS_CORE_STORAGE_SPARSE_MATRIX_STORAGE_BASE_HPP_
+
+#include <stdint.h>
+#include <string>
+#include <utility>
+#include <vector>
+#include "../framework/model.hpp"
+#include "storage_type.hpp"
+
+namespace jubatus {
+namespace core {
+namespace storage {
+
+// Row-oriented table of sparse vectors.  Recommenders keep their raw rows in
+// it; column names are mapped to internal integer ids by the storage.
+class sparse_matrix_storage_base : public framework::model {
+ public:
+  virtual ~sparse_matrix_storage_base() {
+  }
+
+  virtual void set(
+      const std::string& row, const std::string& column, float val) = 0;
+  // Overwrites the given columns of `row`; other columns are kept.
+  virtual void set_row(
+      const std::string& row,
+      const std::vector<std::pair<std::string, float> >& columns) = 0;
+
+  virtual float get(
+      const std::string& row, const std::string& column) const = 0;
+  virtual void get_row(
+      const std::string& row,
+      std::vector<std::pair<std::string, float> >& columns) const = 0;
+
+  // Appends the columns of `row` to `acc` keyed by internal column id,
+  // without decoding column names.  Returns false if the row is empty.
+  virtual bool accumulate_row(
+      const std::string& row,
+      std::vector<std::pair<uint64_t, float> >& acc) const = 0;
+  virtual const std::string& get_column_key(uint64_t id) const = 0;
+
+  virtual float calc_l2norm(const std::string& row) const = 0;
+  virtual void remove(const std::string& row, const std::string& column) = 0;
+  virtual void remove_row(const std::string& row) = 0;
+  virtual void get_all_row_ids(std::vector<std::string>& ids) const = 0;
+  virtual void clear() = 0;
+
+  virtual storage::version get_version() const = 0;
+};
+
+}  // namespace storage
+}  // namespace core
+}  // namespace jubatus
+
+#endif  // JUBATUS_CORE_STORAGE_SPARSE_MATRIX_STORAGE_BASE_HPP_
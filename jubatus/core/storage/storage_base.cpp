@@ -77,6 +77,14 @@ bool storage_base::set_average_and_clear_diff(const diff_t&) {
   return true;
 }
 
+jubatus::util::lang::shared_ptr<const frozen_diff>
+storage_base::freeze_diff() {
+  return jubatus::util::lang::shared_ptr<const frozen_diff>();
+}
+
+void storage_base::abort_diff() {
+}
+
 }  // namespace storage
 }  // namespace core
 }  // namespace jubatus
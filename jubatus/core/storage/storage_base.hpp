@@ -34,6 +34,16 @@ namespace jubatus {
 namespace core {
 namespace storage {
 
+// Diff moved aside by storage_base::freeze_diff().  It is immutable, so it
+// can be converted without the model lock.
+class frozen_diff {
+ public:
+  virtual ~frozen_diff() {
+  }
+
+  virtual void get_diff(diff_t& ret) const = 0;
+};
+
 class storage_base : public framework::model {
  public:
   virtual ~storage_base() {
@@ -81,6 +91,11 @@ class storage_base : public framework::model {
   virtual void get_diff(diff_t&) const;
   virtual bool set_average_and_clear_diff(const diff_t&);
 
+  // Double buffering of the diff (see framework::linear_mixable).  Returns
+  // an empty pointer if not supported.
+  virtual jubatus::util::lang::shared_ptr<const frozen_diff> freeze_diff();
+  virtual void abort_diff();
+
   virtual void register_label(const std::string& label) = 0;
 
   virtual void clear() = 0;
@@ -0,0 +1,121 @@
+// Jubatus: Online machine learning framework for distributed environment
+// Copyright (C) 2015 Preferred Networks and Nippon Telegraph and Telephone Corporation.
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License version 2.1 as published by the Free Software Foundation.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+#ifndef JUBATUS_CORE_STORAGE_WEIGHT_ACCESSOR_HPP_
+#define JUBATUS_CORE_STORAGE_WEIGHT_ACCESSOR_HPP_
+
+#include <stdint.h>
+#include <string>
+#include "../common/key_manager.hpp"
+#include "storage_base.hpp"
+
+namespace jubatus {
+namespace core {
+namespace storage {
+
+// Reads and writes, feature by feature, the weights of the two labels a
+// linear learner updates for an example (the correct one and the most
+// confusing one).
+//
+// The primary template is instantiated on concrete storages which provide
+// non-virtual accessors by label id (find_label_id, get_label_id, get2_by_id
+// and set2_by_id): label ids are resolved once per example and no vector is
+// built per feature.  weight_accessor<storage_base> is the fallback through
+// the virtual interface.
+template <class Storage>
+class weight_accessor {
+ public:
+  // |label2| may be empty; it is then never written.
+  weight_accessor(
+      Storage& storage,
+      const std::string& label1,
+      const std::string& label2)
+      : storage_(storage),
+        label1_(label1),
+        label2_(label2),
+        id1_(storage.find_label_id(label1)),
+        id2_(label2 == "" ? common::key_manager::NOTFOUND
+                          : storage.find_label_id(label2)) {
+  }
+
+  // Overwrites |w1| and |w2| with the weights of |feature| for each label
+  // the storage has a weight of.
+  void get2(const std::string& feature, val2_t& w1, val2_t& w2) const {
+    storage_.get2_by_id(feature, id1_, w1, id2_, w2);
+  }
+
+  // Labels are registered to the storage on the first write.
+  void set2(const std::string& feature, const val2_t& w1, const val2_t& w2) {
+    if (id1_ == common::key_manager::NOTFOUND) {
+      id1_ = storage_.get_label_id(label1_);
+    }
+    if (id2_ == common::key_manager::NOTFOUND && label2_ != "") {
+      id2_ = storage_.get_label_id(label2_);
+    }
+    storage_.set2_by_id(feature, id1_, w1, id2_, w2);
+  }
+
+ private:
+  Storage& storage_;
+  const std::string label1_;
+  const std::string label2_;
+  uint64_t id1_;
+  uint64_t id2_;
+};
+
+template <>
+class weight_accessor<storage_base> {
+ public:
+  weight_accessor(
+      storage_base& storage,
+      const std::string& label1,
+      const std::string& label2)
+      : storage_(storage),
+        label1_(label1),
+        label2_(label2) {
+  }
+
+  void get2(const std::string& feature, val2_t& w1, val2_t& w2) const {
+    // |buf_| is reused so that its capacity is allocated only once.
+    storage_.get2(feature, buf_);
+    for (size_t i = 0; i < buf_.size(); ++i) {
+      if (buf_[i].first == label1_) {
+        w1 = buf_[i].second;
+      } else if (buf_[i].first == label2_) {
+        w2 = buf_[i].second;
+      }
+    }
+  }
+
+  void set2(const std::string& feature, const val2_t& w1, const val2_t& w2) {
+    storage_.set2(feature, label1_, w1);
+    if (label2_ != "") {
+      storage_.set2(feature, label2_, w2);
+    }
+  }
+
+ private:
+  storage_base& storage_;
+  const std::string label1_;
+  const std::string label2_;
+  mutable feature_val2_t buf_;
+};
+
+}  // namespace storage
+}  // namespace core
+}  // namespace jubatus
+
+#endif  // JUBATUS_CORE_STORAGE_WEIGHT_ACCESSOR_HPP_
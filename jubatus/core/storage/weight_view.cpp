@@ -0,0 +1,322 @@
+// Jubatus: Online machine learning framework for distributed environment
+// Copyright (C) 2015 Preferred Networks and Nippon Telegraph and Telephone Corporation.
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License version 2.1 as published by the Free Software Foundation.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+#include "weight_view.hpp"
+
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+#include "jubatus/util/lang/cast.h"
+#include "../common/exception.hpp"
+
+using std::string;
+using std::vector;
+
+namespace jubatus {
+namespace core {
+namespace storage {
+
+namespace {
+
+enum cell_state {
+  CELL_ABSENT = 0,
+  CELL_LOADED = 1,
+  CELL_WRITTEN = 2
+};
+
+}  // namespace
+
+weight_view::weight_view(
+    const storage_base& base,
+    const vector<string>& features,
+    const vector<string>& labels) {
+  vector<string> known = base.get_labels();
+  for (size_t i = 0; i < known.size(); ++i) {
+    label2id_.insert(std::make_pair(known[i], labels_.size()));
+    labels_.push_back(known[i]);
+    active_.push_back(1);
+  }
+  for (size_t i = 0; i < labels.size(); ++i) {
+    if (label2id_.insert(std::make_pair(labels[i], labels_.size())).second) {
+      labels_.push_back(labels[i]);
+      active_.push_back(0);
+    }
+  }
+  for (size_t i = 0; i < features.size(); ++i) {
+    if (feature2id_.insert(
+            std::make_pair(features[i], features_.size())).second) {
+      features_.push_back(features[i]);
+    }
+  }
+
+  weights_.resize(features_.size() * labels_.size());
+  state_.resize(weights_.size(), CELL_ABSENT);
+
+  feature_val3_t row;
+  for (size_t f = 0; f < features_.size(); ++f) {
+    base.get3(features_[f], row);
+    for (size_t i = 0; i < row.size(); ++i) {
+      index_t::const_iterator it = label2id_.find(row[i].first);
+      if (it == label2id_.end()) {
+        continue;
+      }
+      cell(f, it->second) = row[i].second;
+      state_[f * labels_.size() + it->second] = CELL_LOADED;
+    }
+  }
+}
+
+weight_view::~weight_view() {
+}
+
+size_t weight_view::feature_index(const string& feature) const {
+  index_t::const_iterator it = feature2id_.find(feature);
+  return it == feature2id_.end() ? NOTFOUND : it->second;
+}
+
+size_t weight_view::writable_feature_index(const string& feature) const {
+  size_t id = feature_index(feature);
+  if (id == NOTFOUND) {
+    throw JUBATUS_EXCEPTION(storage_exception(
+        "feature is not covered by the weight view: " + feature));
+  }
+  return id;
+}
+
+size_t weight_view::label_index(const string& label) const {
+  index_t::const_iterator it = label2id_.find(label);
+  if (it == label2id_.end()) {
+    throw JUBATUS_EXCEPTION(storage_exception(
+        "label is not covered by the weight view: " + label));
+  }
+  return it->second;
+}
+
+val3_t& weight_view::cell(size_t feature_id, size_t label_id) {
+  return weights_[feature_id * labels_.size() + label_id];
+}
+
+const val3_t& weight_view::cell(size_t feature_id, size_t label_id) const {
+  return weights_[feature_id * labels_.size() + label_id];
+}
+
+val3_t& weight_view::touch_cell(size_t feature_id, size_t label_id) {
+  // Plain stores: concurrent writers may overwrite each other (Hogwild!).
+  active_[label_id] = 1;
+  state_[feature_id * labels_.size() + label_id] = CELL_WRITTEN;
+  return cell(feature_id, label_id);
+}
+
+void weight_view::get(const string& feature, feature_val1_t& ret) const {
+  ret.clear();
+  size_t f = feature_index(feature);
+  if (f == NOTFOUND) {
+    return;
+  }
+  for (size_t l = 0; l < labels_.size(); ++l) {
+    if (state_[f * labels_.size() + l] != CELL_ABSENT) {
+      ret.push_back(make_pair(labels_[l], cell(f, l).v1));
+    }
+  }
+}
+
+void weight_view::get2(const string& feature, feature_val2_t& ret) const {
+  ret.clear();
+  size_t f = feature_index(feature);
+  if (f == NOTFOUND) {
+    return;
+  }
+  for (size_t l = 0; l < labels_.size(); ++l) {
+    if (state_[f * labels_.size() + l] != CELL_ABSENT) {
+      const val3_t& w = cell(f, l);
+      ret.push_back(make_pair(labels_[l], val2_t(w.v1, w.v2)));
+    }
+  }
+}
+
+void weight_view::get3(const string& feature, feature_val3_t& ret) const {
+  ret.clear();
+  size_t f = feature_index(feature);
+  if (f == NOTFOUND) {
+    return;
+  }
+  for (size_t l = 0; l < labels_.size(); ++l) {
+    if (state_[f * labels_.size() + l] != CELL_ABSENT) {
+      ret.push_back(make_pair(labels_[l], cell(f, l)));
+    }
+  }
+}
+
+void weight_view::inp(const common::sfv_t& sfv,
+                      map_feature_val1_t& ret) const {
+  ret.clear();
+
+  vector<float> scores(labels_.size());
+  for (common::sfv_t::const_iterator it = sfv.begin(); it != sfv.end(); ++it) {
+    size_t f = feature_index(it->first);
+    if (f == NOTFOUND) {
+      continue;
+    }
+    const float val = it->second;
+    const val3_t* row = &weights_[f * labels_.size()];
+    const char* state = &state_[f * labels_.size()];
+    for (size_t l = 0; l < labels_.size(); ++l) {
+      if (state[l] != CELL_ABSENT) {
+        scores[l] += row[l].v1 * val;
+      }
+    }
+  }
+
+  for (size_t l = 0; l < labels_.size(); ++l) {
+    if (active_[l]) {
+      ret[labels_[l]] = scores[l];
+    }
+  }
+}
+
+void weight_view::set(
+    const string& feature,
+    const string& klass,
+    const val1_t& w) {
+  size_t f = writable_feature_index(feature);
+  touch_cell(f, label_index(klass)).v1 = w;
+}
+
+void weight_view::set2(
+    const string& feature,
+    const string& klass,
+    const val2_t& w) {
+  size_t f = writable_feature_index(feature);
+  val3_t& c = touch_cell(f, label_index(klass));
+  c.v1 = w.v1;
+  c.v2 = w.v2;
+}
+
+void weight_view::set3(
+    const string& feature,
+    const string& klass,
+    const val3_t& w) {
+  size_t f = writable_feature_index(feature);
+  touch_cell(f, label_index(klass)) = w;
+}
+
+void weight_view::get_status(std::map<string, string>& status) const {
+  size_t num_classes = 0;
+  for (size_t l = 0; l < active_.size(); ++l) {
+    if (active_[l]) {
+      ++num_classes;
+    }
+  }
+  status["num_features"] =
+    jubatus::util::lang::lexical_cast<string>(features_.size());
+  status["num_classes"] =
+    jubatus::util::lang::lexical_cast<string>(num_classes);
+}
+
+void weight_view::update(
+    const string& feature,
+    const string& inc_class,
+    const string& dec_class,
+    const val1_t& v) {
+  size_t f = writable_feature_index(feature);
+  touch_cell(f, label_index(inc_class)).v1 += v;
+  if (dec_class != "") {
+    touch_cell(f, label_index(dec_class)).v1 -= v;
+  }
+}
+
+void weight_view::bulk_update(
+    const common::sfv_t& sfv,
+    float step_width,
+    const string& inc_class,
+    const string& dec_class) {
+  size_t inc_id = label_index(inc_class);
+  size_t dec_id = dec_class != "" ? label_index(dec_class) : NOTFOUND;
+  for (common::sfv_t::const_iterator it = sfv.begin(); it != sfv.end(); ++it) {
+    size_t f = writable_feature_index(it->first);
+    float val = it->second * step_width;
+    touch_cell(f, inc_id).v1 += val;
+    if (dec_id != NOTFOUND) {
+      touch_cell(f, dec_id).v1 -= val;
+    }
+  }
+}
+
+void weight_view::register_label(const string& label) {
+  active_[label_index(label)] = 1;
+}
+
+bool weight_view::delete_label(const string&) {
+  throw JUBATUS_EXCEPTION(
+      common::unsupported_method("weight_view::delete_label"));
+}
+
+void weight_view::clear() {
+  std::fill(active_.begin(), active_.end(), 0);
+  std::fill(weights_.begin(), weights_.end(), val3_t());
+  std::fill(state_.begin(), state_.end(), CELL_ABSENT);
+}
+
+vector<string> weight_view::get_labels() const {
+  vector<string> labels;
+  for (size_t l = 0; l < labels_.size(); ++l) {
+    if (active_[l]) {
+      labels.push_back(labels_[l]);
+    }
+  }
+  return labels;
+}
+
+bool weight_view::set_label(const string& label) {
+  size_t l = label_index(label);
+  if (active_[l]) {
+    return false;
+  }
+  active_[l] = 1;
+  return true;
+}
+
+void weight_view::pack(framework::packer&) const {
+  throw JUBATUS_EXCEPTION(common::unsupported_method("weight_view::pack"));
+}
+
+void weight_view::unpack(msgpack::object) {
+  throw JUBATUS_EXCEPTION(common::unsupported_method("weight_view::unpack"));
+}
+
+string weight_view::type() const {
+  return "weight_view";
+}
+
+void weight_view::write_back(storage_base& base) const {
+  for (size_t l = 0; l < labels_.size(); ++l) {
+    if (active_[l]) {
+      base.register_label(labels_[l]);
+    }
+  }
+  for (size_t f = 0; f < features_.size(); ++f) {
+    for (size_t l = 0; l < labels_.size(); ++l) {
+      if (state_[f * labels_.size() + l] == CELL_WRITTEN) {
+        base.set3(features_[f], labels_[l], cell(f, l));
+      }
+    }
+  }
+}
+
+}  // namespace storage
+}  // namespace core
+}  // namespace jubatus
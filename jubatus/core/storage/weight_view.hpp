@@ -0,0 +1,128 @@
+// Jubatus: Online machine learning framework for distributed environment
+// Copyright (C) 2015 Preferred Networks and Nippon Telegraph and Telephone Corporation.
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License version 2.1 as published by the Free Software Foundation.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+#ifndef JUBATUS_CORE_STORAGE_WEIGHT_VIEW_HPP_
+#define JUBATUS_CORE_STORAGE_WEIGHT_VIEW_HPP_
+
+#include <map>
+#include <string>
+#include <vector>
+#include "jubatus/util/data/unordered_map.h"
+#include "storage_base.hpp"
+
+namespace jubatus {
+namespace core {
+namespace storage {
+
+// A dense (feature x label) copy of another storage, limited to a fixed set
+// of features and labels given at construction time.  Each weight lives at a
+// fixed offset of one flat array and the index maps are never modified after
+// construction, so many threads may read and update the view at once without
+// locking.  Writers racing on the same cell may lose an update, which is the
+// trade-off Hogwild! style training accepts.  |write_back| copies the cells
+// that were written to the original storage.
+class weight_view : public storage_base {
+ public:
+  weight_view(
+      const storage_base& base,
+      const std::vector<std::string>& features,
+      const std::vector<std::string>& labels);
+  ~weight_view();
+
+  void get(const std::string& feature, feature_val1_t& ret) const;
+  void get2(const std::string& feature, feature_val2_t& ret) const;
+  void get3(const std::string& feature, feature_val3_t& ret) const;
+
+  /// inner product
+  void inp(const common::sfv_t& sfv, map_feature_val1_t& ret) const;
+
+  void set(
+      const std::string& feature,
+      const std::string& klass,
+      const val1_t& w);
+  void set2(
+      const std::string& feature,
+      const std::string& klass,
+      const val2_t& w);
+  void set3(
+      const std::string& feature,
+      const std::string& klass,
+      const val3_t& w);
+
+  void get_status(std::map<std::string, std::string>& status) const;
+
+  void update(
+      const std::string& feature,
+      const std::string& inc_class,
+      const std::string& dec_class,
+      const val1_t& v);
+
+  void bulk_update(
+      const common::sfv_t& sfv,
+      float step_width,
+      const std::string& inc_class,
+      const std::string& dec_class);
+
+  void register_label(const std::string& label);
+  bool delete_label(const std::string& label);
+
+  void clear();
+  std::vector<std::string> get_labels() const;
+  bool set_label(const std::string& label);
+
+  void pack(framework::packer& packer) const;
+  void unpack(msgpack::object o);
+
+  version get_version() const {
+    return version();
+  }
+
+  std::string type() const;
+
+  // Calls |base.set3| for every cell written through this view, after
+  // registering the labels that became active.
+  void write_back(storage_base& base) const;
+
+ private:
+  typedef jubatus::util::data::unordered_map<std::string, size_t> index_t;
+
+  static const size_t NOTFOUND = static_cast<size_t>(-1);
+
+  size_t feature_index(const std::string& feature) const;
+  size_t writable_feature_index(const std::string& feature) const;
+  size_t label_index(const std::string& label) const;
+  val3_t& cell(size_t feature_id, size_t label_id);
+  const val3_t& cell(size_t feature_id, size_t label_id) const;
+  val3_t& touch_cell(size_t feature_id, size_t label_id);
+
+  index_t feature2id_;
+  std::vector<std::string> features_;
+  index_t label2id_;
+  std::vector<std::string> labels_;
+
+  // Whether each label is visible from |inp| and |get_labels|.
+  std::vector<char> active_;
+  // Row-major (feature x label) weights, and whether each cell exists in the
+  // original storage (CELL_LOADED) or was written here (CELL_WRITTEN).
+  std::vector<val3_t> weights_;
+  std::vector<char> state_;
+};
+
+}  // namespace storage
+}  // namespace core
+}  // namespace jubatus
+
+#endif  // JUBATUS_CORE_STORAGE_WEIGHT_VIEW_HPP_
@@ -0,0 +1,155 @@
+// Jubatus: Online machine learning framework for distributed environment
+// Copyright (C) 2015 Preferred Networks and Nippon Telegraph and Telephone Corporation.
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License version 2.1 as published by the Free Software Foundation.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "weight_view.hpp"
+#include "local_storage_mixture.hpp"
+
+using std::make_pair;
+using std::sort;
+using std::string;
+using std::vector;
+
+namespace jubatus {
+namespace core {
+namespace storage {
+
+namespace {
+
+vector<string> make_list(const char* a, const char* b) {
+  vector<string> v;
+  v.push_back(a);
+  v.push_back(b);
+  return v;
+}
+
+}  // namespace
+
+TEST(weight_view, load) {
+  local_storage_mixture s;
+  s.set3("a", "x", val3_t(1, 2, 3));
+  s.set3("b", "y", val3_t(4, 5, 6));
+  s.set3("c", "x", val3_t(7, 8, 9));
+
+  weight_view v(s, make_list("a", "b"), make_list("x", "z"));
+
+  feature_val3_t a;
+  v.get3("a", a);
+  ASSERT_EQ(1u, a.size());
+  EXPECT_EQ("x", a[0].first);
+  EXPECT_EQ(val3_t(1, 2, 3), a[0].second);
+
+  feature_val2_t b;
+  v.get2("b", b);
+  ASSERT_EQ(1u, b.size());
+  EXPECT_EQ("y", b[0].first);
+  EXPECT_EQ(val2_t(4, 5), b[0].second);
+
+  // features outside of the view read as empty
+  feature_val1_t c;
+  v.get("c", c);
+  EXPECT_TRUE(c.empty());
+
+  // "z" is not visible until it is written
+  vector<string> labels = v.get_labels();
+  sort(labels.begin(), labels.end());
+  ASSERT_EQ(2u, labels.size());
+  EXPECT_EQ("x", labels[0]);
+  EXPECT_EQ("y", labels[1]);
+}
+
+TEST(weight_view, inp) {
+  local_storage_mixture s;
+  s.set("a", "x", 1);
+  s.set("b", "x", 2);
+  s.set("b", "y", 3);
+
+  weight_view v(s, make_list("a", "b"), vector<string>());
+
+  common::sfv_t fv;
+  fv.push_back(make_pair("a", 1.f));
+  fv.push_back(make_pair("b", 2.f));
+  fv.push_back(make_pair("c", 4.f));
+
+  map_feature_val1_t expect, actual;
+  s.inp(fv, expect);
+  v.inp(fv, actual);
+  ASSERT_EQ(2u, actual.size());
+  EXPECT_FLOAT_EQ(expect["x"], actual["x"]);
+  EXPECT_FLOAT_EQ(expect["y"], actual["y"]);
+  EXPECT_FLOAT_EQ(5.f, actual["x"]);
+}
+
+TEST(weight_view, write_back) {
+  local_storage_mixture s;
+  s.set3("a", "x", val3_t(1, 1, 1));
+  s.set3("b", "x", val3_t(2, 2, 2));
+
+  weight_view v(s, make_list("a", "b"), make_list("y", "z"));
+
+  common::sfv_t fv;
+  fv.push_back(make_pair("a", 1.f));
+  v.bulk_update(fv, 0.5f, "y", "x");
+  v.set2("b", "x", val2_t(3, 4));
+
+  // nothing reaches the original storage before write_back
+  feature_val3_t a;
+  s.get3("a", a);
+  ASSERT_EQ(1u, a.size());
+
+  v.write_back(s);
+
+  s.get3("a", a);
+  sort(a.begin(), a.end());
+  ASSERT_EQ(2u, a.size());
+  EXPECT_EQ("x", a[0].first);
+  EXPECT_EQ(val3_t(0.5, 1, 1), a[0].second);
+  EXPECT_EQ("y", a[1].first);
+  EXPECT_EQ(val3_t(0.5, 0, 0), a[1].second);
+
+  feature_val3_t b;
+  s.get3("b", b);
+  ASSERT_EQ(1u, b.size());
+  EXPECT_EQ(val3_t(3, 4, 2), b[0].second);
+
+  // the written cells are recorded as a diff to be mixed
+  diff_t diff;
+  s.get_diff(diff);
+  EXPECT_EQ(2u, diff.diff.size());
+
+  vector<string> labels = s.get_labels();
+  sort(labels.begin(), labels.end());
+  ASSERT_EQ(2u, labels.size());
+  EXPECT_EQ("x", labels[0]);
+  EXPECT_EQ("y", labels[1]);
+}
+
+TEST(weight_view, uncovered_write) {
+  local_storage_mixture s;
+  weight_view v(s, make_list("a", "b"), make_list("x", "y"));
+  EXPECT_THROW(v.set("c", "x", 1), storage_exception);
+  EXPECT_THROW(v.set("a", "z", 1), storage_exception);
+  EXPECT_THROW(v.delete_label("x"), common::unsupported_method);
+}
+
+}  // namespace storage
+}  // namespace core
+}  // namespace jubatus
@@ -55,6 +55,8 @@ void column_table::clear() {
   tuples_ = 0;
   clock_ = 0;
   index_.clear();
+  change_log_.clear();
+  log_garbage_ = 0;
 }
 
 std::pair<bool, uint64_t> column_table::exact_match(
@@ -20,6 +20,8 @@
 #include <stdint.h>
 #include <algorithm>
 #include <cstring>
+#include <limits>
+#include <map>
 #include <string>
 #include <vector>
 #include <utility>
@@ -58,9 +60,10 @@ class column_table {
 
  public:
   typedef std::pair<owner, uint64_t> version_t;
+  typedef std::map<owner, uint64_t> version_clock;
 
   column_table()
-      : tuples_(0), clock_(0) {
+      : tuples_(0), clock_(0), log_garbage_(0) {
   }
   ~column_table() {
   }
@@ -83,6 +86,7 @@ class column_table {
       // add tuple
       keys_.push_back(key);
       versions_.push_back(std::make_pair(o, clock_));
+      log_insert_(tuples_);
       columns_[0].push_back(v1);
       JUBATUS_ASSERT_EQ(keys_.size(), versions_.size(), "");
 
@@ -91,7 +95,7 @@ class column_table {
       ++tuples_;
     } else {  // key exists
       const uint64_t index = it->second;
-      versions_[index] = std::make_pair(o, clock_);
+      set_version_(index, std::make_pair(o, clock_));
       columns_[0].update(index, v1);
     }
     ++clock_;
@@ -114,6 +118,7 @@ class column_table {
       // add tuple
       keys_.push_back(key);
       versions_.push_back(std::make_pair(o , clock_));
+      log_insert_(tuples_);
       columns_[0].push_back(v1);
       columns_[1].push_back(v2);
       JUBATUS_ASSERT_EQ(keys_.size(), versions_.size(), "");
@@ -123,7 +128,7 @@ class column_table {
       ++tuples_;
     } else {  // key exists
       const uint64_t index = it->second;
-      versions_[index] = std::make_pair(o, clock_);
+      set_version_(index, std::make_pair(o, clock_));
       columns_[0].update(index, v1);
       columns_[1].update(index, v2);
     }
@@ -143,7 +148,7 @@ class column_table {
     if (tuples_ < colum_id || it == index_.end()) {
       return false;
     }
-    versions_[it->second] = std::make_pair(o, clock_);
+    set_version_(it->second, std::make_pair(o, clock_));
     columns_[colum_id].update(it->second, v);
     columns_[colum_id].update(it->second, v);
     ++clock_;
@@ -158,6 +163,13 @@ class column_table {
     return keys_[key_id];
   }
 
+  // Same as get_key(), but returns a reference into the table instead of a
+  // copy; like columns, it is valid until the table is modified.
+  const std::string& get_key_ref(uint64_t key_id) const {
+    JUBATUS_ASSERT_LT(key_id, tuples_, "");
+    return keys_[key_id];
+  }
+
   void scan_clock() {
     jubatus::util::concurrent::scoped_wlock lk(table_lock_);
     uint64_t max_clock = 0;
@@ -251,13 +263,47 @@ class column_table {
 
   void get_row(const uint64_t id, framework::packer& pk) const {
     jubatus::util::concurrent::scoped_rlock lk(table_lock_);
-    JUBATUS_ASSERT_GE(tuples_, id, "specified index is bigger than table size");
-    pk.pack_array(3);  // [key, [owner, id], [data]]
-    pk.pack(keys_[id]);  // key
-    pk.pack(versions_[id]);  // [version]
-    pk.pack_array(columns_.size());
-    for (size_t i = 0; i < columns_.size(); ++i) {
-      columns_[i].pack_with_index(id, pk);
+    get_row_(id, pk);
+  }
+
+  /* packs an array of rows (each in get_row() format) updated after
+     the given clock; owners missing in the clock match all their rows.
+     only the change log is walked, not the whole table.
+  */
+  void get_rows_since(const version_clock& vc, framework::packer& pk) const {
+    jubatus::util::concurrent::scoped_rlock lk(table_lock_);
+    std::vector<std::pair<change_log::const_iterator,
+                          clock_index::const_iterator> > begins;
+    uint64_t count = 0;
+    for (change_log::const_iterator it = change_log_.begin();
+         it != change_log_.end(); ++it) {
+      const clock_index& log = it->second;
+      const version_clock::const_iterator v = vc.find(it->first);
+      const clock_index::const_iterator begin = v == vc.end() ?
+          log.begin() :
+          std::upper_bound(log.begin(), log.end(),
+                           std::make_pair(v->second, uint64_t()),
+                           clock_less_);
+      for (clock_index::const_iterator e = begin; e != log.end(); ++e) {
+        if (is_logged_(it->first, *e)) {
+          ++count;
+        }
+      }
+      if (begin != log.end()) {
+        begins.push_back(std::make_pair(it, begin));
+      }
+    }
+
+    pk.pack_array(count);
+    for (size_t i = 0; i < begins.size(); ++i) {
+      const owner& o = begins[i].first->first;
+      const clock_index& log = begins[i].first->second;
+      for (clock_index::const_iterator it = begins[i].second;
+           it != log.end(); ++it) {
+        if (is_logged_(o, *it)) {
+          get_row_(it->second, pk);
+        }
+      }
     }
   }
 
@@ -280,6 +326,7 @@ class column_table {
       // add tuple
       keys_.push_back(key);
       versions_.push_back(set_version);
+      log_insert_(tuples_);
       for (size_t i = 0; i < columns_.size(); ++i) {
         columns_[i].push_back(dat.via.array.ptr[i]);
       }
@@ -298,7 +345,7 @@ class column_table {
       // overwrite tuple if needed
       if (versions_[target].second <= set_version.second) {
         // needed!!
-        versions_[target] = set_version;
+        set_version_(target, set_version);
         for (size_t i = 0; i < columns_.size(); ++i) {
           columns_[i].update(target, dat.via.array.ptr[i]);
         }
@@ -318,7 +365,7 @@ class column_table {
     if (it == index_.end()) {
       return false;
     }
-    versions_[it->second] = std::make_pair(o, clock_);
+    set_version_(it->second, std::make_pair(o, clock_));
     ++clock_;
     return true;
   }
@@ -328,7 +375,7 @@ class column_table {
     if (size() < index) {
       return false;
     }
-    versions_[index] = std::make_pair(o, clock_);
+    set_version_(index, std::make_pair(o, clock_));
     ++clock_;
     return true;
   }
@@ -369,7 +416,28 @@ class column_table {
     return true;
   }
 
-  MSGPACK_DEFINE(keys_, tuples_, versions_, columns_, clock_, index_);
+  template<class Buffer>
+  void msgpack_pack(msgpack::packer<Buffer>& packer) const {
+    msgpack::type::make_define(
+        keys_, tuples_, versions_, columns_, clock_, index_)
+        .msgpack_pack(packer);
+  }
+  void msgpack_unpack(msgpack::object o) {
+    msgpack::type::make_define(
+        keys_, tuples_, versions_, columns_, clock_, index_)
+        .msgpack_unpack(o);
+    // the change log is not serialized; rebuild it from versions
+    change_log_.clear();
+    log_garbage_ = 0;
+    for (uint64_t i = 0; i < versions_.size(); ++i) {
+      change_log_[versions_[i].first].push_back(
+          std::make_pair(versions_[i].second, i));
+    }
+    for (change_log::iterator it = change_log_.begin();
+         it != change_log_.end(); ++it) {
+      std::sort(it->second.begin(), it->second.end());
+    }
+  }
 
   void pack(framework::packer& packer) const {
     packer.pack(*this);
@@ -380,6 +448,13 @@ class column_table {
   }
 
  private:
+  // (clock, row index) pairs of one owner, ordered by clock.  Entries of
+  // rows rewritten or deleted later are not removed at once, but skipped
+  // when read and dropped by compact_log_() once there are many of them.
+  typedef std::pair<uint64_t, uint64_t> log_entry;
+  typedef std::vector<log_entry> clock_index;
+  typedef std::map<owner, clock_index> change_log;
+
   std::vector<std::string> keys_;
   std::vector<version_t> versions_;
   std::vector<detail::abstract_column> columns_;
@@ -387,6 +462,100 @@ class column_table {
   uint64_t tuples_;
   uint64_t clock_;
   index_table index_;
+  change_log change_log_;
+  uint64_t log_garbage_;  // number of stale entries in change_log_
+
+  void get_row_(const uint64_t id, framework::packer& pk) const {
+    JUBATUS_ASSERT_GE(tuples_, id, "specified index is bigger than table size");
+    pk.pack_array(3);  // [key, [owner, id], [data]]
+    pk.pack(keys_[id]);  // key
+    pk.pack(versions_[id]);  // [version]
+    pk.pack_array(columns_.size());
+    for (size_t i = 0; i < columns_.size(); ++i) {
+      columns_[i].pack_with_index(id, pk);
+    }
+  }
+
+  static bool clock_less_(const log_entry& lhs, const log_entry& rhs) {
+    return lhs.first < rhs.first;
+  }
+
+  bool is_logged_(const owner& o, const log_entry& e) const {
+    return e.second < tuples_ && versions_[e.second].second == e.first &&
+        versions_[e.second].first == o;
+  }
+
+  void log_insert_(uint64_t index) {
+    const version_t& v = versions_[index];
+    clock_index& log = change_log_[v.first];
+    const log_entry e(v.second, index);
+    if (log.empty() || log.back().first < e.first) {
+      log.push_back(e);
+      return;
+    }
+    // rows put by MIX may come with older clocks than the latest one
+    clock_index::iterator it =
+        std::upper_bound(log.begin(), log.end(), e, clock_less_);
+    for (clock_index::iterator jt = it;
+         jt != log.begin() && (jt - 1)->first == e.first; --jt) {
+      if ((jt - 1)->second == index) {
+        return;  // a stale entry of the same version becomes live again
+      }
+    }
+    log.insert(it, e);
+  }
+
+  // Called when an entry of the log stops matching its row.
+  void log_discard_() {
+    if (++log_garbage_ > tuples_ / 2) {
+      compact_log_();
+    }
+  }
+
+  void compact_log_() {
+    for (change_log::iterator it = change_log_.begin();
+         it != change_log_.end();) {
+      clock_index& log = it->second;
+      clock_index::iterator out = log.begin();
+      for (clock_index::const_iterator in = log.begin();
+           in != log.end(); ++in) {
+        if (is_logged_(it->first, *in)) {
+          *out++ = *in;
+        }
+      }
+      log.erase(out, log.end());
+      if (log.empty()) {
+        change_log_.erase(it++);
+      } else {
+        ++it;
+      }
+    }
+    log_garbage_ = 0;
+  }
+
+  void set_version_(uint64_t index, const version_t& v) {
+    if (versions_[index] == v) {
+      return;
+    }
+    versions_[index] = v;
+    log_insert_(index);
+    log_discard_();
+  }
+
+  // Moves the log entry of row |from| to row |to|, keeping its clock.
+  void log_move_(uint64_t from, uint64_t to) {
+    const version_t& v = versions_[from];
+    clock_index& log = change_log_[v.first];
+    clock_index::iterator it = std::lower_bound(
+        log.begin(), log.end(), log_entry(v.second, 0), clock_less_);
+    for (; it != log.end() && it->first == v.second; ++it) {
+      if (it->second == from) {
+        it->second = to;
+        return;
+      }
+    }
+    JUBATUS_ASSERT_UNREACHABLE();
+  }
 
   void delete_row_(uint64_t index) {
     JUBATUS_ASSERT_LT(index, size(), "");
@@ -408,12 +577,15 @@ class column_table {
     keys_.pop_back();
 
     if (index + 1 != versions_.size()) {
+      // the last row moves into the deleted slot
+      log_move_(versions_.size() - 1, index);
       std::swap(versions_[index], versions_.back());
     }
     versions_.pop_back();
 
     --tuples_;
     ++clock_;
+    log_discard_();  // the entry of the deleted row
 
     JUBATUS_ASSERT_EQ(tuples_, index_.size(), "");
     JUBATUS_ASSERT_EQ(tuples_, keys_.size(), "");
@@ -958,3 +958,136 @@ TEST(table, delete_bv_row) {
     ASSERT_EQ(bv2, bc[0]);  // data will move
   }
 }
+
+namespace {
+
+std::set<string> rows_since(
+    const column_table& table,
+    const column_table::version_clock& vc) {
+  msgpack::sbuffer sb;
+  stream_writer<msgpack::sbuffer> sw(sb);
+  jubatus::core::framework::jubatus_packer jp(sw);
+  packer pk(jp);
+  table.get_rows_since(vc, pk);
+
+  msgpack::unpacked msg;
+  msgpack::unpack(&msg, sb.data(), sb.size());
+  vector<msgpack::object> rows;
+  msg.get().convert(&rows);
+  std::set<string> keys;
+  for (size_t i = 0; i < rows.size(); ++i) {
+    keys.insert(rows[i].via.array.ptr[0].as<string>());
+  }
+  EXPECT_EQ(rows.size(), keys.size());
+  return keys;
+}
+
+}  // namespace
+
+TEST(table, get_rows_since) {
+  column_table base;
+  vector<column_type> schema;
+  schema.push_back(column_type(column_type::int32_type));
+  base.init(schema);
+
+  base.add("a", owner("x"), 1);  // x:0
+  base.add("b", owner("x"), 2);  // x:1
+  base.add("c", owner("y"), 3);  // y:2
+  base.add("d", owner("y"), 4);  // y:3
+
+  column_table::version_clock vc;
+  ASSERT_EQ(4u, rows_since(base, vc).size());
+
+  vc[owner("x")] = 1;
+  vc[owner("y")] = 2;
+  std::set<string> keys = rows_since(base, vc);
+  ASSERT_EQ(1u, keys.size());
+  EXPECT_EQ(1u, keys.count("d"));
+
+  // rewriting and moving rows keeps the log in sync
+  base.add("a", owner("y"), 5);  // y:4
+  base.delete_row("c");  // "d" moves to the slot of "c"
+  base.update_clock("b", owner("x"));  // x:6
+  keys = rows_since(base, vc);
+  ASSERT_EQ(3u, keys.size());
+  EXPECT_EQ(1u, keys.count("a"));
+  EXPECT_EQ(1u, keys.count("b"));
+  EXPECT_EQ(1u, keys.count("d"));
+
+  vc[owner("x")] = 6;
+  vc[owner("y")] = 4;
+  EXPECT_EQ(0u, rows_since(base, vc).size());
+
+  // the log survives serialization
+  msgpack::sbuffer sb;
+  stream_writer<msgpack::sbuffer> sw(sb);
+  jubatus::core::framework::jubatus_packer jp(sw);
+  packer pk(jp);
+  base.pack(pk);
+  msgpack::unpacked msg;
+  msgpack::unpack(&msg, sb.data(), sb.size());
+  column_table loaded;
+  loaded.unpack(msg.get());
+  vc[owner("y")] = 3;
+  keys = rows_since(loaded, vc);
+  ASSERT_EQ(1u, keys.size());
+  EXPECT_EQ(1u, keys.count("a"));
+
+  base.clear();
+  EXPECT_EQ(0u, rows_since(base, column_table::version_clock()).size());
+}
+
+TEST(table, get_rows_since_many_changes) {
+  vector<column_type> schema;
+  schema.push_back(column_type(column_type::int32_type));
+  column_table base;
+  base.init(schema);
+
+  // enough rewrites and deletes to compact the change log several times
+  jubatus::util::math::random::mtrand rand(0);
+  const char* owners[] = {"x", "y"};
+  for (int i = 0; i < 2000; ++i) {
+    const string key = jubatus::util::lang::lexical_cast<string>(
+        rand.next_int(100));
+    if (rand.next_int(4) == 0) {
+      base.delete_row(key);
+    } else {
+      base.add(key, owner(owners[rand.next_int(2)]), i);
+    }
+  }
+
+  // rows put by MIX may come in any order of their clocks
+  column_table remote;
+  remote.init(schema);
+  for (int i = 0; i < 10; ++i) {
+    remote.add("z" + jubatus::util::lang::lexical_cast<string>(i),
+               owner("z"), i);
+  }
+  for (int i = 9; i >= 0; --i) {
+    msgpack::sbuffer sb;
+    stream_writer<msgpack::sbuffer> sw(sb);
+    jubatus::core::framework::jubatus_packer jp(sw);
+    packer pk(jp);
+    remote.get_row(i, pk);
+    msgpack::unpacked msg;
+    msgpack::unpack(&msg, sb.data(), sb.size());
+    base.set_row(msg.get());
+  }
+
+  const uint64_t clocks[] = {0, 500, 1000, 1500, 1990, 3000};
+  for (size_t c = 0; c < sizeof(clocks) / sizeof(clocks[0]); ++c) {
+    column_table::version_clock vc;
+    vc[owner("x")] = clocks[c];
+    vc[owner("y")] = clocks[c];
+    vc[owner("z")] = 4;
+
+    std::set<string> expected;
+    for (uint64_t i = 0; i < base.size(); ++i) {
+      const column_table::version_t v = base.get_version(i);
+      if (vc[v.first] < v.second) {
+        expected.insert(base.get_key(i));
+      }
+    }
+    EXPECT_EQ(expected, rows_since(base, vc)) << clocks[c];
+  }
+}
@@ -17,14 +17,14 @@
 #include "lru_unlearner.hpp"
 
 #include <string>
-#include "jubatus/util/data/unordered_set.h"
+#include <utility>
+#include <vector>
 
 // TODO(kmaehashi) move key_matcher to common
 #include "../fv_converter/key_matcher_factory.hpp"
 
 #include "../common/exception.hpp"
 
-using jubatus::util::data::unordered_set;
 using jubatus::core::fv_converter::key_matcher_factory;
 
 namespace jubatus {
@@ -32,13 +32,17 @@ namespace core {
 namespace unlearner {
 
 lru_unlearner::lru_unlearner(const config& conf)
-    : max_size_(conf.max_size) {
+    : head_(NIL),
+      tail_(NIL),
+      free_(NIL),
+      sticky_size_(0),
+      max_size_(conf.max_size) {
   if (conf.max_size <= 0) {
     throw JUBATUS_EXCEPTION(
         common::config_exception() << common::exception::error_message(
             "max_size must be a positive integer"));
   }
-  entry_map_.reserve(max_size_);
+  index_.reserve(max_size_);
 
   if (conf.sticky_pattern) {
     key_matcher_factory f;
@@ -46,92 +50,128 @@ lru_unlearner::lru_unlearner(const config& conf)
   }
 }
 
+void lru_unlearner::clear() {
+  index_.clear();
+  std::vector<slot>().swap(slots_);
+  head_ = NIL;
+  tail_ = NIL;
+  free_ = NIL;
+  sticky_size_ = 0;
+}
+
 bool lru_unlearner::can_touch(const std::string& id) {
-  return (exists_in_memory(id) || sticky_ids_.size() < max_size_);
+  return (exists_in_memory(id) || sticky_size_ < max_size_);
 }
 
 bool lru_unlearner::touch(const std::string& id) {
-  // When sticky pattern is specified, unlearner excludes IDs matching
-  // the pattern from unlearning.
-  bool is_sticky = sticky_matcher_ && sticky_matcher_->match(id);
-
-  if (is_sticky) {
-    unordered_set<std::string>::const_iterator it = sticky_ids_.find(id);
-    if (it != sticky_ids_.end()) {
-      // Sticky ID that is already on memory; nothing to do.
-      return true;
-    }
-  } else {
-    entry_map::iterator it = entry_map_.find(id);
-    if (it != entry_map_.end()) {
-      // Non-sticky ID that is already on memory; mark the ID
-      // as most recently used.
-      lru_.push_front(id);
-      lru_.erase(it->second);
-      it->second = lru_.begin();
-      return true;
+  index_t::iterator it = index_.find(id);
+  if (it != index_.end()) {
+    // ID that is already on memory; mark the ID as most recently used
+    // unless it is sticky.
+    const uint32_t n = it->second;
+    if (slots_[n].prev != STICKY) {
+      unlink(n);
+      link_front(n);
     }
+    return true;
   }
 
   // Touched ID is not on memory; need to secure a space for it.
-  if ((entry_map_.size() + sticky_ids_.size()) >= max_size_) {
-    // No more space; sticky_ids_ is the list of IDs that cannot be
-    // unlearned, so try to unlearn from entry_map_.
-    if (entry_map_.size() == 0) {
-      // entry_map_ is empty; nothing can be unlearned.
+  if (index_.size() >= max_size_) {
+    // No more space; sticky IDs cannot be unlearned, so try to unlearn
+    // from the LRU list.
+    if (tail_ == NIL) {
+      // Nothing can be unlearned.
       return false;
     }
 
     // Unlearn the least recently used entry.
-    unlearn(lru_.back());
-    entry_map_.erase(lru_.back());
-    lru_.pop_back();
+    const uint32_t n = tail_;
+    unlearn(*slots_[n].id);
+    unlink(n);
+    free_slot(n);
+    index_.erase(index_.find(*slots_[n].id));
   }
 
-  // Register the new ID.
-  if (is_sticky) {
-    sticky_ids_.insert(id);
+  // Register the new ID.  When sticky pattern is specified, unlearner
+  // excludes IDs matching the pattern from unlearning; the pattern is only
+  // evaluated here, as the result is kept in the slot.
+  const uint32_t n = allocate_slot();
+  it = index_.insert(std::make_pair(id, n)).first;
+  slots_[n].id = &it->first;
+  if (sticky_matcher_ && sticky_matcher_->match(id)) {
+    slots_[n].prev = STICKY;
+    slots_[n].next = NIL;
+    ++sticky_size_;
   } else {
-    lru_.push_front(id);
-    entry_map_[id] = lru_.begin();
+    link_front(n);
   }
 
   return true;
 }
 
 bool lru_unlearner::remove(const std::string& id) {
-  // Try to erase from non-sticky ID.
-  {
-    entry_map::iterator it = entry_map_.find(id);
-    if (it != entry_map_.end()) {
-      lru_.erase(it->second);
-      entry_map_.erase(it);
-      return true;
-    }
+  index_t::iterator it = index_.find(id);
+  if (it == index_.end()) {
+    return false;
   }
 
-  // Try to erase from sticky ID.
-  {
-    unordered_set<std::string>::iterator it = sticky_ids_.find(id);
-    if (it != sticky_ids_.end()) {
-      sticky_ids_.erase(it);
-      return true;
-    }
+  const uint32_t n = it->second;
+  if (slots_[n].prev == STICKY) {
+    --sticky_size_;
+  } else {
+    unlink(n);
   }
-
-  return false;
+  free_slot(n);
+  index_.erase(it);
+  return true;
 }
 
 bool lru_unlearner::exists_in_memory(const std::string& id) const {
-  return entry_map_.count(id) > 0 || sticky_ids_.count(id) > 0;
+  return index_.count(id) > 0;
 }
 
 // private
 
-void lru_unlearner::rebuild_entry_map() {
-  entry_map_.clear();
-  for (lru::iterator it = lru_.begin(); it != lru_.end(); ++it) {
-    entry_map_[*it] = it;
+uint32_t lru_unlearner::allocate_slot() {
+  if (free_ != NIL) {
+    const uint32_t n = free_;
+    free_ = slots_[n].next;
+    return n;
+  }
+  slots_.push_back(slot());
+  return slots_.size() - 1;
+}
+
+void lru_unlearner::free_slot(uint32_t n) {
+  slots_[n].prev = NIL;
+  slots_[n].next = free_;
+  free_ = n;
+}
+
+void lru_unlearner::link_front(uint32_t n) {
+  slots_[n].prev = NIL;
+  slots_[n].next = head_;
+  if (head_ != NIL) {
+    slots_[head_].prev = n;
+  } else {
+    tail_ = n;
+  }
+  head_ = n;
+}
+
+void lru_unlearner::unlink(uint32_t n) {
+  const uint32_t prev = slots_[n].prev;
+  const uint32_t next = slots_[n].next;
+  if (prev != NIL) {
+    slots_[prev].next = next;
+  } else {
+    head_ = next;
+  }
+  if (next != NIL) {
+    slots_[next].prev = prev;
+  } else {
+    tail_ = prev;
   }
 }
 
@@ -18,8 +18,8 @@
 #define JUBATUS_CORE_UNLEARNER_LRU_UNLEARNER_HPP_
 
 #include <stdint.h>
-#include <list>
 #include <string>
+#include <vector>
 #include "jubatus/util/data/serialization.h"
 #include "jubatus/util/data/unordered_map.h"
 #include "jubatus/util/data/unordered_set.h"
@@ -53,11 +53,7 @@ class lru_unlearner : public unlearner_base {
     return "lru_unlearner";
   }
 
-  void clear() {
-    lru_.clear();
-    entry_map_.clear();
-    sticky_ids_.clear();
-  }
+  void clear();
 
   explicit lru_unlearner(const config& conf);
 
@@ -67,15 +63,31 @@ class lru_unlearner : public unlearner_base {
   bool exists_in_memory(const std::string& id) const;
 
  private:
-  typedef std::list<std::string> lru;
-  typedef jubatus::util::data::unordered_map<std::string, lru::iterator>
-      entry_map;
+  // Each ID in memory owns a slot.  Slots of non-sticky IDs form an
+  // intrusive doubly-linked list in LRU order; freed slots are chained by
+  // `next`.  The ID string itself is only held as the key of index_.
+  struct slot {
+    const std::string* id;
+    uint32_t prev;
+    uint32_t next;
+  };
+  typedef jubatus::util::data::unordered_map<std::string, uint32_t> index_t;
+
+  static const uint32_t NIL = 0xffffffff;
+  // `prev` of slots of sticky IDs, which are never unlearned
+  static const uint32_t STICKY = 0xfffffffe;
 
-  void rebuild_entry_map();
+  uint32_t allocate_slot();
+  void free_slot(uint32_t n);
+  void link_front(uint32_t n);
+  void unlink(uint32_t n);
 
-  lru lru_;
-  entry_map entry_map_;
-  unordered_set<std::string> sticky_ids_;
+  index_t index_;
+  std::vector<slot> slots_;
+  uint32_t head_;
+  uint32_t tail_;
+  uint32_t free_;
+  size_t sticky_size_;
   size_t max_size_;
   shared_ptr<key_matcher> sticky_matcher_;
 };
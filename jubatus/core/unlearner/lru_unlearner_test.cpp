@@ -103,6 +103,44 @@ TEST(lru_unlearner, sticky) {
   EXPECT_TRUE(unlearner.touch("id6"));
 }
 
+TEST(lru_unlearner, remove_and_clear) {
+  lru_unlearner::config config;
+  config.max_size = 3;
+  lru_unlearner unlearner(config);
+
+  mock_callback callback;
+  unlearner.set_callback(callback);
+
+  unlearner.touch("id1");
+  unlearner.touch("id2");
+  unlearner.touch("id3");
+  EXPECT_TRUE(unlearner.remove("id1"));
+  EXPECT_FALSE(unlearner.remove("id1"));
+  EXPECT_TRUE(unlearner.remove("id3"));
+
+  // freed places are reused without unlearning
+  unlearner.touch("id4");
+  unlearner.touch("id5");
+  EXPECT_EQ("", callback.unlearned_id());
+  EXPECT_TRUE(unlearner.exists_in_memory("id2"));
+  EXPECT_TRUE(unlearner.exists_in_memory("id4"));
+  EXPECT_TRUE(unlearner.exists_in_memory("id5"));
+
+  unlearner.touch("id6");
+  EXPECT_EQ("id2", callback.unlearned_id());
+  unlearner.touch("id4");
+  unlearner.touch("id7");
+  EXPECT_EQ("id5", callback.unlearned_id());
+
+  unlearner.clear();
+  EXPECT_FALSE(unlearner.exists_in_memory("id4"));
+  unlearner.touch("id1");
+  unlearner.touch("id2");
+  unlearner.touch("id3");
+  unlearner.touch("id4");
+  EXPECT_EQ("id1", callback.unlearned_id());
+}
+
 
 }  // namespace unlearner
 }  // namespace core
@@ -43,14 +43,36 @@ class fenwick_tree{
 public:
   explicit fenwick_tree(int n) :v(n) {}
 
-  T query(int a){
+  T query(int a) const{
     return a>=0?v[a]+query((a&(a+1))-1):0;
   }
 
-  T query(int a, int b){
+  T query(int a, int b) const{
     return query(b)-query(a-1);
   }
 
+  // smallest k such that query(k) > x, or size() if there is no such k.
+  // all values must be non-negative.
+  int upper_bound(T x) const{
+    int n=(int)v.size();
+    int step=1;
+    while(step*2<=n) step*=2;
+    int p=0;
+    for(;step>0;step/=2){
+      // v[p+step-1] holds the sum of [p, p+step-1]
+      int i=p+step-1;
+      if (i<n && !(x<v[i])){
+        x-=v[i];
+        p+=step;
+      }
+    }
+    return p;
+  }
+
+  int size() const{
+    return (int)v.size();
+  }
+
   void increase(int k, T n){
     if (k<(int)v.size()){
       v[k]+=n;